@@ -0,0 +1,583 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkExceptionObject.h"
+#include "itkFreeSurferAnnotMeshIO.h"
+#include "itkNumericTraits.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+
+namespace itk
+{
+namespace
+{
+/** Color table tag following the labels. */
+const itk::int32_t ColorTableTag = 1;
+
+/** Version of the color tables written, older ones start with their
+ * number of entries instead. */
+const itk::int32_t ColorTableVersion = 2;
+
+itk::int32_t ReadBigEndianWord(const unsigned char *input)
+{
+  return static_cast< itk::int32_t >( ( static_cast< itk::uint32_t >( input[0] ) << 24 )
+                                      | ( static_cast< itk::uint32_t >( input[1] ) << 16 )
+                                      | ( static_cast< itk::uint32_t >( input[2] ) << 8 )
+                                      | static_cast< itk::uint32_t >( input[3] ) );
+}
+
+/** Sequential reads of the color table, which fail past the end of the
+ * file. */
+class ColorTableReader
+{
+public:
+  ColorTableReader(const unsigned char *data, size_t length, size_t position):
+    m_Data(data), m_Length(length), m_Position(position)
+  {}
+
+  bool ReadWord(itk::int32_t & word)
+  {
+    if ( m_Length - m_Position < 4 )
+      {
+      return false;
+      }
+    word = ReadBigEndianWord(m_Data + m_Position);
+    m_Position += 4;
+    return true;
+  }
+
+  /** Read a string with its length, up to its first null character. */
+  bool ReadString(std::string & value)
+  {
+    itk::int32_t length;
+    if ( !this->ReadWord(length) || length < 0 || m_Length - m_Position < static_cast< size_t >( length ) )
+      {
+      return false;
+      }
+    const char *first = reinterpret_cast< const char * >( m_Data + m_Position );
+    const void *end = std::memchr(first, '\0', length);
+    value.assign( first, end ? static_cast< const char * >( end ) - first : length );
+    m_Position += length;
+    return true;
+  }
+
+private:
+  const unsigned char *m_Data;
+  size_t               m_Length;
+  size_t               m_Position;
+};
+
+/** Append word to data, big endian. */
+void AppendWord(std::vector< unsigned char > & data, itk::int32_t word)
+{
+  const itk::uint32_t bits = static_cast< itk::uint32_t >( word );
+
+  data.push_back( static_cast< unsigned char >( bits >> 24 ) );
+  data.push_back( static_cast< unsigned char >( bits >> 16 ) );
+  data.push_back( static_cast< unsigned char >( bits >> 8 ) );
+  data.push_back( static_cast< unsigned char >( bits ) );
+}
+
+/** Append value to data with its length, and its terminating null
+ * character as the annotations store their strings. */
+void AppendString(std::vector< unsigned char > & data, const std::string & value)
+{
+  AppendWord(data, static_cast< itk::int32_t >( value.size() + 1 ));
+  data.insert( data.end(), value.begin(), value.end() );
+  data.push_back(0);
+}
+
+/** Annotation value of a color: its components from 0 to 255 packed. */
+itk::int32_t GetAnnotationValue(const FreeSurferAnnotMeshIO::RGBAPixelType & color)
+{
+  itk::int32_t value = 0;
+
+  for ( int nn = 2; nn >= 0; --nn )
+    {
+    const float component = std::max( 0.0f, std::min(color.GetNthComponent(nn), 1.0f) );
+    value = ( value << 8 ) | static_cast< itk::int32_t >( component * 255.0f + 0.5f );
+    }
+  return value;
+}
+}
+
+FreeSurferAnnotMeshIO::FreeSurferAnnotMeshIO()
+{
+  this->AddSupportedWriteExtension(".annot");
+  this->m_FileType = BINARY;
+  this->m_ByteOrder = BigEndian;
+  m_LabelsOffset = 0;
+}
+
+FreeSurferAnnotMeshIO::LabelColorContainerPointer FreeSurferAnnotMeshIO::GetLabelColorTable()
+{
+  LabelColorContainerPointer colorMap;
+  if ( ExposeMetaData< LabelColorContainerPointer >(this->GetMetaDataDictionary(), "colorContainer", colorMap) )
+    {
+    return colorMap;
+    }
+  return NULL;
+}
+
+FreeSurferAnnotMeshIO::LabelNameContainerPointer FreeSurferAnnotMeshIO::GetLabelNameTable()
+{
+  LabelNameContainerPointer labelMap;
+  if ( ExposeMetaData< LabelNameContainerPointer >(this->GetMetaDataDictionary(), "labelContainer", labelMap) )
+    {
+    return labelMap;
+    }
+  return NULL;
+}
+
+void FreeSurferAnnotMeshIO::SetLabelColorTable(const LabelColorContainer *colorMap)
+{
+  EncapsulateMetaData< LabelColorContainerPointer >( this->GetMetaDataDictionary(), "colorContainer",
+                                                     const_cast< LabelColorContainer * >( colorMap ) );
+  this->Modified();
+}
+
+void FreeSurferAnnotMeshIO::SetLabelNameTable(const LabelNameContainer *labelMap)
+{
+  EncapsulateMetaData< LabelNameContainerPointer >( this->GetMetaDataDictionary(), "labelContainer",
+                                                    const_cast< LabelNameContainer * >( labelMap ) );
+  this->Modified();
+}
+
+bool FreeSurferAnnotMeshIO::CanReadFile(const char *fileName)
+{
+  if ( !itksys::SystemTools::FileExists(fileName, true) )
+    {
+    return false;
+    }
+
+  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) != ".annot" )
+    {
+    return false;
+    }
+
+  return true;
+}
+
+bool FreeSurferAnnotMeshIO::CanWriteFile(const char *fileName)
+{
+  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) != ".annot" )
+    {
+    return false;
+    }
+
+  return true;
+}
+
+void FreeSurferAnnotMeshIO::ReadMeshInformation()
+{
+  if ( this->m_FileName.empty() )
+    {
+    itkExceptionMacro("No input FileName");
+    }
+
+  // The file stays mapped until the labels are read
+  if ( !m_File.Open(this->m_FileName) )
+    {
+    itkExceptionMacro("Unable to open file " << this->m_FileName);
+    }
+
+  if ( !m_File.Holds(0, 4) )
+    {
+    m_File.Close();
+    itkExceptionMacro(<< "File " << this->m_FileName << " is too short for an annotation");
+    }
+
+  // The number of vertices is followed by the vertex and label pairs
+  const itk::int32_t numberOfVertices = ReadBigEndianWord( m_File.GetData() );
+  m_LabelsOffset = 4;
+  if ( numberOfVertices < 0 || !m_File.Holds(m_LabelsOffset, 8 * static_cast< size_t >( numberOfVertices )) )
+    {
+    m_File.Close();
+    itkExceptionMacro(<< "File " << this->m_FileName << " does not hold the labels of " << numberOfVertices
+                      << " vertices");
+    }
+
+  this->m_NumberOfPoints = static_cast< SizeValueType >( numberOfVertices );
+  this->m_NumberOfPointPixels = this->m_NumberOfPoints;
+  this->m_NumberOfCells = 0;
+  this->m_UpdatePoints = false;
+  this->m_UpdateCells = false;
+  this->m_UpdatePointData = this->m_NumberOfPointPixels > 0;
+  this->m_UpdateCellData = false;
+
+  // Labels are 32 bits integers
+  this->m_PointPixelComponentType = INT;
+  this->m_NumberOfPointPixelComponents = itk::NumericTraits< unsigned int >::One;
+  this->m_PointPixelType = SCALAR;
+
+  this->m_CellPixelComponentType = INT;
+  this->m_NumberOfCellPixelComponents = itk::NumericTraits< unsigned int >::One;
+  this->m_CellPixelType = SCALAR;
+
+  // Forget the tables of the file read before
+  m_ColorTableFileName = "";
+  this->SetLabelColorTable(NULL);
+  this->SetLabelNameTable(NULL);
+
+  const SizeValueType colorTableOffset = m_LabelsOffset + 8 * this->m_NumberOfPointPixels;
+  if ( m_File.Holds(colorTableOffset, 4) && ReadBigEndianWord(m_File.GetData() + colorTableOffset) == ColorTableTag )
+    {
+    this->ReadColorTable(colorTableOffset + 4);
+    }
+
+  if ( !this->m_UpdatePointData )
+    {
+    m_File.Close();
+    }
+}
+
+void FreeSurferAnnotMeshIO::ReadColorTable(SizeValueType offset)
+{
+  ColorTableReader reader(m_File.GetData(), m_File.GetLength(), offset);
+
+  // Old color tables start with their number of entries, newer ones with
+  // their version, negated
+  itk::int32_t numberOfEntries;
+  bool         success = reader.ReadWord(numberOfEntries);
+  const bool   indexed = success && numberOfEntries < 0;
+  if ( indexed )
+    {
+    if ( -numberOfEntries != ColorTableVersion )
+      {
+      m_File.Close();
+      itkExceptionMacro(<< "Unsupported color table version " << -numberOfEntries << " in file " << this->m_FileName);
+      }
+
+    // Number of structures, then number of entries present
+    success = reader.ReadWord(numberOfEntries);
+    }
+
+  success = success && reader.ReadString(m_ColorTableFileName);
+  if ( indexed )
+    {
+    success = success && reader.ReadWord(numberOfEntries);
+    }
+
+  LabelColorContainerPointer colorMap = LabelColorContainer::New();
+  LabelNameContainerPointer  labelMap = LabelNameContainer::New();
+  for ( itk::int32_t ii = 0; success && ii < numberOfEntries; ii++ )
+    {
+    itk::int32_t structure;
+    std::string  name;
+    itk::int32_t rgbt[4];
+    success = ( !indexed || reader.ReadWord(structure) ) && reader.ReadString(name) && reader.ReadWord(rgbt[0])
+              && reader.ReadWord(rgbt[1]) && reader.ReadWord(rgbt[2]) && reader.ReadWord(rgbt[3]);
+    if ( success )
+      {
+      // The fourth component is the transparency
+      RGBAPixelType color;
+      color.SetRed(rgbt[0] / 255.0f);
+      color.SetGreen(rgbt[1] / 255.0f);
+      color.SetBlue(rgbt[2] / 255.0f);
+      color.SetAlpha(1.0f - rgbt[3] / 255.0f);
+
+      const int key = rgbt[0] + ( rgbt[1] << 8 ) + ( rgbt[2] << 16 );
+      colorMap->InsertElement(key, color);
+      labelMap->InsertElement(key, name);
+      }
+    }
+
+  if ( !success )
+    {
+    m_File.Close();
+    itkExceptionMacro(<< "Truncated color table in file " << this->m_FileName);
+    }
+
+  this->SetLabelColorTable(colorMap);
+  this->SetLabelNameTable(labelMap);
+}
+
+void FreeSurferAnnotMeshIO::ReadPoints(void *)
+{
+  return;
+}
+
+void FreeSurferAnnotMeshIO::ReadCells(void *)
+{
+  return;
+}
+
+void FreeSurferAnnotMeshIO::ReadPointData(void *buffer)
+{
+  if ( !m_File.Holds(m_LabelsOffset, 8 * this->m_NumberOfPointPixels) )
+    {
+    itkExceptionMacro(<< "No labels read from file " << this->m_FileName);
+    }
+
+  itk::int32_t *       labels = static_cast< itk::int32_t * >( buffer );
+  const unsigned char *pairs = m_File.GetData() + m_LabelsOffset;
+  const SizeValueType  numberOfVertices = this->m_NumberOfPointPixels;
+
+  // The vertices are usually all there in order, the labels are then copied
+  // as they come
+  SizeValueType ii = 0;
+  while ( ii < numberOfVertices && ReadBigEndianWord(pairs + 8 * ii) == static_cast< itk::int32_t >( ii ) )
+    {
+    labels[ii] = ReadBigEndianWord(pairs + 8 * ii + 4);
+    ii++;
+    }
+
+  // Otherwise the vertices left without a label get 0
+  if ( ii < numberOfVertices )
+    {
+    std::fill(labels + ii, labels + numberOfVertices, 0);
+    for (; ii < numberOfVertices; ii++ )
+      {
+      const itk::int32_t vertex = ReadBigEndianWord(pairs + 8 * ii);
+      if ( vertex < 0 || static_cast< SizeValueType >( vertex ) >= numberOfVertices )
+        {
+        m_File.Close();
+        itkExceptionMacro(<< "Invalid vertex " << vertex << " in file " << this->m_FileName);
+        }
+      labels[vertex] = ReadBigEndianWord(pairs + 8 * ii + 4);
+      }
+    }
+
+  m_File.Close();
+}
+
+void FreeSurferAnnotMeshIO::ReadCellData(void *)
+{
+  return;
+}
+
+void FreeSurferAnnotMeshIO::WriteMeshInformation()
+{
+  // Check file name
+  if ( this->m_FileName == "" )
+    {
+    itkExceptionMacro("No Input FileName");
+    }
+
+  if ( !this->m_UpdatePointData || this->m_NumberOfPointPixelComponents != 1 )
+    {
+    itkExceptionMacro(<< "An annotation needs scalar point data, to write file " << this->m_FileName);
+    }
+
+  // Write to output file
+  std::ofstream outputFile(this->m_FileName.c_str(), std::ios::out | std::ios::binary);
+
+  // Whether output stream opened successfully
+  if ( !outputFile.is_open() )
+    {
+    itkExceptionMacro("Unable to open file\n"
+                      "outputFilename= " << this->m_FileName);
+    }
+
+  unsigned char numberOfVertices[4];
+  WriteBigEndianWord(static_cast< itk::int32_t >( this->m_NumberOfPointPixels ), numberOfVertices);
+  outputFile.write(reinterpret_cast< const char * >( numberOfVertices ), 4);
+  outputFile.close();
+}
+
+void FreeSurferAnnotMeshIO::WritePoints(void *)
+{
+  return;
+}
+
+void FreeSurferAnnotMeshIO::WriteCells(void *)
+{
+  return;
+}
+
+void FreeSurferAnnotMeshIO::WritePointData(void *buffer)
+{
+  // check file name
+  if ( this->m_FileName == "" )
+    {
+    itkExceptionMacro("No Input FileName");
+    }
+
+  // Write to output file
+  std::ofstream outputFile(this->m_FileName.c_str(), std::ios_base::app | std::ios::binary);
+
+  if ( !outputFile.is_open() )
+    {
+    itkExceptionMacro("Unable to open file\n"
+                      "outputFilename= " << this->m_FileName);
+    }
+
+  // Write labels
+  switch ( this->m_PointPixelComponentType )
+    {
+    case UCHAR:
+      {
+      WriteLabels(static_cast< unsigned char * >( buffer ), outputFile);
+      break;
+      }
+    case CHAR:
+      {
+      WriteLabels(static_cast< char * >( buffer ), outputFile);
+      break;
+      }
+    case USHORT:
+      {
+      WriteLabels(static_cast< unsigned short * >( buffer ), outputFile);
+      break;
+      }
+    case SHORT:
+      {
+      WriteLabels(static_cast< short * >( buffer ), outputFile);
+      break;
+      }
+    case UINT:
+      {
+      WriteLabels(static_cast< unsigned int * >( buffer ), outputFile);
+      break;
+      }
+    case INT:
+      {
+      WriteLabels(static_cast< int * >( buffer ), outputFile);
+      break;
+      }
+    case ULONG:
+      {
+      WriteLabels(static_cast< unsigned long * >( buffer ), outputFile);
+      break;
+      }
+    case LONG:
+      {
+      WriteLabels(static_cast< long * >( buffer ), outputFile);
+      break;
+      }
+    case ULONGLONG:
+      {
+      WriteLabels(static_cast< unsigned long long * >( buffer ), outputFile);
+      break;
+      }
+    case LONGLONG:
+      {
+      WriteLabels(static_cast< long long * >( buffer ), outputFile);
+      break;
+      }
+    case FLOAT:
+      {
+      WriteLabels(static_cast< float * >( buffer ), outputFile);
+      break;
+      }
+    case DOUBLE:
+      {
+      WriteLabels(static_cast< double * >( buffer ), outputFile);
+      break;
+      }
+    case LDOUBLE:
+      {
+      WriteLabels(static_cast< long double * >( buffer ), outputFile);
+      break;
+      }
+    default:
+      {
+      itkExceptionMacro(<< "Unknown point data pixel component type" << std::endl);
+      }
+    }
+
+  this->WriteColorTable(outputFile);
+
+  if ( !outputFile )
+    {
+    itkExceptionMacro(<< "Could not write file " << this->m_FileName);
+    }
+  outputFile.close();
+}
+
+bool FreeSurferAnnotMeshIO::GetAnnotationValues(std::map< int, itk::int32_t > & annotationValues)
+{
+  LabelColorContainerPointer colorMap = this->GetLabelColorTable();
+  if ( colorMap.IsNull() )
+    {
+    return false;
+    }
+
+  for ( LabelColorContainer::ConstIterator it = colorMap->Begin(); it != colorMap->End(); ++it )
+    {
+    const itk::int32_t value = GetAnnotationValue( it->Value() );
+    if ( value != it->Index() )
+      {
+      annotationValues[it->Index()] = value;
+      }
+    }
+
+  return !annotationValues.empty();
+}
+
+void FreeSurferAnnotMeshIO::WriteColorTable(std::ofstream & outputFile)
+{
+  LabelColorContainerPointer colorMap = this->GetLabelColorTable();
+  if ( colorMap.IsNull() || colorMap->Size() == 0 )
+    {
+    return;
+    }
+
+  LabelNameContainerPointer labelMap = this->GetLabelNameTable();
+
+  // Tag, version, number of structures and name of the color table, then
+  // the number of entries. The strings are written with their terminating
+  // null character.
+  std::vector< unsigned char > table;
+
+  AppendWord(table, ColorTableTag);
+  AppendWord(table, -ColorTableVersion);
+  AppendWord( table, static_cast< itk::int32_t >( colorMap->Size() ) );
+  AppendString(table, m_ColorTableFileName);
+  AppendWord( table, static_cast< itk::int32_t >( colorMap->Size() ) );
+
+  itk::int32_t structure = 0;
+  for ( LabelColorContainer::ConstIterator it = colorMap->Begin(); it != colorMap->End(); ++it, ++structure )
+    {
+    std::string name;
+    if ( labelMap.IsNotNull() && labelMap->IndexExists( it->Index() ) )
+      {
+      name = labelMap->ElementAt( it->Index() );
+      }
+
+    AppendWord(table, structure);
+    AppendString(table, name);
+
+    const itk::int32_t value = GetAnnotationValue( it->Value() );
+    const float        alpha = std::max( 0.0f, std::min(it->Value().GetAlpha(), 1.0f) );
+    AppendWord(table, value & 0xff);
+    AppendWord(table, ( value >> 8 ) & 0xff);
+    AppendWord(table, ( value >> 16 ) & 0xff);
+    AppendWord(table, static_cast< itk::int32_t >( ( 1.0f - alpha ) * 255.0f + 0.5f ));
+    }
+
+  outputFile.write(reinterpret_cast< const char * >( &table[0] ), table.size());
+}
+
+void FreeSurferAnnotMeshIO::WriteCellData(void *)
+{
+  return;
+}
+
+void FreeSurferAnnotMeshIO::Write()
+{}
+
+void FreeSurferAnnotMeshIO::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Color table file name : " << m_ColorTableFileName << std::endl;
+}
+} // namespace itk end
@@ -0,0 +1,201 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkFreeSurferAnnotMeshIO_h
+#define __itkFreeSurferAnnotMeshIO_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkIntTypes.h"
+#include "itkMapContainer.h"
+#include "itkMeshIOBase.h"
+#include "itkMeshIOMappedFile.h"
+#include "itkMetaDataObject.h"
+#include "itkRGBAPixel.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+/** \class FreeSurferAnnotMeshIO
+ * FreeSurfer annotation (parcellation) files, the suffix is set as *.annot
+ *
+ * An annotation holds one label per vertex and a color table. The labels
+ * are read as 32 bits integer point data, the annotation value of each
+ * vertex (red + green * 256 + blue * 65536 of its structure), as in the
+ * label data arrays of GIFTI files converted by FreeSurfer. The color table
+ * fills the same label color and name tables as GiftiMeshIO, keyed by the
+ * annotation values, in the meta data dictionary of this MeshIO.
+ *
+ * The file is memory mapped, and the labels are decoded in one pass into
+ * the point data buffer. Vertices without a label are given 0.
+ *
+ * When writing, the point data are the labels. A label which is not the
+ * annotation value of its color in the label color table is replaced by
+ * it. Without a label color table, no color table is written.
+ * \ingroup IOFilters
+ */
+
+class ITK_EXPORT FreeSurferAnnotMeshIO:public MeshIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef FreeSurferAnnotMeshIO              Self;
+  typedef MeshIOBase                         Superclass;
+  typedef SmartPointer< const Self >         ConstPointer;
+  typedef SmartPointer< Self >               Pointer;
+  typedef RGBAPixel< float >                 RGBAPixelType;
+  typedef MapContainer< int, RGBAPixelType > LabelColorContainer;
+  typedef MapContainer< int, std::string >   LabelNameContainer;
+  typedef LabelColorContainer::Pointer       LabelColorContainerPointer;
+  typedef LabelNameContainer::Pointer        LabelNameContainerPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FreeSurferAnnotMeshIO, MeshIOBase);
+
+  LabelColorContainerPointer GetLabelColorTable();
+  LabelNameContainerPointer  GetLabelNameTable();
+  void SetLabelColorTable(const LabelColorContainer *colorMap);
+  void SetLabelNameTable(const LabelNameContainer *labelMap);
+
+  /** Name of the color table file recorded in the annotation. */
+  itkGetStringMacro(ColorTableFileName);
+  itkSetStringMacro(ColorTableFileName);
+
+  /*-------- This part of the interfaces deals with reading data. ----- */
+
+  /** Determine if the file can be read with this MeshIO implementation.
+   * \param FileNameToRead The name of the file to test for reading.
+   * \post Sets classes MeshIOBase::m_FileName variable to be FileNameToWrite
+   * \return Returns true if this MeshIO can read the file specified.
+   */
+  virtual bool CanReadFile(const char *FileNameToRead);
+
+  /** Read the number of vertices and the color table. */
+  virtual void ReadMeshInformation();
+
+  /** Reads the data from disk into the memory buffer provided. */
+  virtual void ReadPoints(void *buffer);
+
+  virtual void ReadCells(void *buffer);
+
+  virtual void ReadPointData(void *buffer);
+
+  virtual void ReadCellData(void *buffer);
+
+  /*-------- This part of the interfaces deals with writing data. ----- */
+
+  /** Determine if the file can be written with this MeshIO implementation.
+   * \param FileNameToWrite The name of the file to test for writing.
+   * \post Sets classes MeshIOBase::m_FileName variable to be FileNameToWrite
+   * \return Returns true if this MeshIO can write the file specified.
+   */
+  virtual bool CanWriteFile(const char *FileNameToWrite);
+
+  /** Write the number of vertices. */
+  virtual void WriteMeshInformation();
+
+  /** Only the point data are written, with the color table. */
+  virtual void WritePoints(void *buffer);
+
+  virtual void WriteCells(void *buffer);
+
+  virtual void WritePointData(void *buffer);
+
+  virtual void WriteCellData(void *buffer);
+
+  virtual void Write();
+
+protected:
+  FreeSurferAnnotMeshIO();
+  virtual ~FreeSurferAnnotMeshIO(){}
+
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Read the color table at offset of the mapped file. */
+  void ReadColorTable(SizeValueType offset);
+
+  /** Store word at output, big endian. */
+  static void WriteBigEndianWord(itk::int32_t word, unsigned char *output)
+  {
+    const itk::uint32_t bits = static_cast< itk::uint32_t >( word );
+
+    output[0] = static_cast< unsigned char >( bits >> 24 );
+    output[1] = static_cast< unsigned char >( bits >> 16 );
+    output[2] = static_cast< unsigned char >( bits >> 8 );
+    output[3] = static_cast< unsigned char >( bits );
+  }
+
+  /** Fill annotationValues with the annotation value of the color of each
+   * label of the label color table, where they differ. Return whether the
+   * labels have to be replaced. */
+  bool GetAnnotationValues(std::map< int, itk::int32_t > & annotationValues);
+
+  /** Write the vertex and label pairs, by chunks encoded from buffer */
+  template< typename T >
+  void WriteLabels(const T *buffer, std::ofstream & outputFile)
+  {
+    std::map< int, itk::int32_t > annotationValues;
+    const bool                    replaceLabels = this->GetAnnotationValues(annotationValues);
+
+    const SizeValueType chunkSize = 4096;
+    std::vector< unsigned char > chunk(8 * chunkSize);
+    for ( SizeValueType ii = 0; ii < this->m_NumberOfPointPixels; ii += chunkSize )
+      {
+      const SizeValueType numberOfPairs = std::min(chunkSize, this->m_NumberOfPointPixels - ii);
+      for ( SizeValueType jj = 0; jj < numberOfPairs; jj++ )
+        {
+        itk::int32_t label = static_cast< itk::int32_t >( buffer[ii + jj] );
+        if ( replaceLabels )
+          {
+          std::map< int, itk::int32_t >::const_iterator it = annotationValues.find(label);
+          if ( it != annotationValues.end() )
+            {
+            label = it->second;
+            }
+          }
+        WriteBigEndianWord(static_cast< itk::int32_t >( ii + jj ), &chunk[8 * jj]);
+        WriteBigEndianWord(label, &chunk[8 * jj + 4]);
+        }
+      outputFile.write(reinterpret_cast< const char * >( &chunk[0] ), 8 * numberOfPairs);
+      }
+  }
+
+  /** Write the color table from the label color and name tables. */
+  void WriteColorTable(std::ofstream & outputFile);
+
+private:
+  FreeSurferAnnotMeshIO(const Self &); // purposely not implemented
+  void operator=(const Self &);        // purposely not implemented
+
+  std::string      m_ColorTableFileName;
+  SizeValueType    m_LabelsOffset;
+  MeshIOMappedFile m_File;
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,50 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCreateObjectFunction.h"
+#include "itkFreeSurferAnnotMeshIO.h"
+#include "itkFreeSurferAnnotMeshIOFactory.h"
+#include "itkVersion.h"
+
+namespace itk
+{
+void FreeSurferAnnotMeshIOFactory::PrintSelf(std::ostream &, Indent) const
+{}
+
+FreeSurferAnnotMeshIOFactory::FreeSurferAnnotMeshIOFactory()
+{
+  this->RegisterOverride( "itkMeshIOBase",
+                         "itkFreeSurferAnnotMeshIO",
+                         "FreeSurfer Annot Mesh IO",
+                         1,
+                         CreateObjectFunction< FreeSurferAnnotMeshIO >::New() );
+}
+
+FreeSurferAnnotMeshIOFactory::~FreeSurferAnnotMeshIOFactory()
+{}
+
+const char * FreeSurferAnnotMeshIOFactory::GetITKSourceVersion(void) const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char * FreeSurferAnnotMeshIOFactory::GetDescription() const
+{
+  return "FreeSurfer ANNOT Mesh IO Factory, allows the loading of FreeSurfer annotations into insight";
+}
+} // end namespace itk
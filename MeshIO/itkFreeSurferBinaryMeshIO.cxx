@@ -28,15 +28,106 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 
+// The byte swap kernels need the target attribute to be built for any
+// x86 processor, and are chosen at run time
+#if ( defined( __clang__ ) || ( defined( __GNUC__ ) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) ) ) ) \
+  && ( defined( __x86_64__ ) || defined( __i386__ ) ) && !defined( ITK_FREESURFER_NO_SIMD )
+#define ITK_FREESURFER_SIMD
+#include <immintrin.h>
+#endif
+
 namespace itk
 {
+namespace
+{
+/** Magic numbers of triangle surface and curvature files, in their three
+ * first bytes. */
+const itk::uint32_t TriangleFileIdentifier = ( -2 & 0x00ffffff );
+const itk::uint32_t CurvatureFileIdentifier = ( -1 & 0x00ffffff );
+
+itk::uint32_t ReadBigEndianWord(const unsigned char *input)
+{
+  return ( static_cast< itk::uint32_t >( input[0] ) << 24 ) | ( static_cast< itk::uint32_t >( input[1] ) << 16 )
+         | ( static_cast< itk::uint32_t >( input[2] ) << 8 ) | static_cast< itk::uint32_t >( input[3] );
+}
+
+#ifdef ITK_FREESURFER_SIMD
+enum SwapKernel { SCALAR_SWAP, SSSE3_SWAP, AVX2_SWAP };
+
+SwapKernel DetectSwapKernel()
+{
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports("avx2") )
+    {
+    return AVX2_SWAP;
+    }
+  if ( __builtin_cpu_supports("ssse3") )
+    {
+    return SSSE3_SWAP;
+    }
+  return SCALAR_SWAP;
+}
+
+SwapKernel GetSwapKernel()
+{
+  // The kernel is detected once. GCC and Clang, the only compilers of this
+  // code, guard the initialization of local statics against other threads.
+  static const SwapKernel kernel = DetectSwapKernel();
+
+  return kernel;
+}
+
+/** Swap the words of the blocks of 16 bytes, return the number of words
+ * swapped. */
+__attribute__( ( target("ssse3") ) )
+MeshIOBase::SizeValueType SwapWordsSSSE3(const unsigned char *input, unsigned char *output, MeshIOBase::SizeValueType numberOfWords)
+{
+  const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  MeshIOBase::SizeValueType ii = 0;
+
+  for (; ii + 4 <= numberOfWords; ii += 4 )
+    {
+    const __m128i words = _mm_loadu_si128( reinterpret_cast< const __m128i * >( input + 4 * ii ) );
+    _mm_storeu_si128( reinterpret_cast< __m128i * >( output + 4 * ii ), _mm_shuffle_epi8(words, shuffle) );
+    }
+  return ii;
+}
+
+/** Swap the words of the blocks of 64 bytes, return the number of words
+ * swapped. */
+__attribute__( ( target("avx2") ) )
+MeshIOBase::SizeValueType SwapWordsAVX2(const unsigned char *input, unsigned char *output, MeshIOBase::SizeValueType numberOfWords)
+{
+  const __m256i shuffle = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                           3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  MeshIOBase::SizeValueType ii = 0;
+
+  for (; ii + 16 <= numberOfWords; ii += 16 )
+    {
+    const __m256i words0 = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( input + 4 * ii ) );
+    const __m256i words1 = _mm256_loadu_si256( reinterpret_cast< const __m256i * >( input + 4 * ii + 32 ) );
+    _mm256_storeu_si256( reinterpret_cast< __m256i * >( output + 4 * ii ), _mm256_shuffle_epi8(words0, shuffle) );
+    _mm256_storeu_si256( reinterpret_cast< __m256i * >( output + 4 * ii + 32 ), _mm256_shuffle_epi8(words1, shuffle) );
+    }
+  return ii;
+}
+#endif
+}
+
 FreeSurferBinaryMeshIO::FreeSurferBinaryMeshIO()
 {
   this->AddSupportedWriteExtension(".fsb");
   this->AddSupportedWriteExtension(".fcv");
   m_FilePosition = 0;
+  m_FileTypeIdentifier = 0;
+}
+
+FreeSurferBinaryMeshIO::~FreeSurferBinaryMeshIO()
+{
+  CloseFile();
 }
 
 bool FreeSurferBinaryMeshIO::CanReadFile(const char *fileName)
@@ -46,13 +137,24 @@ bool FreeSurferBinaryMeshIO::CanReadFile(const char *fileName)
     return false;
     }
 
-  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) != ".fsb"
-       && itksys::SystemTools::GetFilenameLastExtension(fileName) != ".fcv" )
+  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) == ".fsb"
+       || itksys::SystemTools::GetFilenameLastExtension(fileName) == ".fcv" )
+    {
+    return true;
+    }
+
+  // FreeSurfer names its files lh.pial, rh.thickness, ..., look for the
+  // magic number instead
+  std::ifstream inputFile(fileName, std::ios::binary);
+  unsigned char fileTypeId[3];
+  if ( !inputFile.read(reinterpret_cast< char * >( fileTypeId ), 3) )
     {
     return false;
     }
 
-  return true;
+  const itk::uint32_t fileTypeIdentifier = ( static_cast< itk::uint32_t >( fileTypeId[0] ) << 16 )
+                                           | ( static_cast< itk::uint32_t >( fileTypeId[1] ) << 8 ) | fileTypeId[2];
+  return fileTypeIdentifier == TriangleFileIdentifier || fileTypeIdentifier == CurvatureFileIdentifier;
 }
 
 bool FreeSurferBinaryMeshIO::CanWriteFile(const char *fileName)
@@ -68,6 +170,11 @@ bool FreeSurferBinaryMeshIO::CanWriteFile(const char *fileName)
 
 void FreeSurferBinaryMeshIO::OpenFile()
 {
+  if ( m_File.IsOpen() )
+    {
+    return;
+    }
+
   if ( this->m_FileName.empty() )
     {
     itkExceptionMacro("No input FileName");
@@ -78,9 +185,7 @@ void FreeSurferBinaryMeshIO::OpenFile()
     itkExceptionMacro("File " << this->m_FileName << " does not exist");
     }
 
-  m_InputFile.open(this->m_FileName.c_str(), std::ios::binary);
-
-  if ( !this->m_InputFile.is_open() )
+  if ( !m_File.Open(this->m_FileName) )
     {
     itkExceptionMacro("Unable to open file inputFile " << this->m_FileName);
     }
@@ -90,71 +195,88 @@ void FreeSurferBinaryMeshIO::OpenFile()
 
 void FreeSurferBinaryMeshIO::CloseFile()
 {
-  if ( m_InputFile.is_open() )
+  m_File.Close();
+}
+
+const unsigned char * FreeSurferBinaryMeshIO::GetFileData(StreamOffsetType offset, SizeValueType size)
+{
+  OpenFile();
+
+  if ( !m_File.Holds(offset, size) )
+    {
+    itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold " << size
+                      << " bytes at offset " << offset);
+    }
+
+  return m_File.GetData() + offset;
+}
+
+void FreeSurferBinaryMeshIO::SwapWordsFromBigEndian(const unsigned char *input, void *output, SizeValueType numberOfWords)
+{
+  unsigned char *outputBytes = static_cast< unsigned char * >( output );
+  SizeValueType  ii = 0;
+
+#ifdef ITK_FREESURFER_SIMD
+  switch ( GetSwapKernel() )
+    {
+    case AVX2_SWAP:
+      ii = SwapWordsAVX2(input, outputBytes, numberOfWords);
+      break;
+    case SSSE3_SWAP:
+      ii = SwapWordsSSSE3(input, outputBytes, numberOfWords);
+      break;
+    default:
+      break;
+    }
+#endif
+
+  for (; ii < numberOfWords; ii++ )
     {
-    m_InputFile.close();
+    const itk::uint32_t word = ReadBigEndianWord(input + 4 * ii);
+    std::memcpy( outputBytes + 4 * ii, &word, sizeof( word ) );
     }
 }
 
 void FreeSurferBinaryMeshIO::ReadMeshInformation()
 {
-  // Define input file stream and attach it to input file
+  // Map the input file, it is released when all the data has been read
+  CloseFile();
   OpenFile();
 
   // Define required variables
-  const unsigned int numberOfCellPoints = 3;
-  const unsigned int fileTypeIdLength = 3;
-  unsigned char      fileTypeId[fileTypeIdLength];
+  const unsigned int   numberOfCellPoints = 3;
+  const unsigned int   fileTypeIdLength = 3;
+  const unsigned char *fileTypeId = GetFileData(0, fileTypeIdLength);
   this->m_FileType = BINARY;
 
   // Read file type
-  m_InputFile.read(reinterpret_cast< char * >( fileTypeId ), fileTypeIdLength);
-  m_FileTypeIdentifier = 0;
-  m_FileTypeIdentifier <<= 8;
-
-  m_FileTypeIdentifier |= fileTypeId[0];
-  m_FileTypeIdentifier <<= 8;
-
-  m_FileTypeIdentifier |= fileTypeId[1];
-  m_FileTypeIdentifier <<= 8;
-
-  m_FileTypeIdentifier |= fileTypeId[2];
+  m_FileTypeIdentifier = ( static_cast< itk::uint32_t >( fileTypeId[0] ) << 16 )
+                         | ( static_cast< itk::uint32_t >( fileTypeId[1] ) << 8 ) | fileTypeId[2];
+  StreamOffsetType position = fileTypeIdLength;
 
   // If input file is freesurfer binary surface file
-  if ( m_FileTypeIdentifier == ( -2 & 0x00ffffff ) )
+  if ( m_FileTypeIdentifier == TriangleFileIdentifier )
     {
-    // Read input commend
-    char byte;
-
-    //  Extract Comment, and ignore it.
-    byte = m_InputFile.get();
-
-    std::string comment = "";
-
-    while ( byte != '\n' )
+    //  Skip the comment, it ends with '\n'
+    const unsigned char *comment = m_File.GetData() + position;
+    const void *         commentEnd = std::memchr(comment, '\n', m_File.GetLength() - position);
+    if ( !commentEnd )
       {
-      comment += byte;
-      byte = m_InputFile.get();
+      itkExceptionMacro(<< "No end of comment in file " << this->m_FileName);
       }
+    position += static_cast< const unsigned char * >( commentEnd ) - comment + 1;
 
-    // Try to get the second '\n', but if the '\n' is not there, we put the byte
-    // back.
-    byte = m_InputFile.get();
-    if ( byte != '\n' )
+    // Skip the second '\n' if it is there
+    if ( static_cast< SizeValueType >( position ) < m_File.GetLength() && m_File.GetData()[position] == '\n' )
       {
-      m_InputFile.unget();
+      position++;
       }
 
     // Read the number of points and number of cells
-    itk::uint32_t numberOfPoints;
-    m_InputFile.read( (char *)( &numberOfPoints ), sizeof( numberOfPoints ) );
-    itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToBigEndian(&numberOfPoints);
-    this->m_NumberOfPoints = static_cast< unsigned long int >( numberOfPoints );
-
-    itk::uint32_t numberOfCells;
-    m_InputFile.read( (char *)( &numberOfCells ), sizeof( numberOfCells ) );
-    itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToBigEndian(&numberOfCells);
-    this->m_NumberOfCells = static_cast< unsigned long int >( numberOfCells );
+    const unsigned char *header = GetFileData(position, 2 * sizeof( itk::uint32_t ));
+    this->m_NumberOfPoints = static_cast< unsigned long int >( ReadBigEndianWord(header) );
+    this->m_NumberOfCells = static_cast< unsigned long int >( ReadBigEndianWord(header + 4) );
+    position += 2 * sizeof( itk::uint32_t );
 
     this->m_PointDimension = 3;
 
@@ -177,10 +299,10 @@ void FreeSurferBinaryMeshIO::ReadMeshInformation()
     this->m_CellComponentType  = UINT;
     this->m_CellBufferSize = this->m_NumberOfCells * ( numberOfCellPoints + 2 );
 
-    m_FilePosition = m_InputFile.tellg();
+    m_FilePosition = position;
     }
   // If input file is curvature file
-  else if ( m_FileTypeIdentifier == ( -1 & 0x00ffffff ) )
+  else if ( m_FileTypeIdentifier == CurvatureFileIdentifier )
     {
     // Set corresponding flags
     this->m_UpdatePoints  = false;
@@ -188,26 +310,17 @@ void FreeSurferBinaryMeshIO::ReadMeshInformation()
     this->m_UpdatePointData = true;
     this->m_UpdateCellData  = false;
 
-    // Read numberOfValuesPerPoint and numberOfPoints and numberOfCells
-    itk::uint32_t numberOfPoints;
-    m_InputFile.read( (char *)( &numberOfPoints ), sizeof( numberOfPoints ) );
-    itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToBigEndian(&numberOfPoints);
-    this->m_NumberOfPoints = static_cast< unsigned long int >( numberOfPoints );
+    // Read numberOfPoints, numberOfCells and numberOfValuesPerPoint
+    const unsigned char *header = GetFileData(position, 3 * sizeof( itk::uint32_t ));
+    this->m_NumberOfPoints = static_cast< unsigned long int >( ReadBigEndianWord(header) );
     this->m_NumberOfPointPixels = this->m_NumberOfPoints;
+    this->m_NumberOfCells = static_cast< unsigned long int >( ReadBigEndianWord(header + 4) );
 
-    itk::uint32_t numberOfCells;
-    m_InputFile.read( (char *)( &numberOfCells ), sizeof( numberOfCells ) );
-    itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToBigEndian(&numberOfCells);
-    this->m_NumberOfCells = static_cast< unsigned long int >( numberOfCells );
-
-    itk::uint32_t numberOfValuesPerPoint;
-    m_InputFile.read( (char *)( &numberOfValuesPerPoint ), sizeof( numberOfValuesPerPoint ) );
-    itk::ByteSwapper< itk::uint32_t >::SwapFromSystemToBigEndian(&numberOfValuesPerPoint);
-
-    m_FilePosition = m_InputFile.tellg();
+    m_FilePosition = position + 3 * sizeof( itk::uint32_t );
     }
   else
     {
+    CloseFile();
     itkExceptionMacro(<< "Unvalid file type " << m_FileTypeIdentifier);
     }
 
@@ -221,34 +334,54 @@ void FreeSurferBinaryMeshIO::ReadMeshInformation()
   this->m_NumberOfCellPixelComponents = itk::NumericTraits< unsigned int >::One;
   this->m_CellPixelType  = SCALAR;
 
-  CloseFile();
+  // Nothing else is read from an empty surface
+  if ( !this->m_UpdatePoints && !this->m_UpdateCells && !this->m_UpdatePointData )
+    {
+    CloseFile();
+    }
   return;
 }
 
 void FreeSurferBinaryMeshIO::ReadPoints(void *buffer)
 {
-  OpenFile();
-  m_InputFile.seekg(m_FilePosition, std::ios::beg);
+  const SizeValueType numberOfComponents = this->m_NumberOfPoints * this->m_PointDimension;
 
-  // Number of data array
-  float *data = static_cast< float * >( buffer );
-
-  m_InputFile.read( static_cast< char * >( buffer ), this->m_NumberOfPoints * this->m_PointDimension * sizeof( float ) );
-  itk::ByteSwapper< float >::SwapRangeFromSystemToBigEndian(data, this->m_NumberOfPoints * this->m_PointDimension);
+  SwapWordsFromBigEndian(GetFileData( m_FilePosition, numberOfComponents * sizeof( float ) ), buffer, numberOfComponents);
 
+  if ( !this->m_UpdateCells )
+    {
+    CloseFile();
+    }
   return;
 }
 
 void FreeSurferBinaryMeshIO::ReadCells(void *buffer)
 {
-  const unsigned int numberOfCellPoints = 3;
-  itk::uint32_t *    data = new itk::uint32_t[this->m_NumberOfCells * numberOfCellPoints];
+  const unsigned int  numberOfCellPoints = 3;
+  const SizeValueType numberOfPointIds = this->m_NumberOfCells * numberOfCellPoints;
+  unsigned int *      data = static_cast< unsigned int * >( buffer );
 
-  m_InputFile.read( reinterpret_cast< char * >( data ), this->m_NumberOfCells * numberOfCellPoints * sizeof( itk::uint32_t ) );
-  itk::ByteSwapper< itk::uint32_t >::SwapRangeFromSystemToBigEndian(data, this->m_NumberOfCells * numberOfCellPoints);
+  // The triangles follow the points
+  const StreamOffsetType cellsPosition =
+    m_FilePosition + static_cast< StreamOffsetType >( this->m_NumberOfPoints * this->m_PointDimension * sizeof( float ) );
 
-  this->WriteCellsBuffer(data, static_cast< unsigned int * >( buffer ), TRIANGLE_CELL, 3, this->m_NumberOfCells);
-  delete[] data;
+  // Swap the point identifiers into the end of the buffer, then spread them
+  // in place from the front. The identifiers of a cell are read before they
+  // are overwritten, as a cell takes 2 more elements in the output.
+  unsigned int *pointIds = data + 2 * this->m_NumberOfCells;
+  SwapWordsFromBigEndian(GetFileData( cellsPosition, numberOfPointIds * sizeof( itk::uint32_t ) ), pointIds, numberOfPointIds);
+
+  for ( SizeValueType ii = 0; ii < this->m_NumberOfCells; ii++ )
+    {
+    const unsigned int id0 = pointIds[3 * ii];
+    const unsigned int id1 = pointIds[3 * ii + 1];
+    const unsigned int id2 = pointIds[3 * ii + 2];
+    data[5 * ii] = static_cast< unsigned int >( TRIANGLE_CELL );
+    data[5 * ii + 1] = numberOfCellPoints;
+    data[5 * ii + 2] = id0;
+    data[5 * ii + 3] = id1;
+    data[5 * ii + 4] = id2;
+    }
 
   CloseFile();
 
@@ -257,18 +390,36 @@ void FreeSurferBinaryMeshIO::ReadCells(void *buffer)
 
 void FreeSurferBinaryMeshIO::ReadPointData(void *buffer)
 {
-  OpenFile();
-  m_InputFile.seekg(m_FilePosition, std::ios::beg);
-
-  float *data = static_cast< float * >( buffer );
-
-  m_InputFile.read( reinterpret_cast< char * >( data ), this->m_NumberOfPointPixels * sizeof( float ) );
-  itk::ByteSwapper< float >::SwapRangeFromSystemToBigEndian(data, this->m_NumberOfPointPixels);
+  ReadPointDataRange(static_cast< float * >( buffer ), 0, this->m_NumberOfPointPixels, 1);
 
   CloseFile();
   return;
 }
 
+void FreeSurferBinaryMeshIO::ReadPointDataRange(float *buffer, SizeValueType firstPoint, SizeValueType numberOfPoints,
+                                                unsigned int numberOfComponents)
+{
+  if ( firstPoint > this->m_NumberOfPointPixels || numberOfPoints > this->m_NumberOfPointPixels - firstPoint )
+    {
+    itkExceptionMacro(<< "Points " << firstPoint << " to " << firstPoint + numberOfPoints << " are out of the "
+                      << this->m_NumberOfPointPixels << " points of file " << this->m_FileName);
+    }
+
+  const unsigned char *data = GetFileData(m_FilePosition + static_cast< StreamOffsetType >( firstPoint * sizeof( float ) ),
+                                          numberOfPoints * sizeof( float ) );
+  if ( numberOfComponents == 1 )
+    {
+    SwapWordsFromBigEndian(data, buffer, numberOfPoints);
+    return;
+    }
+
+  for ( SizeValueType ii = 0; ii < numberOfPoints; ii++ )
+    {
+    const itk::uint32_t word = ReadBigEndianWord(data + 4 * ii);
+    std::memcpy( buffer + ii * numberOfComponents, &word, sizeof( word ) );
+    }
+}
+
 void FreeSurferBinaryMeshIO::ReadCellData(void *buffer)
 {
   return;
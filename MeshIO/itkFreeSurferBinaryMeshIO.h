@@ -25,6 +25,7 @@
 
 #include "itkByteSwapper.h"
 #include "itkMeshIOBase.h"
+#include "itkMeshIOMappedFile.h"
 #include "itkIntTypes.h"
 
 #include <fstream>
@@ -35,6 +36,11 @@ namespace itk
 {
 /** \class FreeSurferBinaryMeshIO
   * Freesurfer binary surface data format, the suffix is set as *.fsb
+ *
+ * Curvature files use the suffix *.fcv. Files named as FreeSurfer names
+ * them (lh.pial, rh.thickness, ...) are recognized by their magic number.
+ * The file is memory mapped while it is read, and the big endian values are
+ * byte swapped from the mapping straight into the buffers of the reader.
  * \ingroup IOFilters
  */
 
@@ -75,6 +81,19 @@ public:
 
   virtual void ReadCellData(void *buffer);
 
+  /** Read the point data of numberOfPoints points from firstPoint, into
+   * one component of pixels of numberOfComponents components: the value of
+   * point firstPoint + ii goes to buffer[ii * numberOfComponents]. Several
+   * threads may call it at once between ReadMeshInformation() and
+   * ReadPointData(), which closes the file. */
+  void ReadPointDataRange(float *buffer, SizeValueType firstPoint, SizeValueType numberOfPoints,
+                          unsigned int numberOfComponents);
+
+  /** Copy numberOfWords 4 bytes big endian words from input to output,
+   * in the byte order of this machine. Output may be input, to swap the
+   * words in place. */
+  static void SwapWordsFromBigEndian(const unsigned char *input, void *output, SizeValueType numberOfWords);
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine if the file can be written with this MeshIO implementation.
@@ -167,21 +186,27 @@ protected:
 
 protected:
   FreeSurferBinaryMeshIO();
-  virtual ~FreeSurferBinaryMeshIO(){}
+  virtual ~FreeSurferBinaryMeshIO();
 
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Map the input file in memory, or read it whole if it cannot be
+   * mapped. Nothing is done if the file is already open. */
   void OpenFile();
 
   void CloseFile();
 
+  /** Return the size bytes of the open file starting at offset, throw
+   * an exception if the file is too short. */
+  const unsigned char * GetFileData(StreamOffsetType offset, SizeValueType size);
+
 private:
   FreeSurferBinaryMeshIO(const Self &); // purposely not implemented
   void operator=(const Self &);         // purposely not implemented
 
   StreamOffsetType m_FilePosition;
   itk::uint32_t    m_FileTypeIdentifier;
-  std::ifstream    m_InputFile;
+  MeshIOMappedFile m_File;
 };
 } // end namespace itk
 
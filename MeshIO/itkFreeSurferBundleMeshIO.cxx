@@ -0,0 +1,247 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkExceptionObject.h"
+#include "itkFreeSurferBundleMeshIO.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+
+namespace itk
+{
+FreeSurferBundleMeshIO::FreeSurferBundleMeshIO()
+{
+  this->m_FileType = BINARY;
+}
+
+void FreeSurferBundleMeshIO::AddOverlayFileName(const char *fileName)
+{
+  m_OverlayFileNames.push_back(fileName);
+  this->Modified();
+}
+
+void FreeSurferBundleMeshIO::SetOverlayFileNames(const std::vector< std::string > & fileNames)
+{
+  m_OverlayFileNames = fileNames;
+  this->Modified();
+}
+
+const std::vector< std::string > & FreeSurferBundleMeshIO::GetOverlayFileNames() const
+{
+  return m_OverlayFileNames;
+}
+
+void FreeSurferBundleMeshIO::ClearOverlayFileNames()
+{
+  m_OverlayFileNames.clear();
+  this->Modified();
+}
+
+bool FreeSurferBundleMeshIO::CanReadFile(const char *fileName)
+{
+  FreeSurferBinaryMeshIO::Pointer surfaceMeshIO = FreeSurferBinaryMeshIO::New();
+
+  return surfaceMeshIO->CanReadFile(fileName);
+}
+
+bool FreeSurferBundleMeshIO::CanWriteFile(const char *)
+{
+  return false;
+}
+
+void FreeSurferBundleMeshIO::ReadMeshInformation()
+{
+  m_OverlayMeshIOs.clear();
+
+  // Read the geometry
+  m_SurfaceMeshIO = FreeSurferBinaryMeshIO::New();
+  m_SurfaceMeshIO->SetFileName( this->m_FileName.c_str() );
+  m_SurfaceMeshIO->ReadMeshInformation();
+
+  if ( !m_SurfaceMeshIO->GetUpdatePoints() )
+    {
+    itkExceptionMacro(<< "File " << this->m_FileName << " is not a surface");
+    }
+
+  this->m_NumberOfPoints = m_SurfaceMeshIO->GetNumberOfPoints();
+  this->m_NumberOfCells = m_SurfaceMeshIO->GetNumberOfCells();
+  this->m_PointDimension = m_SurfaceMeshIO->GetPointDimension();
+  this->m_PointComponentType = m_SurfaceMeshIO->GetPointComponentType();
+  this->m_CellComponentType = m_SurfaceMeshIO->GetCellComponentType();
+  this->m_CellBufferSize = m_SurfaceMeshIO->GetCellBufferSize();
+  this->m_UpdatePoints = m_SurfaceMeshIO->GetUpdatePoints();
+  this->m_UpdateCells = m_SurfaceMeshIO->GetUpdateCells();
+
+  // Validate the overlays against the surface from their headers, their
+  // values are read with the point data
+  for ( size_t ii = 0; ii < m_OverlayFileNames.size(); ii++ )
+    {
+    FreeSurferBinaryMeshIO::Pointer overlayMeshIO = FreeSurferBinaryMeshIO::New();
+    overlayMeshIO->SetFileName( m_OverlayFileNames[ii].c_str() );
+    overlayMeshIO->ReadMeshInformation();
+
+    if ( overlayMeshIO->GetUpdatePoints() || !overlayMeshIO->GetUpdatePointData() )
+      {
+      itkExceptionMacro(<< "Overlay " << m_OverlayFileNames[ii] << " is not a curvature file");
+      }
+
+    if ( overlayMeshIO->GetNumberOfPointPixels() != this->m_NumberOfPoints )
+      {
+      itkExceptionMacro(<< "Overlay " << m_OverlayFileNames[ii] << " has " << overlayMeshIO->GetNumberOfPointPixels()
+                        << " values, surface " << this->m_FileName << " has " << this->m_NumberOfPoints << " vertices");
+      }
+
+    m_OverlayMeshIOs.push_back(overlayMeshIO);
+    }
+
+  // One point data component per overlay
+  this->m_UpdatePointData = !m_OverlayMeshIOs.empty();
+  this->m_UpdateCellData = false;
+  this->m_NumberOfPointPixels = this->m_UpdatePointData ? this->m_NumberOfPoints : 0;
+  this->m_PointPixelComponentType = FLOAT;
+  this->m_NumberOfPointPixelComponents = static_cast< unsigned int >( m_OverlayMeshIOs.size() );
+  this->m_PointPixelType = VARIABLELENGTHVECTOR;
+
+  this->m_NumberOfCellPixels = 0;
+  this->m_CellPixelComponentType = FLOAT;
+  this->m_NumberOfCellPixelComponents = itk::NumericTraits< unsigned int >::One;
+  this->m_CellPixelType = SCALAR;
+}
+
+void FreeSurferBundleMeshIO::ReadPoints(void *buffer)
+{
+  m_SurfaceMeshIO->ReadPoints(buffer);
+}
+
+void FreeSurferBundleMeshIO::ReadCells(void *buffer)
+{
+  m_SurfaceMeshIO->ReadCells(buffer);
+}
+
+ITK_THREAD_RETURN_TYPE FreeSurferBundleMeshIO::ReadOverlaysThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ReadOverlaysStruct *             str = static_cast< ReadOverlaysStruct * >( info->UserData );
+
+  const unsigned int  numberOfOverlays = static_cast< unsigned int >( str->Overlays.size() );
+  const SizeValueType firstPoint = str->NumberOfPoints * info->ThreadID / info->NumberOfThreads;
+  const SizeValueType lastPoint = str->NumberOfPoints * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  // Fill the pixels by blocks, from every overlay in turn, so that each
+  // block stays in cache while its components are written
+  const SizeValueType blockSize = 1024;
+  try
+    {
+    for ( SizeValueType point = firstPoint; point < lastPoint; point += blockSize )
+      {
+      const SizeValueType numberOfPoints = std::min(blockSize, lastPoint - point);
+      for ( unsigned int jj = 0; jj < numberOfOverlays; jj++ )
+        {
+        str->Overlays[jj]->ReadPointDataRange(str->Output + point * numberOfOverlays + jj, point, numberOfPoints,
+                                              numberOfOverlays);
+        }
+      }
+    }
+  catch ( ExceptionObject & err )
+    {
+    str->ExceptionMessages[info->ThreadID] = err.GetDescription();
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void FreeSurferBundleMeshIO::ReadPointData(void *buffer)
+{
+  ReadOverlaysStruct str;
+  str.Output = static_cast< float * >( buffer );
+  str.NumberOfPoints = this->m_NumberOfPointPixels;
+  for ( size_t ii = 0; ii < m_OverlayMeshIOs.size(); ii++ )
+    {
+    str.Overlays.push_back( m_OverlayMeshIOs[ii].GetPointer() );
+    }
+
+  // The overlays are mapped since ReadMeshInformation(), the threads all
+  // read from them at once
+  MultiThreader::Pointer threader = MultiThreader::New();
+  const int              numberOfThreads = static_cast< int >( std::min(
+                                                                 static_cast< SizeValueType >( this->m_NumberOfThreads ),
+                                                                 std::max(str.NumberOfPoints / 4096,
+                                                                          static_cast< SizeValueType >( 1 ) ) ) );
+  threader->SetNumberOfThreads(numberOfThreads);
+  str.ExceptionMessages.resize( threader->GetNumberOfThreads() );
+  threader->SetSingleMethod(&Self::ReadOverlaysThreaderCallback, &str);
+  threader->SingleMethodExecute();
+
+  // Release the overlays
+  m_OverlayMeshIOs.clear();
+
+  for ( size_t ii = 0; ii < str.ExceptionMessages.size(); ii++ )
+    {
+    if ( !str.ExceptionMessages[ii].empty() )
+      {
+      itkExceptionMacro(<< str.ExceptionMessages[ii]);
+      }
+    }
+}
+
+void FreeSurferBundleMeshIO::ReadCellData(void *)
+{
+  return;
+}
+
+void FreeSurferBundleMeshIO::WriteMeshInformation()
+{
+  itkExceptionMacro(<< "FreeSurferBundleMeshIO does not write");
+}
+
+void FreeSurferBundleMeshIO::WritePoints(void *)
+{
+  itkExceptionMacro(<< "FreeSurferBundleMeshIO does not write");
+}
+
+void FreeSurferBundleMeshIO::WriteCells(void *)
+{
+  itkExceptionMacro(<< "FreeSurferBundleMeshIO does not write");
+}
+
+void FreeSurferBundleMeshIO::WritePointData(void *)
+{
+  itkExceptionMacro(<< "FreeSurferBundleMeshIO does not write");
+}
+
+void FreeSurferBundleMeshIO::WriteCellData(void *)
+{
+  itkExceptionMacro(<< "FreeSurferBundleMeshIO does not write");
+}
+
+void FreeSurferBundleMeshIO::Write()
+{
+  itkExceptionMacro(<< "FreeSurferBundleMeshIO does not write");
+}
+
+void FreeSurferBundleMeshIO::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Overlay file names :" << std::endl;
+  for ( size_t ii = 0; ii < m_OverlayFileNames.size(); ii++ )
+    {
+    os << indent.GetNextIndent() << m_OverlayFileNames[ii] << std::endl;
+    }
+}
+} // namespace itk end
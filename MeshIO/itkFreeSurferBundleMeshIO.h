@@ -0,0 +1,133 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkFreeSurferBundleMeshIO_h
+#define __itkFreeSurferBundleMeshIO_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkFreeSurferBinaryMeshIO.h"
+#include "itkMeshIOBase.h"
+#include "itkMultiThreader.h"
+
+#include <string>
+#include <vector>
+
+namespace itk
+{
+/** \class FreeSurferBundleMeshIO
+ * Read a FreeSurfer surface together with overlays of its vertices
+ * (thickness, curv, sulc, area, ...) as one mesh. The point data pixels
+ * are variable length vectors with one component per overlay, in the order
+ * the overlays were added.
+ *
+ * The geometry is read once, from the file name set, and the overlays are
+ * read concurrently. Each overlay must be a curvature file with one value
+ * for each vertex of the surface, as told by its header. The files are read
+ * with FreeSurferBinaryMeshIO. This MeshIO does not write.
+ * \ingroup IOFilters
+ */
+
+class ITK_EXPORT FreeSurferBundleMeshIO:public MeshIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef FreeSurferBundleMeshIO     Self;
+  typedef MeshIOBase                 Superclass;
+  typedef SmartPointer< const Self > ConstPointer;
+  typedef SmartPointer< Self >       Pointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FreeSurferBundleMeshIO, MeshIOBase);
+
+  /** Overlays read as the components of the point data. */
+  void AddOverlayFileName(const char *fileName);
+  void SetOverlayFileNames(const std::vector< std::string > & fileNames);
+  const std::vector< std::string > & GetOverlayFileNames() const;
+  void ClearOverlayFileNames();
+
+  /*-------- This part of the interfaces deals with reading data. ----- */
+
+  /** Determine if the file can be read with this MeshIO implementation.
+   * \param FileNameToRead The name of the surface file to test for reading.
+   * \return Returns true if this MeshIO can read the file specified.
+   */
+  virtual bool CanReadFile(const char *FileNameToRead);
+
+  /** Read the headers of the surface and of all the overlays. */
+  virtual void ReadMeshInformation();
+
+  /** Reads the data from disk into the memory buffer provided. */
+  virtual void ReadPoints(void *buffer);
+
+  virtual void ReadCells(void *buffer);
+
+  virtual void ReadPointData(void *buffer);
+
+  virtual void ReadCellData(void *buffer);
+
+  /*-------- This part of the interfaces deals with writing data. ----- */
+
+  /** Return false, this MeshIO does not write. */
+  virtual bool CanWriteFile(const char *FileNameToWrite);
+
+  virtual void WriteMeshInformation();
+
+  virtual void WritePoints(void *buffer);
+
+  virtual void WriteCells(void *buffer);
+
+  virtual void WritePointData(void *buffer);
+
+  virtual void WriteCellData(void *buffer);
+
+  virtual void Write();
+
+protected:
+  FreeSurferBundleMeshIO();
+  virtual ~FreeSurferBundleMeshIO(){}
+
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Overlays read into the point data by the threads of a MultiThreader */
+  struct ReadOverlaysStruct
+    {
+    std::vector< FreeSurferBinaryMeshIO * > Overlays;
+    float *                                 Output;
+    SizeValueType                           NumberOfPoints;
+    std::vector< std::string >              ExceptionMessages;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ReadOverlaysThreaderCallback(void *arg);
+
+private:
+  FreeSurferBundleMeshIO(const Self &); // purposely not implemented
+  void operator=(const Self &);         // purposely not implemented
+
+  std::vector< std::string >                     m_OverlayFileNames;
+  FreeSurferBinaryMeshIO::Pointer                m_SurfaceMeshIO;
+  std::vector< FreeSurferBinaryMeshIO::Pointer > m_OverlayMeshIOs;
+};
+} // end namespace itk
+
+#endif
@@ -0,0 +1,468 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkExceptionObject.h"
+#include "itkFreeSurferBinaryMeshIO.h"
+#include "itkFreeSurferMGHMeshIO.h"
+#include "itkIntTypes.h"
+#include "itkNumericTraits.h"
+
+#include "itk_zlib.h"
+#include <itksys/SystemTools.hxx>
+
+#include <cstdio>
+#include <cstring>
+
+namespace itk
+{
+namespace
+{
+// The values follow a header of fixed size, whatever it holds
+const unsigned int HeaderSize = 284;
+
+// Version, width, height, depth, number of frames and type, 4 bytes each
+const unsigned int HeaderWordsSize = 24;
+
+// Types of the values
+const itk::int32_t MRI_UCHAR = 0;
+const itk::int32_t MRI_INT = 1;
+const itk::int32_t MRI_LONG = 2;
+const itk::int32_t MRI_FLOAT = 3;
+const itk::int32_t MRI_SHORT = 4;
+const itk::int32_t MRI_USHRT = 10;
+
+// Size of the blocks inflated at once, a multiple of every value size
+const unsigned int InflateBlockSize = 1 << 18;
+
+itk::int32_t ReadBigEndianWord(const unsigned char *input)
+{
+  return static_cast< itk::int32_t >( ( static_cast< itk::uint32_t >( input[0] ) << 24 )
+                                      | ( static_cast< itk::uint32_t >( input[1] ) << 16 )
+                                      | ( static_cast< itk::uint32_t >( input[2] ) << 8 )
+                                      | static_cast< itk::uint32_t >( input[3] ) );
+}
+
+/** Copy numberOfValues big endian values of valueSize bytes from input to
+ * output, which may be input, in the byte order of this machine. */
+void SwapValuesFromBigEndian(const unsigned char *input, unsigned char *output,
+                             MeshIOBase::SizeValueType numberOfValues, unsigned int valueSize)
+{
+  switch ( valueSize )
+    {
+    case 1:
+      if ( input != output )
+        {
+        std::memcpy(output, input, numberOfValues);
+        }
+      break;
+    case 2:
+      for ( MeshIOBase::SizeValueType ii = 0; ii < numberOfValues; ii++ )
+        {
+        const itk::uint16_t value = static_cast< itk::uint16_t >( ( input[2 * ii] << 8 ) | input[2 * ii + 1] );
+        std::memcpy( output + 2 * ii, &value, sizeof( value ) );
+        }
+      break;
+    default:
+      FreeSurferBinaryMeshIO::SwapWordsFromBigEndian(input, output, numberOfValues);
+      break;
+    }
+}
+}
+
+FreeSurferMGHMeshIO::FreeSurferMGHMeshIO()
+{
+  this->m_FileType = BINARY;
+  m_Compressed = false;
+  m_ValueSize = 4;
+  m_FilePosition = 0;
+  m_CompressedFile = 0;
+}
+
+FreeSurferMGHMeshIO::~FreeSurferMGHMeshIO()
+{
+  CloseFile();
+}
+
+bool FreeSurferMGHMeshIO::IsCompressedFileName(const std::string & fileName)
+{
+  const std::string extension = itksys::SystemTools::GetFilenameLastExtension(fileName);
+
+  if ( extension == ".mgz" )
+    {
+    return true;
+    }
+
+  return extension == ".gz"
+         && itksys::SystemTools::GetFilenameLastExtension( itksys::SystemTools::GetFilenameWithoutLastExtension(fileName) )
+         == ".mgh";
+}
+
+bool FreeSurferMGHMeshIO::CanReadFile(const char *fileName)
+{
+  if ( !itksys::SystemTools::FileExists(fileName, true) )
+    {
+    return false;
+    }
+
+  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) != ".mgh" && !IsCompressedFileName(fileName) )
+    {
+    return false;
+    }
+
+  return true;
+}
+
+bool FreeSurferMGHMeshIO::CanWriteFile(const char *)
+{
+  return false;
+}
+
+void FreeSurferMGHMeshIO::OpenFile()
+{
+  CloseFile();
+
+  if ( this->m_FileName.empty() )
+    {
+    itkExceptionMacro("No input FileName");
+    }
+
+  if ( !itksys::SystemTools::FileExists( this->m_FileName.c_str() ) )
+    {
+    itkExceptionMacro("File " << this->m_FileName << " does not exist");
+    }
+
+  m_Compressed = IsCompressedFileName(this->m_FileName);
+  m_FilePosition = HeaderSize;
+
+  if ( !m_Compressed )
+    {
+    if ( !m_File.Open(this->m_FileName) )
+      {
+      itkExceptionMacro("Unable to open file " << this->m_FileName);
+      }
+    return;
+    }
+
+  gzFile compressedFile = gzopen(this->m_FileName.c_str(), "rb");
+  if ( !compressedFile )
+    {
+    itkExceptionMacro("Unable to open file " << this->m_FileName);
+    }
+  m_CompressedFile = compressedFile;
+
+  // Inflate the header, the values follow
+  unsigned char header[HeaderSize];
+  const int headerSize = gzread(compressedFile, header, HeaderSize);
+  if ( headerSize != static_cast< int >( HeaderSize ) )
+    {
+    int               errorNumber = Z_OK;
+    const std::string errorMessage = gzerror(compressedFile, &errorNumber);
+    CloseFile();
+    if ( headerSize < 0 || ( errorNumber != Z_OK && errorNumber != Z_STREAM_END ) )
+      {
+      itkExceptionMacro(<< "Unable to inflate file " << this->m_FileName << ": " << errorMessage);
+      }
+    itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold a MGH header");
+    }
+}
+
+void FreeSurferMGHMeshIO::CloseFile()
+{
+  m_File.Close();
+
+  if ( m_CompressedFile )
+    {
+    gzclose( static_cast< gzFile >( m_CompressedFile ) );
+    m_CompressedFile = 0;
+    }
+}
+
+void FreeSurferMGHMeshIO::ReadValues(void *output, SizeValueType numberOfValues)
+{
+  unsigned char *     outputBytes = static_cast< unsigned char * >( output );
+  const SizeValueType numberOfBytes = numberOfValues * m_ValueSize;
+
+  if ( !m_Compressed )
+    {
+    if ( !m_File.Holds(m_FilePosition, numberOfBytes) )
+      {
+      itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold " << numberOfBytes
+                        << " bytes at offset " << m_FilePosition);
+      }
+
+    SwapValuesFromBigEndian(m_File.GetData() + m_FilePosition, outputBytes, numberOfValues, m_ValueSize);
+    m_FilePosition += static_cast< StreamOffsetType >( numberOfBytes );
+    return;
+    }
+
+  // Inflate straight into the output, and swap each block before the next
+  // one pushes it out of the cache
+  gzFile compressedFile = static_cast< gzFile >( m_CompressedFile );
+  for ( SizeValueType offset = 0; offset < numberOfBytes; offset += InflateBlockSize )
+    {
+    const unsigned int blockSize = static_cast< unsigned int >(
+      std::min( numberOfBytes - offset, static_cast< SizeValueType >( InflateBlockSize ) ) );
+    const int          inflatedSize = gzread(compressedFile, outputBytes + offset, blockSize);
+
+    if ( inflatedSize != static_cast< int >( blockSize ) )
+      {
+      int         errorNumber = Z_OK;
+      const char *errorMessage = gzerror(compressedFile, &errorNumber);
+      if ( inflatedSize < 0 || errorNumber != Z_OK )
+        {
+        itkExceptionMacro(<< "Unable to inflate file " << this->m_FileName << ": " << errorMessage);
+        }
+      itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold " << numberOfBytes
+                        << " bytes at offset " << m_FilePosition);
+      }
+
+    SwapValuesFromBigEndian(outputBytes + offset, outputBytes + offset, blockSize / m_ValueSize, m_ValueSize);
+    }
+  m_FilePosition += static_cast< StreamOffsetType >( numberOfBytes );
+}
+
+void FreeSurferMGHMeshIO::ReadMeshInformation()
+{
+  CloseFile();
+
+  if ( this->m_FileName.empty() )
+    {
+    itkExceptionMacro("No input FileName");
+    }
+
+  if ( !itksys::SystemTools::FileExists( this->m_FileName.c_str() ) )
+    {
+    itkExceptionMacro("File " << this->m_FileName << " does not exist");
+    }
+
+  // Only the beginning of the header is needed, from the stream of a
+  // compressed file or from the mapping
+  unsigned char header[HeaderWordsSize];
+  m_Compressed = IsCompressedFileName(this->m_FileName);
+  if ( m_Compressed )
+    {
+    gzFile compressedFile = gzopen(this->m_FileName.c_str(), "rb");
+    if ( !compressedFile )
+      {
+      itkExceptionMacro("Unable to open file " << this->m_FileName);
+      }
+    const int   headerSize = gzread(compressedFile, header, HeaderWordsSize);
+    int         errorNumber = Z_OK;
+    std::string errorMessage = gzerror(compressedFile, &errorNumber);
+    gzclose(compressedFile);
+
+    if ( headerSize < 0 || ( errorNumber != Z_OK && errorNumber != Z_STREAM_END ) )
+      {
+      itkExceptionMacro(<< "Unable to inflate file " << this->m_FileName << ": " << errorMessage);
+      }
+    if ( headerSize != static_cast< int >( HeaderWordsSize ) )
+      {
+      itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold a MGH header");
+      }
+    }
+  else
+    {
+    OpenFile();
+    if ( !m_File.Holds(0, HeaderSize) )
+      {
+      CloseFile();
+      itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold a MGH header");
+      }
+    std::memcpy(header, m_File.GetData(), HeaderWordsSize);
+    }
+
+  const itk::int32_t version = ReadBigEndianWord(header);
+  const itk::int32_t width = ReadBigEndianWord(header + 4);
+  const itk::int32_t height = ReadBigEndianWord(header + 8);
+  const itk::int32_t depth = ReadBigEndianWord(header + 12);
+  const itk::int32_t numberOfFrames = ReadBigEndianWord(header + 16);
+  const itk::int32_t type = ReadBigEndianWord(header + 20);
+
+  if ( version != 1 )
+    {
+    CloseFile();
+    itkExceptionMacro(<< "Unsupported MGH version " << version << " in file " << this->m_FileName);
+    }
+
+  if ( width < 1 || height < 1 || depth < 1 || numberOfFrames < 1 )
+    {
+    CloseFile();
+    itkExceptionMacro(<< "Invalid MGH dimensions " << width << " x " << height << " x " << depth << " x "
+                      << numberOfFrames << " in file " << this->m_FileName);
+    }
+
+  switch ( type )
+    {
+    case MRI_UCHAR:
+      this->m_PointPixelComponentType = UCHAR;
+      m_ValueSize = 1;
+      break;
+    case MRI_SHORT:
+      this->m_PointPixelComponentType = SHORT;
+      m_ValueSize = 2;
+      break;
+    case MRI_USHRT:
+      this->m_PointPixelComponentType = USHORT;
+      m_ValueSize = 2;
+      break;
+    case MRI_INT:
+      this->m_PointPixelComponentType = INT;
+      m_ValueSize = 4;
+      break;
+    case MRI_LONG:
+      // FreeSurfer stores these values as the long of the machine writing
+      // them, so their size in the file is not known
+      CloseFile();
+      itkExceptionMacro(<< "MGH files of type MRI_LONG are not supported, file " << this->m_FileName);
+    case MRI_FLOAT:
+      this->m_PointPixelComponentType = FLOAT;
+      m_ValueSize = 4;
+      break;
+    default:
+      CloseFile();
+      itkExceptionMacro(<< "Unsupported MGH type " << type << " in file " << this->m_FileName);
+    }
+
+  // Every voxel is a vertex, whatever the shape of the volume
+  const double dataSize = static_cast< double >( width ) * height * depth * numberOfFrames * m_ValueSize;
+  if ( dataSize > static_cast< double >( NumericTraits< SizeValueType >::max() ) )
+    {
+    CloseFile();
+    itkExceptionMacro(<< "File " << this->m_FileName << " is too large to be read");
+    }
+
+  this->m_NumberOfPoints = static_cast< SizeValueType >( width ) * height * depth;
+  this->m_NumberOfPointPixels = this->m_NumberOfPoints;
+  this->m_NumberOfPointPixelComponents = static_cast< unsigned int >( numberOfFrames );
+  this->m_PointPixelType = numberOfFrames == 1 ? SCALAR : VARIABLELENGTHVECTOR;
+
+  this->m_NumberOfCells = 0;
+  this->m_NumberOfCellPixels = 0;
+  this->m_CellPixelComponentType = FLOAT;
+  this->m_NumberOfCellPixelComponents = 1;
+  this->m_CellPixelType = SCALAR;
+
+  this->m_UpdatePoints = false;
+  this->m_UpdateCells = false;
+  this->m_UpdatePointData = true;
+  this->m_UpdateCellData = false;
+
+  // A mapped file is checked now, and kept for the point data
+  if ( !m_Compressed && !m_File.Holds( HeaderSize, static_cast< SizeValueType >( dataSize ) ) )
+    {
+    CloseFile();
+    itkExceptionMacro(<< "File " << this->m_FileName << " is too short to hold "
+                      << static_cast< SizeValueType >( dataSize ) << " bytes at offset " << HeaderSize);
+    }
+}
+
+void FreeSurferMGHMeshIO::ReadPoints(void *)
+{}
+
+void FreeSurferMGHMeshIO::ReadCells(void *)
+{}
+
+void FreeSurferMGHMeshIO::ReadPointData(void *buffer)
+{
+  if ( !m_File.IsOpen() )
+    {
+    OpenFile();
+    }
+  m_FilePosition = HeaderSize;
+
+  switch ( this->m_PointPixelComponentType )
+    {
+    case UCHAR:
+      ReadFrames( static_cast< unsigned char * >( buffer ) );
+      break;
+    case SHORT:
+      ReadFrames( static_cast< short * >( buffer ) );
+      break;
+    case USHORT:
+      ReadFrames( static_cast< unsigned short * >( buffer ) );
+      break;
+    case INT:
+      ReadFrames( static_cast< int * >( buffer ) );
+      break;
+    case FLOAT:
+      ReadFrames( static_cast< float * >( buffer ) );
+      break;
+    default:
+      itkExceptionMacro(<< "Unknown point pixel component type" << std::endl);
+    }
+
+  // The check value of a compressed file follows the scan parameters after
+  // the values, inflate them so that damaged values are found
+  if ( m_Compressed )
+    {
+    gzFile        compressedFile = static_cast< gzFile >( m_CompressedFile );
+    unsigned char tail[4096];
+    while ( gzread( compressedFile, tail, sizeof( tail ) ) > 0 )
+      {}
+
+    int         errorNumber = Z_OK;
+    const char *errorMessage = gzerror(compressedFile, &errorNumber);
+    if ( errorNumber != Z_OK && errorNumber != Z_STREAM_END )
+      {
+      itkExceptionMacro(<< "Unable to inflate file " << this->m_FileName << ": " << errorMessage);
+      }
+    }
+
+  CloseFile();
+}
+
+void FreeSurferMGHMeshIO::ReadCellData(void *)
+{}
+
+void FreeSurferMGHMeshIO::WriteMeshInformation()
+{
+  itkExceptionMacro(<< "FreeSurferMGHMeshIO does not write");
+}
+
+void FreeSurferMGHMeshIO::WritePoints(void *)
+{
+  itkExceptionMacro(<< "FreeSurferMGHMeshIO does not write");
+}
+
+void FreeSurferMGHMeshIO::WriteCells(void *)
+{
+  itkExceptionMacro(<< "FreeSurferMGHMeshIO does not write");
+}
+
+void FreeSurferMGHMeshIO::WritePointData(void *)
+{
+  itkExceptionMacro(<< "FreeSurferMGHMeshIO does not write");
+}
+
+void FreeSurferMGHMeshIO::WriteCellData(void *)
+{
+  itkExceptionMacro(<< "FreeSurferMGHMeshIO does not write");
+}
+
+void FreeSurferMGHMeshIO::Write()
+{
+  itkExceptionMacro(<< "FreeSurferMGHMeshIO does not write");
+}
+
+void FreeSurferMGHMeshIO::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Compressed : " << ( m_Compressed ? "On" : "Off" ) << std::endl;
+}
+} // namespace itk end
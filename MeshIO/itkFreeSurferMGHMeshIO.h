@@ -0,0 +1,168 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkFreeSurferMGHMeshIO_h
+#define __itkFreeSurferMGHMeshIO_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkMeshIOBase.h"
+#include "itkMeshIOMappedFile.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+/** \class FreeSurferMGHMeshIO
+ * FreeSurfer MGH volumes holding one value per vertex of a surface, the
+ * suffix is set as *.mgh, or *.mgz and *.mgh.gz for gzip compressed files.
+ *
+ * Surface overlays and statistics are stored as width x height x depth
+ * volumes of frames, with one voxel for each vertex. They are read as point
+ * data only: scalar pixels for one frame, variable length vectors with one
+ * component per frame otherwise. The values keep their type in the file
+ * (unsigned char, short, unsigned short, int or float).
+ *
+ * A .mgh file is memory mapped and its values are byte swapped straight into
+ * the point data buffer. A compressed file is inflated block by block into
+ * the buffer, and each block is byte swapped while it is in the cache; the
+ * compressed file is never held in memory. This MeshIO does not write.
+ * \ingroup IOFilters
+ */
+
+class ITK_EXPORT FreeSurferMGHMeshIO:public MeshIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef FreeSurferMGHMeshIO          Self;
+  typedef MeshIOBase                   Superclass;
+  typedef SmartPointer< const Self >   ConstPointer;
+  typedef SmartPointer< Self >         Pointer;
+  typedef Superclass::StreamOffsetType StreamOffsetType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(FreeSurferMGHMeshIO, MeshIOBase);
+
+  /*-------- This part of the interfaces deals with reading data. ----- */
+
+  /** Determine if the file can be read with this MeshIO implementation.
+   * \param FileNameToRead The name of the file to test for reading.
+   * \return Returns true if this MeshIO can read the file specified.
+   */
+  virtual bool CanReadFile(const char *FileNameToRead);
+
+  /** Read the header of the volume. */
+  virtual void ReadMeshInformation();
+
+  /** Reads the data from disk into the memory buffer provided. */
+  virtual void ReadPoints(void *buffer);
+
+  virtual void ReadCells(void *buffer);
+
+  virtual void ReadPointData(void *buffer);
+
+  virtual void ReadCellData(void *buffer);
+
+  /*-------- This part of the interfaces deals with writing data. ----- */
+
+  /** Return false, this MeshIO does not write. */
+  virtual bool CanWriteFile(const char *FileNameToWrite);
+
+  virtual void WriteMeshInformation();
+
+  virtual void WritePoints(void *buffer);
+
+  virtual void WriteCells(void *buffer);
+
+  virtual void WritePointData(void *buffer);
+
+  virtual void WriteCellData(void *buffer);
+
+  virtual void Write();
+
+protected:
+  FreeSurferMGHMeshIO();
+  virtual ~FreeSurferMGHMeshIO();
+
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** Whether the file name is the one of a gzip compressed file. */
+  static bool IsCompressedFileName(const std::string & fileName);
+
+  /** Open the file at the first value of the first frame. */
+  void OpenFile();
+
+  void CloseFile();
+
+  /** Read the next numberOfValues values of the open file into output, in
+   * the byte order of this machine. */
+  void ReadValues(void *output, SizeValueType numberOfValues);
+
+  /** Read all the frames into the point data buffer. The values of a point
+   * are consecutive in the buffer, and the values of a frame are in the
+   * file, so several frames are read through a block of one frame. */
+  template< typename T >
+  void ReadFrames(T *buffer)
+  {
+    const SizeValueType numberOfPoints = this->m_NumberOfPointPixels;
+    const unsigned int  numberOfFrames = this->m_NumberOfPointPixelComponents;
+
+    if ( numberOfFrames == 1 )
+      {
+      ReadValues(buffer, numberOfPoints);
+      return;
+      }
+
+    std::vector< T > block( std::min( numberOfPoints, static_cast< SizeValueType >( 16384 ) ) );
+    for ( unsigned int frame = 0; frame < numberOfFrames; frame++ )
+      {
+      for ( SizeValueType firstPoint = 0; firstPoint < numberOfPoints; firstPoint += block.size() )
+        {
+        const SizeValueType numberOfBlockPoints = std::min( numberOfPoints - firstPoint,
+                                                            static_cast< SizeValueType >( block.size() ) );
+        ReadValues(&block[0], numberOfBlockPoints);
+
+        T *output = buffer + firstPoint * numberOfFrames + frame;
+        for ( SizeValueType ii = 0; ii < numberOfBlockPoints; ii++ )
+          {
+          output[ii * numberOfFrames] = block[ii];
+          }
+        }
+      }
+  }
+
+private:
+  FreeSurferMGHMeshIO(const Self &); // purposely not implemented
+  void operator=(const Self &);      // purposely not implemented
+
+  bool             m_Compressed;
+  unsigned int     m_ValueSize;
+  StreamOffsetType m_FilePosition;
+  MeshIOMappedFile m_File;
+  void *           m_CompressedFile;
+};
+} // end namespace itk
+
+#endif
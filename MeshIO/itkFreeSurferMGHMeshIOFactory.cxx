@@ -0,0 +1,50 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCreateObjectFunction.h"
+#include "itkFreeSurferMGHMeshIO.h"
+#include "itkFreeSurferMGHMeshIOFactory.h"
+#include "itkVersion.h"
+
+namespace itk
+{
+void FreeSurferMGHMeshIOFactory::PrintSelf(std::ostream &, Indent) const
+{}
+
+FreeSurferMGHMeshIOFactory::FreeSurferMGHMeshIOFactory()
+{
+  this->RegisterOverride( "itkMeshIOBase",
+                         "itkFreeSurferMGHMeshIO",
+                         "FreeSurfer MGH Mesh IO",
+                         1,
+                         CreateObjectFunction< FreeSurferMGHMeshIO >::New() );
+}
+
+FreeSurferMGHMeshIOFactory::~FreeSurferMGHMeshIOFactory()
+{}
+
+const char * FreeSurferMGHMeshIOFactory::GetITKSourceVersion(void) const
+{
+  return ITK_SOURCE_VERSION;
+}
+
+const char * FreeSurferMGHMeshIOFactory::GetDescription() const
+{
+  return "FreeSurfer MGH Mesh IO Factory, allows the loading of FreeSurfer surface overlays into insight";
+}
+} // end namespace itk
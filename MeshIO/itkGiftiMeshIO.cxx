@@ -21,6 +21,7 @@
 #include "itkGiftiMeshIO.h"
 
 #include <itksys/SystemTools.hxx>
+#include <algorithm>
 #include <cstdlib>
 
 namespace itk
@@ -29,7 +30,17 @@ GiftiMeshIO::GiftiMeshIO()
 {
   this->AddSupportedWriteExtension(".gii");
   m_ReadPointData = true;
+  m_ReadPointDataFrames = false;
+  m_UseExternalFile = false;
   m_GiftiImage = 0;
+  m_GiftiStream = 0;
+  m_StreamedDataArrays = 0;
+  m_WriteDataArray = -1;
+  m_WriteDataArrayOffset = 0;
+  m_PointsDataArray = -1;
+  m_CellsDataArray = -1;
+  m_PointDataDataArray = -1;
+  m_CellDataDataArray = -1;
   m_Direction.SetIdentity();
   this->m_FileType = BINARY;
   this->m_ByteOrder = BigEndian;
@@ -112,10 +123,336 @@ void GiftiMeshIO::SetLabelNameTable(const LabelNameContainer * labelMap)
   this->Modified();
 }
 
+void GiftiMeshIO::SetFunctionalDataArrays(const std::vector< int > & indices)
+{
+  if ( m_FunctionalDataArrays != indices )
+    {
+    m_FunctionalDataArrays = indices;
+    this->Modified();
+    }
+}
+
+const std::vector< int > & GiftiMeshIO::GetFunctionalDataArrays() const
+{
+  return m_FunctionalDataArrays;
+}
+
+const std::vector< int > & GiftiMeshIO::GetPointDataFrameDataArrays() const
+{
+  return m_PointDataFrameDataArrays;
+}
+
+unsigned int GiftiMeshIO::GetNumberOfDataArrays() const
+{
+  return static_cast< unsigned int >( m_DataArrayIntents.size() );
+}
+
+int GiftiMeshIO::GetDataArrayIntent(unsigned int index) const
+{
+  if ( index >= m_DataArrayIntents.size() )
+    {
+    itkExceptionMacro(<< "DataArray index " << index << " out of range [0, " << m_DataArrayIntents.size() << ")");
+    }
+
+  return m_DataArrayIntents[index];
+}
+
+std::string GiftiMeshIO::GetExternalFileName() const
+{
+  const std::string path = itksys::SystemTools::GetFilenamePath(this->m_FileName);
+  const std::string name = itksys::SystemTools::GetFilenameWithoutLastExtension(this->m_FileName) + ".dat";
+
+  return path.empty() ? name : path + "/" + name;
+}
+
+bool GiftiMeshIO::IsFunctionalDataArraySelected(int index) const
+{
+  return m_FunctionalDataArrays.empty()
+         || std::find(m_FunctionalDataArrays.begin(), m_FunctionalDataArrays.end(), index) != m_FunctionalDataArrays.end();
+}
+
+bool GiftiMeshIO::IsPointDataFrameDataArray(const giiDataArray *dataArray, int index) const
+{
+  // Any functional data array of one value per point, of whatever intent
+  const int intent = dataArray->intent;
+  if ( intent == NIFTI_INTENT_POINTSET || intent == NIFTI_INTENT_TRIANGLE || intent == NIFTI_INTENT_VECTOR
+       || intent == NIFTI_INTENT_LABEL || intent == NIFTI_INTENT_NODE_INDEX )
+    {
+    return false;
+    }
+
+  return this->IsFunctionalDataArraySelected(index)
+         && ( dataArray->num_dim == 1 || ( dataArray->num_dim == 2 && dataArray->dims[1] == 1 ) );
+}
+
+giiDataArray * GiftiMeshIO::ReadGiftiDataArray(int index)
+{
+  if ( index < 0 )
+    {
+    itkExceptionMacro(<< "Missing data array in file " << this->m_FileName);
+    }
+
+  std::vector< int >::const_iterator it = std::find(m_LoadedDataArrays.begin(), m_LoadedDataArrays.end(), index);
+  if ( it == m_LoadedDataArrays.end() )
+    {
+    // Decode the arrays of all the sections to update at once, and only them
+    std::vector< int > dalist;
+    const int          sections[4] = {
+      this->m_UpdatePoints ? m_PointsDataArray : -1,
+      this->m_UpdateCells ? m_CellsDataArray : -1,
+      this->m_UpdatePointData ? m_PointDataDataArray : -1,
+      this->m_UpdateCellData ? m_CellDataDataArray : -1
+      };
+    std::vector< int > sectionDataArrays(sections, sections + 4);
+    if ( this->m_UpdatePointData )
+      {
+      sectionDataArrays.insert( sectionDataArrays.end(), m_PointDataFrameDataArrays.begin(),
+                                m_PointDataFrameDataArrays.end() );
+      }
+    for ( size_t ii = 0; ii < sectionDataArrays.size(); ii++ )
+      {
+      const int section = sectionDataArrays[ii];
+      if ( section >= 0 && m_ExternalDataArrays[section].FileName.empty()
+           && std::find(dalist.begin(), dalist.end(), section) == dalist.end() )
+        {
+        dalist.push_back(section);
+        }
+      }
+    if ( std::find(dalist.begin(), dalist.end(), index) == dalist.end() )
+      {
+      dalist.push_back(index);
+      }
+
+    // Decode the base64 data arrays in parallel once the file is parsed,
+    // leaving the gifticlib globals alone for other readers on other threads
+    gifti_context context;
+    gifti_init_context(&context);
+    if ( dalist.size() > 1 && this->m_NumberOfThreads > 1 )
+      {
+      context.nthreads = this->m_NumberOfThreads;
+      }
+
+    this->FreeGiftiImage();
+    m_GiftiImage = gifti_read_da_list_ctx( &context, this->GetFileName(), 1, &dalist[0],
+                                           static_cast< int >( dalist.size() ) );
+
+    // Whter reading is successful
+    if ( m_GiftiImage == 0 || m_GiftiImage->numDA != static_cast< int >( dalist.size() ) )
+      {
+      this->FreeGiftiImage();
+      itkExceptionMacro(<< "Could not read the data arrays of GIFTI file " << this->m_FileName);
+      }
+
+    m_LoadedDataArrays = dalist;
+    it = std::find(m_LoadedDataArrays.begin(), m_LoadedDataArrays.end(), index);
+    }
+
+  giiDataArray *dataArray = m_GiftiImage->darray[it - m_LoadedDataArrays.begin()];
+  if ( !dataArray || !dataArray->data )
+    {
+    itkExceptionMacro(<< "Missing data of data array " << index << " in file " << this->m_FileName);
+    }
+
+  return dataArray;
+}
+
+const void * GiftiMeshIO::ReadDataArrayData(int index, size_t size, bool & swap)
+{
+  swap = false;
+
+  // The data of external data arrays are mapped rather than read
+  if ( index >= 0 && static_cast< size_t >( index ) < m_ExternalDataArrays.size()
+       && !m_ExternalDataArrays[index].FileName.empty() )
+    {
+    const ExternalDataArray & externalDataArray = m_ExternalDataArrays[index];
+    swap = externalDataArray.Swap;
+    return this->MapExternalFile(externalDataArray.FileName, externalDataArray.Offset, size);
+    }
+
+  giiDataArray *dataArray = this->ReadGiftiDataArray(index);
+  if ( static_cast< size_t >( dataArray->nvals * dataArray->nbyper ) < size )
+    {
+    itkExceptionMacro(<< "Data array " << index << " of file " << this->m_FileName << " is too small");
+    }
+
+  return dataArray->data;
+}
+
+const void * GiftiMeshIO::MapExternalFile(const std::string & fileName, long long offset, size_t size)
+{
+  // Map each external file once, as a whole
+  size_t ii = 0;
+  while ( ii < m_MappedFiles.size() && m_MappedFiles[ii].FileName != fileName )
+    {
+    ii++;
+    }
+
+  if ( ii == m_MappedFiles.size() )
+    {
+    MappedFile mappedFile;
+    mappedFile.FileName = fileName;
+    mappedFile.File = new MeshIOMappedFile;
+    if ( !mappedFile.File->Open(fileName) )
+      {
+      delete mappedFile.File;
+      itkExceptionMacro(<< "Could not map external file " << fileName << " of file " << this->m_FileName);
+      }
+
+    m_MappedFiles.push_back(mappedFile);
+    }
+
+  const MeshIOMappedFile *file = m_MappedFiles[ii].File;
+  if ( !file->Holds(offset, size) )
+    {
+    itkExceptionMacro(<< "External file " << fileName << " does not hold " << size << " bytes at offset " << offset);
+    }
+
+  return file->GetData() + offset;
+}
+
+void GiftiMeshIO::UnmapExternalFiles()
+{
+  for ( size_t ii = 0; ii < m_MappedFiles.size(); ii++ )
+    {
+    delete m_MappedFiles[ii].File;
+    }
+  m_MappedFiles.clear();
+}
+
+void GiftiMeshIO::BeginWriteDataArray(int index)
+{
+  if ( m_GiftiStream == 0 || index < m_StreamedDataArrays || index >= m_GiftiImage->numDA )
+    {
+    itkExceptionMacro(<< "Data array " << index << " cannot be written to file " << this->m_FileName);
+    }
+
+  m_WriteDataArray = index;
+  m_WriteDataArrayOffset = 0;
+
+  // Store the data of a data array given before the ones preceding it
+  if ( index > m_StreamedDataArrays )
+    {
+    if ( m_GiftiImage->darray[index]->data == 0 )
+      {
+      gifti_alloc_DA_data(m_GiftiImage, &index, 1);
+      }
+    }
+  else if ( gifti_stream_begin_DA(m_GiftiStream, m_GiftiImage->darray[index]) )
+    {
+    itkExceptionMacro(<< "Could not write data array " << index << " to file " << this->m_FileName);
+    }
+}
+
+void GiftiMeshIO::WriteDataArrayData(const void *data, size_t size)
+{
+  giiDataArray *da = m_GiftiImage->darray[m_WriteDataArray];
+
+  if ( m_WriteDataArray > m_StreamedDataArrays )
+    {
+    if ( m_WriteDataArrayOffset + size > static_cast< size_t >( da->nvals * da->nbyper ) )
+      {
+      itkExceptionMacro(<< "Too much data for data array " << m_WriteDataArray << " of file " << this->m_FileName);
+      }
+    memcpy(static_cast< char * >( da->data ) + m_WriteDataArrayOffset, data, size);
+    }
+  else
+    {
+    if ( da->encoding == GIFTI_ENCODING_EXTBIN
+         && !m_ExternalFile.write( static_cast< const char * >( data ), static_cast< std::streamsize >( size ) ) )
+      {
+      itkExceptionMacro(<< "Could not write external file " << this->GetExternalFileName());
+      }
+    if ( gifti_stream_write_DA_data(m_GiftiStream, data, size) )
+      {
+      itkExceptionMacro(<< "Could not write data array " << m_WriteDataArray << " to file " << this->m_FileName);
+      }
+    }
+
+  m_WriteDataArrayOffset += size;
+}
+
+void GiftiMeshIO::EndWriteDataArray()
+{
+  if ( m_WriteDataArray == m_StreamedDataArrays )
+    {
+    if ( gifti_stream_end_DA(m_GiftiStream) )
+      {
+      itkExceptionMacro(<< "Could not write data array " << m_WriteDataArray << " to file " << this->m_FileName);
+      }
+    m_StreamedDataArrays++;
+
+    this->StreamStoredDataArrays(false);
+    }
+}
+
+void GiftiMeshIO::StreamStoredDataArrays(bool all)
+{
+  while ( m_StreamedDataArrays < m_GiftiImage->numDA )
+    {
+    int           index = m_StreamedDataArrays;
+    giiDataArray *da = m_GiftiImage->darray[index];
+    if ( da->data == 0 )
+      {
+      if ( !all )
+        {
+        return;
+        }
+
+      // The data of a data array never given are zero
+      gifti_alloc_DA_data(m_GiftiImage, &index, 1);
+      }
+
+    this->BeginWriteDataArray(index);
+    this->WriteDataArrayData( da->data, static_cast< size_t >( da->nvals * da->nbyper ) );
+    free(da->data);
+    da->data = 0;
+    if ( gifti_stream_end_DA(m_GiftiStream) )
+      {
+      itkExceptionMacro(<< "Could not write data array " << index << " to file " << this->m_FileName);
+      }
+    m_StreamedDataArrays++;
+    }
+}
+
+void GiftiMeshIO::FreeGiftiImage()
+{
+  // Close a file left unfinished by an error
+  if ( m_GiftiStream )
+    {
+    gifti_stream_close(m_GiftiStream);
+    m_GiftiStream = 0;
+    }
+  if ( m_ExternalFile.is_open() )
+    {
+    m_ExternalFile.close();
+    }
+
+  gifti_free_image(m_GiftiImage);
+  m_GiftiImage = 0;
+  m_LoadedDataArrays.clear();
+}
+
 void GiftiMeshIO::ReadMeshInformation()
 {
+  // Start a new read session with the meta data only
+  this->FreeGiftiImage();
+  this->UnmapExternalFiles();
+  this->m_UpdatePoints = false;
+  this->m_UpdateCells = false;
+  this->m_UpdatePointData = false;
+  this->m_UpdateCellData = false;
+  m_PointsDataArray = -1;
+  m_CellsDataArray = -1;
+  m_PointDataDataArray = -1;
+  m_CellDataDataArray = -1;
+  m_DataArrayIntents.clear();
+  m_ExternalDataArrays.clear();
+  m_PointDataFrameDataArrays.clear();
+
   // Get gifti image pointer
-  m_GiftiImage = gifti_read_image(this->GetFileName(), false);
+  gifti_context context;
+  gifti_init_context(&context);
+  m_GiftiImage = gifti_read_image_ctx(&context, this->GetFileName(), false);
 
   // Wheter reading is successful
   if ( m_GiftiImage == 0 )
@@ -126,6 +463,47 @@ void GiftiMeshIO::ReadMeshInformation()
   // Number of data array
   for ( int ii = 0; ii < m_GiftiImage->numDA; ++ii )
     {
+    // Index the intents, and skip the functional arrays not selected
+    const int intent = m_GiftiImage->darray[ii]->intent;
+    m_DataArrayIntents.push_back(intent);
+
+    // Locate the data of external data arrays, relative to the GIFTI file
+    const giiDataArray *da = m_GiftiImage->darray[ii];
+    ExternalDataArray   externalDataArray;
+    externalDataArray.Offset = 0;
+    externalDataArray.Swap = false;
+    if ( da->encoding == GIFTI_ENCODING_EXTBIN && da->ext_fname && *da->ext_fname )
+      {
+      externalDataArray.FileName = da->ext_fname;
+      externalDataArray.Offset = da->ext_offset;
+      externalDataArray.Swap = ( da->endian != gifti_get_this_endian() );
+
+      const std::string path = itksys::SystemTools::GetFilenamePath(this->m_FileName);
+      if ( !path.empty() && !itksys::SystemTools::FileIsFullPath( externalDataArray.FileName.c_str() ) )
+        {
+        const std::string fileName = path + "/" + externalDataArray.FileName;
+        if ( itksys::SystemTools::FileExists( fileName.c_str() )
+             || !itksys::SystemTools::FileExists( externalDataArray.FileName.c_str() ) )
+          {
+          externalDataArray.FileName = fileName;
+          }
+        }
+      }
+    m_ExternalDataArrays.push_back(externalDataArray);
+
+    // The point data frames are gathered once all the arrays are known
+    if ( m_ReadPointDataFrames && m_ReadPointData && this->IsPointDataFrameDataArray(da, ii) )
+      {
+      m_PointDataFrameDataArrays.push_back(ii);
+      continue;
+      }
+
+    if ( ( intent == NIFTI_INTENT_SHAPE || intent == NIFTI_INTENT_VECTOR || intent == NIFTI_INTENT_LABEL )
+         && !this->IsFunctionalDataArraySelected(ii) )
+      {
+      continue;
+      }
+
     if ( m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_POINTSET )
       {
       if ( m_GiftiImage->darray[ii]->num_dim > 0 )
@@ -138,6 +516,7 @@ void GiftiMeshIO::ReadMeshInformation()
         this->m_PointDimension = m_GiftiImage->darray[ii]->dims[1];
         }
       this->m_UpdatePoints = true;
+      m_PointsDataArray = ii;
 
       switch ( m_GiftiImage->darray[ii]->datatype )
         {
@@ -206,6 +585,7 @@ void GiftiMeshIO::ReadMeshInformation()
         }
       this->m_CellBufferSize = static_cast< size_t >( m_GiftiImage->darray[ii]->nvals + 2 * this->m_NumberOfCells );
       this->m_UpdateCells = true;
+      m_CellsDataArray = ii;
 
       switch ( m_GiftiImage->darray[ii]->datatype )
         {
@@ -281,6 +661,7 @@ void GiftiMeshIO::ReadMeshInformation()
         if ( static_cast< unsigned long >( m_GiftiImage->darray[ii]->dims[0] ) == this->m_NumberOfPointPixels )
           {
           this->m_UpdatePointData = true;
+          m_PointDataDataArray = ii;
           this->m_NumberOfPointPixelComponents = 1;
           switch ( m_GiftiImage->darray[ii]->datatype )
             {
@@ -356,6 +737,7 @@ void GiftiMeshIO::ReadMeshInformation()
         else if ( this->m_NumberOfCellPixels == static_cast< unsigned long >( m_GiftiImage->darray[ii]->dims[0] ) )
           {
           this->m_UpdateCellData = true;
+          m_CellDataDataArray = ii;
           this->m_NumberOfCellPixelComponents = 1;
           switch ( m_GiftiImage->darray[ii]->datatype )
             {
@@ -455,6 +837,7 @@ void GiftiMeshIO::ReadMeshInformation()
         if ( static_cast< unsigned long >( m_GiftiImage->darray[ii]->dims[0] ) == this->m_NumberOfPointPixels )
           {
           this->m_UpdatePointData = true;
+          m_PointDataDataArray = ii;
           if ( m_GiftiImage->darray[ii]->num_dim > 1 )
             {
             this->m_NumberOfPointPixelComponents = m_GiftiImage->darray[ii]->dims[1];
@@ -534,6 +917,7 @@ void GiftiMeshIO::ReadMeshInformation()
         else if ( this->m_NumberOfCellPixels == static_cast< unsigned long >( m_GiftiImage->darray[ii]->dims[0] ) )
           {
           this->m_UpdateCellData = true;
+          m_CellDataDataArray = ii;
           if ( m_GiftiImage->darray[ii]->num_dim > 1 )
             {
             this->m_NumberOfCellPixelComponents = m_GiftiImage->darray[ii]->dims[1];
@@ -675,6 +1059,7 @@ void GiftiMeshIO::ReadMeshInformation()
           // static_cast<size_t>(m_GiftiImage->darray[ii]->nvals *
           // m_GiftiImage->darray[ii]->nbyper);
           this->m_UpdatePointData = true;
+          m_PointDataDataArray = ii;
           this->m_NumberOfPointPixelComponents = 1;
           switch ( m_GiftiImage->darray[ii]->datatype )
             {
@@ -753,6 +1138,7 @@ void GiftiMeshIO::ReadMeshInformation()
           // static_cast<size_t>(m_GiftiImage->darray[ii]->nvals *
           // m_GiftiImage->darray[ii]->nbyper);
           this->m_UpdateCellData = true;
+          m_CellDataDataArray = ii;
           this->m_NumberOfCellPixelComponents = 1;
           switch ( m_GiftiImage->darray[ii]->datatype )
             {
@@ -819,228 +1205,312 @@ void GiftiMeshIO::ReadMeshInformation()
         }
       }
     }
+
+  if ( !m_PointDataFrameDataArrays.empty() )
+    {
+    const giiDataArray *da = m_GiftiImage->darray[m_PointDataFrameDataArrays[0]];
+    for ( size_t ii = 1; ii < m_PointDataFrameDataArrays.size(); ii++ )
+      {
+      const giiDataArray *frame = m_GiftiImage->darray[m_PointDataFrameDataArrays[ii]];
+      if ( frame->dims[0] != da->dims[0] || frame->datatype != da->datatype )
+        {
+        itkExceptionMacro(<< "Data array " << m_PointDataFrameDataArrays[ii] << " of file " << this->m_FileName
+                          << " does not match the size and data type of the other point data frames");
+        }
+      }
+    if ( this->m_NumberOfPoints != 0 && this->m_NumberOfPoints != static_cast< SizeValueType >( da->dims[0] ) )
+      {
+      itkExceptionMacro(<< "The point data frames of file " << this->m_FileName << " have " << da->dims[0]
+                        << " values instead of one per point");
+      }
+
+    switch ( da->datatype )
+      {
+      case NIFTI_TYPE_INT8:
+        this->m_PointPixelComponentType = CHAR;
+        break;
+      case NIFTI_TYPE_UINT8:
+        this->m_PointPixelComponentType = UCHAR;
+        break;
+      case NIFTI_TYPE_INT16:
+        this->m_PointPixelComponentType = SHORT;
+        break;
+      case NIFTI_TYPE_UINT16:
+        this->m_PointPixelComponentType = USHORT;
+        break;
+      case NIFTI_TYPE_INT32:
+        this->m_PointPixelComponentType = INT;
+        break;
+      case NIFTI_TYPE_UINT32:
+        this->m_PointPixelComponentType = UINT;
+        break;
+      case NIFTI_TYPE_INT64:
+        this->m_PointPixelComponentType = LONGLONG;
+        break;
+      case NIFTI_TYPE_UINT64:
+        this->m_PointPixelComponentType = ULONGLONG;
+        break;
+      case NIFTI_TYPE_FLOAT32:
+        this->m_PointPixelComponentType = FLOAT;
+        break;
+      case NIFTI_TYPE_FLOAT64:
+        this->m_PointPixelComponentType = DOUBLE;
+        break;
+      default:
+        itkExceptionMacro(<< "Unknown point data frame component type");
+        break;
+      }
+
+    // The frames replace any other point data
+    this->m_NumberOfPointPixels = da->dims[0];
+    this->m_NumberOfPointPixelComponents = static_cast< unsigned int >( m_PointDataFrameDataArrays.size() );
+    this->m_PointPixelType = VARIABLELENGTHVECTOR;
+    this->m_UpdatePointData = true;
+    m_PointDataDataArray = m_PointDataFrameDataArrays[0];
+    }
+
+  // The data arrays are read on demand by the Read*() methods
+  this->FreeGiftiImage();
 }
 
 void GiftiMeshIO::ReadPoints(void *buffer)
 {
-  // Get gifti image pointer
-  m_GiftiImage = gifti_read_image(this->GetFileName(), true);
+  // Get the data of the data array indexed by ReadMeshInformation()
+  const size_t pointsBufferSize = this->m_NumberOfPoints * this->m_PointDimension;
+  const size_t componentSize = this->GetComponentSize(this->m_PointComponentType);
+  bool         swap;
+  const void * data = this->ReadDataArrayData(m_PointsDataArray, pointsBufferSize * componentSize, swap);
 
-  // Whter reading is successful
-  if ( m_GiftiImage == 0 )
+  memcpy(buffer, data, pointsBufferSize * componentSize);
+  if ( swap )
     {
-    itkExceptionMacro(<< this->GetFileName() << " is not recognized as a GIFTI file");
+    gifti_swap_Nbytes(buffer, pointsBufferSize, componentSize);
     }
 
-  // Number of data array
-  const size_t pointsBufferSize = this->m_NumberOfPoints * this->m_PointDimension;
-
-  for ( int ii = 0; ii < m_GiftiImage->numDA; ++ii )
+  // Free the image once the last section to update has been read
+  if ( !this->m_UpdateCells && !this->m_UpdatePointData && !this->m_UpdateCellData )
     {
-    if ( m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_POINTSET )
-      {
-      memcpy(buffer, m_GiftiImage->darray[ii]->data, pointsBufferSize * m_GiftiImage->darray[ii]->nbyper);
-      }
+    this->FreeGiftiImage();
+    this->UnmapExternalFiles();
     }
 }
 
 void GiftiMeshIO::ReadCells(void *buffer)
 {
-  // Get gifti image pointer
-  m_GiftiImage = gifti_read_image(this->GetFileName(), true);
-
-  // Whter reading is successful
-  if ( m_GiftiImage == 0 )
+  // Get the data of the data array indexed by ReadMeshInformation()
+  const size_t cellsBufferSize = this->m_NumberOfCells * 3;
+  const size_t componentSize = this->GetComponentSize(this->m_CellComponentType);
+  bool         swap;
+  const void * data = this->ReadDataArrayData(m_CellsDataArray, cellsBufferSize * componentSize, swap);
+
+  // Swap a copy of mapped data in another byte order
+  std::vector< char > swappedData;
+  if ( swap )
     {
-    itkExceptionMacro(<< this->GetFileName() << " is not recognized as a GIFTI file");
+    swappedData.assign(static_cast< const char * >( data ), static_cast< const char * >( data ) + cellsBufferSize * componentSize);
+    gifti_swap_Nbytes(&swappedData[0], cellsBufferSize, componentSize);
+    data = &swappedData[0];
     }
+  void *cellsData = const_cast< void * >( data );
 
-  // Number of data array
-  for ( int ii = 0; ii < m_GiftiImage->numDA; ++ii )
+  switch ( this->m_CellComponentType )
     {
-    if ( m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_TRIANGLE )
+    case CHAR:
       {
-      switch ( this->m_CellComponentType )
-        {
-        case CHAR:
-          {
-          this->WriteCellsBuffer(static_cast< char * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< char * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case UCHAR:
-          {
-          this->WriteCellsBuffer(static_cast< unsigned char * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< unsigned char * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case USHORT:
-          {
-          this->WriteCellsBuffer(static_cast< unsigned short * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< unsigned short * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case SHORT:
-          {
-          this->WriteCellsBuffer(static_cast< short * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< short * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case UINT:
-          {
-          this->WriteCellsBuffer(static_cast< unsigned int * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< unsigned int * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case INT:
-          {
-          this->WriteCellsBuffer(static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< int * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case ULONG:
-          {
-          this->WriteCellsBuffer(static_cast< unsigned long * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< unsigned long * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case LONG:
-          {
-          this->WriteCellsBuffer(static_cast< long * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< long * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case LONGLONG:
-          {
-          this->WriteCellsBuffer(static_cast< long long * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< long long * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case ULONGLONG:
-          {
-          this->WriteCellsBuffer(static_cast< unsigned long long * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< unsigned long long * >( buffer ), TRIANGLE_CELL, 3, this->m_NumberOfCells);
-          break;
-          }
-        case FLOAT:
-          {
-          this->WriteCellsBuffer(static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< float * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case DOUBLE:
-          {
-          this->WriteCellsBuffer(static_cast< double * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< double * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        case LDOUBLE:
-          {
-          this->WriteCellsBuffer(static_cast< long double * >( m_GiftiImage->darray[ii]->data ),
-                                 static_cast< long double * >( buffer ),
-                                 TRIANGLE_CELL,
-                                 3,
-                                 this->m_NumberOfCells);
-          break;
-          }
-        default:
-          {
-          itkExceptionMacro(<< "Unknown cell data pixel component type" << std::endl);
-          }
-        }
+      this->WriteCellsBuffer(static_cast< char * >( cellsData ),
+                             static_cast< char * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case UCHAR:
+      {
+      this->WriteCellsBuffer(static_cast< unsigned char * >( cellsData ),
+                             static_cast< unsigned char * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case USHORT:
+      {
+      this->WriteCellsBuffer(static_cast< unsigned short * >( cellsData ),
+                             static_cast< unsigned short * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case SHORT:
+      {
+      this->WriteCellsBuffer(static_cast< short * >( cellsData ),
+                             static_cast< short * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case UINT:
+      {
+      this->WriteCellsBuffer(static_cast< unsigned int * >( cellsData ),
+                             static_cast< unsigned int * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case INT:
+      {
+      this->WriteCellsBuffer(static_cast< int * >( cellsData ),
+                             static_cast< int * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case ULONG:
+      {
+      this->WriteCellsBuffer(static_cast< unsigned long * >( cellsData ),
+                             static_cast< unsigned long * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case LONG:
+      {
+      this->WriteCellsBuffer(static_cast< long * >( cellsData ),
+                             static_cast< long * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case LONGLONG:
+      {
+      this->WriteCellsBuffer(static_cast< long long * >( cellsData ),
+                             static_cast< long long * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case ULONGLONG:
+      {
+      this->WriteCellsBuffer(static_cast< unsigned long long * >( cellsData ),
+                             static_cast< unsigned long long * >( buffer ), TRIANGLE_CELL, 3, this->m_NumberOfCells);
+      break;
+      }
+    case FLOAT:
+      {
+      this->WriteCellsBuffer(static_cast< float * >( cellsData ),
+                             static_cast< float * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case DOUBLE:
+      {
+      this->WriteCellsBuffer(static_cast< double * >( cellsData ),
+                             static_cast< double * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    case LDOUBLE:
+      {
+      this->WriteCellsBuffer(static_cast< long double * >( cellsData ),
+                             static_cast< long double * >( buffer ),
+                             TRIANGLE_CELL,
+                             3,
+                             this->m_NumberOfCells);
+      break;
+      }
+    default:
+      {
+      itkExceptionMacro(<< "Unknown cell data pixel component type" << std::endl);
       }
     }
 
-  return;
+  // Free the image once the last section to update has been read
+  if ( !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->FreeGiftiImage();
+    this->UnmapExternalFiles();
+    }
 }
 
-void GiftiMeshIO::ReadPointData(void *buffer)
+void GiftiMeshIO::InterleavePointDataFrames(void *buffer)
 {
-  // Get gifti image pointer
-  m_GiftiImage = gifti_read_image(this->GetFileName(), true);
-
-  // Whter reading is successful
-  if ( m_GiftiImage == 0 )
+  switch ( this->GetComponentSize(this->m_PointPixelComponentType) )
     {
-    itkExceptionMacro(<< this->GetFileName() << " is not recognized as a GIFTI file");
+    case 1:
+      this->InterleavePointDataFramesBuffer( static_cast< uint8_t * >( buffer ) );
+      break;
+    case 2:
+      this->InterleavePointDataFramesBuffer( static_cast< uint16_t * >( buffer ) );
+      break;
+    case 4:
+      this->InterleavePointDataFramesBuffer( static_cast< uint32_t * >( buffer ) );
+      break;
+    case 8:
+      this->InterleavePointDataFramesBuffer( static_cast< uint64_t * >( buffer ) );
+      break;
+    default:
+      itkExceptionMacro(<< "Unknown point data frame component type");
+      break;
     }
+}
 
-  // Read point or cell Data
-  for ( int ii = 0; ii < m_GiftiImage->numDA; ++ii )
+void GiftiMeshIO::ReadPointData(void *buffer)
+{
+  if ( !m_PointDataFrameDataArrays.empty() )
+    {
+    this->InterleavePointDataFrames(buffer);
+    }
+  else
     {
-    if ( m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_SHAPE  || m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_VECTOR
-         || m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_LABEL )
+    // Get the data of the data array indexed by ReadMeshInformation()
+    const size_t pointDataBufferSize = this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents;
+    const size_t componentSize = this->GetComponentSize(this->m_PointPixelComponentType);
+    bool         swap;
+    const void * data = this->ReadDataArrayData(m_PointDataDataArray, pointDataBufferSize * componentSize, swap);
+
+    memcpy(buffer, data, pointDataBufferSize * componentSize);
+    if ( swap )
       {
-      if ( static_cast< unsigned long >( m_GiftiImage->darray[ii]->dims[0] ) == this->m_NumberOfPointPixels )
-        {
-        const size_t pointDataBufferSize = this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents;
-        memcpy(buffer, m_GiftiImage->darray[ii]->data, pointDataBufferSize * m_GiftiImage->darray[ii]->nbyper);
-        }
+      gifti_swap_Nbytes(buffer, pointDataBufferSize, componentSize);
       }
     }
 
-  return;
+  // Free the image once the last section to update has been read
+  if ( !this->m_UpdateCellData )
+    {
+    this->FreeGiftiImage();
+    this->UnmapExternalFiles();
+    }
 }
 
 void GiftiMeshIO::ReadCellData(void *buffer)
 {
-  // Get gifti image pointer
-  m_GiftiImage = gifti_read_image(this->GetFileName(), true);
-
-  // Whter reading is successful
-  if ( m_GiftiImage == 0 )
-    {
-    itkExceptionMacro(<< this->GetFileName() << " is not recognized as a GIFTI file");
-    }
-
-  // Read point or cell Data
-  for ( int ii = 0; ii < m_GiftiImage->numDA; ++ii )
+  // Get the data of the data array indexed by ReadMeshInformation()
+  const size_t cellDataBufferSize = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
+  const size_t componentSize = this->GetComponentSize(this->m_CellPixelComponentType);
+  bool         swap;
+  const void * data = this->ReadDataArrayData(m_CellDataDataArray, cellDataBufferSize * componentSize, swap);
+
+  memcpy(buffer, data, cellDataBufferSize * componentSize);
+  if ( swap )
     {
-    if ( m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_SHAPE  || m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_VECTOR
-         || m_GiftiImage->darray[ii]->intent == NIFTI_INTENT_LABEL )
-      {
-      if ( static_cast< unsigned long >( m_GiftiImage->darray[ii]->dims[0] ) == this->m_NumberOfCellPixels )
-        {
-        const size_t cellDataBufferSize = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
-        memcpy(buffer, m_GiftiImage->darray[ii]->data, cellDataBufferSize * m_GiftiImage->darray[ii]->nbyper);
-        }
-      }
+    gifti_swap_Nbytes(buffer, cellDataBufferSize, componentSize);
     }
 
-  return;
+  // The cell data are the last section
+  this->FreeGiftiImage();
+  this->UnmapExternalFiles();
 }
 
 void GiftiMeshIO::WriteMeshInformation()
@@ -1070,6 +1540,7 @@ void GiftiMeshIO::WriteMeshInformation()
 
   // Create a new gifti image
   int dims[6] = {0};
+  this->FreeGiftiImage();
   m_GiftiImage = gifti_create_image(nda, NIFTI_INTENT_POINTSET, NIFTI_TYPE_UINT32, 0, dims, 0);
 
   // Whter reading is successful
@@ -1183,9 +1654,6 @@ void GiftiMeshIO::WriteMeshInformation()
       }
 
     gifti_update_nbyper(m_GiftiImage);
-
-    // Allocate memory
-    gifti_alloc_DA_data(m_GiftiImage, dalist, 1);
     }
 
   // Update cells
@@ -1241,9 +1709,6 @@ void GiftiMeshIO::WriteMeshInformation()
       }
 
     gifti_update_nbyper(m_GiftiImage);
-
-    // Allocate memory
-    gifti_alloc_DA_data(m_GiftiImage, dalist, 1);
     }
 
   // Update point data
@@ -1325,9 +1790,6 @@ void GiftiMeshIO::WriteMeshInformation()
       }
 
     gifti_update_nbyper(m_GiftiImage);
-
-    // Allocate memory
-    gifti_alloc_DA_data(m_GiftiImage, dalist, 1);
     }
 
   // Update cell data
@@ -1409,10 +1871,45 @@ void GiftiMeshIO::WriteMeshInformation()
       }
 
     gifti_update_nbyper(m_GiftiImage);
+    }
+
+  // Lay the data arrays out one after the other in the external file
+  if ( this->m_UseExternalFile )
+    {
+    const std::string externalFileName = itksys::SystemTools::GetFilenameName( this->GetExternalFileName() );
+    long long         offset = 0;
+    for ( int ii = 0; ii < m_GiftiImage->numDA; ++ii )
+      {
+      giiDataArray *da = m_GiftiImage->darray[ii];
+      da->encoding = GIFTI_ENCODING_EXTBIN;
+      free(da->ext_fname);
+      da->ext_fname = gifti_strdup( externalFileName.c_str() );
+      da->ext_offset = offset;
+      offset += da->nvals * da->nbyper;
+      }
 
-    // Allocate memory
-    gifti_alloc_DA_data(m_GiftiImage, dalist, 1);
+    m_ExternalFile.clear();
+    m_ExternalFile.open(this->GetExternalFileName().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if ( !m_ExternalFile )
+      {
+      this->FreeGiftiImage();
+      itkExceptionMacro(<< "Could not open external file " << this->GetExternalFileName() << " for writing");
+      }
     }
+
+  // Write the meta data now, and each data array as soon as it has been given,
+  // compressing the GZipBase64Binary data arrays in chunks across the threads
+  gifti_context context;
+  gifti_init_context(&context);
+  context.zlevel = this->m_CompressionLevel;
+  context.zthreads = this->m_NumberOfThreads;
+  m_GiftiStream = gifti_stream_open_ctx( &context, m_GiftiImage, this->GetFileName() );
+  if ( m_GiftiStream == 0 )
+    {
+    this->FreeGiftiImage();
+    itkExceptionMacro(<< "Could not open GIFTI file " << this->m_FileName << " for writing");
+    }
+  m_StreamedDataArrays = 0;
 }
 
 void GiftiMeshIO::WritePoints(void *buffer)
@@ -1427,75 +1924,67 @@ void GiftiMeshIO::WritePoints(void *buffer)
         {
         case UCHAR:
           {
-          ConvertBuffer(static_cast< unsigned char * >( buffer ),
-                        static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                        pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< unsigned char * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case CHAR:
           {
-          ConvertBuffer(static_cast< char * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< char * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case USHORT:
           {
-          ConvertBuffer(static_cast< unsigned short * >( buffer ),
-                        static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                        pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< unsigned short * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case SHORT:
           {
-          ConvertBuffer(static_cast< short * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< short * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case UINT:
           {
-          ConvertBuffer(static_cast< unsigned int * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< unsigned int * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case INT:
           {
-          ConvertBuffer(static_cast< int * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< int * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case ULONG:
           {
-          ConvertBuffer(static_cast< unsigned long * >( buffer ),
-                        static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                        pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< unsigned long * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case LONG:
           {
-          ConvertBuffer(static_cast< long * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< long * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case ULONGLONG:
           {
-          ConvertBuffer(static_cast< unsigned long long * >( buffer ),
-                        static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                        pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< unsigned long long * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case LONGLONG:
           {
-          ConvertBuffer(static_cast< long long * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< long long * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case FLOAT:
           {
-          ConvertBuffer(static_cast< float * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< float * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case DOUBLE:
           {
-          ConvertBuffer(static_cast< double * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< double * >( buffer ), pointsBufferSize, ii);
           break;
           }
         case LDOUBLE:
           {
-          ConvertBuffer(static_cast< long double * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointsBufferSize);
+          this->WriteDataArrayBuffer< float >(static_cast< long double * >( buffer ), pointsBufferSize, ii);
           break;
           }
         default:
@@ -1518,68 +2007,67 @@ void GiftiMeshIO::WriteCells(void *buffer)
         {
         case UCHAR:
           {
-          this->ReadCellsBuffer( static_cast< unsigned char * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< unsigned char * >( buffer ), ii);
           break;
           }
         case CHAR:
           {
-          this->ReadCellsBuffer( static_cast< char * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< char * >( buffer ), ii);
           break;
           }
         case USHORT:
           {
-          this->ReadCellsBuffer( static_cast< unsigned short * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< unsigned short * >( buffer ), ii);
           break;
           }
         case SHORT:
           {
-          this->ReadCellsBuffer( static_cast< short * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< short * >( buffer ), ii);
           break;
           }
         case UINT:
           {
-          this->ReadCellsBuffer( static_cast< unsigned int * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< unsigned int * >( buffer ), ii);
           break;
           }
         case INT:
           {
-          this->ReadCellsBuffer( static_cast< int * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< int * >( buffer ), ii);
           break;
           }
         case ULONG:
           {
-          this->ReadCellsBuffer( static_cast< unsigned long * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< unsigned long * >( buffer ), ii);
           break;
           }
         case LONG:
           {
-          this->ReadCellsBuffer( static_cast< long * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< long * >( buffer ), ii);
           break;
           }
         case ULONGLONG:
           {
-          this->ReadCellsBuffer( static_cast< unsigned long long * >( buffer ),
-                                static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< unsigned long long * >( buffer ), ii);
           break;
           }
         case LONGLONG:
           {
-          this->ReadCellsBuffer( static_cast< long long * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< long long * >( buffer ), ii);
           break;
           }
         case FLOAT:
           {
-          this->ReadCellsBuffer( static_cast< float * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< float * >( buffer ), ii);
           break;
           }
         case DOUBLE:
           {
-          this->ReadCellsBuffer( static_cast< double * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< double * >( buffer ), ii);
           break;
           }
         case LDOUBLE:
           {
-          this->ReadCellsBuffer( static_cast< long double * >( buffer ), static_cast< int32_t * >( m_GiftiImage->darray[ii]->data ) );
+          this->WriteTrianglesDataArray(static_cast< long double * >( buffer ), ii);
           break;
           }
         default:
@@ -1607,81 +2095,67 @@ void GiftiMeshIO::WritePointData(void *buffer)
           {
           case UCHAR:
             {
-            ConvertBuffer(static_cast< unsigned char * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned char * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case CHAR:
             {
-            ConvertBuffer(static_cast< char * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< char * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case USHORT:
             {
-            ConvertBuffer(static_cast< unsigned short * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned short * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case SHORT:
             {
-            ConvertBuffer(static_cast< short * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< short * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case UINT:
             {
-            ConvertBuffer(static_cast< unsigned int * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned int * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case INT:
             {
-            ConvertBuffer(static_cast< int * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< int * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case ULONG:
             {
-            ConvertBuffer(static_cast< unsigned long * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case LONG:
             {
-            ConvertBuffer(static_cast< long * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case ULONGLONG:
             {
-            ConvertBuffer(static_cast< unsigned long long * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned long long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case LONGLONG:
             {
-            ConvertBuffer(static_cast< long long * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< long long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case FLOAT:
             {
-            ConvertBuffer(static_cast< float * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< float * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case DOUBLE:
             {
-            ConvertBuffer(static_cast< double * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< double * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case LDOUBLE:
             {
-            ConvertBuffer(static_cast< long double * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< long double * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           default:
@@ -1701,79 +2175,67 @@ void GiftiMeshIO::WritePointData(void *buffer)
           {
           case UCHAR:
             {
-            ConvertBuffer(static_cast< unsigned char * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned char * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case CHAR:
             {
-            ConvertBuffer(static_cast< char * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< char * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case USHORT:
             {
-            ConvertBuffer(static_cast< unsigned short * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned short * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case SHORT:
             {
-            ConvertBuffer(static_cast< short * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< short * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case UINT:
             {
-            ConvertBuffer(static_cast< unsigned int * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned int * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case INT:
             {
-            ConvertBuffer(static_cast< int * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< int * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case ULONG:
             {
-            ConvertBuffer(static_cast< unsigned long * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case LONG:
             {
-            ConvertBuffer(static_cast< long * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case ULONGLONG:
             {
-            ConvertBuffer(static_cast< unsigned long long * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned long long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case LONGLONG:
             {
-            ConvertBuffer(static_cast< long long * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< long long * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case FLOAT:
             {
-            ConvertBuffer(static_cast< float * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< float * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case DOUBLE:
             {
-            ConvertBuffer(static_cast< double * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< double * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           case LDOUBLE:
             {
-            ConvertBuffer(static_cast< long double * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          pointDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< long double * >( buffer ), pointDataBufferSize, ii);
             break;
             }
           default:
@@ -1802,81 +2264,67 @@ void GiftiMeshIO::WriteCellData(void *buffer)
           {
           case UCHAR:
             {
-            ConvertBuffer(static_cast< unsigned char * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned char * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case CHAR:
             {
-            ConvertBuffer(static_cast< char * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< char * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case USHORT:
             {
-            ConvertBuffer(static_cast< unsigned short * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned short * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case SHORT:
             {
-            ConvertBuffer(static_cast< short * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< short * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case UINT:
             {
-            ConvertBuffer(static_cast< unsigned int * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned int * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case INT:
             {
-            ConvertBuffer(static_cast< int * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< int * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case ULONG:
             {
-            ConvertBuffer(static_cast< unsigned long * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case LONG:
             {
-            ConvertBuffer(static_cast< long * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case ULONGLONG:
             {
-            ConvertBuffer(static_cast< unsigned long long * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< unsigned long long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case LONGLONG:
             {
-            ConvertBuffer(static_cast< long long * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< long long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case FLOAT:
             {
-            ConvertBuffer(static_cast< float * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< float * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case DOUBLE:
             {
-            ConvertBuffer(static_cast< double * >( buffer ), static_cast< float * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< double * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case LDOUBLE:
             {
-            ConvertBuffer(static_cast< long double * >( buffer ),
-                          static_cast< float * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< float >(static_cast< long double * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           default:
@@ -1896,79 +2344,67 @@ void GiftiMeshIO::WriteCellData(void *buffer)
           {
           case UCHAR:
             {
-            ConvertBuffer(static_cast< unsigned char * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned char * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case CHAR:
             {
-            ConvertBuffer(static_cast< char * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< char * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case USHORT:
             {
-            ConvertBuffer(static_cast< unsigned short * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned short * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case SHORT:
             {
-            ConvertBuffer(static_cast< short * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< short * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case UINT:
             {
-            ConvertBuffer(static_cast< unsigned int * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned int * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case INT:
             {
-            ConvertBuffer(static_cast< int * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< int * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case ULONG:
             {
-            ConvertBuffer(static_cast< unsigned long * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case LONG:
             {
-            ConvertBuffer(static_cast< long * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case ULONGLONG:
             {
-            ConvertBuffer(static_cast< unsigned long long * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< unsigned long long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case LONGLONG:
             {
-            ConvertBuffer(static_cast< long long * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< long long * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case FLOAT:
             {
-            ConvertBuffer(static_cast< float * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< float * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case DOUBLE:
             {
-            ConvertBuffer(static_cast< double * >( buffer ), static_cast< int * >( m_GiftiImage->darray[ii]->data ), cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< double * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           case LDOUBLE:
             {
-            ConvertBuffer(static_cast< long double * >( buffer ),
-                          static_cast< int * >( m_GiftiImage->darray[ii]->data ),
-                          cellDataBufferSize);
+            this->WriteDataArrayBuffer< int >(static_cast< long double * >( buffer ), cellDataBufferSize, ii);
             break;
             }
           default:
@@ -1985,7 +2421,28 @@ void GiftiMeshIO::WriteCellData(void *buffer)
 
 void GiftiMeshIO::Write()
 {
-  gifti_write_image(m_GiftiImage, this->m_FileName.c_str(), 1);
+  if ( m_GiftiStream == 0 )
+    {
+    itkExceptionMacro(<< "WriteMeshInformation() has not been called before Write()");
+    }
+
+  // Write the data arrays which have not been given, or stored until now
+  this->StreamStoredDataArrays(true);
+
+  const int errors = gifti_stream_close(m_GiftiStream);
+  m_GiftiStream = 0;
+  bool externalFileFailed = false;
+  if ( m_ExternalFile.is_open() )
+    {
+    m_ExternalFile.close();
+    externalFileFailed = m_ExternalFile.fail();
+    }
+  this->FreeGiftiImage();
+
+  if ( errors || externalFileFailed )
+    {
+    itkExceptionMacro(<< "Could not write GIFTI file " << this->m_FileName);
+    }
 }
 
 void GiftiMeshIO::PrintSelf(std::ostream & os, Indent indent) const
@@ -1995,5 +2452,14 @@ void GiftiMeshIO::PrintSelf(std::ostream & os, Indent indent) const
   os << indent << gifticlib_version() << std::endl;
   os << indent << "Direction : " << std::endl;
   os << indent << m_Direction << std::endl;
+  os << indent << "Use external file : " << ( m_UseExternalFile ? "On" : "Off" ) << std::endl;
+  os << indent << "Read point data frames : " << ( m_ReadPointDataFrames ? "On" : "Off" ) << std::endl;
+  os << indent << "Number of data arrays : " << m_DataArrayIntents.size() << std::endl;
+  os << indent << "Functional data arrays : ";
+  for ( size_t ii = 0; ii < m_FunctionalDataArrays.size(); ii++ )
+    {
+    os << m_FunctionalDataArrays[ii] << " ";
+    }
+  os << std::endl;
 }
 } // namespace itk end
@@ -25,17 +25,43 @@
 #include "itkMapContainer.h"
 #include "itkMatrix.h"
 #include "itkMeshIOBase.h"
+#include "itkMeshIOMappedFile.h"
 #include "itkMetaDataObject.h"
+#include "itkMultiThreader.h"
 #include "itkRGBAPixel.h"
 
 #include "gifti_io.h"
 
+#include <algorithm>
 #include <fstream>
 #include <string>
+#include <vector>
 
 namespace itk
 {
 /** \class GiftiMeshIO
+ *
+ * ReadMeshInformation() reads the meta data of the file and indexes the
+ * data array of each section. The first Read*() call decodes only the data
+ * arrays of the sections that have to be updated and the following ones
+ * share them; the image is freed once the last section that has to be
+ * updated has been read. SetFunctionalDataArrays() restricts which shape,
+ * vector and label data arrays may become point or cell data.
+ *
+ * With ReadPointDataFramesOn(), the one-dimensional functional data arrays
+ * with one value per point, such as the time points of a .func.gii file, are
+ * all decoded at once and interleaved as the components of one point data
+ * pixel, to be read into VariableLengthVector or Array pixels.
+ *
+ * The data of ExternalFileBinary data arrays are not read by gifticlib: their
+ * external file is mapped in memory and copied directly into the buffers of
+ * the Read*() methods. SetUseExternalFile() writes all the data arrays to
+ * such an external file, named after the GIFTI file with a ".dat" extension.
+ *
+ * WriteMeshInformation() writes the meta data of the file, and each data
+ * array is encoded and written from the buffer given to its Write*() method
+ * in chunks of bounded size, without a copy of the whole data. Data arrays
+ * given before the ones preceding them in the file are stored until then.
  *
  * \ingroup IOFilters
  */
@@ -65,6 +91,15 @@ public:
   itkSetMacro(ReadPointData, bool);
   itkBooleanMacro(ReadPointData);
 
+  /** Set/Get whether the data arrays are written to an ExternalFileBinary
+   * file instead of being encoded in the GIFTI file. Default is false. */
+  itkGetConstMacro(UseExternalFile, bool);
+  itkSetMacro(UseExternalFile, bool);
+  itkBooleanMacro(UseExternalFile);
+
+  /** Name of the external file written next to the GIFTI file. */
+  std::string GetExternalFileName() const;
+
   void SetDirection(const DirectionType direction);
 
   itkGetConstReferenceMacro(Direction, DirectionType);
@@ -74,6 +109,28 @@ public:
   void SetLabelColorTable(const LabelColorContainer * colorMap);
   void SetLabelNameTable(const LabelNameContainer * labelMap);
 
+  /** Set/Get whether all the one-dimensional functional data arrays with one
+   * value per point are read as the components of the point data, in file
+   * order, rather than the last one as scalar point data. They must be of
+   * the same data type. Default is false. */
+  itkGetConstMacro(ReadPointDataFrames, bool);
+  itkSetMacro(ReadPointDataFrames, bool);
+  itkBooleanMacro(ReadPointDataFrames);
+
+  /** Indices of the data arrays read as the point data components by the
+   * last ReadMeshInformation() with ReadPointDataFrames on. */
+  const std::vector< int > & GetPointDataFrameDataArrays() const;
+
+  /** Set/Get the indices of the shape, vector and label data arrays which
+   * may be read as point or cell data. If empty, all of them are considered
+   * and the last one matching wins. */
+  void SetFunctionalDataArrays(const std::vector< int > & indices);
+  const std::vector< int > & GetFunctionalDataArrays() const;
+
+  /** Number and intents of the data arrays found by ReadMeshInformation(). */
+  unsigned int GetNumberOfDataArrays() const;
+  int GetDataArrayIntent(unsigned int index) const;
+
   /*-------- This part of the interfaces deals with reading data. ----- */
 
   /** Determine if the file can be read with this MeshIO implementation.
@@ -121,10 +178,180 @@ public:
 
 protected:
   GiftiMeshIO();
-  virtual ~GiftiMeshIO(){gifti_free_image(m_GiftiImage); }
+  virtual ~GiftiMeshIO(){ this->FreeGiftiImage(); this->UnmapExternalFiles(); }
 
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Return the data array of the file at index, reading it together with
+   * the data arrays of the other sections to update unless it has already
+   * been read. */
+  giiDataArray * ReadGiftiDataArray(int index);
+
+  /** Return the size bytes of data of the data array of the file at index,
+   * either read by ReadGiftiDataArray() or mapped from its external file.
+   * swap is set if they are not in the byte order of this machine. */
+  const void * ReadDataArrayData(int index, size_t size, bool & swap);
+
+  /** Map the size bytes at offset of an external file in memory. The file
+   * stays mapped until UnmapExternalFiles() is called. */
+  const void * MapExternalFile(const std::string & fileName, long long offset, size_t size);
+
+  void UnmapExternalFiles();
+
+  bool IsFunctionalDataArraySelected(int index) const;
+
+  /** Whether the data array at index may be one of the point data frames. */
+  bool IsPointDataFrameDataArray(const giiDataArray *dataArray, int index) const;
+
+  /** Interleave the data arrays of the point data frames into buffer. */
+  void InterleavePointDataFrames(void *buffer);
+
+  /** Point data frames interleaved per point by the threads of a
+   * MultiThreader, T being a type of the size of one component */
+  template< typename T >
+  struct PointDataFramesStruct
+    {
+    std::vector< const T * > Frames;
+    std::vector< bool >      Swap;
+    T *                      Output;
+    SizeValueType            NumberOfPoints;
+    };
+
+  template< typename T >
+  static ITK_THREAD_RETURN_TYPE PointDataFramesThreaderCallback(void *arg)
+  {
+    MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+    PointDataFramesStruct< T > *     str = static_cast< PointDataFramesStruct< T > * >( info->UserData );
+
+    const SizeValueType numberOfFrames = str->Frames.size();
+    const SizeValueType firstPoint = str->NumberOfPoints * info->ThreadID / info->NumberOfThreads;
+    const SizeValueType lastPoint = str->NumberOfPoints * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+    // Go by tiles of points and frames, so that both the frames read and
+    // the points written stay in cache
+    const SizeValueType tileSize = 64;
+    for ( SizeValueType point = firstPoint; point < lastPoint; point += tileSize )
+      {
+      const SizeValueType pointEnd = std::min(point + tileSize, lastPoint);
+      for ( SizeValueType frame = 0; frame < numberOfFrames; frame += tileSize )
+        {
+        const SizeValueType frameEnd = std::min(frame + tileSize, numberOfFrames);
+        for ( SizeValueType ii = point; ii < pointEnd; ii++ )
+          {
+          T *output = str->Output + ii * numberOfFrames;
+          for ( SizeValueType jj = frame; jj < frameEnd; jj++ )
+            {
+            output[jj] = str->Frames[jj][ii];
+            }
+          }
+        }
+      }
+
+    for ( SizeValueType jj = 0; jj < numberOfFrames; jj++ )
+      {
+      if ( str->Swap[jj] )
+        {
+        for ( SizeValueType ii = firstPoint; ii < lastPoint; ii++ )
+          {
+          gifti_swap_Nbytes(str->Output + ii * numberOfFrames + jj, 1, sizeof( T ));
+          }
+        }
+      }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  template< typename T >
+  void InterleavePointDataFramesBuffer(T *buffer)
+  {
+    PointDataFramesStruct< T > str;
+    str.Output = buffer;
+    str.NumberOfPoints = this->m_NumberOfPointPixels;
+
+    // The first frame decodes the data arrays of all of them at once
+    for ( size_t ii = 0; ii < m_PointDataFrameDataArrays.size(); ii++ )
+      {
+      bool swap;
+      str.Frames.push_back( static_cast< const T * >(
+                              this->ReadDataArrayData(m_PointDataFrameDataArrays[ii], str.NumberOfPoints * sizeof( T ),
+                                                      swap) ) );
+      str.Swap.push_back(swap);
+      }
+
+    MultiThreader::Pointer threader = MultiThreader::New();
+    const int              numberOfThreads = static_cast< int >( std::min(
+                                                                   static_cast< SizeValueType >( this->m_NumberOfThreads ),
+                                                                   std::max(str.NumberOfPoints / 4096,
+                                                                            static_cast< SizeValueType >( 1 ) ) ) );
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(&Self::PointDataFramesThreaderCallback< T >, &str);
+    threader->SingleMethodExecute();
+  }
+
+  /** Free the image read or created last. */
+  void FreeGiftiImage();
+
+  /** Write the data of the data array at index, in any number of calls to
+   * WriteDataArrayData(). The data are streamed to the file if all the data
+   * arrays before it have been written, or stored in the image otherwise. */
+  void BeginWriteDataArray(int index);
+  void WriteDataArrayData(const void *data, size_t size);
+  void EndWriteDataArray();
+
+  /** Stream the stored data arrays following the ones already written, up
+   * to the first one not given yet unless all is set. */
+  void StreamStoredDataArrays(bool all);
+
+  /** Convert and write the elements of input to the data array at index, by
+   * chunks of bounded size. */
+  template< class TOutput, class TInput >
+  void WriteDataArrayBuffer(TInput *input, SizeValueType numberOfElements, int index)
+  {
+    const SizeValueType    chunkSize = 65536;
+    std::vector< TOutput > chunk( numberOfElements < chunkSize ? numberOfElements : chunkSize );
+
+    this->BeginWriteDataArray(index);
+    for ( SizeValueType ii = 0; ii < numberOfElements; ii += chunk.size() )
+      {
+      const SizeValueType nn = numberOfElements - ii < chunk.size() ? numberOfElements - ii : chunk.size();
+      this->ConvertBuffer(input + ii, &chunk[0], nn);
+      this->WriteDataArrayData( &chunk[0], nn * sizeof( TOutput ) );
+      }
+    this->EndWriteDataArray();
+  }
+
+  /** Write the point identifiers of the cells of input to the triangle data
+   * array at index, by chunks of bounded size. */
+  template< class TInput >
+  void WriteTrianglesDataArray(TInput *input, int index)
+  {
+    const SizeValueType    chunkSize = 3 * 16384;
+    std::vector< int32_t > chunk;
+    chunk.reserve(chunkSize);
+
+    this->BeginWriteDataArray(index);
+    SizeValueType inputIndex = NumericTraits< SizeValueType >::Zero;
+    for ( SizeValueType ii = 0; ii < this->m_NumberOfCells; ii++ )
+      {
+      inputIndex++; // ignore the cell type
+      const unsigned int numberOfPoints = static_cast< unsigned int >( input[inputIndex++] );
+      for ( unsigned int jj = 0; jj < numberOfPoints; jj++ )
+        {
+        chunk.push_back( static_cast< int32_t >( input[inputIndex++] ) );
+        }
+      if ( chunk.size() >= chunkSize )
+        {
+        this->WriteDataArrayData( &chunk[0], chunk.size() * sizeof( int32_t ) );
+        chunk.clear();
+        }
+      }
+    if ( !chunk.empty() )
+      {
+      this->WriteDataArrayData( &chunk[0], chunk.size() * sizeof( int32_t ) );
+      }
+    this->EndWriteDataArray();
+  }
+
   template< class TInput, class TOutput >
   void ConvertBuffer(TInput *input, TOutput *output, SizeValueType numberOfElements)
   {
@@ -138,8 +365,40 @@ protected:
   }
 
 private:
+  /** Location of the data of an ExternalFileBinary data array. */
+  struct ExternalDataArray {
+    std::string FileName;
+    long long   Offset;
+    bool        Swap;
+  };
+
+  /** External file mapped in memory. */
+  struct MappedFile {
+    std::string        FileName;
+    MeshIOMappedFile * File;
+  };
+
   bool          m_ReadPointData;
+  bool          m_ReadPointDataFrames;
+  bool          m_UseExternalFile;
+  gifti_stream *m_GiftiStream;
+  int           m_StreamedDataArrays;
+  int           m_WriteDataArray;
+  size_t        m_WriteDataArrayOffset;
+  std::ofstream m_ExternalFile;
   gifti_image * m_GiftiImage;
+  int           m_PointsDataArray;
+  int           m_CellsDataArray;
+  int           m_PointDataDataArray;
+  int           m_CellDataDataArray;
+
+  std::vector< int > m_LoadedDataArrays;
+  std::vector< int > m_DataArrayIntents;
+  std::vector< int > m_FunctionalDataArrays;
+  std::vector< int > m_PointDataFrameDataArrays;
+
+  std::vector< ExternalDataArray > m_ExternalDataArrays;
+  std::vector< MappedFile >        m_MappedFiles;
   DirectionType m_Direction;
 
 private:
@@ -0,0 +1,147 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#if defined( _MSC_VER )
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkMeshCellArena.h"
+
+namespace itk
+{
+namespace
+{
+// Number of cells in the first slab of a type; each further slab doubles
+// up to the maximum.
+const MeshCellArena::SizeValueType MinimumSlabCapacity = 256;
+const MeshCellArena::SizeValueType MaximumSlabCapacity = 65536;
+}
+
+MeshCellArena::MeshCellArena():
+  m_LastDestroyFunction(0),
+  m_LastSlabList(0),
+  m_NumberOfCells(0),
+  m_NumberOfSlabs(0),
+  m_AllocatedBytes(0)
+{}
+
+MeshCellArena::~MeshCellArena()
+{
+  this->Clear();
+}
+
+void * MeshCellArena::Allocate(size_t elementSize, DestroyFunctionType destroyFunction)
+{
+  if ( destroyFunction != m_LastDestroyFunction )
+    {
+    SlabList & list = m_SlabLists[destroyFunction];
+    list.m_ElementSize = elementSize;
+    m_LastSlabList = &list;
+    m_LastDestroyFunction = destroyFunction;
+    }
+
+  std::vector< Slab > & slabs = m_LastSlabList->m_Slabs;
+  if ( slabs.empty() || slabs.back().m_Size == slabs.back().m_Capacity )
+    {
+    SizeValueType capacity = MinimumSlabCapacity;
+    if ( !slabs.empty() )
+      {
+      capacity = slabs.back().m_Capacity * 2;
+      if ( capacity > MaximumSlabCapacity )
+        {
+        capacity = MaximumSlabCapacity;
+        }
+      }
+
+    Slab slab;
+    slab.m_Buffer = static_cast< char * >( ::operator new(capacity * elementSize) );
+    slab.m_Size = 0;
+    slab.m_Capacity = capacity;
+    slabs.push_back(slab);
+
+    ++m_NumberOfSlabs;
+    m_AllocatedBytes += capacity * elementSize;
+    }
+
+  const Slab & slab = slabs.back();
+
+  return slab.m_Buffer + slab.m_Size * elementSize;
+}
+
+void MeshCellArena::Clear()
+{
+  for ( SlabListMapType::iterator it = m_SlabLists.begin(); it != m_SlabLists.end(); ++it )
+    {
+    DestroyFunctionType   destroyFunction = it->first;
+    const size_t          elementSize = it->second.m_ElementSize;
+    std::vector< Slab > & slabs = it->second.m_Slabs;
+
+    for ( size_t ii = 0; ii < slabs.size(); ii++ )
+      {
+      for ( SizeValueType jj = 0; jj < slabs[ii].m_Size; jj++ )
+        {
+        ( *destroyFunction )( slabs[ii].m_Buffer + jj * elementSize );
+        }
+      ::operator delete(slabs[ii].m_Buffer);
+      }
+    }
+
+  m_SlabLists.clear();
+  m_LastDestroyFunction = 0;
+  m_LastSlabList = 0;
+  m_NumberOfCells = 0;
+  m_NumberOfSlabs = 0;
+  m_AllocatedBytes = 0;
+}
+
+void MeshCellArena::Splice(Self *other)
+{
+  if ( other == 0 || other == this )
+    {
+    return;
+    }
+
+  for ( SlabListMapType::iterator it = other->m_SlabLists.begin(); it != other->m_SlabLists.end(); ++it )
+    {
+    SlabList & list = m_SlabLists[it->first];
+    list.m_ElementSize = it->second.m_ElementSize;
+    list.m_Slabs.insert( list.m_Slabs.end(), it->second.m_Slabs.begin(), it->second.m_Slabs.end() );
+    }
+
+  m_NumberOfCells += other->m_NumberOfCells;
+  m_NumberOfSlabs += other->m_NumberOfSlabs;
+  m_AllocatedBytes += other->m_AllocatedBytes;
+
+  // The slabs now belong to this arena, forget them without destroying
+  // the cells
+  other->m_SlabLists.clear();
+  other->m_LastDestroyFunction = 0;
+  other->m_LastSlabList = 0;
+  other->m_NumberOfCells = 0;
+  other->m_NumberOfSlabs = 0;
+  other->m_AllocatedBytes = 0;
+}
+
+void MeshCellArena::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Number of cells: " << m_NumberOfCells << std::endl;
+  os << indent << "Number of slabs: " << m_NumberOfSlabs << std::endl;
+  os << indent << "Allocated bytes: " << m_AllocatedBytes << std::endl;
+}
+} // end namespace itk
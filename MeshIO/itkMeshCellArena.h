@@ -0,0 +1,156 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMeshCellArena_h
+#define __itkMeshCellArena_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkLightObject.h"
+#include "itkObjectFactory.h"
+
+#include <map>
+#include <new>
+#include <vector>
+
+namespace itk
+{
+/** \class MeshCellArena
+ * \brief Slab allocator for the cells of a mesh.
+ *
+ * Cells are placement-constructed in large slabs, one list of slabs per
+ * cell type, and are all destroyed together when the arena is cleared or
+ * deleted. This replaces one heap allocation per cell by one allocation per
+ * slab.
+ *
+ * The arena does not register itself with a mesh. The owner of the cells
+ * container must keep the arena alive for as long as the cells are used,
+ * and must not delete the cells itself (see
+ * Mesh::CellsAllocatedAsStaticArray). MeshFileReader stores the arena in the
+ * MetaDataDictionary of the cells container of its output mesh for that
+ * purpose.
+ *
+ * \sa MeshFileReader
+ */
+class ITK_EXPORT MeshCellArena:public LightObject
+{
+public:
+  /** Standard class typedefs. */
+  typedef MeshCellArena              Self;
+  typedef LightObject                Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  typedef unsigned long SizeValueType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MeshCellArena, LightObject);
+
+  /** Default construct a cell of type TCell inside the arena. The cell is
+   * owned by the arena and must not be deleted by the caller. */
+  template< typename TCell >
+  TCell * ConstructCell()
+  {
+    void *memory = this->Allocate( sizeof( TCell ), &MeshCellArena::DestroyCell< TCell > );
+    TCell *cell = new( memory ) TCell;
+
+    // Only a constructed cell may be destroyed by Clear()
+    this->Commit();
+
+    return cell;
+  }
+
+  /** Destroy every cell and release all the slabs. */
+  void Clear();
+
+  /** Move all the cells of another arena into this one, leaving the other
+   * arena empty. The cells keep their addresses. This is used to gather the
+   * arenas filled by several threads, since an arena itself is not thread
+   * safe. */
+  void Splice(Self *other);
+
+  /** Number of cells constructed in the arena. */
+  itkGetConstMacro(NumberOfCells, SizeValueType);
+
+  /** Number of slabs allocated so far. */
+  itkGetConstMacro(NumberOfSlabs, SizeValueType);
+
+  /** Total size in bytes of the allocated slabs. */
+  itkGetConstMacro(AllocatedBytes, SizeValueType);
+
+protected:
+  MeshCellArena();
+  ~MeshCellArena();
+
+  virtual void PrintSelf(std::ostream & os, Indent indent) const;
+
+  typedef void ( *DestroyFunctionType )(void *);
+
+  /** Return storage for one element of the given size, taken from the
+   * current slab of the type identified by destroyFunction. The storage is
+   * handed out again until Commit() is called. */
+  void * Allocate(size_t elementSize, DestroyFunctionType destroyFunction);
+
+  /** Count the element constructed in the storage returned by the last
+   * call to Allocate(). */
+  void Commit()
+  {
+    ++m_LastSlabList->m_Slabs.back().m_Size;
+    ++m_NumberOfCells;
+  }
+
+  template< typename TCell >
+  static void DestroyCell(void *cell)
+  {
+    static_cast< TCell * >( cell )->~TCell();
+  }
+
+  struct Slab
+    {
+    char *m_Buffer;
+    SizeValueType m_Size;
+    SizeValueType m_Capacity;
+    };
+
+  struct SlabList
+    {
+    size_t m_ElementSize;
+    std::vector< Slab > m_Slabs;
+    };
+
+  typedef std::map< DestroyFunctionType, SlabList > SlabListMapType;
+
+  SlabListMapType     m_SlabLists;
+  DestroyFunctionType m_LastDestroyFunction;
+  SlabList *          m_LastSlabList;
+
+  SizeValueType m_NumberOfCells;
+  SizeValueType m_NumberOfSlabs;
+  SizeValueType m_AllocatedBytes;
+
+private:
+  MeshCellArena(const Self &);  // purposely not implemented
+  void operator=(const Self &); // purposely not implemented
+};
+} // end namespace itk
+
+#endif
@@ -21,19 +21,24 @@
 #include "itkMacro.h"
 #include "itkHexahedronCell.h"
 #include "itkLineCell.h"
+#include "itkMeshCellArena.h"
 #include "itkMeshIOBase.h"
 #include "itkMeshSource.h"
+#include "itkMultiThreader.h"
 #include "itkPolygonCell.h"
 #include "itkQuadrilateralCell.h"
 #include "itkQuadraticEdgeCell.h"
 #include "itkQuadraticTriangleCell.h"
 #include "itkTetrahedronCell.h"
 #include "itkTriangleCell.h"
+#include "itkVectorContainer.h"
 #include "itkVertexCell.h"
 
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkMeshConvertPixelTraits.h"
 
+#include <vector>
+
 namespace itk
 {
 /** \class MeshFileReaderException
@@ -110,16 +115,20 @@ public:
   itkTypeMacro(MeshFileReader, MeshSource);
 
   /** Define output mesh types */
-  typedef TOutputMesh                              OutputMeshType;
-  typedef typename OutputMeshType::CoordRepType    OutputCoordRepType;
-  typedef typename OutputMeshType::PixelType       OutputPointPixelType;
-  typedef typename OutputMeshType::CellPixelType   OutputCellPixelType;
-  typedef typename OutputMeshType::PointType       OutputPointType;
-  typedef typename OutputMeshType::PointIdentifier OutputPointIdentifier;
-  typedef typename OutputMeshType::CellIdentifier  OutputCellIdentifier;
-  typedef typename OutputMeshType::CellAutoPointer OutputCellAutoPointer;
-  typedef typename OutputMeshType::CellType        OutputCellType;
-  typedef typename MeshIOBase::SizeValueType       SizeValueType;
+  typedef TOutputMesh                                 OutputMeshType;
+  typedef typename OutputMeshType::CoordRepType       OutputCoordRepType;
+  typedef typename OutputMeshType::PixelType          OutputPointPixelType;
+  typedef typename OutputMeshType::CellPixelType      OutputCellPixelType;
+  typedef typename OutputMeshType::PointType          OutputPointType;
+  typedef typename OutputMeshType::PointsContainer    OutputPointsContainer;
+  typedef typename OutputMeshType::PointDataContainer OutputPointDataContainer;
+  typedef typename OutputMeshType::CellDataContainer  OutputCellDataContainer;
+  typedef typename OutputMeshType::PointIdentifier    OutputPointIdentifier;
+  typedef typename OutputMeshType::CellIdentifier     OutputCellIdentifier;
+  typedef typename OutputMeshType::CellAutoPointer    OutputCellAutoPointer;
+  typedef typename OutputMeshType::CellType           OutputCellType;
+  typedef typename OutputMeshType::CellsContainer     OutputCellsContainer;
+  typedef typename MeshIOBase::SizeValueType          SizeValueType;
 
   typedef VertexCell< OutputCellType >            OutputVertexCellType;
   typedef LineCell< OutputCellType >              OutputLineCellType;
@@ -148,6 +157,19 @@ public:
 
   itkGetObjectMacro(MeshIO, MeshIOBase);
 
+  /** Set/Get whether the cells are constructed in a MeshCellArena instead of
+   * being allocated one by one. The arena is stored in the
+   * MetaDataDictionary of the cells container of the output mesh under the
+   * key "MeshCellArena", so the cells are released together with the
+   * container, and the cells allocation method of the mesh is set to
+   * CellsAllocatedAsStaticArray. Another mesh given the same cells container
+   * must use CellsAllocatedAsStaticArray too, as it must not delete the
+   * cells. This option is ignored for QuadEdgeMesh, which manages its own
+   * cells. Default is off. */
+  itkSetMacro(UseCellArena, bool);
+  itkGetConstMacro(UseCellArena, bool);
+  itkBooleanMacro(UseCellArena);
+
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. */
   virtual void GenerateOutputInformation();
@@ -164,9 +186,138 @@ public:
 
 protected:
   MeshFileReader();
-  ~MeshFileReader(){}
+  ~MeshFileReader();
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Create a cell of type TCell, in the cell arena when one is in use, and
+   * hand it to the given auto pointer with the matching ownership. */
+  template< typename TCell >
+  TCell * CreateCell(OutputCellAutoPointer & cell);
+
+  /** Construct the cells with the threads of the MultiThreader straight into
+   * a pre-sized, vector-backed cells container. A serial pass first
+   * validates the cell buffer and records, every few cells, the buffer
+   * offset and the output cell identifier (polylines are split into one
+   * line cell per edge, so the two do not advance together). Each thread
+   * then walks its own range of the buffer. Returns false when the mesh
+   * type, the cells container or the number of threads does not allow it,
+   * in which case ReadCells() falls back to the serial construction. */
+  template< typename T >
+  bool ReadCellsInParallel(T *buffer);
+
+  template< typename T >
+  struct ReadCellsThreadStruct
+    {
+    const T *                             Buffer;
+    SizeValueType                         BufferSize;
+    std::vector< SizeValueType >          ChunkOffsets;
+    std::vector< OutputCellIdentifier >   ChunkCellIds;
+    OutputCellType **                     Cells;
+    std::vector< MeshCellArena::Pointer > Arenas;
+    };
+
+  template< typename T >
+  static ITK_THREAD_RETURN_TYPE ReadCellsThreaderCallback(void *arg);
+
+  /** Construct a cell of type TCell, in the given arena if not null, and set
+   * its point identifiers. */
+  template< typename TCell, typename T >
+  static OutputCellType * ConstructCell(MeshCellArena *arena, const T *pointIds, unsigned int numberOfPoints);
+
+  /** Whether TMesh is a QuadEdgeMesh, detected through its QEPrimal type. */
+  template< typename TMesh >
+  struct IsQuadEdgeMesh
+    {
+    typedef char YesType;
+    typedef struct { char m_Dummy[2]; } NoType;
+
+    template< typename T >
+    static YesType Test(typename T::QEPrimal *);
+
+    template< typename T >
+    static NoType Test(...);
+
+    itkStaticConstMacro(Value, bool, sizeof( Test< TMesh >(0) ) == sizeof( YesType ));
+    };
+
+  /** Read the points straight into the storage of a vector-backed points
+   * container, through MeshIOBase::ReadPointsAs(). This is only possible
+   * when the file stores the coordinates with the dimension of
+   * OutputPointType; returns false when ReadPoints(T *) has to be used
+   * instead. */
+  bool ReadPointsInPlace();
+
+  /** Visitors for MeshIOBase::VisitComponentType() that read the points and
+   * the cells with the component type of the file. */
+  class ReadPointsVisitor
+  {
+public:
+    ReadPointsVisitor(Self *reader):m_Reader(reader) {}
+
+    template< typename T >
+    void Visit()
+    {
+      MeshIOBase *             meshIO = m_Reader->GetMeshIO();
+      MeshIOScratchBuffer< T > pointsBuffer(meshIO->GetNumberOfPoints() * OutputPointDimension);
+
+      meshIO->ReadPoints( static_cast< void * >( pointsBuffer.GetBuffer() ) );
+      m_Reader->ReadPoints( pointsBuffer.GetBuffer() );
+    }
+
+private:
+    Self *m_Reader;
+  };
+
+  class ReadCellsVisitor
+  {
+public:
+    ReadCellsVisitor(Self *reader):m_Reader(reader) {}
+
+    template< typename T >
+    void Visit()
+    {
+      MeshIOBase *             meshIO = m_Reader->GetMeshIO();
+      MeshIOScratchBuffer< T > cellsBuffer(meshIO->GetCellBufferSize());
+
+      meshIO->ReadCells( static_cast< void * >( cellsBuffer.GetBuffer() ) );
+      m_Reader->ReadCells( cellsBuffer.GetBuffer() );
+    }
+
+private:
+    Self *m_Reader;
+  };
+
+  /** Return the contiguous storage of a VectorContainer, or null for any
+   * other kind of container. */
+  template< typename TElementIdentifier, typename TElement >
+  static void * GetContiguousStorage(VectorContainer< TElementIdentifier, TElement > *container)
+  {
+    if ( container->Size() == 0 )
+      {
+      return 0;
+      }
+    return static_cast< void * >( &( container->ElementAt(0) ) );
+  }
+
+  template< typename TContainer >
+  static void * GetContiguousStorage(TContainer *itkNotUsed(container))
+  {
+    return 0;
+  }
+
+  /** Whether a container type is a VectorContainer. */
+  template< typename TElementIdentifier, typename TElement >
+  static bool IsContiguousContainer(const VectorContainer< TElementIdentifier, TElement > *itkNotUsed(container))
+  {
+    return true;
+  }
+
+  template< typename TContainer >
+  static bool IsContiguousContainer(const TContainer *itkNotUsed(container))
+  {
+    return false;
+  }
+
   /** Convert a block of pixels from one type to another. */
   template< typename T >
   void ConvertPointPixelBuffer(void *inputData, T *outputData, size_t numberOfPixels);
@@ -188,6 +339,9 @@ protected:
   bool                m_UserSpecifiedMeshIO; // keep track whether the MeshIO is
                                              // user specified
   std::string m_FileName;                    // The file to be read
+
+  bool                   m_UseCellArena;
+  MeshCellArena::Pointer m_CellArena; // arena of the cells being read, if any
 private:
   MeshFileReader(const Self &); // purposely not implemented
   void operator=(const Self &); // purposely not implemented
@@ -24,6 +24,7 @@
 #include "itkMeshIOFactory.h"
 #include "itkMeshFileReader.h"
 #include "itkMeshRegion.h"
+#include "itkMetaDataObject.h"
 #include "itkObjectFactory.h"
 #include "itkPixelTraits.h"
 
@@ -38,6 +39,15 @@ MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::
   m_MeshIO = 0;
   m_FileName = "";
   m_UserSpecifiedMeshIO = false;
+  m_UseCellArena = false;
+
+  MeshIOBufferPool::AddUser();
+}
+
+template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
+MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::~MeshFileReader()
+{
+  MeshIOBufferPool::RemoveUser();
 }
 
 template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
@@ -57,6 +67,7 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
 
   os << indent << "UserSpecifiedMeshIO flag: " << m_UserSpecifiedMeshIO << "\n";
   os << indent << "m_FileName: " << m_FileName << "\n";
+  os << indent << "UseCellArena: " << m_UseCellArena << "\n";
 }
 
 template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
@@ -111,24 +122,89 @@ template< class T >
 void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::ReadPoints(T *buffer)
 {
   typename TOutputMesh::Pointer output = this->GetOutput();
-  output->GetPoints()->Reserve( m_MeshIO->GetNumberOfPoints() );
-  OutputPointType point;
 
-  for ( OutputPointIdentifier id = 0; id < output->GetNumberOfPoints(); id++ )
+  typename OutputPointsContainer::Pointer points = OutputPointsContainer::New();
+  if ( m_MeshIO->GetNumberOfPoints() )
     {
-    for ( OutputPointIdentifier ii = 0; ii < OutputPointDimension; ii++ )
+    points->Reserve( m_MeshIO->GetNumberOfPoints() );
+    }
+
+  // Fill the pre-sized container in a single pass, converting the
+  // coordinates as they are copied
+  const T *                                inputPoint = buffer;
+  typename OutputPointsContainer::Iterator pointIterator = points->Begin();
+  while ( pointIterator != points->End() )
+    {
+    OutputPointType & point = pointIterator.Value();
+    for ( unsigned int ii = 0; ii < OutputPointDimension; ii++ )
       {
-      point[ii] = static_cast< typename OutputPointType::ValueType >( buffer[id * OutputPointDimension + ii] );
+      point[ii] = static_cast< typename OutputPointType::ValueType >( inputPoint[ii] );
       }
 
-    output->SetPoint(id, point);
+    inputPoint += OutputPointDimension;
+    ++pointIterator;
     }
+
+  output->SetPoints(points);
+}
+
+template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
+bool MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::ReadPointsInPlace()
+{
+  typedef typename OutputPointType::ValueType OutputPointValueType;
+
+  if ( m_MeshIO->GetPointDimension() != OutputPointDimension
+       || sizeof( OutputPointType ) != OutputPointDimension * sizeof( OutputPointValueType )
+       || m_MeshIO->GetNumberOfPoints() == 0 )
+    {
+    return false;
+    }
+
+  typename OutputPointsContainer::Pointer points = OutputPointsContainer::New();
+  points->Reserve( m_MeshIO->GetNumberOfPoints() );
+
+  void *storage = GetContiguousStorage( points.GetPointer() );
+  if ( storage == 0 )
+    {
+    return false;
+    }
+
+  itkDebugMacro(<< "Reading points directly into the points container.");
+  m_MeshIO->ReadPointsAs( static_cast< OutputPointValueType * >( storage ) );
+
+  this->GetOutput()->SetPoints(points);
+  return true;
+}
+
+template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
+template< typename TCell >
+TCell * MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::CreateCell(OutputCellAutoPointer & cell)
+{
+  TCell *newCell;
+
+  if ( m_CellArena )
+    {
+    newCell = m_CellArena->ConstructCell< TCell >();
+    cell.TakeNoOwnership(newCell);
+    }
+  else
+    {
+    newCell = new TCell;
+    cell.TakeOwnership(newCell);
+    }
+
+  return newCell;
 }
 
 template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
 template< class T >
 void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::ReadCells(T *buffer)
 {
+  if ( this->ReadCellsInParallel(buffer) )
+    {
+    return;
+    }
+
   typename TOutputMesh::Pointer output = this->GetOutput();
 
   SizeValueType        index = NumericTraits< SizeValueType >::Zero;
@@ -146,13 +222,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           itkExceptionMacro(<< "Invalid Vertex Cell with number of points = " << numberOfPoints);
           }
         OutputCellAutoPointer cell;
-        OutputVertexCellType *vertexCell = new OutputVertexCellType;
+        OutputVertexCellType *vertexCell = this->CreateCell< OutputVertexCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputVertexCellType::NumberOfPoints; jj++ )
           {
           vertexCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(vertexCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -168,11 +243,10 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
         for ( unsigned int jj = 1; jj < numberOfPoints; ++jj )
           {
           OutputCellAutoPointer cell;
-          OutputLineCellType *  lineCell = new OutputLineCellType;
+          OutputLineCellType *  lineCell = this->CreateCell< OutputLineCellType >(cell);
           lineCell->SetPointId(0, pointIDBuffer);
           pointIDBuffer = static_cast< OutputPointIdentifier >( buffer[index++] );
           lineCell->SetPointId(1, pointIDBuffer);
-          cell.TakeOwnership(lineCell);
           output->SetCell(id++, cell);
           }
         break;
@@ -186,13 +260,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           }
 
         OutputCellAutoPointer   cell;
-        OutputTriangleCellType *triangleCell = new OutputTriangleCellType;
+        OutputTriangleCellType *triangleCell = this->CreateCell< OutputTriangleCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputTriangleCellType::NumberOfPoints; jj++ )
           {
           triangleCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(triangleCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -205,13 +278,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           }
 
         OutputCellAutoPointer        cell;
-        OutputQuadrilateralCellType *quadrilateralCell = new OutputQuadrilateralCellType;
+        OutputQuadrilateralCellType *quadrilateralCell = this->CreateCell< OutputQuadrilateralCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputQuadrilateralCellType::NumberOfPoints; jj++ )
           {
           quadrilateralCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(quadrilateralCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -223,21 +295,19 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
         unsigned int          numberOfPoints = static_cast< unsigned int >( buffer[index++] );
         if ( numberOfPoints == OutputTriangleCellType::NumberOfPoints )
           {
-          OutputTriangleCellType *triangleCell = new OutputTriangleCellType;
+          OutputTriangleCellType *triangleCell = this->CreateCell< OutputTriangleCellType >(cell);
           for ( unsigned int jj = 0; jj < OutputTriangleCellType::NumberOfPoints; jj++ )
             {
             triangleCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
             }
-          cell.TakeOwnership(triangleCell);
           }
         else
           {
-          OutputPolygonCellType *polygonCell = new OutputPolygonCellType;
+          OutputPolygonCellType *polygonCell = this->CreateCell< OutputPolygonCellType >(cell);
           for ( unsigned int jj = 0; jj < numberOfPoints; jj++ )
             {
             polygonCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
             }
-          cell.TakeOwnership(polygonCell);
           }
 
         output->SetCell(id++, cell);
@@ -252,13 +322,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           }
 
         OutputCellAutoPointer      cell;
-        OutputTetrahedronCellType *tetrahedronCell = new OutputTetrahedronCellType;
+        OutputTetrahedronCellType *tetrahedronCell = this->CreateCell< OutputTetrahedronCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputTetrahedronCellType::NumberOfPoints; jj++ )
           {
           tetrahedronCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(tetrahedronCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -271,13 +340,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           }
 
         OutputCellAutoPointer     cell;
-        OutputHexahedronCellType *hexahedronCell = new OutputHexahedronCellType;
+        OutputHexahedronCellType *hexahedronCell = this->CreateCell< OutputHexahedronCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputHexahedronCellType::NumberOfPoints; jj++ )
           {
           hexahedronCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(hexahedronCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -290,13 +358,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           }
 
         OutputCellAutoPointer        cell;
-        OutputQuadraticEdgeCellType *quadraticEdgeCell = new OutputQuadraticEdgeCellType;
+        OutputQuadraticEdgeCellType *quadraticEdgeCell = this->CreateCell< OutputQuadraticEdgeCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputQuadraticEdgeCellType::NumberOfPoints; jj++ )
           {
           quadraticEdgeCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(quadraticEdgeCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -309,13 +376,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
           }
 
         OutputCellAutoPointer            cell;
-        OutputQuadraticTriangleCellType *quadraticTriangleCell = new OutputQuadraticTriangleCellType;
+        OutputQuadraticTriangleCellType *quadraticTriangleCell = this->CreateCell< OutputQuadraticTriangleCellType >(cell);
         for ( unsigned int jj = 0; jj < OutputQuadraticTriangleCellType::NumberOfPoints; jj++ )
           {
           quadraticTriangleCell->SetPointId( jj, static_cast< OutputPointIdentifier >( buffer[index++] ) );
           }
 
-        cell.TakeOwnership(quadraticTriangleCell);
         output->SetCell(id++, cell);
         break;
         }
@@ -327,19 +393,284 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
     }
 }
 
+template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
+template< class T >
+bool MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::ReadCellsInParallel(T *buffer)
+{
+  // Below this number of cells per thread, starting the threads costs more
+  // than it saves
+  const SizeValueType minimumNumberOfCellsPerThread = 4096;
+
+  ThreadIdType numberOfThreads = this->GetNumberOfThreads();
+  if ( numberOfThreads > m_MeshIO->GetNumberOfCells() / minimumNumberOfCellsPerThread )
+    {
+    numberOfThreads = static_cast< ThreadIdType >( m_MeshIO->GetNumberOfCells() / minimumNumberOfCellsPerThread );
+    }
+
+  // QuadEdgeMesh builds its own cells in SetCell(), and only a
+  // VectorContainer can be filled concurrently
+  if ( numberOfThreads < 2
+       || IsQuadEdgeMesh< OutputMeshType >::Value
+       || !IsContiguousContainer( static_cast< OutputCellsContainer * >( 0 ) ) )
+    {
+    return false;
+    }
+
+  ReadCellsThreadStruct< T > str;
+  str.Buffer = buffer;
+  str.BufferSize = m_MeshIO->GetCellBufferSize();
+
+  // Validate the whole buffer and record where each chunk of cells starts,
+  // in the buffer and in the output cells container. The threads can then
+  // construct the cells without any further check.
+  const SizeValueType  chunkSize = m_MeshIO->GetNumberOfCells() / ( 4 * numberOfThreads ) + 1;
+  SizeValueType        numberOfRecords = NumericTraits< SizeValueType >::Zero;
+  SizeValueType        index = NumericTraits< SizeValueType >::Zero;
+  OutputCellIdentifier id = NumericTraits< OutputCellIdentifier >::Zero;
+  while ( index < str.BufferSize )
+    {
+    if ( numberOfRecords++ % chunkSize == 0 )
+      {
+      str.ChunkOffsets.push_back(index);
+      str.ChunkCellIds.push_back(id);
+      }
+
+    if ( index + 2 > str.BufferSize )
+      {
+      itkExceptionMacro(<< "Truncated cell buffer");
+      }
+    MeshIOBase::CellGeometryType type = static_cast< MeshIOBase::CellGeometryType >( static_cast< int >( buffer[index++] ) );
+    unsigned int                 numberOfPoints = static_cast< unsigned int >( buffer[index++] );
+    if ( index + numberOfPoints > str.BufferSize )
+      {
+      itkExceptionMacro(<< "Truncated cell buffer");
+      }
+    index += numberOfPoints;
+
+    switch ( type )
+      {
+      case MeshIOBase::VERTEX_CELL:
+        if ( numberOfPoints != OutputVertexCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Vertex Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      case MeshIOBase::LINE_CELL:
+        if ( numberOfPoints < 2 )
+          {
+          itkExceptionMacro(<< "Invalid Line Cell with number of points = " << numberOfPoints);
+          }
+        id += numberOfPoints - 1;
+        break;
+      case MeshIOBase::TRIANGLE_CELL:
+        if ( numberOfPoints != OutputTriangleCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Triangle Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      case MeshIOBase::QUADRILATERAL_CELL:
+        if ( numberOfPoints != OutputQuadrilateralCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Quadrilateral Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      case MeshIOBase::POLYGON_CELL:
+        ++id;
+        break;
+      case MeshIOBase::TETRAHEDRON_CELL:
+        if ( numberOfPoints != OutputTetrahedronCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Tetrahedron Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      case MeshIOBase::HEXAHEDRON_CELL:
+        if ( numberOfPoints != OutputHexahedronCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Hexahedron Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      case MeshIOBase::QUADRATIC_EDGE_CELL:
+        if ( numberOfPoints != OutputQuadraticEdgeCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Quadratic edge Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      case MeshIOBase::QUADRATIC_TRIANGLE_CELL:
+        if ( numberOfPoints != OutputQuadraticTriangleCellType::NumberOfPoints )
+          {
+          itkExceptionMacro(<< "Invalid Quadratic triangle Cell with number of points = " << numberOfPoints);
+          }
+        ++id;
+        break;
+      default:
+        itkExceptionMacro(<< "Unknown cell type");
+      }
+    }
+
+  if ( id == 0 )
+    {
+    return false;
+    }
+
+  typename OutputCellsContainer::Pointer cells = OutputCellsContainer::New();
+  cells->Reserve(id);
+  str.Cells = static_cast< OutputCellType ** >( GetContiguousStorage( cells.GetPointer() ) );
+
+  // Each thread fills its own arena, they are gathered afterwards
+  if ( m_CellArena )
+    {
+    str.Arenas.resize(numberOfThreads);
+    for ( ThreadIdType ii = 0; ii < numberOfThreads; ii++ )
+      {
+      str.Arenas[ii] = MeshCellArena::New();
+      }
+    }
+
+  itkDebugMacro(<< "Constructing " << id << " cells with " << numberOfThreads << " threads");
+
+  this->GetMultiThreader()->SetNumberOfThreads(numberOfThreads);
+  this->GetMultiThreader()->SetSingleMethod(&Self::template ReadCellsThreaderCallback< T >, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  for ( size_t ii = 0; ii < str.Arenas.size(); ii++ )
+    {
+    m_CellArena->Splice(str.Arenas[ii]);
+    }
+
+  this->GetOutput()->SetCells(cells);
+  return true;
+}
+
+template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
+template< class T >
+ITK_THREAD_RETURN_TYPE MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >
+::ReadCellsThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ReadCellsThreadStruct< T > *     str = static_cast< ReadCellsThreadStruct< T > * >( info->UserData );
+
+  // Split the chunks evenly among the threads
+  const size_t numberOfChunks = str->ChunkOffsets.size();
+  const size_t firstChunk = numberOfChunks * info->ThreadID / info->NumberOfThreads;
+  const size_t lastChunk = numberOfChunks * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+  if ( firstChunk == lastChunk )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  MeshCellArena *arena = str->Arenas.empty() ? 0 : str->Arenas[info->ThreadID].GetPointer();
+  const T *      buffer = str->Buffer;
+  OutputCellType **cells = str->Cells;
+
+  SizeValueType        index = str->ChunkOffsets[firstChunk];
+  const SizeValueType  end = lastChunk < numberOfChunks ? str->ChunkOffsets[lastChunk] : str->BufferSize;
+  OutputCellIdentifier id = str->ChunkCellIds[firstChunk];
+  while ( index < end )
+    {
+    MeshIOBase::CellGeometryType type = static_cast< MeshIOBase::CellGeometryType >( static_cast< int >( buffer[index++] ) );
+    unsigned int                 numberOfPoints = static_cast< unsigned int >( buffer[index++] );
+    const T *                    pointIds = buffer + index;
+    index += numberOfPoints;
+
+    switch ( type )
+      {
+      case MeshIOBase::VERTEX_CELL:
+        cells[id++] = ConstructCell< OutputVertexCellType >(arena, pointIds, numberOfPoints);
+        break;
+      case MeshIOBase::LINE_CELL:
+        // for polylines will be loaded as individual edges.
+        for ( unsigned int jj = 1; jj < numberOfPoints; ++jj )
+          {
+          cells[id++] = ConstructCell< OutputLineCellType >(arena, pointIds + jj - 1, 2);
+          }
+        break;
+      case MeshIOBase::TRIANGLE_CELL:
+        cells[id++] = ConstructCell< OutputTriangleCellType >(arena, pointIds, numberOfPoints);
+        break;
+      case MeshIOBase::QUADRILATERAL_CELL:
+        cells[id++] = ConstructCell< OutputQuadrilateralCellType >(arena, pointIds, numberOfPoints);
+        break;
+      case MeshIOBase::POLYGON_CELL:
+        if ( numberOfPoints == OutputTriangleCellType::NumberOfPoints )
+          {
+          cells[id++] = ConstructCell< OutputTriangleCellType >(arena, pointIds, numberOfPoints);
+          }
+        else
+          {
+          cells[id++] = ConstructCell< OutputPolygonCellType >(arena, pointIds, numberOfPoints);
+          }
+        break;
+      case MeshIOBase::TETRAHEDRON_CELL:
+        cells[id++] = ConstructCell< OutputTetrahedronCellType >(arena, pointIds, numberOfPoints);
+        break;
+      case MeshIOBase::HEXAHEDRON_CELL:
+        cells[id++] = ConstructCell< OutputHexahedronCellType >(arena, pointIds, numberOfPoints);
+        break;
+      case MeshIOBase::QUADRATIC_EDGE_CELL:
+        cells[id++] = ConstructCell< OutputQuadraticEdgeCellType >(arena, pointIds, numberOfPoints);
+        break;
+      case MeshIOBase::QUADRATIC_TRIANGLE_CELL:
+        cells[id++] = ConstructCell< OutputQuadraticTriangleCellType >(arena, pointIds, numberOfPoints);
+        break;
+      default:
+        // already rejected by ReadCellsInParallel()
+        break;
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
+template< typename TCell, typename T >
+typename MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::OutputCellType *
+MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >
+::ConstructCell(MeshCellArena *arena, const T *pointIds, unsigned int numberOfPoints)
+{
+  TCell *cell = arena ? arena->ConstructCell< TCell >() : new TCell;
+
+  for ( unsigned int jj = 0; jj < numberOfPoints; jj++ )
+    {
+    cell->SetPointId( jj, static_cast< OutputPointIdentifier >( pointIds[jj] ) );
+    }
+
+  return cell;
+}
+
 template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
 void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTraits >::ReadPointData()
 {
   typename TOutputMesh::Pointer output = this->GetOutput();
 
-  char *                inputPointDataBuffer = 0;
-  OutputPointPixelType *outputPointDataBuffer = new OutputPointPixelType[m_MeshIO->GetNumberOfPointPixels()];
+  typename OutputPointDataContainer::Pointer pointData = OutputPointDataContainer::New();
+  if ( m_MeshIO->GetNumberOfPointPixels() )
+    {
+    pointData->Reserve( m_MeshIO->GetNumberOfPointPixels() );
+    }
+
+  // Decode straight into the storage of a vector-backed container, and
+  // through a temporary array otherwise
+  OutputPointPixelType *outputPointDataBuffer =
+    static_cast< OutputPointPixelType * >( GetContiguousStorage( pointData.GetPointer() ) );
+  const bool            useContainerStorage = ( outputPointDataBuffer != 0 );
+  if ( !useContainerStorage )
+    {
+    outputPointDataBuffer = new OutputPointPixelType[m_MeshIO->GetNumberOfPointPixels()];
+    }
 
   try
     {
     if ( ( m_MeshIO->GetPointPixelComponentType() !=
            MeshIOBase::MapComponentType< ITK_TYPENAME ConvertPointPixelTraits::ComponentType >::CType )
-        || ( m_MeshIO->GetNumberOfPointPixelComponents() != ConvertPointPixelTraits::GetNumberOfComponents() ) )
+        || ( m_MeshIO->GetNumberOfPointPixelComponents() != ConvertPointPixelTraits::GetNumberOfComponents() )
+        || ( sizeof( OutputPointPixelType ) != ConvertPointPixelTraits::GetNumberOfComponents()
+             * sizeof( ITK_TYPENAME ConvertPointPixelTraits::ComponentType ) ) )
       {
       // the point pixel types don't match a type conversion needs to be
       // performed
@@ -353,12 +684,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
                      << " m_MeshIO->NumberOfComponents "
                      << m_MeshIO->GetNumberOfPointPixelComponents() );
 
-      inputPointDataBuffer =
-        new char[m_MeshIO->GetNumberOfPointPixelComponents() * m_MeshIO->GetComponentSize( m_MeshIO->GetPointPixelComponentType() )
-                 * m_MeshIO->GetNumberOfPointPixels()];
-      m_MeshIO->ReadPointData( static_cast< void * >( inputPointDataBuffer ) );
+      MeshIOScratchBuffer< char > inputPointDataBuffer(
+        m_MeshIO->GetNumberOfPointPixelComponents() * m_MeshIO->GetComponentSize( m_MeshIO->GetPointPixelComponentType() )
+        * m_MeshIO->GetNumberOfPointPixels() );
+      m_MeshIO->ReadPointData( static_cast< void * >( inputPointDataBuffer.GetBuffer() ) );
 
-      this->ConvertPointPixelBuffer( static_cast< void * >( inputPointDataBuffer ), outputPointDataBuffer, m_MeshIO->GetNumberOfPointPixels() );
+      this->ConvertPointPixelBuffer( static_cast< void * >( inputPointDataBuffer.GetBuffer() ), outputPointDataBuffer, m_MeshIO->GetNumberOfPointPixels() );
       }
     else
       {
@@ -369,14 +700,7 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
   catch ( ... )
     {
     // if an exception is thrown catch it
-    if ( inputPointDataBuffer )
-      {
-      // clean up
-      delete[] inputPointDataBuffer;
-      inputPointDataBuffer = 0;
-      }
-
-    if ( outputPointDataBuffer )
+    if ( !useContainerStorage )
       {
       // clean up
       delete[] outputPointDataBuffer;
@@ -387,23 +711,21 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
     throw;
     }
 
-  // clean up
-  if ( inputPointDataBuffer )
-    {
-    delete[] inputPointDataBuffer;
-    inputPointDataBuffer = 0;
-    }
-
-  for ( OutputPointIdentifier id = 0; id < m_MeshIO->GetNumberOfPointPixels(); id++ )
+  if ( !useContainerStorage )
     {
-    output->SetPointData(id, outputPointDataBuffer[id]);
-    }
+    OutputPointPixelType *                      pixel = outputPointDataBuffer;
+    typename OutputPointDataContainer::Iterator pointDataIterator = pointData->Begin();
+    while ( pointDataIterator != pointData->End() )
+      {
+      pointDataIterator.Value() = *pixel++;
+      ++pointDataIterator;
+      }
 
-  if ( outputPointDataBuffer )
-    {
     delete[] outputPointDataBuffer;
     outputPointDataBuffer = 0;
     }
+
+  output->SetPointData(pointData);
 }
 
 template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
@@ -411,14 +733,29 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
 {
   typename TOutputMesh::Pointer output = this->GetOutput();
 
-  char *               inputCellDataBuffer = 0;
-  OutputCellPixelType *outputCellDataBuffer = new OutputCellPixelType[m_MeshIO->GetNumberOfCellPixels()];
+  typename OutputCellDataContainer::Pointer cellData = OutputCellDataContainer::New();
+  if ( m_MeshIO->GetNumberOfCellPixels() )
+    {
+    cellData->Reserve( m_MeshIO->GetNumberOfCellPixels() );
+    }
+
+  // Decode straight into the storage of a vector-backed container, and
+  // through a temporary array otherwise
+  OutputCellPixelType *outputCellDataBuffer =
+    static_cast< OutputCellPixelType * >( GetContiguousStorage( cellData.GetPointer() ) );
+  const bool           useContainerStorage = ( outputCellDataBuffer != 0 );
+  if ( !useContainerStorage )
+    {
+    outputCellDataBuffer = new OutputCellPixelType[m_MeshIO->GetNumberOfCellPixels()];
+    }
 
   try
     {
     if ( ( m_MeshIO->GetCellPixelComponentType() !=
            MeshIOBase::MapComponentType< ITK_TYPENAME ConvertCellPixelTraits::ComponentType >::CType )
-        || ( m_MeshIO->GetNumberOfCellPixelComponents() != ConvertCellPixelTraits::GetNumberOfComponents() ) )
+        || ( m_MeshIO->GetNumberOfCellPixelComponents() != ConvertCellPixelTraits::GetNumberOfComponents() )
+        || ( sizeof( OutputCellPixelType ) != ConvertCellPixelTraits::GetNumberOfComponents()
+             * sizeof( ITK_TYPENAME ConvertCellPixelTraits::ComponentType ) ) )
       {
       // the cell pixel types don't match a type conversion needs to be
       // performed
@@ -432,12 +769,12 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
                      << " m_MeshIO->NumberOfComponents "
                      << m_MeshIO->GetNumberOfCellPixelComponents() );
 
-      inputCellDataBuffer =
-        new char[m_MeshIO->GetNumberOfCellPixelComponents() * m_MeshIO->GetComponentSize( m_MeshIO->GetCellPixelComponentType() )
-                 * m_MeshIO->GetNumberOfCellPixels()];
-      m_MeshIO->ReadCellData( static_cast< void * >( inputCellDataBuffer ) );
+      MeshIOScratchBuffer< char > inputCellDataBuffer(
+        m_MeshIO->GetNumberOfCellPixelComponents() * m_MeshIO->GetComponentSize( m_MeshIO->GetCellPixelComponentType() )
+        * m_MeshIO->GetNumberOfCellPixels() );
+      m_MeshIO->ReadCellData( static_cast< void * >( inputCellDataBuffer.GetBuffer() ) );
 
-      this->ConvertCellPixelBuffer( static_cast< void * >( inputCellDataBuffer ), outputCellDataBuffer, m_MeshIO->GetNumberOfCellPixels() );
+      this->ConvertCellPixelBuffer( static_cast< void * >( inputCellDataBuffer.GetBuffer() ), outputCellDataBuffer, m_MeshIO->GetNumberOfCellPixels() );
       }
     else
       {
@@ -448,15 +785,7 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
   catch ( ... )
     {
     // if an exception is thrown catch it
-
-    if ( inputCellDataBuffer )
-      {
-      // clean up
-      delete[] inputCellDataBuffer;
-      inputCellDataBuffer = 0;
-      }
-
-    if ( outputCellDataBuffer )
+    if ( !useContainerStorage )
       {
       // clean up
       delete[] outputCellDataBuffer;
@@ -467,23 +796,21 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
     throw;
     }
 
-  // clean up
-  if ( inputCellDataBuffer )
-    {
-    delete[] inputCellDataBuffer;
-    inputCellDataBuffer = 0;
-    }
-
-  for ( OutputCellIdentifier id = 0; id < m_MeshIO->GetNumberOfCellPixels(); id++ )
+  if ( !useContainerStorage )
     {
-    output->SetCellData(id, outputCellDataBuffer[id]);
-    }
+    OutputCellPixelType *                      pixel = outputCellDataBuffer;
+    typename OutputCellDataContainer::Iterator cellDataIterator = cellData->Begin();
+    while ( cellDataIterator != cellData->End() )
+      {
+      cellDataIterator.Value() = *pixel++;
+      ++cellDataIterator;
+      }
 
-  if ( outputCellDataBuffer )
-    {
     delete[] outputCellDataBuffer;
     outputCellDataBuffer = 0;
     }
+
+  output->SetCellData(cellData);
 }
 
 template< class TOutputMesh, class ConvertPointPixelTraits, class ConvertCellPixelTraits >
@@ -568,236 +895,47 @@ void MeshFileReader< TOutputMesh, ConvertPointPixelTraits, ConvertCellPixelTrait
   m_MeshIO->ReadMeshInformation();
 
   // Read points
-  if ( m_MeshIO->GetUpdatePoints() )
+  if ( m_MeshIO->GetUpdatePoints() && !this->ReadPointsInPlace() )
     {
-    switch ( m_MeshIO->GetPointComponentType() )
-      {
-      case MeshIOBase::CHAR:
-        {
-        char *pointsBuffer = new char[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::UCHAR:
-        {
-        unsigned char *pointsBuffer = new unsigned char[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::SHORT:
-        {
-        short *pointsBuffer = new short[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::USHORT:
-        {
-        unsigned short *pointsBuffer = new unsigned short[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::INT:
-        {
-        int *pointsBuffer = new int[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::UINT:
-        {
-        unsigned int *pointsBuffer = new unsigned int[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::LONG:
-        {
-        long *pointsBuffer = new long[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::ULONG:
-        {
-        unsigned long *pointsBuffer = new unsigned long[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::LONGLONG:
-        {
-        long long *pointsBuffer = new long long[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::ULONGLONG:
-        {
-        unsigned long long *pointsBuffer = new unsigned long long[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::FLOAT:
-        {
-        float *pointsBuffer = new float[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::DOUBLE:
-        {
-        double *pointsBuffer = new double[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::LDOUBLE:
-        {
-        long double *pointsBuffer = new long double[m_MeshIO->GetNumberOfPoints() * OutputPointDimension];
-        m_MeshIO->ReadPoints( static_cast< void * >( pointsBuffer ) );
-        ReadPoints(pointsBuffer);
-        delete[] pointsBuffer;
-        break;
-        }
-      case MeshIOBase::UNKNOWNCOMPONENTTYPE:
-      default:
-        {
-        itkExceptionMacro(<< "Unknown point component type");
-        }
-      }
+    ReadPointsVisitor visitor(this);
+    m_MeshIO->VisitComponentType(m_MeshIO->GetPointComponentType(), visitor);
     }
 
   // Read cells
   if ( m_MeshIO->GetUpdateCells() )
     {
-    switch ( m_MeshIO->GetCellComponentType() )
+    // The cells allocation method has to be set after Initialize(), which
+    // released the previous cells according to the previous method
+    m_CellArena = 0;
+    if ( !IsQuadEdgeMesh< OutputMeshType >::Value )
       {
-      case MeshIOBase::CHAR:
-        {
-        char *cellsBuffer = new char[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::UCHAR:
-        {
-        unsigned char *cellsBuffer = new unsigned char[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::SHORT:
-        {
-        short *cellsBuffer = new short[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::USHORT:
-        {
-        unsigned short *cellsBuffer = new unsigned short[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::INT:
-        {
-        int *cellsBuffer = new int[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::UINT:
-        {
-        unsigned int *cellsBuffer = new unsigned int[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::LONG:
-        {
-        long *cellsBuffer = new long[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::ULONG:
+      if ( m_UseCellArena )
         {
-        unsigned long *cellsBuffer = new unsigned long[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::LONGLONG:
-        {
-        long long *cellsBuffer = new long long[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::ULONGLONG:
-        {
-        unsigned long long *cellsBuffer = new unsigned long long[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
+        m_CellArena = MeshCellArena::New();
+        output->SetCellsAllocationMethod(OutputMeshType::CellsAllocatedAsStaticArray);
         }
-      case MeshIOBase::FLOAT:
+      else
         {
-        float *cellsBuffer = new float[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
+        output->SetCellsAllocationMethod(OutputMeshType::CellsAllocatedDynamicallyCellByCell);
         }
-      case MeshIOBase::DOUBLE:
-        {
-        double *cellsBuffer = new double[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::LDOUBLE:
-        {
-        long double *cellsBuffer = new long double[m_MeshIO->GetCellBufferSize()];
-        m_MeshIO->ReadCells( static_cast< void * >( cellsBuffer ) );
-        ReadCells(cellsBuffer);
-        delete[] cellsBuffer;
-        break;
-        }
-      case MeshIOBase::UNKNOWNCOMPONENTTYPE:
-      default:
+      }
+
+    ReadCellsVisitor visitor(this);
+    m_MeshIO->VisitComponentType(m_MeshIO->GetCellComponentType(), visitor);
+
+    if ( m_CellArena )
+      {
+      // The cells container holds the arena of its cells, so that the cells
+      // stay valid as long as the container, in whatever mesh it ends up
+      if ( output->GetCells() )
         {
-        itkExceptionMacro(<< "Unknown cell component type");
+        EncapsulateMetaData< MeshCellArena::Pointer >(output->GetCells()->GetMetaDataDictionary(),
+                                                      "MeshCellArena", m_CellArena);
         }
+      itkDebugMacro(<< "Cell arena: " << m_CellArena->GetNumberOfCells() << " cells in "
+                    << m_CellArena->GetNumberOfSlabs() << " slabs, "
+                    << m_CellArena->GetAllocatedBytes() << " bytes");
+      m_CellArena = 0;
       }
     }
 
@@ -38,12 +38,16 @@ MeshFileWriter< TInputMesh >
   m_FactorySpecifiedMeshIO = false;
   m_UserSpecifiedMeshIO = false;
   m_FileTypeIsBINARY = false;
+
+  MeshIOBufferPool::AddUser();
 }
 
 template< class TInputMesh >
 MeshFileWriter< TInputMesh >
 ::~MeshFileWriter()
-{}
+{
+  MeshIOBufferPool::RemoveUser();
+}
 
 template< class TInputMesh >
 void
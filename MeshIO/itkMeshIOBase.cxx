@@ -27,6 +27,8 @@ MeshIOBase::MeshIOBase():
   m_ByteOrder(OrderNotApplicable),
   m_FileType(ASCII),
   m_UseCompression(false),
+  m_CompressionLevel(6),
+  m_NumberOfThreads( MultiThreader::GetGlobalDefaultNumberOfThreads() ),
   m_PointComponentType(UNKNOWNCOMPONENTTYPE),
   m_CellComponentType(UNKNOWNCOMPONENTTYPE),
   m_PointPixelComponentType(UNKNOWNCOMPONENTTYPE),
@@ -222,6 +224,9 @@ void MeshIOBase::PrintSelf(std::ostream & os, Indent indent) const
   os << indent << "FileName: " << m_FileName << std::endl;
   os << indent << "FileType: " << GetFileTypeAsString(m_FileType) << std::endl;
   os << indent << "ByteOrder: " << GetByteOrderAsString(m_ByteOrder) << std::endl;
+  os << indent << "UseCompression: " << m_UseCompression << std::endl;
+  os << indent << "CompressionLevel: " << m_CompressionLevel << std::endl;
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
   os << indent << "Point dimension: " << m_PointDimension << std::endl;
   os << indent << "Point component type: " << GetComponentTypeAsString(m_PointComponentType) << std::endl;
   os << indent << "Cell  component type: " << GetComponentTypeAsString(m_CellComponentType) << std::endl;
@@ -25,6 +25,8 @@
 #include "itkIntTypes.h"
 #include "itkLightProcessObject.h"
 #include "itkMatrix.h"
+#include "itkMeshIOBufferPool.h"
+#include "itkMultiThreader.h"
 #include "itkRGBPixel.h"
 #include "itkRGBAPixel.h"
 #include "itkSymmetricSecondRankTensor.h"
@@ -34,6 +36,7 @@
 
 #include <string>
 #include <complex>
+#include <cstring>
 #include <fstream>
 
 namespace itk
@@ -146,6 +149,80 @@ public:
     static const IOComponentType CType = UNKNOWNCOMPONENTTYPE;
   };
 
+  /** Call visitor.Visit< T >() with T the native type of the given
+   * component type, e.g. float for FLOAT. This is the compile-time
+   * counterpart of MapComponentType and replaces switch statements over
+   * IOComponentType. An exception is thrown for UNKNOWNCOMPONENTTYPE. */
+  template< typename TVisitor >
+  void VisitComponentType(IOComponentType componentType, TVisitor & visitor) const
+  {
+    switch ( componentType )
+      {
+      case UCHAR:
+        visitor.template Visit< unsigned char >();
+        break;
+      case CHAR:
+        visitor.template Visit< char >();
+        break;
+      case USHORT:
+        visitor.template Visit< unsigned short >();
+        break;
+      case SHORT:
+        visitor.template Visit< short >();
+        break;
+      case UINT:
+        visitor.template Visit< unsigned int >();
+        break;
+      case INT:
+        visitor.template Visit< int >();
+        break;
+      case ULONG:
+        visitor.template Visit< unsigned long >();
+        break;
+      case LONG:
+        visitor.template Visit< long >();
+        break;
+      case LONGLONG:
+        visitor.template Visit< long long >();
+        break;
+      case ULONGLONG:
+        visitor.template Visit< unsigned long long >();
+        break;
+      case FLOAT:
+        visitor.template Visit< float >();
+        break;
+      case DOUBLE:
+        visitor.template Visit< double >();
+        break;
+      case LDOUBLE:
+        visitor.template Visit< long double >();
+        break;
+      case UNKNOWNCOMPONENTTYPE:
+      default:
+        itkExceptionMacro(<< "Unknown component type: " << componentType);
+      }
+  }
+
+  /** Convert numberOfComponents values from one native type to another.
+   * The same-type overload is a plain copy. */
+  template< typename TInput, typename TOutput >
+  static void ConvertBuffer(const TInput *input, TOutput *output, SizeValueType numberOfComponents)
+  {
+    for ( SizeValueType ii = 0; ii < numberOfComponents; ii++ )
+      {
+      output[ii] = static_cast< TOutput >( input[ii] );
+      }
+  }
+
+  template< typename T >
+  static void ConvertBuffer(const T *input, T *output, SizeValueType numberOfComponents)
+  {
+    if ( input != output )
+      {
+      std::memcpy( output, input, numberOfComponents * sizeof( T ) );
+      }
+  }
+
   template< typename T >
   void SetPixelType(const T & itkNotUsed(dummy), bool UsePointPixel = true)
   {
@@ -385,8 +462,8 @@ public:
   itkGetConstMacro(NumberOfPointPixels, SizeValueType);
   itkSetMacro(NumberOfCellPixels, SizeValueType);
   itkGetConstMacro(NumberOfCellPixels, SizeValueType);
-  itkSetMacro(CellBufferSize, unsigned int);
-  itkGetConstMacro(CellBufferSize, unsigned int);
+  itkSetMacro(CellBufferSize, SizeValueType);
+  itkGetConstMacro(CellBufferSize, SizeValueType);
   itkSetMacro(UpdatePoints, bool);
   itkGetConstMacro(UpdatePoints, bool);
   itkSetMacro(UpdateCells, bool);
@@ -450,6 +527,17 @@ public:
   itkGetConstMacro(UseCompression, bool);
   itkBooleanMacro(UseCompression);
 
+  /** Set/Get the compression level, from 0 (none) to 9 (best), used
+   * by the formats that compress their data. */
+  itkSetClampMacro(CompressionLevel, int, 0, 9);
+  itkGetConstMacro(CompressionLevel, int);
+
+  /** Set/Get the number of threads the formats that encode or decode
+   * their data in parallel may use. Defaults to the global default
+   * number of threads of the MultiThreader. */
+  itkSetClampMacro(NumberOfThreads, int, 1, ITK_MAX_THREADS);
+  itkGetConstMacro(NumberOfThreads, int);
+
   /** Convenience method returns the FileType as a string. This can be
      * used for writing output files. */
   std::string GetFileTypeAsString(FileType) const;
@@ -476,6 +564,25 @@ public:
 
   virtual void ReadCellData(void *buffer) = 0;
 
+  /** Read the points into a buffer of the native type TOutput. The file is
+   * decoded straight into the buffer when its component type is TOutput,
+   * otherwise it goes through one temporary buffer of the file component
+   * type that is converted with ConvertBuffer(). The buffer must hold
+   * NumberOfPoints * PointDimension values. */
+  template< typename TOutput >
+  void ReadPointsAs(TOutput *buffer)
+  {
+    if ( m_PointComponentType == MapComponentType< TOutput >::CType )
+      {
+      this->ReadPoints(buffer);
+      }
+    else
+      {
+      ReadPointsAsVisitor< TOutput > visitor(this, buffer, m_NumberOfPoints * m_PointDimension);
+      this->VisitComponentType(m_PointComponentType, visitor);
+      }
+  }
+
   /*-------- This part of the interfaces deals with writing data ----- */
 
   /** Writes the data to disk from the memory buffer provided. Make sure
@@ -510,6 +617,31 @@ protected:
   MeshIOBase();
   virtual ~MeshIOBase(){}
 
+  /** Visitor used by ReadPointsAs() to read with the file component type
+   * and convert to TOutput. */
+  template< typename TOutput >
+  class ReadPointsAsVisitor
+  {
+public:
+    ReadPointsAsVisitor(MeshIOBase *meshIO, TOutput *output, SizeValueType numberOfComponents):
+      m_MeshIO(meshIO), m_Output(output), m_NumberOfComponents(numberOfComponents)
+    {}
+
+    template< typename TInput >
+    void Visit()
+    {
+      MeshIOScratchBuffer< TInput > input(m_NumberOfComponents);
+
+      m_MeshIO->ReadPoints( input.GetBuffer() );
+      ConvertBuffer(input.GetBuffer(), m_Output, m_NumberOfComponents);
+    }
+
+private:
+    MeshIOBase *  m_MeshIO;
+    TOutput *     m_Output;
+    SizeValueType m_NumberOfComponents;
+  };
+
   void PrintSelf(std::ostream & os, Indent indent) const;
 
   /** Insert an extension to the list of supported extensions for reading. */
@@ -579,11 +711,12 @@ protected:
         itk::ByteSwapper< TInput >::SwapRangeFromSystemToLittleEndian(buffer, numberOfComponents);
         }
 
-      outputFile.write(reinterpret_cast< char * >( buffer ), numberOfComponents);
+      outputFile.write( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( TInput ) );
       }
     else
       {
-      TOutput *data = new TOutput[numberOfComponents];
+      MeshIOScratchBuffer< TOutput > scratch(numberOfComponents);
+      TOutput *                      data = scratch.GetBuffer();
       for ( SizeValueType ii = 0; ii < numberOfComponents; ii++ )
         {
         data[ii] = static_cast< TOutput >( buffer[ii] );
@@ -598,7 +731,7 @@ protected:
         itk::ByteSwapper< TOutput >::SwapRangeFromSystemToLittleEndian(data, numberOfComponents);
         }
 
-      outputFile.write(reinterpret_cast< char * >( data ), numberOfComponents);
+      outputFile.write( reinterpret_cast< char * >( data ), numberOfComponents * sizeof( TOutput ) );
       }
   }
 
@@ -708,6 +841,10 @@ protected:
 
   /** Should we compress the data? */
   bool m_UseCompression;
+  int  m_CompressionLevel;
+
+  /** Number of threads to encode or decode the data with */
+  int m_NumberOfThreads;
 
   /** Used internally to keep track of the type of the component. */
   IOComponentType m_PointComponentType;
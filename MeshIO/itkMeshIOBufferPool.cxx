@@ -0,0 +1,256 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#if defined( _MSC_VER )
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkMeshIOBufferPool.h"
+#include "itkMutexLock.h"
+#include "itkMutexLockHolder.h"
+
+#include <new>
+#include <vector>
+
+namespace itk
+{
+namespace
+{
+// Size classes split every power of two from 4 kB up to half the address
+// space in four steps (4, 5, 6 and 7 quarters of it), so that a buffer is
+// at most 25% larger than requested
+const unsigned int MinimumSizeClassShift = 12;
+const unsigned int StepsPerPowerOfTwo = 4;
+const unsigned int NumberOfSizeClasses = StepsPerPowerOfTwo * ( sizeof( size_t ) * 8 - MinimumSizeClassShift - 1 );
+
+inline size_t SizeClassCapacity(size_t sizeClass)
+{
+  return ( StepsPerPowerOfTwo + sizeClass % StepsPerPowerOfTwo )
+         << ( sizeClass / StepsPerPowerOfTwo + MinimumSizeClassShift - 2 );
+}
+
+// Smallest size class holding the given number of bytes
+inline size_t GetSizeClass(size_t bytes)
+{
+  if ( bytes <= SizeClassCapacity(0) )
+    {
+    return 0;
+    }
+
+  // bytes - 1 is in [2^shift, 2^(shift + 1)), its two bits after the
+  // leading one give the quarter below it
+  unsigned int shift = MinimumSizeClassShift;
+  while ( ( ( bytes - 1 ) >> ( shift + 1 ) ) != 0 )
+    {
+    ++shift;
+    }
+  const size_t quarter = ( ( bytes - 1 ) >> ( shift - 2 ) ) - StepsPerPowerOfTwo;
+
+  return StepsPerPowerOfTwo * ( shift - MinimumSizeClassShift ) + quarter + 1;
+}
+
+// Placed in front of every buffer to remember its size class. The union
+// keeps the buffer aligned as strictly as the memory from operator new.
+union BlockHeader
+  {
+  size_t m_SizeClass;
+  double m_AlignDouble;
+  long double m_AlignLongDouble;
+  void *m_AlignPointer;
+  };
+
+struct BufferPoolState
+  {
+  typedef MeshIOBufferPool::SizeValueType SizeValueType;
+
+  BufferPoolState():
+    m_NumberOfHits(0),
+    m_NumberOfGrows(0),
+    m_PooledBytes(0),
+    m_MaximumPooledBytes(256 * 1024 * 1024),
+    m_NumberOfUsers(0)
+  {}
+
+  // Free idle buffers, largest first, until at most the given number of
+  // bytes is pooled. The mutex must be held.
+  void Trim(SizeValueType bytes)
+  {
+    for ( unsigned int ii = NumberOfSizeClasses; ii > 0 && m_PooledBytes > bytes; ii-- )
+      {
+      std::vector< BlockHeader * > & freeList = m_FreeLists[ii - 1];
+      while ( !freeList.empty() && m_PooledBytes > bytes )
+        {
+        ::operator delete( freeList.back() );
+        freeList.pop_back();
+        m_PooledBytes -= static_cast< SizeValueType >( SizeClassCapacity(ii - 1) );
+        }
+      }
+  }
+
+  SimpleMutexLock              m_Mutex;
+  std::vector< BlockHeader * > m_FreeLists[NumberOfSizeClasses];
+  SizeValueType                m_NumberOfHits;
+  SizeValueType                m_NumberOfGrows;
+  SizeValueType                m_PooledBytes;
+  SizeValueType                m_MaximumPooledBytes;
+  SizeValueType                m_NumberOfUsers;
+  };
+
+// The pool is never destroyed: a buffer released by a static object, after
+// the static objects of this file would have been destroyed, must still find
+// it. Its idle buffers are freed when the last reader or writer is gone.
+BufferPoolState & GetBufferPool()
+{
+  static BufferPoolState *pool = new BufferPoolState;
+
+  return *pool;
+}
+}
+
+void * MeshIOBufferPool::Acquire(size_t bytes)
+{
+  if ( bytes == 0 )
+    {
+    return 0;
+    }
+
+  const size_t sizeClass = GetSizeClass(bytes);
+  if ( sizeClass >= NumberOfSizeClasses || bytes > ~size_t(0) - sizeof( BlockHeader ) )
+    {
+    throw std::bad_alloc();
+    }
+
+  BufferPoolState & pool = GetBufferPool();
+  BlockHeader *     block = 0;
+    {
+    MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+    std::vector< BlockHeader * > &     freeList = pool.m_FreeLists[sizeClass];
+    if ( !freeList.empty() )
+      {
+      block = freeList.back();
+      freeList.pop_back();
+      pool.m_PooledBytes -= static_cast< SizeValueType >( SizeClassCapacity(sizeClass) );
+      ++pool.m_NumberOfHits;
+      }
+    else
+      {
+      ++pool.m_NumberOfGrows;
+      }
+    }
+
+  if ( block == 0 )
+    {
+    // Allocate outside of the lock
+    block = static_cast< BlockHeader * >( ::operator new( sizeof( BlockHeader ) + SizeClassCapacity(sizeClass) ) );
+    block->m_SizeClass = sizeClass;
+    }
+
+  return static_cast< void * >( block + 1 );
+}
+
+void MeshIOBufferPool::Release(void *buffer)
+{
+  if ( buffer == 0 )
+    {
+    return;
+    }
+
+  BlockHeader *     block = static_cast< BlockHeader * >( buffer ) - 1;
+  const size_t      capacity = SizeClassCapacity(block->m_SizeClass);
+  BufferPoolState & pool = GetBufferPool();
+    {
+    MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+    if ( pool.m_NumberOfUsers > 0
+         && pool.m_PooledBytes + capacity <= pool.m_MaximumPooledBytes )
+      {
+      pool.m_FreeLists[block->m_SizeClass].push_back(block);
+      pool.m_PooledBytes += static_cast< SizeValueType >( capacity );
+      return;
+      }
+    }
+
+  ::operator delete(block);
+}
+
+void MeshIOBufferPool::AddUser()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  ++pool.m_NumberOfUsers;
+}
+
+void MeshIOBufferPool::RemoveUser()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  if ( pool.m_NumberOfUsers > 0 && --pool.m_NumberOfUsers == 0 )
+    {
+    pool.Trim(0);
+    }
+}
+
+void MeshIOBufferPool::Clear()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  pool.Trim(0);
+}
+
+void MeshIOBufferPool::ResetCounters()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  pool.m_NumberOfHits = 0;
+  pool.m_NumberOfGrows = 0;
+}
+
+MeshIOBufferPool::SizeValueType MeshIOBufferPool::GetNumberOfHits()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  return pool.m_NumberOfHits;
+}
+
+MeshIOBufferPool::SizeValueType MeshIOBufferPool::GetNumberOfGrows()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  return pool.m_NumberOfGrows;
+}
+
+MeshIOBufferPool::SizeValueType MeshIOBufferPool::GetPooledBytes()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  return pool.m_PooledBytes;
+}
+
+void MeshIOBufferPool::SetMaximumPooledBytes(SizeValueType bytes)
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  pool.m_MaximumPooledBytes = bytes;
+  pool.Trim(bytes);
+}
+
+MeshIOBufferPool::SizeValueType MeshIOBufferPool::GetMaximumPooledBytes()
+{
+  BufferPoolState & pool = GetBufferPool();
+  MutexLockHolder< SimpleMutexLock > mutexHolder(pool.m_Mutex);
+  return pool.m_MaximumPooledBytes;
+}
+} // end namespace itk
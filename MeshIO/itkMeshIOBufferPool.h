@@ -0,0 +1,139 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMeshIOBufferPool_h
+#define __itkMeshIOBufferPool_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkMacro.h"
+
+#include <cstddef>
+
+namespace itk
+{
+/** \class MeshIOBufferPool
+ * \brief Pool of scratch buffers shared by the mesh readers and writers.
+ *
+ * Reading or writing a mesh goes through several temporary buffers as large
+ * as the points, the cells or the pixel data. When many meshes are processed
+ * in a loop the same sizes are requested over and over, so the buffers are
+ * kept in free lists instead of being returned to the heap. There is one
+ * free list per size class, each power of two being split in four classes,
+ * so a buffer is at most 25% larger than requested. A request is served
+ * from its size class when a buffer is available (a hit), and from the heap
+ * otherwise (a grow).
+ *
+ * Buffers are only pooled while the pool has users: MeshFileReader and
+ * MeshFileWriter are users for as long as they exist. When the last user
+ * goes away, the idle buffers are returned to the heap. Keep a reader
+ * alive, and change its file name, to reuse the buffers across meshes.
+ *
+ * The pool is shared by all the threads and guarded by a mutex that is only
+ * held while a free list is updated. The total size of the idle buffers is
+ * bounded by MaximumPooledBytes; buffers released beyond that bound are
+ * returned to the heap.
+ *
+ * Buffers are raw memory aligned as if returned by operator new. Use
+ * MeshIOScratchBuffer to hold an array of plain data for the duration of a
+ * scope.
+ *
+ * \sa MeshIOScratchBuffer
+ */
+class ITK_EXPORT MeshIOBufferPool
+{
+public:
+  typedef unsigned long SizeValueType;
+
+  /** Return a buffer of at least the given size in bytes, or null for a
+   * zero size. The buffer must be given back with Release(). */
+  static void * Acquire(size_t bytes);
+
+  /** Give back a buffer obtained from Acquire(). Null is ignored. */
+  static void Release(void *buffer);
+
+  /** Declare a user of the pool, and remove it. Released buffers are only
+   * kept while there is at least one user, and the idle buffers are
+   * returned to the heap when the last user is removed. */
+  static void AddUser();
+
+  static void RemoveUser();
+
+  /** Return all the idle buffers to the heap. The counters are kept. */
+  static void Clear();
+
+  /** Reset the hit and grow counters. */
+  static void ResetCounters();
+
+  /** Number of requests served from an idle buffer. */
+  static SizeValueType GetNumberOfHits();
+
+  /** Number of requests that had to allocate a new buffer. */
+  static SizeValueType GetNumberOfGrows();
+
+  /** Total size in bytes of the idle buffers held by the pool. */
+  static SizeValueType GetPooledBytes();
+
+  /** Bound on the total size of the idle buffers, 256 MB by default. Setting
+   * a smaller bound releases idle buffers to fit. */
+  static void SetMaximumPooledBytes(SizeValueType bytes);
+
+  static SizeValueType GetMaximumPooledBytes();
+
+private:
+  MeshIOBufferPool();                         // purposely not implemented
+  MeshIOBufferPool(const MeshIOBufferPool &); // purposely not implemented
+  void operator=(const MeshIOBufferPool &);   // purposely not implemented
+};
+
+/** \class MeshIOScratchBuffer
+ * \brief Array of plain data taken from MeshIOBufferPool for one scope.
+ *
+ * The elements are not initialized, so T must be a type without
+ * constructor or destructor, such as the component types of MeshIOBase.
+ * The buffer goes back to the pool when the object is destroyed, which
+ * also covers the exceptions thrown while reading.
+ */
+template< typename T >
+class MeshIOScratchBuffer
+{
+public:
+  explicit MeshIOScratchBuffer(MeshIOBufferPool::SizeValueType numberOfElements):
+    m_Buffer( static_cast< T * >( MeshIOBufferPool::Acquire(numberOfElements * sizeof( T )) ) )
+  {}
+
+  ~MeshIOScratchBuffer()
+  {
+    MeshIOBufferPool::Release(m_Buffer);
+  }
+
+  T * GetBuffer() const
+  {
+    return m_Buffer;
+  }
+
+private:
+  MeshIOScratchBuffer(const MeshIOScratchBuffer &); // purposely not implemented
+  void operator=(const MeshIOScratchBuffer &);      // purposely not implemented
+
+  T *m_Buffer;
+};
+} // end namespace itk
+
+#endif
@@ -20,8 +20,10 @@
 #endif
 
 #include "itkBYUMeshIOFactory.h"
+#include "itkFreeSurferAnnotMeshIOFactory.h"
 #include "itkFreeSurferAsciiMeshIOFactory.h"
 #include "itkFreeSurferBinaryMeshIOFactory.h"
+#include "itkFreeSurferMGHMeshIOFactory.h"
 #include "itkGiftiMeshIOFactory.h"
 #include "itkMeshIOFactory.h"
 #include "itkOBJMeshIOFactory.h"
@@ -29,6 +31,7 @@
 #include "itkMutexLock.h"
 #include "itkMutexLockHolder.h"
 #include "itkVTKPolyDataMeshIOFactory.h"
+#include "itkVTKXMLPolyDataMeshIOFactory.h"
 
 namespace itk
 {
@@ -90,12 +93,15 @@ void MeshIOFactory::RegisterBuiltInFactories()
     if ( firstTime )
       {
       ObjectFactoryBase::RegisterFactory( BYUMeshIOFactory::New() );
+      ObjectFactoryBase::RegisterFactory( FreeSurferAnnotMeshIOFactory::New() );
       ObjectFactoryBase::RegisterFactory( FreeSurferAsciiMeshIOFactory::New() );
       ObjectFactoryBase::RegisterFactory( FreeSurferBinaryMeshIOFactory::New() );
+      ObjectFactoryBase::RegisterFactory( FreeSurferMGHMeshIOFactory::New() );
       ObjectFactoryBase::RegisterFactory( GiftiMeshIOFactory::New() );
       ObjectFactoryBase::RegisterFactory( OBJMeshIOFactory::New() );
       ObjectFactoryBase::RegisterFactory( OFFMeshIOFactory::New() );
       ObjectFactoryBase::RegisterFactory( VTKPolyDataMeshIOFactory::New() );
+      ObjectFactoryBase::RegisterFactory( VTKXMLPolyDataMeshIOFactory::New() );
 
       firstTime = false;
       }
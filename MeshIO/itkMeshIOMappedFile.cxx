@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#if defined( _MSC_VER )
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkMeshIOMappedFile.h"
+
+#include <fstream>
+
+#if defined( _WIN32 ) && !defined( __CYGWIN__ )
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+MeshIOMappedFile::MeshIOMappedFile():
+  m_Data(0), m_Length(0), m_Mapping(0)
+{}
+
+MeshIOMappedFile::~MeshIOMappedFile()
+{
+  this->Close();
+}
+
+bool MeshIOMappedFile::Open(const std::string & fileName)
+{
+  this->Close();
+
+#if defined( _WIN32 ) && !defined( __CYGWIN__ )
+  HANDLE        file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                   FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER length;
+  if ( file != INVALID_HANDLE_VALUE && GetFileSizeEx(file, &length) && length.QuadPart > 0 )
+    {
+    m_Mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if ( m_Mapping )
+      {
+      m_Data = static_cast< const unsigned char * >( MapViewOfFile(static_cast< HANDLE >( m_Mapping ),
+                                                                   FILE_MAP_READ, 0, 0, 0) );
+      m_Length = static_cast< size_t >( length.QuadPart );
+      if ( !m_Data )
+        {
+        CloseHandle( static_cast< HANDLE >( m_Mapping ) );
+        m_Mapping = 0;
+        m_Length = 0;
+        }
+      }
+    }
+  if ( file != INVALID_HANDLE_VALUE )
+    {
+    CloseHandle(file);
+    }
+#else
+  const int   file = open(fileName.c_str(), O_RDONLY);
+  struct stat fileStat;
+  if ( file >= 0 && fstat(file, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && fileStat.st_size > 0 )
+    {
+    void *address = mmap(0, static_cast< size_t >( fileStat.st_size ), PROT_READ, MAP_SHARED, file, 0);
+    if ( address != MAP_FAILED )
+      {
+      m_Mapping = address;
+      m_Data = static_cast< const unsigned char * >( address );
+      m_Length = static_cast< size_t >( fileStat.st_size );
+      }
+    }
+  if ( file >= 0 )
+    {
+    close(file);
+    }
+#endif
+
+  if ( m_Data )
+    {
+    return true;
+    }
+
+  // Read the file whole when it cannot be mapped
+  std::ifstream inputFile(fileName.c_str(), std::ios::binary);
+  if ( !inputFile.is_open() )
+    {
+    return false;
+    }
+
+  char data[65536];
+  while ( inputFile.read( data, sizeof( data ) ) || inputFile.gcount() > 0 )
+    {
+    m_Buffer.insert( m_Buffer.end(), data, data + inputFile.gcount() );
+    }
+
+  m_Length = m_Buffer.size();
+  m_Data = m_Buffer.empty() ? reinterpret_cast< const unsigned char * >( "" )
+           : reinterpret_cast< const unsigned char * >( &m_Buffer[0] );
+  return true;
+}
+
+void MeshIOMappedFile::Close()
+{
+  if ( m_Mapping )
+    {
+#if defined( _WIN32 ) && !defined( __CYGWIN__ )
+    UnmapViewOfFile(m_Data);
+    CloseHandle( static_cast< HANDLE >( m_Mapping ) );
+#else
+    munmap(m_Mapping, m_Length);
+#endif
+    }
+
+  m_Mapping = 0;
+  m_Data = 0;
+  m_Length = 0;
+  std::vector< char >().swap(m_Buffer);
+}
+} // end namespace itk
@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef __itkMeshIOMappedFile_h
+#define __itkMeshIOMappedFile_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkMacro.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace itk
+{
+/** \class MeshIOMappedFile
+ * \brief Read-only view of a whole file, for the binary mesh readers.
+ *
+ * Open() maps the file in memory, so that the readers decode its values
+ * straight into their output buffers. A file that cannot be mapped, such as
+ * a pipe, is read whole into memory instead. The data stay valid until
+ * Close() or the destruction of the object, and may be read by several
+ * threads at once.
+ */
+class ITK_EXPORT MeshIOMappedFile
+{
+public:
+  MeshIOMappedFile();
+  ~MeshIOMappedFile();
+
+  /** Open the file, return false if it cannot be read. An open file is
+   * closed first. */
+  bool Open(const std::string & fileName);
+
+  void Close();
+
+  bool IsOpen() const
+  {
+    return m_Data != 0;
+  }
+
+  /** Contents of the open file. */
+  const unsigned char * GetData() const
+  {
+    return m_Data;
+  }
+
+  size_t GetLength() const
+  {
+    return m_Length;
+  }
+
+  /** Whether size bytes from offset are in the file. */
+  bool Holds(long long offset, size_t size) const
+  {
+    return offset >= 0 && static_cast< unsigned long long >( offset ) <= m_Length
+           && size <= m_Length - static_cast< size_t >( offset );
+  }
+
+private:
+  MeshIOMappedFile(const MeshIOMappedFile &); // purposely not implemented
+  void operator=(const MeshIOMappedFile &);   // purposely not implemented
+
+  const unsigned char *m_Data;
+  size_t               m_Length;
+  void *               m_Mapping;
+  std::vector< char >  m_Buffer;
+};
+} // end namespace itk
+
+#endif
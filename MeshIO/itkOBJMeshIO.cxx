@@ -254,8 +254,9 @@ void OBJMeshIO::ReadCells(void *buffer)
   OpenFile();
 
   // Read and analyze the first line in the file
-  long *        data = new long[this->m_CellBufferSize - this->m_NumberOfCells];
-  unsigned long index = 0;
+  MeshIOScratchBuffer< long > scratch(this->m_CellBufferSize - this->m_NumberOfCells);
+  long *                      data = scratch.GetBuffer();
+  unsigned long               index = 0;
 
   std::string line;
   std::string inputLine;
@@ -311,7 +312,6 @@ void OBJMeshIO::ReadCells(void *buffer)
   this->WriteCellsBuffer(data, static_cast< long * >( buffer ), POLYGON_CELL, this->m_NumberOfCells);
   // this->WriteCellsBuffer(data, static_cast<unsigned int *>(buffer),
   // TRIANGLE_CELL, 3, this->m_NumberOfCells);
-  delete[] data;
 
   return;
 }
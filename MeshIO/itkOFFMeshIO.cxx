@@ -294,7 +294,8 @@ void OFFMeshIO::ReadPoints(void *buffer)
 
 void OFFMeshIO::ReadCells(void *buffer)
 {
-  itk::uint32_t *data = new itk::uint32_t[this->m_CellBufferSize - this->m_NumberOfCells];
+  MeshIOScratchBuffer< itk::uint32_t > scratch(this->m_CellBufferSize - this->m_NumberOfCells);
+  itk::uint32_t *                      data = scratch.GetBuffer();
 
   if ( this->m_FileType == ASCII )
     {
@@ -320,8 +321,6 @@ void OFFMeshIO::ReadCells(void *buffer)
     this->WriteCellsBuffer(data, static_cast< unsigned int * >( buffer ), POLYGON_CELL, this->m_NumberOfCells);
     }
 
-  delete[] data;
-
   return;
 }
 
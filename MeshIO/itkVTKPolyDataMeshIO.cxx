@@ -20,12 +20,23 @@
 #include "itkVTKPolyDataMeshIO.h"
 
 #include <itksys/SystemTools.hxx>
+#include <algorithm>
 #include <fstream>
 
 namespace itk
 {
 // Constructor
-VTKPolyDataMeshIO::VTKPolyDataMeshIO()
+VTKPolyDataMeshIO::VTKPolyDataMeshIO():
+  m_PointsPosition(-1),
+  m_VerticesPosition(-1),
+  m_LinesPosition(-1),
+  m_PolygonsPosition(-1),
+  m_PointDataPosition(-1),
+  m_CellDataPosition(-1),
+  m_VerticesConnectivityPosition(-1),
+  m_LinesConnectivityPosition(-1),
+  m_PolygonsConnectivityPosition(-1),
+  m_UseOffsetsCellLayout(false)
 {
   this->AddSupportedWriteExtension(".vtk");
   this->m_ByteOrder = BigEndian;
@@ -66,31 +77,204 @@ bool VTKPolyDataMeshIO::CanWriteFile(const char *fileName)
   return true;
 }
 
-void VTKPolyDataMeshIO::ReadMeshInformation()
+void VTKPolyDataMeshIO::OpenFile()
 {
-  // Read input file into a file stream
-  std::ifstream inputFile;
+  if ( m_InputFile.is_open() )
+    {
+    return;
+    }
 
-  // Use default filetype
-  if ( this->m_FileType == ASCII )
+  // The file is always opened in binary mode, so that the offsets taken in
+  // ReadMeshInformation() can be seeked to in ASCII files as well
+  m_InputFile.clear();
+  m_InputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+  if ( !m_InputFile.is_open() )
     {
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
+    itkExceptionMacro("Unable to open file\n" "inputFilename= " << this->m_FileName);
     }
-  else if ( m_FileType == BINARY )
+}
+
+void VTKPolyDataMeshIO::CloseFile()
+{
+  if ( m_InputFile.is_open() )
     {
-#ifdef _WIN32
-    inputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
-#else
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-#endif
+    m_InputFile.close();
     }
+}
 
-  if ( !inputFile.is_open() )
+void VTKPolyDataMeshIO::SeekSection(StreamOffsetType position, const char *section)
+{
+  if ( position < 0 )
     {
-    itkExceptionMacro("Unable to open file\n" "inputFilename= " << this->m_FileName);
-    return;
+    itkExceptionMacro(<< "No " << section << " section in file " << this->m_FileName);
     }
 
+  this->OpenFile();
+
+  // The stream may have hit the end of the file in a previous read
+  m_InputFile.clear();
+  m_InputFile.seekg(position, std::ios::beg);
+  if ( m_InputFile.fail() )
+    {
+    itkExceptionMacro(<< "Unable to seek to the " << section << " section of file " << this->m_FileName);
+    }
+}
+
+void VTKPolyDataMeshIO::SkipBinarySection(SizeValueType numberOfBytes)
+{
+  if ( this->m_FileType == BINARY )
+    {
+    m_InputFile.seekg(static_cast< StreamOffsetType >( numberOfBytes ), std::ios::cur);
+    }
+}
+
+VTKPolyDataMeshIO::CellSectionsType VTKPolyDataMeshIO::GetCellSections() const
+{
+  CellSectionsType sections;
+
+  if ( m_VerticesPosition >= 0 )
+    {
+    sections.push_back( CellSectionType(m_VerticesPosition, VERTEX_CELL) );
+    }
+  if ( m_LinesPosition >= 0 )
+    {
+    sections.push_back( CellSectionType(m_LinesPosition, LINE_CELL) );
+    }
+  if ( m_PolygonsPosition >= 0 )
+    {
+    sections.push_back( CellSectionType(m_PolygonsPosition, POLYGON_CELL) );
+    }
+
+  std::sort( sections.begin(), sections.end() );
+  return sections;
+}
+
+void VTKPolyDataMeshIO::GetCellSectionSize(CellGeometryType cellType, SizeValueType & numberOfCells,
+                                           SizeValueType & numberOfIndices) const
+{
+  const MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
+
+  numberOfCells = 0;
+  numberOfIndices = 0;
+  switch ( GetCellSectionIndex(cellType) )
+    {
+    case 0:
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfVertices", numberOfCells);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfVertexIndices", numberOfIndices);
+      break;
+    case 1:
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfCells);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfLineIndices", numberOfIndices);
+      break;
+    case 2:
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygons", numberOfCells);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygonIndices", numberOfIndices);
+      break;
+    default:
+      break;
+    }
+}
+
+int VTKPolyDataMeshIO::GetCellSectionIndex(CellGeometryType cellType)
+{
+  switch ( cellType )
+    {
+    case VERTEX_CELL:
+      return 0;
+    case LINE_CELL:
+      return 1;
+    case TRIANGLE_CELL:
+    case POLYGON_CELL:
+    case QUADRILATERAL_CELL:
+      return 2;
+    default:
+      return -1;
+    }
+}
+
+bool VTKPolyDataMeshIO::ReadOffsetsCellSection(SizeValueType numberOfOffsets, SizeValueType connectivitySize,
+                                               StreamOffsetType & offsetsPosition,
+                                               StreamOffsetType & connectivityPosition)
+{
+  const char *        arrayNames[2] = { "OFFSETS", "CONNECTIVITY" };
+  const SizeValueType numberOfValues[2] = { numberOfOffsets, connectivitySize };
+  StreamOffsetType    positions[2];
+
+  for ( int ii = 0; ii < 2; ii++ )
+    {
+    // The array header follows the end of the previous line, or the ASCII
+    // values of the offsets
+    std::string line;
+    while ( line.find(arrayNames[ii]) == std::string::npos )
+      {
+      if ( !std::getline(m_InputFile, line, '\n') )
+        {
+        itkExceptionMacro(<< "Missing " << arrayNames[ii] << " array in file " << this->m_FileName);
+        }
+      }
+
+    StringStreamType ss;
+    ss << line;
+    StringType item;
+    StringType arrayType;
+    ss >> item;
+    ss >> arrayType;
+
+    IOComponentType componentType = UNKNOWNCOMPONENTTYPE;
+    if ( arrayType == "vtktypeint64" )
+      {
+      componentType = LONGLONG;
+      }
+    else if ( arrayType == "vtktypeint32" )
+      {
+      componentType = INT;
+      }
+    else
+      {
+      itkExceptionMacro(<< "Unsupported " << arrayNames[ii] << " type " << arrayType);
+      }
+
+    // The cells of all sections share one buffer
+    if ( this->m_CellComponentType != UNKNOWNCOMPONENTTYPE && this->m_CellComponentType != componentType )
+      {
+      itkExceptionMacro(<< "Cell sections of different types in file " << this->m_FileName);
+      }
+    this->m_CellComponentType = componentType;
+
+    positions[ii] = m_InputFile.tellg();
+    this->SkipBinarySection( numberOfValues[ii] * this->GetComponentSize(componentType) );
+    }
+
+  if ( numberOfOffsets < 2 )
+    {
+    offsetsPosition = -1;
+    connectivityPosition = -1;
+    return false;
+    }
+
+  offsetsPosition = positions[0];
+  connectivityPosition = positions[1];
+  return true;
+}
+
+void VTKPolyDataMeshIO::ReadMeshInformation()
+{
+  // Scan the file once, recording where the values of each section start
+  this->CloseFile();
+  this->OpenFile();
+  std::ifstream & inputFile = m_InputFile;
+
+  m_PointsPosition = -1;
+  m_VerticesPosition = -1;
+  m_LinesPosition = -1;
+  m_PolygonsPosition = -1;
+  m_PointDataPosition = -1;
+  m_CellDataPosition = -1;
+  m_VerticesConnectivityPosition = -1;
+  m_LinesConnectivityPosition = -1;
+  m_PolygonsConnectivityPosition = -1;
+  this->m_CellComponentType = UNKNOWNCOMPONENTTYPE;
+
   // Define used variables
   unsigned    numLine = 0;
   std::string line;
@@ -100,40 +284,31 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
     {
     std::getline(inputFile, line, '\n');
     ++numLine;
-    }
 
-  // Determine file type
-  if ( line.find("ASCII") != std::string::npos )
-    {
-    if ( this->m_FileType != ASCII )
+    // Files of version 5 and above store the cells as OFFSETS and
+    // CONNECTIVITY arrays
+    if ( numLine == 1 )
       {
-      this->m_FileType = ASCII;
-#ifdef _WIN32
-      inputFile.close();
-      inputFile.open(this->m_FileName.c_str(), std::ios::in);
-      if ( !inputFile.is_open() )
+      const std::string::size_type versionPosition = line.find("Version");
+      unsigned int                 majorVersion = 0;
+      if ( versionPosition != std::string::npos )
         {
-        itkExceptionMacro("Unable to open file\n" "inputFilename= " << this->m_FileName);
-        return;
+        StringStreamType ss;
+        ss << line.substr( versionPosition + 7 );
+        ss >> majorVersion;
         }
-#endif
+      this->m_UseOffsetsCellLayout = majorVersion >= 5;
       }
     }
+
+  // Determine file type
+  if ( line.find("ASCII") != std::string::npos )
+    {
+    this->m_FileType = ASCII;
+    }
   else if ( line.find("BINARY") != std::string::npos )
     {
-    if ( this->m_FileType != BINARY )
-      {
-      this->m_FileType = BINARY;
-#ifdef _WIN32
-      inputFile.close();
-      inputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
-      if ( !inputFile.is_open() )
-        {
-        itkExceptionMacro("Unable to open file\n" "inputFilename= " << this->m_FileName);
-        return;
-        }
-#endif
-      }
+    this->m_FileType = BINARY;
     }
   else
     {
@@ -232,6 +407,10 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
         }
 
       this->m_UpdatePoints = true;
+
+      this->m_PointsPosition = inputFile.tellg();
+      this->SkipBinarySection( this->m_NumberOfPoints * this->m_PointDimension
+                               * this->GetComponentSize(this->m_PointComponentType) );
       }
     else if ( line.find("VERTICES") != std::string::npos )
       {
@@ -243,14 +422,26 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
       ss >> item; // should be "VERTICES"
 
       // Get number of Points
-      unsigned int numberOfVertices;
-      unsigned int numberOfVertexIndices;
+      SizeValueType numberOfVertices;
+      SizeValueType numberOfVertexIndices;
       ss >> numberOfVertices;
       ss >> numberOfVertexIndices;
+      if ( this->m_UseOffsetsCellLayout )
+        {
+        // The header counts the offsets, one more than the cells, and the
+        // point ids only
+        if ( !this->ReadOffsetsCellSection(numberOfVertices, numberOfVertexIndices, this->m_VerticesPosition,
+                                           this->m_VerticesConnectivityPosition) )
+          {
+          continue;
+          }
+        numberOfVertices -= 1;
+        numberOfVertexIndices += numberOfVertices;
+        }
       this->m_NumberOfCells += numberOfVertices;
       this->m_CellBufferSize += numberOfVertexIndices;
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfVertices", numberOfVertices);
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfVertices", numberOfVertices);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
 
       // Check whether numberOfVertices and numberOfVertexIndices are correct
       if ( numberOfVertices < 1 )
@@ -268,9 +459,15 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
         return;
         }
 
-      // Set cell component type
-      this->m_CellComponentType = UINT;
       this->m_UpdateCells = true;
+      if ( !this->m_UseOffsetsCellLayout )
+        {
+        // Set cell component type
+        this->m_CellComponentType = UINT;
+
+        this->m_VerticesPosition = inputFile.tellg();
+        this->SkipBinarySection( numberOfVertexIndices * sizeof( unsigned int ) );
+        }
       }
     else if ( line.find("LINES") != std::string::npos )
       {
@@ -282,14 +479,26 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
       ss >> item; // should be "LINES"
 
       // Get number of Polylines
-      unsigned int numberOfLines;
-      unsigned int numberOfLineIndices;
+      SizeValueType numberOfLines;
+      SizeValueType numberOfLineIndices;
       ss >> numberOfLines;
       ss >> numberOfLineIndices;
+      if ( this->m_UseOffsetsCellLayout )
+        {
+        // The header counts the offsets, one more than the cells, and the
+        // point ids only
+        if ( !this->ReadOffsetsCellSection(numberOfLines, numberOfLineIndices, this->m_LinesPosition,
+                                           this->m_LinesConnectivityPosition) )
+          {
+          continue;
+          }
+        numberOfLines -= 1;
+        numberOfLineIndices += numberOfLines;
+        }
       this->m_NumberOfCells += numberOfLines;
       this->m_CellBufferSize += numberOfLineIndices;
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfLineIndices", numberOfLineIndices);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLineIndices", numberOfLineIndices);
 
       // Check whether numberOfPolylines and numberOfPolylineIndices are correct
       if ( numberOfLines < 1 )
@@ -307,9 +516,15 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
         return;
         }
 
-      // Set cell component type
-      this->m_CellComponentType = UINT;
       this->m_UpdateCells = true;
+      if ( !this->m_UseOffsetsCellLayout )
+        {
+        // Set cell component type
+        this->m_CellComponentType = UINT;
+
+        this->m_LinesPosition = inputFile.tellg();
+        this->SkipBinarySection( numberOfLineIndices * sizeof( unsigned int ) );
+        }
       }
     else if ( line.find("POLYGONS") != std::string::npos )
       {
@@ -321,14 +536,26 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
       ss >> item; // should be "POLYGONS"
 
       // Get number of Polygons
-      unsigned int numberOfPolygons;
-      unsigned int numberOfPolygonIndices;
+      SizeValueType numberOfPolygons;
+      SizeValueType numberOfPolygonIndices;
       ss >> numberOfPolygons;
       ss >> numberOfPolygonIndices;
+      if ( this->m_UseOffsetsCellLayout )
+        {
+        // The header counts the offsets, one more than the cells, and the
+        // point ids only
+        if ( !this->ReadOffsetsCellSection(numberOfPolygons, numberOfPolygonIndices, this->m_PolygonsPosition,
+                                           this->m_PolygonsConnectivityPosition) )
+          {
+          continue;
+          }
+        numberOfPolygons -= 1;
+        numberOfPolygonIndices += numberOfPolygons;
+        }
       this->m_NumberOfCells += numberOfPolygons;
       this->m_CellBufferSize += numberOfPolygonIndices;
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfPolygons", numberOfPolygons);
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfPolygons", numberOfPolygons);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
 
       // Check whether numberOfPolygons and numberOfPolygonIndices are correct
       if ( numberOfPolygons < 1 )
@@ -346,9 +573,15 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
         return;
         }
 
-      // Set cell component type
-      this->m_CellComponentType = UINT;
       this->m_UpdateCells = true;
+      if ( !this->m_UseOffsetsCellLayout )
+        {
+        // Set cell component type
+        this->m_CellComponentType = UINT;
+
+        this->m_PolygonsPosition = inputFile.tellg();
+        this->SkipBinarySection( numberOfPolygonIndices * sizeof( unsigned int ) );
+        }
       }
     else if ( line.find("POINT_DATA") != std::string::npos )
       {
@@ -646,6 +879,26 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
         this->m_NumberOfPointPixelComponents = this->m_PointDimension * ( this->m_PointDimension + 1 ) / 2;
         this->m_UpdatePointData = true;
         }
+
+      // Scalars are followed by the LOOKUP_TABLE line
+      if ( line.find("SCALARS") != std::string::npos && line.find("COLOR_SCALARS") == std::string::npos )
+        {
+        if ( !inputFile.eof() )
+          {
+          std::getline(inputFile, line, '\n');
+          }
+        if ( line.find("LOOKUP_TABLE") == std::string::npos )
+          {
+          itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
+          }
+        }
+
+      this->m_PointDataPosition = inputFile.tellg();
+      if ( this->m_PointPixelComponentType != UNKNOWNCOMPONENTTYPE )
+        {
+        this->SkipBinarySection( this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents
+                                 * this->GetComponentSize(this->m_PointPixelComponentType) );
+        }
       }
     else if ( line.find("CELL_DATA") != std::string::npos )
       {
@@ -935,6 +1188,26 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
         this->m_NumberOfCellPixelComponents = this->m_PointDimension * ( this->m_PointDimension + 1 ) / 2;
         this->m_UpdateCellData = true;
         }
+
+      // Scalars are followed by the LOOKUP_TABLE line
+      if ( line.find("SCALARS") != std::string::npos && line.find("COLOR_SCALARS") == std::string::npos )
+        {
+        if ( !inputFile.eof() )
+          {
+          std::getline(inputFile, line, '\n');
+          }
+        if ( line.find("LOOKUP_TABLE") == std::string::npos )
+          {
+          itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
+          }
+        }
+
+      this->m_CellDataPosition = inputFile.tellg();
+      if ( this->m_CellPixelComponentType != UNKNOWNCOMPONENTTYPE )
+        {
+        this->SkipBinarySection( this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents
+                                 * this->GetComponentSize(this->m_CellPixelComponentType) );
+        }
       }
     }
 
@@ -943,33 +1216,17 @@ void VTKPolyDataMeshIO::ReadMeshInformation()
     this->m_CellBufferSize += this->m_NumberOfCells;
     }
 
-  inputFile.close();
+  // The file stays open for the Read*() methods
+  if ( !this->m_UpdatePoints && !this->m_UpdateCells && !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
 }
 
 void VTKPolyDataMeshIO::ReadPoints(void *buffer)
 {
-  // Read input file
-  std::ifstream inputFile;
-
-  if ( this->m_FileType == ASCII )
-    {
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-    }
-  else if ( m_FileType == BINARY )
-    {
-#ifdef _WIN32
-    inputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
-#else
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-#endif
-    }
-
-  // Test whether the file has been opened
-  if ( !inputFile.is_open() )
-    {
-    itkExceptionMacro("Unable to open file\n" "inputFilename= " << this->m_FileName);
-    return;
-    }
+  // Go straight to the section recorded by ReadMeshInformation()
+  this->SeekSection(this->m_PointsPosition, "POINTS");
 
   // Read points according to filetype as ASCII or BINARY
   if ( this->m_FileType == ASCII )
@@ -978,67 +1235,67 @@ void VTKPolyDataMeshIO::ReadPoints(void *buffer)
       {
       case UCHAR:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< unsigned char * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< unsigned char * >( buffer ) );
         break;
         }
       case CHAR:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< char * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< char * >( buffer ) );
         break;
         }
       case USHORT:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< unsigned short * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< unsigned short * >( buffer ) );
         break;
         }
       case SHORT:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< short * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< short * >( buffer ) );
         break;
         }
       case UINT:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< unsigned int * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< unsigned int * >( buffer ) );
         break;
         }
       case INT:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< int * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< int * >( buffer ) );
         break;
         }
       case ULONG:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< unsigned long * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< unsigned long * >( buffer ) );
         break;
         }
       case LONG:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< long * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< long * >( buffer ) );
         break;
         }
       case ULONGLONG:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< unsigned long long * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< unsigned long long * >( buffer ) );
         break;
         }
       case LONGLONG:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< long long * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< long long * >( buffer ) );
         break;
         }
       case FLOAT:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< float * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< float * >( buffer ) );
         break;
         }
       case DOUBLE:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< double * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< double * >( buffer ) );
         break;
         }
       case LDOUBLE:
         {
-        ReadPointsBufferAsASCII( inputFile, static_cast< long double * >( buffer ) );
+        ReadPointsBufferAsASCII( m_InputFile, static_cast< long double * >( buffer ) );
         break;
         }
       default:
@@ -1053,42 +1310,42 @@ void VTKPolyDataMeshIO::ReadPoints(void *buffer)
       {
       case UCHAR:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< unsigned char * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< unsigned char * >( buffer ) );
         break;
         }
       case CHAR:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< char * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< char * >( buffer ) );
         break;
         }
       case USHORT:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< unsigned short * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< unsigned short * >( buffer ) );
         break;
         }
       case SHORT:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< short * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< short * >( buffer ) );
         break;
         }
       case UINT:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< unsigned int * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< unsigned int * >( buffer ) );
         break;
         }
       case INT:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< int * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< int * >( buffer ) );
         break;
         }
       case ULONG:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< unsigned long * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< unsigned long * >( buffer ) );
         break;
         }
       case LONG:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< long * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< long * >( buffer ) );
         break;
         }
       case ULONGLONG:
@@ -1101,7 +1358,7 @@ void VTKPolyDataMeshIO::ReadPoints(void *buffer)
           data[ii] = static_cast< unsigned long >( input[ii] );
           }
 
-        ReadPointsBufferAsBINARY(inputFile, data);
+        ReadPointsBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
@@ -1115,18 +1372,18 @@ void VTKPolyDataMeshIO::ReadPoints(void *buffer)
           data[ii] = static_cast< long >( input[ii] );
           }
 
-        ReadPointsBufferAsBINARY(inputFile, data);
+        ReadPointsBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
       case FLOAT:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< float * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< float * >( buffer ) );
         break;
         }
       case DOUBLE:
         {
-        ReadPointsBufferAsBINARY( inputFile, static_cast< double * >( buffer ) );
+        ReadPointsBufferAsBINARY( m_InputFile, static_cast< double * >( buffer ) );
         break;
         }
       case LDOUBLE:
@@ -1139,7 +1396,7 @@ void VTKPolyDataMeshIO::ReadPoints(void *buffer)
           data[ii] = static_cast< double >( input[ii] );
           }
 
-        ReadPointsBufferAsBINARY(inputFile, data);
+        ReadPointsBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
@@ -1154,69 +1411,69 @@ void VTKPolyDataMeshIO::ReadPoints(void *buffer)
     itkExceptionMacro(<< "Invalid output file type(not ASCII or BINARY)");
     }
 
-  inputFile.close();
+  // Close the file once the last section to update has been read
+  if ( !this->m_UpdateCells && !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
 }
 
 void VTKPolyDataMeshIO::ReadCells(void *buffer)
 {
-  // Read input file
-  std::ifstream inputFile;
-
-  if ( this->m_FileType == ASCII )
+  // Read cells according to layout and file type
+  if ( this->m_UseOffsetsCellLayout )
     {
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-    }
-  else if ( m_FileType == BINARY )
-    {
-#ifdef _WIN32
-    inputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
-#else
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-#endif
-    }
-
-  // Test whether the file has been opened
-  if ( !inputFile.is_open() )
-    {
-    itkExceptionMacro(<< "Unable to open file\n" "inputFilename= " << this->m_FileName);
-    return;
+    switch ( this->m_CellComponentType )
+      {
+      case INT:
+        ReadCellsBufferAsOffsets( m_InputFile, static_cast< int * >( buffer ) );
+        break;
+      case LONGLONG:
+        ReadCellsBufferAsOffsets( m_InputFile, static_cast< long long * >( buffer ) );
+        break;
+      default:
+        itkExceptionMacro(<< "Unknown cell component type");
+      }
     }
-
-  // Read cells according to file type
-  if ( this->m_FileType == ASCII )
+  else if ( this->m_FileType == ASCII )
     {
-    ReadCellsBufferAsASCII(inputFile, buffer);
+    ReadCellsBufferAsASCII(m_InputFile, buffer);
     }
   else if ( this->m_FileType == BINARY )
     {
-    ReadCellsBufferAsBINARY(inputFile, buffer);
+    ReadCellsBufferAsBINARY(m_InputFile, buffer);
     }
   else
     {
     itkExceptionMacro(<< "Unkonw file type");
     }
 
-  inputFile.close();
+  // Close the file once the last section to update has been read
+  if ( !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
 }
 
 void VTKPolyDataMeshIO::ReadCellsBufferAsASCII(std::ifstream & inputFile, void *buffer)
 {
-  std::string   line;
   unsigned long index = 0;
   unsigned int  numPoints; // number of point in each cell
 
   MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
   unsigned int *       data = static_cast< unsigned int * >( buffer );
 
-  while ( !inputFile.eof() )
+  // Visit the cell sections in the order in which they appear in the file
+  const CellSectionsType sections = this->GetCellSections();
+  for ( size_t section = 0; section < sections.size(); section++ )
     {
-    std::getline(inputFile, line, '\n');
-    if ( line.find("VERTICES") != std::string::npos )
+    this->SeekSection(sections[section].first, "cells");
+    if ( sections[section].second == MeshIOBase::VERTEX_CELL )
       {
-      unsigned int numberOfVertices = 0;
-      ExposeMetaData< unsigned int >(metaDic, "numberOfVertices", numberOfVertices);
+      SizeValueType numberOfVertices = 0;
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfVertices", numberOfVertices);
 
-      for ( unsigned int ii = 0; ii < numberOfVertices; ii++ )
+      for ( SizeValueType ii = 0; ii < numberOfVertices; ii++ )
         {
         inputFile >> numPoints;
         data[index++] = MeshIOBase::VERTEX_CELL;
@@ -1227,12 +1484,12 @@ void VTKPolyDataMeshIO::ReadCellsBufferAsASCII(std::ifstream & inputFile, void *
           }
         }
       }
-    else if ( line.find("LINES") != std::string::npos )
+    else if ( sections[section].second == MeshIOBase::LINE_CELL )
       {
-      unsigned int numberOfLines = 0;
-      ExposeMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
+      SizeValueType numberOfLines = 0;
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
 
-      for ( unsigned int ii = 0; ii < numberOfLines; ii++ )
+      for ( SizeValueType ii = 0; ii < numberOfLines; ii++ )
         {
         inputFile >> numPoints;
         data[index++] = MeshIOBase::LINE_CELL;
@@ -1243,12 +1500,12 @@ void VTKPolyDataMeshIO::ReadCellsBufferAsASCII(std::ifstream & inputFile, void *
           }
         }
       }
-    else if ( line.find("POLYGONS") != std::string::npos )
+    else if ( sections[section].second == MeshIOBase::POLYGON_CELL )
       {
-      unsigned int numberOfPolygons = 0;
-      ExposeMetaData< unsigned int >(metaDic, "numberOfPolygons", numberOfPolygons);
+      SizeValueType numberOfPolygons = 0;
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygons", numberOfPolygons);
 
-      for ( unsigned int ii = 0; ii < numberOfPolygons; ii++ )
+      for ( SizeValueType ii = 0; ii < numberOfPolygons; ii++ )
         {
         inputFile >> numPoints;
 
@@ -1272,104 +1529,68 @@ void VTKPolyDataMeshIO::ReadCellsBufferAsBINARY(std::ifstream & inputFile, void
     return;
     }
 
-  unsigned int *inputBuffer = new unsigned int[this->m_CellBufferSize - this->m_NumberOfCells];
-  void *        pv = inputBuffer;
-  char *        startBuffer = static_cast< char * >( pv );
   unsigned int *outputBuffer = static_cast< unsigned int * >( buffer );
 
-  std::string          line;
-  MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
+  // Visit the cell sections in the order in which they appear in the file
+  const CellSectionsType sections = this->GetCellSections();
+  for ( size_t section = 0; section < sections.size(); section++ )
+    {
+    SizeValueType numberOfCells = 0;
+    SizeValueType numberOfIndices = 0;
+    this->GetCellSectionSize(sections[section].second, numberOfCells, numberOfIndices);
+
+    // The section takes numberOfIndices values in the file and one more
+    // value per cell, the cell type, in the output buffer. Read it straight
+    // into the tail of its output range, then expand it in place.
+    unsigned int *input = outputBuffer + numberOfCells;
+    this->SeekSection(sections[section].first, "cells");
+    inputFile.read( reinterpret_cast< char * >( input ), numberOfIndices * sizeof( unsigned int ) );
+    if ( inputFile.gcount() != static_cast< std::streamsize >( numberOfIndices * sizeof( unsigned int ) ) )
+      {
+      itkExceptionMacro(<< "Unexpected end of file while reading cells of file " << this->m_FileName);
+      }
 
-  while ( !inputFile.eof() )
+    this->ExpandCellsBufferAsBINARY(input, outputBuffer, sections[section].second, numberOfCells);
+    outputBuffer += numberOfIndices + numberOfCells;
+    }
+}
+
+void VTKPolyDataMeshIO::ExpandCellsBufferAsBINARY(const unsigned int *input, unsigned int *output,
+                                                  CellGeometryType cellType, SizeValueType numberOfCells)
+{
+  // Before cell ii is written, the input is still numberOfCells - ii values
+  // ahead of the output, so no input value is overwritten before it is read.
+  // The big endian values are swapped in the same pass.
+  const bool swap = itk::ByteSwapper< unsigned int >::SystemIsLittleEndian();
+
+  SizeValueType inputIndex = 0;
+  SizeValueType outputIndex = 0;
+  for ( SizeValueType ii = 0; ii < numberOfCells; ii++ )
     {
-    std::getline(inputFile, line, '\n');
-    if ( line.find("VERTICES") != std::string::npos )
+    unsigned int numberOfPoints = input[inputIndex++];
+    if ( swap )
       {
-      unsigned int numberOfVertices = 0;
-      unsigned int numberOfVertexIndices = 0;
-      ExposeMetaData< unsigned int >(metaDic, "numberOfVertices", numberOfVertices);
-      ExposeMetaData< unsigned int >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
-      inputFile.read( startBuffer, numberOfVertexIndices * sizeof( unsigned int ) );
-
-      pv = startBuffer;
-      unsigned int *data = static_cast< unsigned int * >( pv );
-      if ( itk::ByteSwapper< unsigned int >::SystemIsLittleEndian() )
-        {
-        itk::ByteSwapper< unsigned int >::SwapRangeFromSystemToBigEndian(data, numberOfVertexIndices);
-        }
-      this->WriteCellsBuffer(data, outputBuffer, MeshIOBase::VERTEX_CELL, numberOfVertices);
-      startBuffer += numberOfVertexIndices * sizeof( unsigned int );
-      outputBuffer += ( numberOfVertexIndices + numberOfVertices ) * sizeof( unsigned int );
+      itk::ByteSwapper< unsigned int >::SwapFromSystemToBigEndian(&numberOfPoints);
       }
-    else if ( line.find("LINES") != std::string::npos )
-      {
-      unsigned int numberOfLines = 0;
-      unsigned int numberOfLineIndices = 0;
-      ExposeMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
-      ExposeMetaData< unsigned int >(metaDic, "numberOfLineIndices", numberOfLineIndices);
-      inputFile.read( startBuffer, numberOfLineIndices * sizeof( unsigned int ) );
 
-      pv = startBuffer;
-      unsigned int *data = static_cast< unsigned int * >( pv );
-      if ( itk::ByteSwapper< unsigned int >::SystemIsLittleEndian() )
-        {
-        itk::ByteSwapper< unsigned int >::SwapRangeFromSystemToBigEndian(data, numberOfLineIndices);
-        }
-      this->WriteCellsBuffer(data, outputBuffer, MeshIOBase::LINE_CELL, numberOfLines);
-      startBuffer += numberOfLineIndices * sizeof( unsigned int );
-      outputBuffer += ( numberOfLineIndices + numberOfLines ) * sizeof( unsigned int );
-      }
-    else if ( line.find("POLYGONS") != std::string::npos )
+    output[outputIndex++] = static_cast< unsigned int >( cellType );
+    output[outputIndex++] = numberOfPoints;
+    for ( unsigned int jj = 0; jj < numberOfPoints; jj++ )
       {
-      unsigned int numberOfPolygons = 0;
-      unsigned int numberOfPolygonIndices = 0;
-      ExposeMetaData< unsigned int >(metaDic, "numberOfPolygons", numberOfPolygons);
-      ExposeMetaData< unsigned int >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
-      inputFile.read( startBuffer, numberOfPolygonIndices * sizeof( unsigned int ) );
-
-      pv = startBuffer;
-      unsigned int *data = static_cast< unsigned int * >( pv );
-      if ( itk::ByteSwapper< unsigned int >::SystemIsLittleEndian() )
+      unsigned int pointId = input[inputIndex++];
+      if ( swap )
         {
-        itk::ByteSwapper< unsigned int >::SwapRangeFromSystemToBigEndian(data, numberOfPolygonIndices);
+        itk::ByteSwapper< unsigned int >::SwapFromSystemToBigEndian(&pointId);
         }
-
-      this->WriteCellsBuffer(data, outputBuffer, MeshIOBase::POLYGON_CELL, numberOfPolygons);
-      startBuffer += numberOfPolygonIndices * sizeof( unsigned int );
-      outputBuffer += ( numberOfPolygonIndices + numberOfPolygons ) * sizeof( unsigned int );
+      output[outputIndex++] = pointId;
       }
     }
-
-  if ( this->m_CellBufferSize )
-    {
-    delete[] inputBuffer;
-    }
 }
 
 void VTKPolyDataMeshIO::ReadPointData(void *buffer)
 {
-  // Read input file
-  std::ifstream inputFile;
-
-  if ( this->m_FileType == ASCII )
-    {
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-    }
-  else if ( m_FileType == BINARY )
-    {
-#ifdef _WIN32
-    inputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
-#else
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-#endif
-    }
-
-  // Test whether the file has been opened
-  if ( !inputFile.is_open() )
-    {
-    itkExceptionMacro(<< "Unable to open file\n" "inputFilename= " << this->m_FileName);
-    return;
-    }
+  // Go straight to the section recorded by ReadMeshInformation()
+  this->SeekSection(this->m_PointDataPosition, "POINT_DATA");
 
   // Read cells according to file type
   if ( this->m_FileType == ASCII )
@@ -1378,67 +1599,67 @@ void VTKPolyDataMeshIO::ReadPointData(void *buffer)
       {
       case UCHAR:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< unsigned char * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< unsigned char * >( buffer ) );
         break;
         }
       case CHAR:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< char * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< char * >( buffer ) );
         break;
         }
       case USHORT:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< unsigned short * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< unsigned short * >( buffer ) );
         break;
         }
       case SHORT:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< short * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< short * >( buffer ) );
         break;
         }
       case UINT:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< unsigned int * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< unsigned int * >( buffer ) );
         break;
         }
       case INT:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< int * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< int * >( buffer ) );
         break;
         }
       case ULONG:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< unsigned long * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< unsigned long * >( buffer ) );
         break;
         }
       case LONG:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< long * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< long * >( buffer ) );
         break;
         }
       case ULONGLONG:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< unsigned long long * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< unsigned long long * >( buffer ) );
         break;
         }
       case LONGLONG:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< long long * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< long long * >( buffer ) );
         break;
         }
       case FLOAT:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< float * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< float * >( buffer ) );
         break;
         }
       case DOUBLE:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< double * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< double * >( buffer ) );
         break;
         }
       case LDOUBLE:
         {
-        ReadPointDataBufferAsASCII( inputFile, static_cast< long double * >( buffer ) );
+        ReadPointDataBufferAsASCII( m_InputFile, static_cast< long double * >( buffer ) );
         break;
         }
       default:
@@ -1453,42 +1674,42 @@ void VTKPolyDataMeshIO::ReadPointData(void *buffer)
       {
       case UCHAR:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< unsigned char * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< unsigned char * >( buffer ) );
         break;
         }
       case CHAR:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< char * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< char * >( buffer ) );
         break;
         }
       case USHORT:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< unsigned short * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< unsigned short * >( buffer ) );
         break;
         }
       case SHORT:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< short * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< short * >( buffer ) );
         break;
         }
       case UINT:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< unsigned int * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< unsigned int * >( buffer ) );
         break;
         }
       case INT:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< int * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< int * >( buffer ) );
         break;
         }
       case ULONG:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< unsigned long * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< unsigned long * >( buffer ) );
         break;
         }
       case LONG:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< long * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< long * >( buffer ) );
         break;
         }
       case ULONGLONG:
@@ -1501,7 +1722,7 @@ void VTKPolyDataMeshIO::ReadPointData(void *buffer)
           data[ii] = static_cast< unsigned long >( input[ii] );
           }
 
-        ReadPointDataBufferAsBINARY(inputFile, data);
+        ReadPointDataBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
@@ -1515,18 +1736,18 @@ void VTKPolyDataMeshIO::ReadPointData(void *buffer)
           data[ii] = static_cast< long >( input[ii] );
           }
 
-        ReadPointDataBufferAsBINARY(inputFile, data);
+        ReadPointDataBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
       case FLOAT:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< float * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< float * >( buffer ) );
         break;
         }
       case DOUBLE:
         {
-        ReadPointDataBufferAsBINARY( inputFile, static_cast< double * >( buffer ) );
+        ReadPointDataBufferAsBINARY( m_InputFile, static_cast< double * >( buffer ) );
         break;
         }
       case LDOUBLE:
@@ -1539,7 +1760,7 @@ void VTKPolyDataMeshIO::ReadPointData(void *buffer)
           data[ii] = static_cast< double >( input[ii] );
           }
 
-        ReadPointDataBufferAsBINARY(inputFile, data);
+        ReadPointDataBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
@@ -1554,33 +1775,17 @@ void VTKPolyDataMeshIO::ReadPointData(void *buffer)
     itkExceptionMacro(<< "Unkonw file type");
     }
 
-  inputFile.close();
+  // Close the file once the last section to update has been read
+  if ( !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
 }
 
 void VTKPolyDataMeshIO::ReadCellData(void *buffer)
 {
-  // Read input file
-  std::ifstream inputFile;
-
-  if ( this->m_FileType == ASCII )
-    {
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-    }
-  else if ( m_FileType == BINARY )
-    {
-#ifdef _WIN32
-    inputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
-#else
-    inputFile.open(this->m_FileName.c_str(), std::ios::in);
-#endif
-    }
-
-  // Test whether the file has been opened
-  if ( !inputFile.is_open() )
-    {
-    itkExceptionMacro(<< "Unable to open file\n" "inputFilename= " << this->m_FileName);
-    return;
-    }
+  // Go straight to the section recorded by ReadMeshInformation()
+  this->SeekSection(this->m_CellDataPosition, "CELL_DATA");
 
   // Read cell data according file type
   if ( this->m_FileType == ASCII )
@@ -1589,67 +1794,67 @@ void VTKPolyDataMeshIO::ReadCellData(void *buffer)
       {
       case UCHAR:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< unsigned char * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< unsigned char * >( buffer ) );
         break;
         }
       case CHAR:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< char * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< char * >( buffer ) );
         break;
         }
       case USHORT:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< unsigned short * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< unsigned short * >( buffer ) );
         break;
         }
       case SHORT:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< short * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< short * >( buffer ) );
         break;
         }
       case UINT:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< unsigned int * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< unsigned int * >( buffer ) );
         break;
         }
       case INT:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< int * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< int * >( buffer ) );
         break;
         }
       case ULONG:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< unsigned long * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< unsigned long * >( buffer ) );
         break;
         }
       case LONG:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< long * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< long * >( buffer ) );
         break;
         }
       case ULONGLONG:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< unsigned long long * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< unsigned long long * >( buffer ) );
         break;
         }
       case LONGLONG:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< long long * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< long long * >( buffer ) );
         break;
         }
       case FLOAT:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< float * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< float * >( buffer ) );
         break;
         }
       case DOUBLE:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< double * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< double * >( buffer ) );
         break;
         }
       case LDOUBLE:
         {
-        ReadCellDataBufferAsASCII( inputFile, static_cast< long double * >( buffer ) );
+        ReadCellDataBufferAsASCII( m_InputFile, static_cast< long double * >( buffer ) );
         break;
         }
       default:
@@ -1664,42 +1869,42 @@ void VTKPolyDataMeshIO::ReadCellData(void *buffer)
       {
       case UCHAR:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< unsigned char * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< unsigned char * >( buffer ) );
         break;
         }
       case CHAR:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< char * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< char * >( buffer ) );
         break;
         }
       case USHORT:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< unsigned short * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< unsigned short * >( buffer ) );
         break;
         }
       case SHORT:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< short * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< short * >( buffer ) );
         break;
         }
       case UINT:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< unsigned int * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< unsigned int * >( buffer ) );
         break;
         }
       case INT:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< int * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< int * >( buffer ) );
         break;
         }
       case ULONG:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< unsigned long * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< unsigned long * >( buffer ) );
         break;
         }
       case LONG:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< long * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< long * >( buffer ) );
         break;
         }
       case ULONGLONG:
@@ -1712,7 +1917,7 @@ void VTKPolyDataMeshIO::ReadCellData(void *buffer)
           data[ii] = static_cast< unsigned long >( input[ii] );
           }
 
-        ReadCellDataBufferAsBINARY(inputFile, data);
+        ReadCellDataBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
@@ -1726,18 +1931,18 @@ void VTKPolyDataMeshIO::ReadCellData(void *buffer)
           data[ii] = static_cast< long >( input[ii] );
           }
 
-        ReadCellDataBufferAsBINARY(inputFile, data);
+        ReadCellDataBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
       case FLOAT:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< float * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< float * >( buffer ) );
         break;
         }
       case DOUBLE:
         {
-        ReadCellDataBufferAsBINARY( inputFile, static_cast< double * >( buffer ) );
+        ReadCellDataBufferAsBINARY( m_InputFile, static_cast< double * >( buffer ) );
         break;
         }
       case LDOUBLE:
@@ -1750,7 +1955,7 @@ void VTKPolyDataMeshIO::ReadCellData(void *buffer)
           data[ii] = static_cast< double >( input[ii] );
           }
 
-        ReadCellDataBufferAsBINARY(inputFile, data);
+        ReadCellDataBufferAsBINARY(m_InputFile, data);
         delete[] data;
         break;
         }
@@ -1765,7 +1970,7 @@ void VTKPolyDataMeshIO::ReadCellData(void *buffer)
     itkExceptionMacro(<< "Unkonw file type");
     }
 
-  inputFile.close();
+  this->CloseFile();
 }
 
 void VTKPolyDataMeshIO::WriteMeshInformation()
@@ -1800,7 +2005,14 @@ void VTKPolyDataMeshIO::WriteMeshInformation()
     }
 
   // Write VTK header
-  outputFile << "# vtk DataFile Version 2.0" << "\n";
+  if ( this->m_UseOffsetsCellLayout )
+    {
+    outputFile << "# vtk DataFile Version 5.1" << "\n";
+    }
+  else
+    {
+    outputFile << "# vtk DataFile Version 2.0" << "\n";
+    }
   outputFile << "File written by itkPolyDataMeshIO" << "\n";
   if ( m_FileType == ASCII )
     {
@@ -2069,8 +2281,16 @@ void VTKPolyDataMeshIO::WriteCells(void *buffer)
     return;
     }
 
-  // Write file according to ASCII or BINARY
-  if ( this->m_FileType == ASCII )
+  // Write file according to layout and ASCII or BINARY
+  if ( this->m_UseOffsetsCellLayout )
+    {
+    WriteCellsBufferAsOffsetsVisitor visitor;
+    visitor.MeshIO = this;
+    visitor.OutputFile = &outputFile;
+    visitor.Buffer = buffer;
+    this->VisitComponentType(this->m_CellComponentType, visitor);
+    }
+  else if ( this->m_FileType == ASCII )
     {
     switch ( this->m_CellComponentType )
       {
@@ -2256,6 +2476,25 @@ void VTKPolyDataMeshIO::WriteCells(void *buffer)
   outputFile.close();
 }
 
+void VTKPolyDataMeshIO::WriteCellArray(std::ofstream & outputFile, const char *name, long long *values,
+                                       SizeValueType numberOfValues)
+{
+  outputFile << name << " vtktypeint64" << '\n';
+  if ( this->m_FileType == ASCII )
+    {
+    // Nine values per line, as written by VTK
+    for ( SizeValueType ii = 0; ii < numberOfValues; ii++ )
+      {
+      outputFile << values[ii] << ( ( ii % 9 == 8 || ii + 1 == numberOfValues ) ? '\n' : ' ' );
+      }
+    }
+  else
+    {
+    itk::ByteSwapper< long long >::SwapWriteRangeFromSystemToBigEndian(values, numberOfValues, &outputFile);
+    outputFile << '\n';
+    }
+}
+
 void VTKPolyDataMeshIO::WritePointData(void *buffer)
 {
   // check file name
@@ -2702,23 +2941,25 @@ void VTKPolyDataMeshIO::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
 
   const MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
-  unsigned int               value = 0;
+  SizeValueType              value = 0;
 
-  if ( ExposeMetaData< unsigned int >(metaDic, "numberOfVertices", value) )
+  if ( ExposeMetaData< SizeValueType >(metaDic, "numberOfVertices", value) )
     {
     os << indent << "number of vertices : " << value << std::endl;
     }
 
-  if ( ExposeMetaData< unsigned int >(metaDic, "numberOfLines", value) )
+  if ( ExposeMetaData< SizeValueType >(metaDic, "numberOfLines", value) )
     {
     os << indent << "number of lines : " << value << std::endl;
     }
 
-  if ( ExposeMetaData< unsigned int >(metaDic, "numberOfPolygons", value) )
+  if ( ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygons", value) )
     {
     os << indent << "number of polygons : " << value << std::endl;
     }
 
+  os << indent << "UseOffsetsCellLayout : " << m_UseOffsetsCellLayout << std::endl;
+
   StringType dataName;
   if ( ExposeMetaData< StringType >(metaDic, "pointScalarDataName", dataName) )
     {
@@ -25,8 +25,10 @@
 #include "itkByteSwapper.h"
 #include "itkMetaDataObject.h"
 #include "itkMeshIOBase.h"
+#include "itkMultiThreader.h"
 #include "itkVectorContainer.h"
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <itksys/SystemTools.hxx>
@@ -37,6 +39,16 @@ namespace itk
  * \brief
  * Reads a vtkPolyData legacy file and create an itk::Mesh<> or itk::QuadEdgeMesh<>
  *
+ * ReadMeshInformation() scans the file once and records where the data of
+ * each section starts. The file is kept open and every Read*() method
+ * seeks straight to its section; the file is closed once the last section
+ * that has to be updated has been read.
+ *
+ * Files of version 5 and above, such as those written by VTK 9, store each
+ * cell section as an OFFSETS and a CONNECTIVITY array. The offsets give the
+ * position of every cell, so these sections are expanded into the cells
+ * buffer by several threads.
+ *
  * \author Wanlin Zhu. Uviversity of New South Wales, Australia.
  */
 class ITK_EXPORT VTKPolyDataMeshIO:public MeshIOBase
@@ -57,6 +69,7 @@ public:
   typedef std::vector< PointIdentifier >                     PointIdVector;
   typedef VectorContainer< PointIdentifier,  PointIdVector > PolylinesContainerType;
   typedef PolylinesContainerType::Pointer                    PolylinesContainerPointer;
+  typedef std::streamoff                                     StreamOffsetType;
 
   /** Method for creation through the object factory. */
   itkNewMacro(Self);
@@ -64,6 +77,14 @@ public:
   /** Run-time type information (and related methods). */
   itkTypeMacro(VTKPolyDataMeshIO, MeshIOBase);
 
+  /** Write the cells as OFFSETS and CONNECTIVITY arrays of 64 bit indices,
+   * in a version 5.1 file. Off by default, so that the files can be read by
+   * VTK versions older than 9. ReadMeshInformation() sets it to the layout
+   * of the file read. */
+  itkSetMacro(UseOffsetsCellLayout, bool);
+  itkGetConstMacro(UseOffsetsCellLayout, bool);
+  itkBooleanMacro(UseOffsetsCellLayout);
+
   /**-------- This part of the interfaces deals with reading data. ----- */
 
   /** Determine if the file can be read with this MeshIO implementation.
@@ -113,15 +134,53 @@ protected:
 
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Open the input file if it is not open yet. */
+  void OpenFile();
+
+  void CloseFile();
+
+  /** Position the input file at the first value of a section recorded by
+   * ReadMeshInformation(). */
+  void SeekSection(StreamOffsetType position, const char *section);
+
+  /** Move the input file past the binary values of the current section, so
+   * that they are not scanned for keywords. */
+  void SkipBinarySection(SizeValueType numberOfBytes);
+
+  typedef std::pair< StreamOffsetType, CellGeometryType > CellSectionType;
+  typedef std::vector< CellSectionType >                  CellSectionsType;
+
+  /** Offsets and cell types of the VERTICES, LINES and POLYGONS sections, in
+   * file order. */
+  CellSectionsType GetCellSections() const;
+
+  /** Number of cells and of indices of the section of a cell type, as
+   * counted in the legacy layout: one index per point and one per cell. */
+  void GetCellSectionSize(CellGeometryType cellType, SizeValueType & numberOfCells,
+                          SizeValueType & numberOfIndices) const;
+
+  /** Index of the VERTICES, LINES and POLYGONS section that holds a cell
+   * type, or -1 when the type cannot be written. */
+  static int GetCellSectionIndex(CellGeometryType cellType);
+
+  /** Read the OFFSETS and CONNECTIVITY headers that follow a cell section
+   * header in the version 5 layout, record where their values start and
+   * move past them. Return false when the section has no cell. */
+  bool ReadOffsetsCellSection(SizeValueType numberOfOffsets, SizeValueType connectivitySize,
+                              StreamOffsetType & offsetsPosition, StreamOffsetType & connectivityPosition);
+
+  /** Write an OFFSETS or CONNECTIVITY array of the version 5 layout. */
+  void WriteCellArray(std::ofstream & outputFile, const char *name, long long *values, SizeValueType numberOfValues);
+
   template< typename T >
   void UpdateCellInformation(T *buffer)
   {
-    unsigned int numberOfVertices = 0;
-    unsigned int numberOfVertexIndices = 0;
-    unsigned int numberOfLines = 0;
-    unsigned int numberOfLineIndices = 0;
-    unsigned int numberOfPolygons = 0;
-    unsigned int numberOfPolygonIndices = 0;
+    SizeValueType numberOfVertices = 0;
+    SizeValueType numberOfVertexIndices = 0;
+    SizeValueType numberOfLines = 0;
+    SizeValueType numberOfLineIndices = 0;
+    SizeValueType numberOfPolygons = 0;
+    SizeValueType numberOfPolygonIndices = 0;
 
     unsigned long index = 0;
 
@@ -159,55 +218,37 @@ protected:
       }
 
     MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
-    EncapsulateMetaData< unsigned int >(metaDic, "numberOfVertices", numberOfVertices);
-    EncapsulateMetaData< unsigned int >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
-    EncapsulateMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
-    EncapsulateMetaData< unsigned int >(metaDic, "numberOfLineIndices", numberOfLineIndices);
-    EncapsulateMetaData< unsigned int >(metaDic, "numberOfPolygons", numberOfPolygons);
-    EncapsulateMetaData< unsigned int >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
+    EncapsulateMetaData< SizeValueType >(metaDic, "numberOfVertices", numberOfVertices);
+    EncapsulateMetaData< SizeValueType >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
+    EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
+    EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLineIndices", numberOfLineIndices);
+    EncapsulateMetaData< SizeValueType >(metaDic, "numberOfPolygons", numberOfPolygons);
+    EncapsulateMetaData< SizeValueType >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
     return;
   }
 
+  /** The point readers expect the input file to be positioned at the first
+   * coordinate of the POINTS section. */
   template< typename T >
   void ReadPointsBufferAsASCII(std::ifstream & inputFile, T *buffer)
   {
-    std::string line;
-
-    while ( !inputFile.eof() )
+    /**  Load the point coordinates into the itk::Mesh */
+    unsigned long numberOfComponents = this->m_NumberOfPoints * this->m_PointDimension;
+    for ( unsigned long ii = 0; ii < numberOfComponents; ii++ )
       {
-      std::getline(inputFile, line, '\n');
-
-      if ( line.find("POINTS") != std::string::npos )
-        {
-        /**  Load the point coordinates into the itk::Mesh */
-        unsigned long numberOfComponents = this->m_NumberOfPoints * this->m_PointDimension;
-        for ( unsigned int ii = 0; ii < numberOfComponents; ii++ )
-          {
-          inputFile >> buffer[ii];
-          }
-        }
+      inputFile >> buffer[ii];
       }
   }
 
   template< typename T >
   void ReadPointsBufferAsBINARY(std::ifstream & inputFile, T *buffer)
   {
-    std::string line;
-
-    while ( !inputFile.eof() )
+    /**  Load the point coordinates into the itk::Mesh */
+    unsigned long numberOfComponents = this->m_NumberOfPoints * this->m_PointDimension;
+    inputFile.read( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( T ) );
+    if ( itk::ByteSwapper< T >::SystemIsLittleEndian() )
       {
-      std::getline(inputFile, line, '\n');
-
-      if ( line.find("POINTS") != std::string::npos )
-        {
-        /**  Load the point coordinates into the itk::Mesh */
-        unsigned long numberOfComponents = this->m_NumberOfPoints * this->m_PointDimension;
-        inputFile.read( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( T ) );
-        if ( itk::ByteSwapper< T >::SystemIsLittleEndian() )
-          {
-          itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(buffer, numberOfComponents);
-          }
-        }
+      itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(buffer, numberOfComponents);
       }
   }
 
@@ -215,188 +256,206 @@ protected:
 
   void ReadCellsBufferAsBINARY(std::ifstream & inputFile, void *buffer);
 
+  /** Insert the cell type in front of each cell of a section read as big
+   * endian values. The input may lie in the output buffer, numberOfCells
+   * values past the output. */
+  void ExpandCellsBufferAsBINARY(const unsigned int *input, unsigned int *output,
+                                 CellGeometryType cellType, SizeValueType numberOfCells);
+
+  /** Read the values of an OFFSETS or CONNECTIVITY array. */
   template< typename T >
-  void ReadPointDataBufferAsASCII(std::ifstream & inputFile, T *buffer)
+  void ReadCellArray(std::ifstream & inputFile, T *values, SizeValueType numberOfValues)
   {
-    StringType line;
-
-    while ( !inputFile.eof() )
+    if ( this->m_FileType == ASCII )
       {
-      std::getline(inputFile, line, '\n');
-      if ( line.find("POINT_DATA") != std::string::npos )
+      for ( SizeValueType ii = 0; ii < numberOfValues; ii++ )
         {
-        if ( !inputFile.eof() )
-          {
-          std::getline(inputFile, line, '\n');
-          }
-        else
-          {
-          itkExceptionMacro("UnExpected end of line while trying to read POINT_DATA");
-          }
+        inputFile >> values[ii];
+        }
+      }
+    else
+      {
+      inputFile.read( reinterpret_cast< char * >( values ), numberOfValues * sizeof( T ) );
+      if ( inputFile.gcount() != static_cast< std::streamsize >( numberOfValues * sizeof( T ) ) )
+        {
+        itkExceptionMacro(<< "Unexpected end of file while reading cells of file " << this->m_FileName);
+        }
+      itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(values, numberOfValues);
+      }
 
-        /** For scalars we have to read the next line of LOOKUP_TABLE */
-        if ( line.find("SCALARS") != std::string::npos && line.find("COLOR_SCALARS") == std::string::npos )
-          {
-          if ( !inputFile.eof() )
-            {
-            std::getline(inputFile, line, '\n');
-            if ( line.find("LOOKUP_TABLE") == std::string::npos )
-              {
-              itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-              }
-            }
-          else
-            {
-            itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-            }
-          }
+    if ( inputFile.fail() )
+      {
+      itkExceptionMacro(<< "Error while reading cells of file " << this->m_FileName);
+      }
+  }
 
-        /** for VECTORS or NORMALS or TENSORS, we could read them directly */
-        unsigned long numberOfComponents = this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents;
-        for ( unsigned int ii = 0; ii < numberOfComponents; ii++ )
-          {
-          inputFile >> buffer[ii];
-          }
-        }
+  /** Cells of a section of the version 5 layout, expanded by the threads of
+   * a MultiThreader */
+  template< typename T >
+  struct OffsetsCellsStruct
+    {
+    const T *        Offsets;
+    const T *        Connectivity;
+    T *              Output;
+    SizeValueType    NumberOfCells;
+    CellGeometryType CellType;
+    };
+
+  /** Expand the cells [firstCell, lastCell) into the output buffer. Cell
+   * ii starts at Offsets[ii] + 2 * ii in the output buffer, so any range of
+   * cells can be expanded on its own. */
+  template< typename T >
+  static void ExpandOffsetsCells(const OffsetsCellsStruct< T > & str, SizeValueType firstCell, SizeValueType lastCell)
+  {
+    for ( SizeValueType ii = firstCell; ii < lastCell; ii++ )
+      {
+      const SizeValueType begin = static_cast< SizeValueType >( str.Offsets[ii] );
+      const SizeValueType end = static_cast< SizeValueType >( str.Offsets[ii + 1] );
+      T *                 output = str.Output + begin + 2 * ii;
+      *output++ = static_cast< T >( str.CellType );
+      *output++ = static_cast< T >( end - begin );
+      std::copy(str.Connectivity + begin, str.Connectivity + end, output);
       }
   }
 
   template< typename T >
-  void ReadPointDataBufferAsBINARY(std::ifstream & inputFile, T *buffer)
+  static ITK_THREAD_RETURN_TYPE OffsetsCellsThreaderCallback(void *arg)
   {
-    StringType line;
+    MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+    OffsetsCellsStruct< T > *        str = static_cast< OffsetsCellsStruct< T > * >( info->UserData );
+
+    // The cells are split evenly among the threads without a serial walk
+    const SizeValueType firstCell = str->NumberOfCells * info->ThreadID / info->NumberOfThreads;
+    const SizeValueType lastCell = str->NumberOfCells * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+    ExpandOffsetsCells(*str, firstCell, lastCell);
 
-    while ( !inputFile.eof() )
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  /** Read the cells of a file of version 5 and above. */
+  template< typename T >
+  void ReadCellsBufferAsOffsets(std::ifstream & inputFile, T *buffer)
+  {
+    // Visit the cell sections in the order in which they appear in the file
+    const CellSectionsType sections = this->GetCellSections();
+    for ( size_t section = 0; section < sections.size(); section++ )
       {
-      std::getline(inputFile, line, '\n');
-      if ( line.find("POINT_DATA") != std::string::npos )
+      const CellGeometryType cellType = sections[section].second;
+      SizeValueType          numberOfCells = 0;
+      SizeValueType          numberOfIndices = 0;
+      this->GetCellSectionSize(cellType, numberOfCells, numberOfIndices);
+      const SizeValueType connectivitySize = numberOfIndices - numberOfCells;
+
+      MeshIOScratchBuffer< T > offsets(numberOfCells + 1);
+      this->SeekSection(sections[section].first, "cell offsets");
+      this->ReadCellArray( inputFile, offsets.GetBuffer(), numberOfCells + 1 );
+
+      MeshIOScratchBuffer< T > connectivity(connectivitySize);
+      if ( cellType == VERTEX_CELL )
         {
-        if ( !inputFile.eof() )
-          {
-          std::getline(inputFile, line, '\n');
-          }
-        else
-          {
-          itkExceptionMacro("UnExpected end of line while trying to read POINT_DATA");
-          }
+        this->SeekSection(m_VerticesConnectivityPosition, "cell connectivity");
+        }
+      else if ( cellType == LINE_CELL )
+        {
+        this->SeekSection(m_LinesConnectivityPosition, "cell connectivity");
+        }
+      else
+        {
+        this->SeekSection(m_PolygonsConnectivityPosition, "cell connectivity");
+        }
+      this->ReadCellArray(inputFile, connectivity.GetBuffer(), connectivitySize);
 
-        /** For scalars we have to read the next line of LOOKUP_TABLE */
-        if ( line.find("SCALARS") != std::string::npos && line.find("COLOR_SCALARS") == std::string::npos )
+      // The threads write where the offsets tell them to, so the offsets
+      // are checked before any of them is used
+      const T *offsetsBuffer = offsets.GetBuffer();
+      if ( offsetsBuffer[0] != 0
+           || static_cast< SizeValueType >( offsetsBuffer[numberOfCells] ) != connectivitySize )
+        {
+        itkExceptionMacro(<< "Cell offsets do not match the connectivity size in file " << this->m_FileName);
+        }
+      for ( SizeValueType ii = 0; ii < numberOfCells; ii++ )
+        {
+        if ( offsetsBuffer[ii + 1] < offsetsBuffer[ii] )
           {
-          if ( !inputFile.eof() )
-            {
-            std::getline(inputFile, line, '\n');
-            if ( line.find("LOOKUP_TABLE") == std::string::npos )
-              {
-              itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-              }
-            }
-          else
-            {
-            itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-            }
+          itkExceptionMacro(<< "Cell offsets are not increasing in file " << this->m_FileName);
           }
+        }
 
-        /** for VECTORS or NORMALS or TENSORS, we could read them directly */
-        unsigned long numberOfComponents = this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents;
-        inputFile.read( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( T ) );
-        if ( itk::ByteSwapper< T >::SystemIsLittleEndian() )
-          {
-          itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(buffer, numberOfComponents);
-          }
+      OffsetsCellsStruct< T > str;
+      str.Offsets = offsetsBuffer;
+      str.Connectivity = connectivity.GetBuffer();
+      str.Output = buffer;
+      str.NumberOfCells = numberOfCells;
+      str.CellType = cellType;
+
+      // Below this number of cells per thread, starting the threads costs
+      // more than expanding the cells
+      const SizeValueType minimumNumberOfCellsPerThread = 4096;
+      const int           numberOfThreads = static_cast< int >( std::min(
+                                                                  static_cast< SizeValueType >( this->m_NumberOfThreads ),
+                                                                  numberOfCells / minimumNumberOfCellsPerThread) );
+      if ( numberOfThreads < 2 )
+        {
+        ExpandOffsetsCells(str, 0, numberOfCells);
         }
+      else
+        {
+        MultiThreader::Pointer threader = MultiThreader::New();
+        threader->SetNumberOfThreads(numberOfThreads);
+        threader->SetSingleMethod(&Self::OffsetsCellsThreaderCallback< T >, &str);
+        threader->SingleMethodExecute();
+        }
+
+      buffer += numberOfIndices + numberOfCells;
       }
   }
 
+  /** The point and cell data readers expect the input file to be positioned
+   * at the first value of the POINT_DATA or CELL_DATA section, after the
+   * attribute header and the LOOKUP_TABLE line of scalars. */
   template< typename T >
-  void ReadCellDataBufferAsASCII(std::ifstream & inputFile, T *buffer)
+  void ReadPointDataBufferAsASCII(std::ifstream & inputFile, T *buffer)
   {
-    StringType line;
-
-    while ( !inputFile.eof() )
+    /** for VECTORS or NORMALS or TENSORS, we could read them directly */
+    unsigned long numberOfComponents = this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents;
+    for ( unsigned long ii = 0; ii < numberOfComponents; ii++ )
       {
-      std::getline(inputFile, line, '\n');
-      if ( line.find("CELL_DATA") != std::string::npos )
-        {
-        if ( !inputFile.eof() )
-          {
-          std::getline(inputFile, line, '\n');
-          }
-        else
-          {
-          itkExceptionMacro("UnExpected end of line while trying to read CELL_DATA");
-          }
+      inputFile >> buffer[ii];
+      }
+  }
 
-        /** For scalars we have to read the next line of LOOKUP_TABLE */
-        if ( line.find("SCALARS") != std::string::npos && line.find("COLOR_SCALARS") == std::string::npos )
-          {
-          if ( !inputFile.eof() )
-            {
-            std::getline(inputFile, line, '\n');
-            if ( line.find("LOOKUP_TABLE") == std::string::npos )
-              {
-              itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-              }
-            }
-          else
-            {
-            itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-            }
-          }
+  template< typename T >
+  void ReadPointDataBufferAsBINARY(std::ifstream & inputFile, T *buffer)
+  {
+    /** for VECTORS or NORMALS or TENSORS, we could read them directly */
+    unsigned long numberOfComponents = this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents;
+    inputFile.read( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( T ) );
+    if ( itk::ByteSwapper< T >::SystemIsLittleEndian() )
+      {
+      itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(buffer, numberOfComponents);
+      }
+  }
 
-        /** for VECTORS or NORMALS or TENSORS, we could read them directly */
-        unsigned long numberOfComponents = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
-        for ( unsigned int ii = 0; ii < numberOfComponents; ii++ )
-          {
-          inputFile >> buffer[ii];
-          }
-        }
+  template< typename T >
+  void ReadCellDataBufferAsASCII(std::ifstream & inputFile, T *buffer)
+  {
+    /** for VECTORS or NORMALS or TENSORS, we could read them directly */
+    unsigned long numberOfComponents = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
+    for ( unsigned long ii = 0; ii < numberOfComponents; ii++ )
+      {
+      inputFile >> buffer[ii];
       }
   }
 
   template< typename T >
   void ReadCellDataBufferAsBINARY(std::ifstream & inputFile, T *buffer)
   {
-    StringType line;
-
-    while ( !inputFile.eof() )
+    /** For VECTORS or NORMALS or TENSORS, we could read them directly */
+    unsigned long numberOfComponents = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
+    inputFile.read( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( T ) );
+    if ( itk::ByteSwapper< T >::SystemIsLittleEndian() )
       {
-      std::getline(inputFile, line, '\n');
-      if ( line.find("POINT_DATA") != std::string::npos )
-        {
-        if ( !inputFile.eof() )
-          {
-          std::getline(inputFile, line, '\n');
-          }
-        else
-          {
-          itkExceptionMacro("UnExpected end of line while trying to read POINT_DATA");
-          }
-
-        /** For scalars we have to read the next line of LOOKUP_TABLE */
-        if ( line.find("SCALARS") != std::string::npos && line.find("COLOR_SCALARS") == std::string::npos )
-          {
-          if ( !inputFile.eof() )
-            {
-            std::getline(inputFile, line, '\n');
-            if ( line.find("LOOKUP_TABLE") == std::string::npos )
-              {
-              itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-              }
-            }
-          else
-            {
-            itkExceptionMacro("UnExpected end of line while trying to read LOOKUP_TABLE");
-            }
-          }
-        /** For VECTORS or NORMALS or TENSORS, we could read them directly */
-        unsigned long numberOfComponents = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
-        inputFile.read( reinterpret_cast< char * >( buffer ), numberOfComponents * sizeof( T ) );
-        if ( itk::ByteSwapper< T >::SystemIsLittleEndian() )
-          {
-          itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(buffer, numberOfComponents);
-          }
-        }
+      itk::ByteSwapper< T >::SwapRangeFromSystemToBigEndian(buffer, numberOfComponents);
       }
   }
 
@@ -436,20 +495,20 @@ protected:
   void WriteCellsBufferAsASCII(std::ofstream & outputFile, T *buffer)
   {
     MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
-    unsigned int         numberOfVertices = 0;
-    unsigned int         numberOfVertexIndices = 0;
-    unsigned int         numberOfLines = 0;
-    unsigned int         numberOfLineIndices = 0;
-    unsigned int         numberOfPolygons = 0;
-    unsigned int         numberOfPolygonIndices = 0;
+    SizeValueType        numberOfVertices = 0;
+    SizeValueType        numberOfVertexIndices = 0;
+    SizeValueType        numberOfLines = 0;
+    SizeValueType        numberOfLineIndices = 0;
+    SizeValueType        numberOfPolygons = 0;
+    SizeValueType        numberOfPolygonIndices = 0;
 
     /** Write vertices */
     unsigned long index = 0;
 
-    ExposeMetaData< unsigned int >(metaDic, "numberOfVertices", numberOfVertices);
+    ExposeMetaData< SizeValueType >(metaDic, "numberOfVertices", numberOfVertices);
     if ( numberOfVertices )
       {
-      ExposeMetaData< unsigned int >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
       outputFile << "VERTICES " << numberOfVertices << " " << numberOfVertexIndices << '\n';
       for ( unsigned long ii = 0; ii < this->m_NumberOfCells; ii++ )
         {
@@ -473,7 +532,7 @@ protected:
 
     /** Write lines */
     index = 0;
-    ExposeMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
+    ExposeMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
     if ( numberOfLines )
       {
       numberOfLineIndices = 0;
@@ -526,8 +585,8 @@ protected:
 
       numberOfLines = polylines->Size();
       numberOfLineIndices += numberOfLines;
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfLineIndices", numberOfLineIndices);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLineIndices", numberOfLineIndices);
       outputFile << "LINES " << numberOfLines << " " << numberOfLineIndices << '\n';
       for ( PointIdentifier ii = 0; ii < polylines->Size(); ++ii )
         {
@@ -543,10 +602,10 @@ protected:
 
     /** Write polygons */
     index = 0;
-    ExposeMetaData< unsigned int >(metaDic, "numberOfPolygons", numberOfPolygons);
+    ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygons", numberOfPolygons);
     if ( numberOfPolygons )
       {
-      ExposeMetaData< unsigned int >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
       outputFile << "POLYGONS " << numberOfPolygons << " " << numberOfPolygonIndices << '\n';
       for ( unsigned long ii = 0; ii < this->m_NumberOfCells; ii++ )
         {
@@ -575,20 +634,20 @@ protected:
   void WriteCellsBufferAsBINARY(std::ofstream & outputFile, T *buffer)
   {
     MetaDataDictionary & metaDic = this->GetMetaDataDictionary();
-    unsigned int         numberOfVertices = 0;
-    unsigned int         numberOfVertexIndices = 0;
-    unsigned int         numberOfLines = 0;
-    unsigned int         numberOfLineIndices = 0;
-    unsigned int         numberOfPolygons = 0;
-    unsigned int         numberOfPolygonIndices = 0;
+    SizeValueType        numberOfVertices = 0;
+    SizeValueType        numberOfVertexIndices = 0;
+    SizeValueType        numberOfLines = 0;
+    SizeValueType        numberOfLineIndices = 0;
+    SizeValueType        numberOfPolygons = 0;
+    SizeValueType        numberOfPolygonIndices = 0;
 
     /** Write vertices */
     unsigned long index = 0;
 
-    ExposeMetaData< unsigned int >(metaDic, "numberOfVertices", numberOfVertices);
+    ExposeMetaData< SizeValueType >(metaDic, "numberOfVertices", numberOfVertices);
     if ( numberOfVertices )
       {
-      ExposeMetaData< unsigned int >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfVertexIndices", numberOfVertexIndices);
       outputFile << "VERTICES " << numberOfVertices << " " << numberOfVertexIndices << '\n';
       unsigned int *data  = new unsigned int[numberOfVertexIndices];
       ReadCellsBuffer(buffer, data);
@@ -599,7 +658,7 @@ protected:
 
     /** Write lines */
     index = 0;
-    ExposeMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
+    ExposeMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
     if ( numberOfLines )
       {
       numberOfLineIndices = 0;
@@ -652,8 +711,8 @@ protected:
 
       numberOfLines = polylines->Size();
       numberOfLineIndices += numberOfLines;
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfLines", numberOfLines);
-      EncapsulateMetaData< unsigned int >(metaDic, "numberOfLineIndices", numberOfLineIndices);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLines", numberOfLines);
+      EncapsulateMetaData< SizeValueType >(metaDic, "numberOfLineIndices", numberOfLineIndices);
 
       outputFile << "LINES " << numberOfLines << " " << numberOfLineIndices << '\n';
       unsigned int *data  = new unsigned int[numberOfLineIndices];
@@ -675,10 +734,10 @@ protected:
 
     /** Write polygons */
     index = 0;
-    ExposeMetaData< unsigned int >(metaDic, "numberOfPolygons", numberOfPolygons);
+    ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygons", numberOfPolygons);
     if ( numberOfPolygons )
       {
-      ExposeMetaData< unsigned int >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
+      ExposeMetaData< SizeValueType >(metaDic, "numberOfPolygonIndices", numberOfPolygonIndices);
       outputFile << "POLYGONS " << numberOfPolygons << " " << numberOfPolygonIndices << '\n';
       unsigned int *data  = new unsigned int[numberOfPolygonIndices];
       ReadCellsBuffer(buffer, data);
@@ -688,6 +747,69 @@ protected:
       }
   }
 
+  /** Write the cells in the version 5 layout. Unlike the legacy layout, the
+   * lines are written as they are, without being joined into polylines. */
+  template< typename T >
+  void WriteCellsBufferAsOffsets(std::ofstream & outputFile, T *buffer)
+  {
+    this->UpdateCellInformation(buffer);
+
+    const char *sectionNames[3] = { "VERTICES", "LINES", "POLYGONS" };
+    const CellGeometryType sectionTypes[3] = { VERTEX_CELL, LINE_CELL, POLYGON_CELL };
+    for ( int section = 0; section < 3; section++ )
+      {
+      SizeValueType numberOfCells = 0;
+      SizeValueType numberOfIndices = 0;
+      this->GetCellSectionSize(sectionTypes[section], numberOfCells, numberOfIndices);
+      if ( !numberOfCells )
+        {
+        continue;
+        }
+
+      const SizeValueType                connectivitySize = numberOfIndices - numberOfCells;
+      MeshIOScratchBuffer< long long > offsets(numberOfCells + 1);
+      MeshIOScratchBuffer< long long > connectivity(connectivitySize);
+      long long *                      offsetsBuffer = offsets.GetBuffer();
+      long long *                      connectivityBuffer = connectivity.GetBuffer();
+
+      SizeValueType index = 0;
+      SizeValueType cellId = 0;
+      SizeValueType pointId = 0;
+      offsetsBuffer[0] = 0;
+      for ( SizeValueType ii = 0; ii < this->m_NumberOfCells; ii++ )
+        {
+        MeshIOBase::CellGeometryType cellType = static_cast< MeshIOBase::CellGeometryType >( static_cast< int >( buffer[index++] ) );
+        SizeValueType                nn = static_cast< SizeValueType >( buffer[index++] );
+        if ( GetCellSectionIndex(cellType) == section )
+          {
+          for ( SizeValueType jj = 0; jj < nn; jj++ )
+            {
+            connectivityBuffer[pointId++] = static_cast< long long >( buffer[index + jj] );
+            }
+          offsetsBuffer[++cellId] = static_cast< long long >( pointId );
+          }
+        index += nn;
+        }
+
+      outputFile << sectionNames[section] << " " << numberOfCells + 1 << " " << connectivitySize << '\n';
+      this->WriteCellArray(outputFile, "OFFSETS", offsetsBuffer, numberOfCells + 1);
+      this->WriteCellArray(outputFile, "CONNECTIVITY", connectivityBuffer, connectivitySize);
+      }
+  }
+
+  struct WriteCellsBufferAsOffsetsVisitor
+    {
+    Self *          MeshIO;
+    std::ofstream * OutputFile;
+    void *          Buffer;
+
+    template< typename T >
+    void Visit()
+    {
+      MeshIO->WriteCellsBufferAsOffsets( *OutputFile, static_cast< T * >( Buffer ) );
+    }
+    };
+
   template< typename T >
   void WritePointDataBufferAsASCII(std::ofstream & outputFile, T *buffer, const StringType & pointPixelComponentName)
   {
@@ -1142,6 +1264,26 @@ protected:
       }
   }
 
+  /** Input file, kept open between ReadMeshInformation() and the last
+   * Read*() call */
+  std::ifstream m_InputFile;
+
+  /** Offsets of the first value of each section, -1 when absent */
+  StreamOffsetType m_PointsPosition;
+  StreamOffsetType m_VerticesPosition;
+  StreamOffsetType m_LinesPosition;
+  StreamOffsetType m_PolygonsPosition;
+  StreamOffsetType m_PointDataPosition;
+  StreamOffsetType m_CellDataPosition;
+
+  /** Offsets of the CONNECTIVITY values of the version 5 layout, -1 when
+   * absent */
+  StreamOffsetType m_VerticesConnectivityPosition;
+  StreamOffsetType m_LinesConnectivityPosition;
+  StreamOffsetType m_PolygonsConnectivityPosition;
+
+  bool m_UseOffsetsCellLayout;
+
 private:
   VTKPolyDataMeshIO(const Self &); // purposely not implemented
   void operator=(const Self &);    // purposely not implemented
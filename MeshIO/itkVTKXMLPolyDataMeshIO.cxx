@@ -0,0 +1,1015 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkVTKXMLPolyDataMeshIO.h"
+
+#include "itk_zlib.h"
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace itk
+{
+namespace
+{
+// Size of the uncompressed zlib blocks written, the VTK default
+const VTKXMLPolyDataMeshIO::SizeValueType DefaultBlockSize = 32768;
+
+// Size of the chunks read while looking for the appended data
+const std::streamsize HeaderChunkSize = 65536;
+}
+
+VTKXMLPolyDataMeshIO::VTKXMLPolyDataMeshIO():
+  m_AppendedDataPosition(-1),
+  m_HeaderSize(8),
+  m_Compressed(false),
+  m_BlockSize(DefaultBlockSize)
+{
+  this->AddSupportedWriteExtension(".vtp");
+  this->m_FileType = BINARY;
+  this->m_ByteOrder = ByteSwapper< int >::SystemIsBigEndian() ? BigEndian : LittleEndian;
+
+  for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+    {
+    m_NumberOfSectionCells[section] = 0;
+    m_NumberOfSectionIndices[section] = 0;
+    }
+}
+
+bool VTKXMLPolyDataMeshIO::CanReadFile(const char *fileName)
+{
+  if ( !itksys::SystemTools::FileExists(fileName, true) )
+    {
+    return false;
+    }
+
+  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) != ".vtp" )
+    {
+    return false;
+    }
+
+  // The root element must be a PolyData VTKFile
+  std::ifstream inputFile(fileName, std::ios::in | std::ios::binary);
+  if ( !inputFile.is_open() )
+    {
+    return false;
+    }
+
+  char                  chunk[1024];
+  inputFile.read( chunk, sizeof( chunk ) );
+  const StringType      header( chunk, static_cast< size_t >( inputFile.gcount() ) );
+  StringType::size_type position = header.find("<VTKFile");
+  if ( position == StringType::npos )
+    {
+    return false;
+    }
+
+  return header.find("PolyData", position) != StringType::npos;
+}
+
+bool VTKXMLPolyDataMeshIO::CanWriteFile(const char *fileName)
+{
+  if ( itksys::SystemTools::GetFilenameLastExtension(fileName) != ".vtp" )
+    {
+    return false;
+    }
+
+  return true;
+}
+
+void VTKXMLPolyDataMeshIO::OpenFile()
+{
+  if ( m_InputFile.is_open() )
+    {
+    return;
+    }
+
+  m_InputFile.clear();
+  m_InputFile.open(this->m_FileName.c_str(), std::ios::in | std::ios::binary);
+  if ( !m_InputFile.is_open() )
+    {
+    itkExceptionMacro("Unable to open file\n" "inputFilename= " << this->m_FileName);
+    }
+}
+
+void VTKXMLPolyDataMeshIO::CloseFile()
+{
+  if ( m_InputFile.is_open() )
+    {
+    m_InputFile.close();
+    }
+}
+
+const char * VTKXMLPolyDataMeshIO::GetVTKTypeName(IOComponentType componentType)
+{
+  switch ( componentType )
+    {
+    case UCHAR:
+      return "UInt8";
+    case CHAR:
+      return "Int8";
+    case USHORT:
+      return "UInt16";
+    case SHORT:
+      return "Int16";
+    case UINT:
+      return "UInt32";
+    case INT:
+      return "Int32";
+    case ULONG:
+      return sizeof( unsigned long ) == 8 ? "UInt64" : "UInt32";
+    case LONG:
+      return sizeof( long ) == 8 ? "Int64" : "Int32";
+    case ULONGLONG:
+      return "UInt64";
+    case LONGLONG:
+      return "Int64";
+    case FLOAT:
+      return "Float32";
+    case DOUBLE:
+      return "Float64";
+    default:
+      return 0;
+    }
+}
+
+MeshIOBase::IOComponentType VTKXMLPolyDataMeshIO::GetComponentTypeFromVTKTypeName(const StringType & name)
+{
+  if ( name == "UInt8" )
+    {
+    return UCHAR;
+    }
+  else if ( name == "Int8" )
+    {
+    return CHAR;
+    }
+  else if ( name == "UInt16" )
+    {
+    return USHORT;
+    }
+  else if ( name == "Int16" )
+    {
+    return SHORT;
+    }
+  else if ( name == "UInt32" )
+    {
+    return UINT;
+    }
+  else if ( name == "Int32" )
+    {
+    return INT;
+    }
+  else if ( name == "UInt64" )
+    {
+    return ULONGLONG;
+    }
+  else if ( name == "Int64" )
+    {
+    return LONGLONG;
+    }
+  else if ( name == "Float32" )
+    {
+    return FLOAT;
+    }
+  else if ( name == "Float64" )
+    {
+    return DOUBLE;
+    }
+
+  return UNKNOWNCOMPONENTTYPE;
+}
+
+int VTKXMLPolyDataMeshIO::GetSection(CellGeometryType cellType)
+{
+  switch ( cellType )
+    {
+    case VERTEX_CELL:
+      return VERTS;
+    case LINE_CELL:
+      return LINES;
+    case TRIANGLE_CELL:
+    case QUADRILATERAL_CELL:
+    case POLYGON_CELL:
+      return POLYS;
+    default:
+      return -1;
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ReadMeshInformation()
+{
+  this->CloseFile();
+  this->OpenFile();
+
+  this->m_NumberOfPoints = 0;
+  this->m_UpdatePoints = false;
+  this->m_UpdateCells = false;
+  this->m_UpdatePointData = false;
+  this->m_UpdateCellData = false;
+
+  m_AppendedDataPosition = -1;
+  m_HeaderSize = 4;
+  m_Compressed = false;
+  m_Points = DataArrayType();
+  m_PointData = DataArrayType();
+  m_CellData = DataArrayType();
+  for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+    {
+    m_Connectivity[section] = DataArrayType();
+    m_Offsets[section] = DataArrayType();
+    m_NumberOfSectionCells[section] = 0;
+    m_NumberOfSectionIndices[section] = 0;
+    }
+
+  // Read the XML header, up to the '_' that marks the beginning of the
+  // appended data
+  StringType            header;
+  StringType::size_type appended = StringType::npos;
+  StringType::size_type underscore = StringType::npos;
+  while ( underscore == StringType::npos && m_InputFile )
+    {
+    char chunk[HeaderChunkSize];
+    m_InputFile.read(chunk, HeaderChunkSize);
+
+    // The tag may straddle two chunks
+    const StringType::size_type from = header.size() > 16 ? header.size() - 16 : 0;
+    header.append( chunk, static_cast< size_t >( m_InputFile.gcount() ) );
+    if ( appended == StringType::npos )
+      {
+      appended = header.find("<AppendedData", from);
+      }
+    if ( appended != StringType::npos )
+      {
+      underscore = header.find('_', appended);
+      }
+    }
+
+  if ( appended != StringType::npos )
+    {
+    if ( underscore == StringType::npos )
+      {
+      itkExceptionMacro(<< "No '_' marking the appended data in file " << this->m_FileName);
+      }
+    m_AppendedDataPosition = static_cast< StreamOffsetType >( underscore + 1 );
+    header.resize( header.find('>', appended) + 1 );
+    }
+
+  this->ParseHeader(header);
+
+  // Points
+  this->m_PointDimension = 3;
+  if ( this->m_NumberOfPoints )
+    {
+    if ( !m_Points.IsPresent() || m_Points.NumberOfComponents != 3 )
+      {
+      itkExceptionMacro(<< "Invalid Points array in file " << this->m_FileName);
+      }
+    this->m_PointComponentType = m_Points.ComponentType;
+    this->m_UpdatePoints = true;
+    }
+
+  // Cells, their buffer takes the type of the first connectivity array
+  this->m_NumberOfCells = 0;
+  this->m_CellBufferSize = 0;
+  for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+    {
+    if ( !m_NumberOfSectionCells[section] )
+      {
+      continue;
+      }
+
+    if ( !m_Connectivity[section].IsPresent() || !m_Offsets[section].IsPresent() )
+      {
+      itkExceptionMacro(<< "Missing connectivity or offsets array in file " << this->m_FileName);
+      }
+
+    m_NumberOfSectionIndices[section] = this->ReadNumberOfBytes(m_Connectivity[section])
+                                        / this->GetComponentSize(m_Connectivity[section].ComponentType);
+    if ( !this->m_UpdateCells )
+      {
+      this->m_CellComponentType = m_Connectivity[section].ComponentType;
+      }
+
+    this->m_NumberOfCells += m_NumberOfSectionCells[section];
+    this->m_CellBufferSize += 2 * m_NumberOfSectionCells[section] + m_NumberOfSectionIndices[section];
+    this->m_UpdateCells = true;
+    }
+
+  // Point and cell data
+  if ( m_PointData.IsPresent() && this->m_NumberOfPoints )
+    {
+    this->m_NumberOfPointPixels = this->m_NumberOfPoints;
+    this->m_NumberOfPointPixelComponents = m_PointData.NumberOfComponents;
+    this->m_PointPixelComponentType = m_PointData.ComponentType;
+    this->m_PointPixelType = m_PointData.NumberOfComponents == 1 ? SCALAR : VECTOR;
+    this->m_UpdatePointData = true;
+    }
+
+  if ( m_CellData.IsPresent() && this->m_NumberOfCells )
+    {
+    this->m_NumberOfCellPixels = this->m_NumberOfCells;
+    this->m_NumberOfCellPixelComponents = m_CellData.NumberOfComponents;
+    this->m_CellPixelComponentType = m_CellData.ComponentType;
+    this->m_CellPixelType = m_CellData.NumberOfComponents == 1 ? SCALAR : VECTOR;
+    this->m_UpdateCellData = true;
+    }
+
+  // The file stays open for the Read*() methods
+  if ( !this->m_UpdatePoints && !this->m_UpdateCells && !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ParseHeader(const StringType & header)
+{
+  // The header is scanned tag by tag, the section is the innermost element
+  // among Points, Verts, Lines, Polys, PointData and CellData
+  StringType            section;
+  StringType::size_type position = 0;
+
+  while ( ( position = header.find('<', position) ) != StringType::npos )
+    {
+    StringType::size_type end = header.find('>', position);
+    if ( end == StringType::npos )
+      {
+      itkExceptionMacro(<< "Unterminated XML tag in file " << this->m_FileName);
+      }
+
+    StringType tag = header.substr(position + 1, end - position - 1);
+    position = end + 1;
+
+    // Declarations, comments and closing tags
+    if ( tag.empty() || tag[0] == '?' || tag[0] == '!' )
+      {
+      continue;
+      }
+    if ( tag[0] == '/' )
+      {
+      if ( tag.substr(1) == section )
+        {
+        section.clear();
+        }
+      continue;
+      }
+
+    bool selfClosing = false;
+    if ( tag[tag.size() - 1] == '/' )
+      {
+      selfClosing = true;
+      tag.resize(tag.size() - 1);
+      }
+
+    // Element name, then name="value" attributes
+    StringType::size_type index = tag.find_first_of(" \t\r\n");
+    const StringType      name = tag.substr(0, index);
+    AttributesType        attributes;
+    while ( index != StringType::npos )
+      {
+      const StringType::size_type equal = tag.find('=', index);
+      if ( equal == StringType::npos )
+        {
+        break;
+        }
+      const StringType::size_type open = tag.find_first_of("\"'", equal);
+      if ( open == StringType::npos )
+        {
+        break;
+        }
+      const StringType::size_type close = tag.find(tag[open], open + 1);
+      if ( close == StringType::npos )
+        {
+        itkExceptionMacro(<< "Unterminated XML attribute in file " << this->m_FileName);
+        }
+
+      const StringType::size_type first = tag.find_first_not_of(" \t\r\n", index);
+      const StringType::size_type last = tag.find_last_not_of(" \t\r\n=", equal);
+      attributes[tag.substr(first, last - first + 1)] = tag.substr(open + 1, close - open - 1);
+      index = close + 1;
+      }
+
+    this->ParseTag(name, attributes, section);
+
+    if ( !selfClosing && ( name == "Points" || name == "Verts" || name == "Lines" || name == "Polys"
+                           || name == "Strips" || name == "PointData" || name == "CellData" ) )
+      {
+      section = name;
+      }
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ParseTag(const StringType & name, const AttributesType & attributes,
+                                     const StringType & section)
+{
+  AttributesType::const_iterator it;
+
+  if ( name == "VTKFile" )
+    {
+    it = attributes.find("type");
+    if ( it == attributes.end() || it->second != "PolyData" )
+      {
+      itkExceptionMacro(<< "File " << this->m_FileName << " is not a VTK PolyData file");
+      }
+
+    it = attributes.find("byte_order");
+    this->m_ByteOrder = ( it != attributes.end() && it->second == "BigEndian" ) ? BigEndian : LittleEndian;
+
+    it = attributes.find("header_type");
+    if ( it != attributes.end() && it->second == "UInt64" )
+      {
+      m_HeaderSize = 8;
+      }
+    else if ( it != attributes.end() && it->second != "UInt32" )
+      {
+      itkExceptionMacro(<< "Unsupported header_type " << it->second << " in file " << this->m_FileName);
+      }
+
+    it = attributes.find("compressor");
+    if ( it != attributes.end() && !it->second.empty() )
+      {
+      if ( it->second != "vtkZLibDataCompressor" )
+        {
+        itkExceptionMacro(<< "Unsupported compressor " << it->second << " in file " << this->m_FileName);
+        }
+      m_Compressed = true;
+      }
+    }
+  else if ( name == "Piece" )
+    {
+    if ( this->m_NumberOfPoints || m_Points.IsPresent() )
+      {
+      itkExceptionMacro(<< "Only one Piece is supported in file " << this->m_FileName);
+      }
+
+    const char *counts[] = { "NumberOfPoints", "NumberOfVerts", "NumberOfLines", "NumberOfPolys", "NumberOfStrips" };
+    SizeValueType values[5] = { 0, 0, 0, 0, 0 };
+    for ( unsigned int ii = 0; ii < 5; ii++ )
+      {
+      it = attributes.find(counts[ii]);
+      if ( it != attributes.end() )
+        {
+        values[ii] = static_cast< SizeValueType >( std::strtoul(it->second.c_str(), 0, 10) );
+        }
+      }
+
+    if ( values[4] )
+      {
+      itkExceptionMacro(<< "Triangle strips are not supported in file " << this->m_FileName);
+      }
+
+    this->m_NumberOfPoints = values[0];
+    m_NumberOfSectionCells[VERTS] = values[1];
+    m_NumberOfSectionCells[LINES] = values[2];
+    m_NumberOfSectionCells[POLYS] = values[3];
+    }
+  else if ( name == "AppendedData" )
+    {
+    it = attributes.find("encoding");
+    if ( it == attributes.end() || it->second != "raw" )
+      {
+      itkExceptionMacro(<< "Only the raw encoding of the appended data is supported in file " << this->m_FileName);
+      }
+    }
+  else if ( name == "DataArray" )
+    {
+    DataArrayType array;
+
+    it = attributes.find("Name");
+    if ( it != attributes.end() )
+      {
+      array.Name = it->second;
+      }
+
+    it = attributes.find("format");
+    if ( it == attributes.end() || it->second != "appended" )
+      {
+      itkExceptionMacro(<< "DataArray " << array.Name << " of file " << this->m_FileName
+                        << " is not in the appended format, which is the only one supported");
+      }
+
+    it = attributes.find("type");
+    array.ComponentType = GetComponentTypeFromVTKTypeName(it != attributes.end() ? it->second : StringType() );
+    if ( array.ComponentType == UNKNOWNCOMPONENTTYPE )
+      {
+      itkExceptionMacro(<< "Unsupported type of DataArray " << array.Name << " in file " << this->m_FileName);
+      }
+
+    it = attributes.find("NumberOfComponents");
+    if ( it != attributes.end() )
+      {
+      array.NumberOfComponents = static_cast< unsigned int >( std::strtoul(it->second.c_str(), 0, 10) );
+      }
+
+    it = attributes.find("offset");
+    array.Offset = static_cast< StreamOffsetType >( it != attributes.end() ? std::strtoul(it->second.c_str(), 0, 10) : 0 );
+
+    if ( section == "Points" && !m_Points.IsPresent() )
+      {
+      m_Points = array;
+      }
+    else if ( section == "PointData" && !m_PointData.IsPresent() )
+      {
+      m_PointData = array;
+      }
+    else if ( section == "CellData" && !m_CellData.IsPresent() )
+      {
+      m_CellData = array;
+      }
+    else if ( section == "Verts" || section == "Lines" || section == "Polys" )
+      {
+      const int cellSection = section == "Verts" ? VERTS : ( section == "Lines" ? LINES : POLYS );
+      if ( array.Name == "connectivity" )
+        {
+        m_Connectivity[cellSection] = array;
+        }
+      else if ( array.Name == "offsets" )
+        {
+        m_Offsets[cellSection] = array;
+        }
+      }
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ReadHeader(unsigned long long *values, SizeValueType numberOfHeaderValues)
+{
+  if ( m_HeaderSize == 8 )
+    {
+    ReadBufferAsBinary(values, m_InputFile, numberOfHeaderValues);
+    }
+  else
+    {
+    MeshIOScratchBuffer< unsigned int > header(numberOfHeaderValues);
+    ReadBufferAsBinary(header.GetBuffer(), m_InputFile, numberOfHeaderValues);
+    ConvertBuffer(header.GetBuffer(), values, numberOfHeaderValues);
+    }
+
+  if ( m_InputFile.fail() )
+    {
+    itkExceptionMacro(<< "Unexpected end of file while reading an array header of file " << this->m_FileName);
+    }
+}
+
+VTKXMLPolyDataMeshIO::SizeValueType VTKXMLPolyDataMeshIO::ReadNumberOfBytes(const DataArrayType & array)
+{
+  if ( m_AppendedDataPosition < 0 )
+    {
+    itkExceptionMacro(<< "No appended data in file " << this->m_FileName);
+    }
+
+  m_InputFile.clear();
+  m_InputFile.seekg(m_AppendedDataPosition + array.Offset, std::ios::beg);
+
+  if ( !m_Compressed )
+    {
+    unsigned long long numberOfBytes = 0;
+    this->ReadHeader(&numberOfBytes, 1);
+    return static_cast< SizeValueType >( numberOfBytes );
+    }
+
+  // Number of blocks, size of the blocks and size of the last block, which
+  // is 0 when the last block is full
+  unsigned long long blocks[3];
+  this->ReadHeader(blocks, 3);
+  if ( !blocks[0] )
+    {
+    return 0;
+    }
+
+  return static_cast< SizeValueType >( ( blocks[0] - 1 ) * blocks[1] + ( blocks[2] ? blocks[2] : blocks[1] ) );
+}
+
+void VTKXMLPolyDataMeshIO::ReadArray(const DataArrayType & array, void *buffer, SizeValueType numberOfValues)
+{
+  const SizeValueType numberOfBytes = numberOfValues * this->GetComponentSize(array.ComponentType);
+  this->OpenFile();
+  if ( this->ReadNumberOfBytes(array) != numberOfBytes )
+    {
+    itkExceptionMacro(<< "DataArray " << array.Name << " of file " << this->m_FileName
+                      << " does not hold " << numberOfValues << " values");
+    }
+
+  unsigned char *output = static_cast< unsigned char * >( buffer );
+  if ( !m_Compressed )
+    {
+    m_InputFile.read( reinterpret_cast< char * >( output ), numberOfBytes );
+    }
+  else
+    {
+    // Block sizes, then the compressed sizes of the blocks
+    m_InputFile.seekg(m_AppendedDataPosition + array.Offset, std::ios::beg);
+    unsigned long long blocks[3];
+    this->ReadHeader(blocks, 3);
+
+    const SizeValueType                       numberOfBlocks = static_cast< SizeValueType >( blocks[0] );
+    MeshIOScratchBuffer< unsigned long long > compressedSizes(numberOfBlocks);
+    this->ReadHeader(compressedSizes.GetBuffer(), numberOfBlocks);
+
+    SizeValueType compressedBytes = 0;
+    for ( SizeValueType ii = 0; ii < numberOfBlocks; ii++ )
+      {
+      compressedBytes += static_cast< SizeValueType >( compressedSizes.GetBuffer()[ii] );
+      }
+
+    MeshIOScratchBuffer< unsigned char > compressed(compressedBytes);
+    m_InputFile.read(reinterpret_cast< char * >( compressed.GetBuffer() ), compressedBytes);
+
+    // Each block inflates into its own range of the output
+    ZLibBlocksStruct str;
+    str.Compress = false;
+    str.CompressionLevel = 0;
+    const unsigned char *input = compressed.GetBuffer();
+    for ( SizeValueType ii = 0; ii < numberOfBlocks; ii++ )
+      {
+      const SizeValueType blockSize = static_cast< SizeValueType >( blocks[1] );
+      str.Inputs.push_back(input);
+      str.InputSizes.push_back( static_cast< SizeValueType >( compressedSizes.GetBuffer()[ii] ) );
+      str.Outputs.push_back(output + ii * blockSize);
+      str.OutputSizes.push_back( ( ii + 1 == numberOfBlocks && blocks[2] ) ? static_cast< SizeValueType >( blocks[2] ) : blockSize );
+      input += str.InputSizes.back();
+      }
+
+    if ( m_InputFile.fail() )
+      {
+      itkExceptionMacro(<< "Unexpected end of file while reading DataArray " << array.Name << " of file " << this->m_FileName);
+      }
+
+    this->ProcessZLibBlocks(str);
+    }
+
+  if ( m_InputFile.fail() )
+    {
+    itkExceptionMacro(<< "Unexpected end of file while reading DataArray " << array.Name << " of file " << this->m_FileName);
+    }
+
+  this->SwapFromFileByteOrder(array.ComponentType, buffer, numberOfValues);
+}
+
+void VTKXMLPolyDataMeshIO::SwapFromFileByteOrder(IOComponentType componentType, void *buffer, SizeValueType numberOfValues) const
+{
+  SwapVisitor visitor(buffer, numberOfValues, this->m_ByteOrder == BigEndian);
+
+  this->VisitComponentType(componentType, visitor);
+}
+
+ITK_THREAD_RETURN_TYPE VTKXMLPolyDataMeshIO::ZLibBlocksThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ZLibBlocksStruct *               str = static_cast< ZLibBlocksStruct * >( info->UserData );
+
+  // Split the blocks evenly among the threads
+  const size_t numberOfBlocks = str->Inputs.size();
+  const size_t firstBlock = numberOfBlocks * info->ThreadID / info->NumberOfThreads;
+  const size_t lastBlock = numberOfBlocks * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  for ( size_t ii = firstBlock; ii < lastBlock; ii++ )
+    {
+    uLongf outputSize = static_cast< uLongf >( str->OutputSizes[ii] );
+    if ( str->Compress )
+      {
+      str->Status[ii] = compress2(str->Outputs[ii], &outputSize, str->Inputs[ii],
+                                  static_cast< uLong >( str->InputSizes[ii] ), str->CompressionLevel);
+      }
+    else
+      {
+      str->Status[ii] = uncompress(str->Outputs[ii], &outputSize, str->Inputs[ii],
+                                   static_cast< uLong >( str->InputSizes[ii] ) );
+      if ( str->Status[ii] == Z_OK && outputSize != str->OutputSizes[ii] )
+        {
+        str->Status[ii] = Z_DATA_ERROR;
+        }
+      }
+    str->OutputSizes[ii] = static_cast< SizeValueType >( outputSize );
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void VTKXMLPolyDataMeshIO::ProcessZLibBlocks(ZLibBlocksStruct & str)
+{
+  const size_t numberOfBlocks = str.Inputs.size();
+  str.Status.assign(numberOfBlocks, Z_OK);
+  if ( !numberOfBlocks )
+    {
+    return;
+    }
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  const int              numberOfThreads = static_cast< int >( std::min(
+                                                                 static_cast< size_t >( std::max(this->m_NumberOfThreads, 1) ),
+                                                                 numberOfBlocks) );
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(&Self::ZLibBlocksThreaderCallback, &str);
+  threader->SingleMethodExecute();
+
+  for ( size_t ii = 0; ii < numberOfBlocks; ii++ )
+    {
+    if ( str.Status[ii] != Z_OK )
+      {
+      itkExceptionMacro(<< "zlib error " << str.Status[ii] << " while " << ( str.Compress ? "deflating" : "inflating" )
+                        << " block " << ii << " of file " << this->m_FileName);
+      }
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ReadPoints(void *buffer)
+{
+  this->ReadArray(m_Points, buffer, this->m_NumberOfPoints * 3);
+
+  // Close the file once the last section to update has been read
+  if ( !this->m_UpdateCells && !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ReadCells(void *buffer)
+{
+  ReadCellsVisitor visitor(this, buffer);
+  this->VisitComponentType(this->m_CellComponentType, visitor);
+
+  if ( !this->m_UpdatePointData && !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ReadPointData(void *buffer)
+{
+  this->ReadArray(m_PointData, buffer, this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents);
+
+  if ( !this->m_UpdateCellData )
+    {
+    this->CloseFile();
+    }
+}
+
+void VTKXMLPolyDataMeshIO::ReadCellData(void *buffer)
+{
+  this->ReadArray(m_CellData, buffer, this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents);
+
+  this->CloseFile();
+}
+
+void VTKXMLPolyDataMeshIO::WriteMeshInformation()
+{
+  // Check file name
+  if ( this->m_FileName == "" )
+    {
+    itkExceptionMacro("No Input FileName");
+    }
+
+  // The arrays are encoded by the Write*() methods and written by Write()
+  m_Compressed = this->m_UseCompression;
+  m_HeaderSize = 8;
+  m_Points = DataArrayType();
+  m_PointData = DataArrayType();
+  m_CellData = DataArrayType();
+  m_CellDataOrder.clear();
+  for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+    {
+    m_Connectivity[section] = DataArrayType();
+    m_Offsets[section] = DataArrayType();
+    m_NumberOfSectionCells[section] = 0;
+    m_NumberOfSectionIndices[section] = 0;
+    }
+}
+
+void VTKXMLPolyDataMeshIO::EncodeArray(const void *buffer, SizeValueType numberOfBytes, DataArrayType & array)
+{
+  const unsigned char *input = static_cast< const unsigned char * >( buffer );
+
+  if ( !m_Compressed )
+    {
+    const unsigned long long header = numberOfBytes;
+    array.Data.resize( sizeof( header ) + numberOfBytes );
+    std::memcpy( &array.Data[0], &header, sizeof( header ) );
+    if ( numberOfBytes )
+      {
+      std::memcpy(&array.Data[sizeof( header )], input, numberOfBytes);
+      }
+    return;
+    }
+
+  // Deflate each block into a buffer large enough for its worst case
+  const SizeValueType numberOfBlocks = ( numberOfBytes + m_BlockSize - 1 ) / m_BlockSize;
+  const SizeValueType bound = static_cast< SizeValueType >( compressBound( static_cast< uLong >( m_BlockSize ) ) );
+
+  MeshIOScratchBuffer< unsigned char > compressed(numberOfBlocks * bound);
+  ZLibBlocksStruct                     str;
+  str.Compress = true;
+  str.CompressionLevel = this->m_CompressionLevel;
+  for ( SizeValueType ii = 0; ii < numberOfBlocks; ii++ )
+    {
+    str.Inputs.push_back(input + ii * m_BlockSize);
+    str.InputSizes.push_back( std::min(m_BlockSize, numberOfBytes - ii * m_BlockSize) );
+    str.Outputs.push_back(compressed.GetBuffer() + ii * bound);
+    str.OutputSizes.push_back(bound);
+    }
+  this->ProcessZLibBlocks(str);
+
+  // Header: number of blocks, block size, last block size, compressed sizes
+  std::vector< unsigned long long > header(3 + numberOfBlocks);
+  header[0] = numberOfBlocks;
+  header[1] = m_BlockSize;
+  header[2] = numberOfBlocks ? str.InputSizes.back() : 0;
+  SizeValueType compressedBytes = 0;
+  for ( SizeValueType ii = 0; ii < numberOfBlocks; ii++ )
+    {
+    header[3 + ii] = str.OutputSizes[ii];
+    compressedBytes += str.OutputSizes[ii];
+    }
+
+  const SizeValueType headerBytes = header.size() * sizeof( unsigned long long );
+  array.Data.resize(headerBytes + compressedBytes);
+  std::memcpy(&array.Data[0], &header[0], headerBytes);
+
+  unsigned char *output = &array.Data[0] + headerBytes;
+  for ( SizeValueType ii = 0; ii < numberOfBlocks; ii++ )
+    {
+    std::memcpy(output, str.Outputs[ii], str.OutputSizes[ii]);
+    output += str.OutputSizes[ii];
+    }
+}
+
+void VTKXMLPolyDataMeshIO::EncodeArray(IOComponentType componentType, const void *buffer, SizeValueType numberOfValues,
+                                       unsigned int numberOfComponents, const char *name, DataArrayType & array)
+{
+  array.Name = name;
+  array.NumberOfComponents = numberOfComponents;
+  array.ComponentType = componentType;
+
+  if ( componentType == LDOUBLE )
+    {
+    MeshIOScratchBuffer< double > data(numberOfValues);
+    EncodeLongDoubleVisitor       visitor(buffer, numberOfValues, data.GetBuffer());
+    this->VisitComponentType(componentType, visitor);
+
+    array.ComponentType = DOUBLE;
+    this->EncodeArray(data.GetBuffer(), numberOfValues * sizeof( double ), array);
+    return;
+    }
+
+  this->EncodeArray(buffer, numberOfValues * this->GetComponentSize(componentType), array);
+}
+
+void VTKXMLPolyDataMeshIO::WritePoints(void *buffer)
+{
+  if ( this->m_PointDimension > 3 )
+    {
+    itkExceptionMacro(<< "VTK PolyData points have at most three coordinates");
+    }
+
+  BufferVisitor< WritePointsCall > visitor(this, buffer);
+  this->VisitComponentType(this->m_PointComponentType, visitor);
+}
+
+void VTKXMLPolyDataMeshIO::WriteCells(void *buffer)
+{
+  BufferVisitor< WriteCellsCall > visitor(this, buffer);
+  this->VisitComponentType(this->m_CellComponentType, visitor);
+}
+
+void VTKXMLPolyDataMeshIO::WritePointData(void *buffer)
+{
+  this->EncodeArray(this->m_PointPixelComponentType, buffer,
+                    this->m_NumberOfPointPixels * this->m_NumberOfPointPixelComponents,
+                    this->m_NumberOfPointPixelComponents, "PointData", m_PointData);
+}
+
+void VTKXMLPolyDataMeshIO::WriteCellData(void *buffer)
+{
+  BufferVisitor< WriteCellDataCall > visitor(this, buffer);
+  this->VisitComponentType(this->m_CellPixelComponentType, visitor);
+}
+
+void VTKXMLPolyDataMeshIO::WriteDataArrayTag(std::ostream & os, const DataArrayType & array, StreamOffsetType offset) const
+{
+  os << "        <DataArray type=\"" << GetVTKTypeName(array.ComponentType) << "\" Name=\"" << array.Name
+     << "\" NumberOfComponents=\"" << array.NumberOfComponents << "\" format=\"appended\" offset=\""
+     << offset << "\"/>\n";
+}
+
+void VTKXMLPolyDataMeshIO::Write()
+{
+  std::ofstream outputFile(this->m_FileName.c_str(), std::ios::out | std::ios::binary);
+  if ( !outputFile.is_open() )
+    {
+    itkExceptionMacro("Unable to open file\n" "outputFilename= " << this->m_FileName);
+    }
+
+  // Arrays in the order in which they are appended
+  std::vector< const DataArrayType * > arrays;
+  arrays.push_back(&m_PointData);
+  arrays.push_back(&m_CellData);
+  arrays.push_back(&m_Points);
+  for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+    {
+    arrays.push_back(&m_Connectivity[section]);
+    arrays.push_back(&m_Offsets[section]);
+    }
+
+  std::map< const DataArrayType *, StreamOffsetType > offsets;
+  StreamOffsetType                                    offset = 0;
+  for ( size_t ii = 0; ii < arrays.size(); ii++ )
+    {
+    offsets[arrays[ii]] = offset;
+    offset += static_cast< StreamOffsetType >( arrays[ii]->Data.size() );
+    }
+
+  const char *byteOrder = ByteSwapper< int >::SystemIsBigEndian() ? "BigEndian" : "LittleEndian";
+  outputFile << "<?xml version=\"1.0\"?>\n";
+  outputFile << "<VTKFile type=\"PolyData\" version=\"1.0\" byte_order=\"" << byteOrder << "\" header_type=\"UInt64\"";
+  if ( m_Compressed )
+    {
+    outputFile << " compressor=\"vtkZLibDataCompressor\"";
+    }
+  outputFile << ">\n";
+  outputFile << "  <PolyData>\n";
+  outputFile << "    <Piece NumberOfPoints=\"" << ( m_Points.Data.empty() ? 0 : this->m_NumberOfPoints )
+             << "\" NumberOfVerts=\"" << m_NumberOfSectionCells[VERTS]
+             << "\" NumberOfLines=\"" << m_NumberOfSectionCells[LINES]
+             << "\" NumberOfStrips=\"0\" NumberOfPolys=\"" << m_NumberOfSectionCells[POLYS] << "\">\n";
+
+  const char *dataNames[] = { "PointData", "CellData" };
+  const DataArrayType *data[] = { &m_PointData, &m_CellData };
+  for ( unsigned int ii = 0; ii < 2; ii++ )
+    {
+    outputFile << "      <" << dataNames[ii];
+    if ( !data[ii]->Data.empty() )
+      {
+      outputFile << ( data[ii]->NumberOfComponents == 1 ? " Scalars=\"" : " Vectors=\"" ) << data[ii]->Name << "\">\n";
+      this->WriteDataArrayTag(outputFile, *data[ii], offsets[data[ii]]);
+      outputFile << "      </" << dataNames[ii] << ">\n";
+      }
+    else
+      {
+      outputFile << "/>\n";
+      }
+    }
+
+  if ( !m_Points.Data.empty() )
+    {
+    outputFile << "      <Points>\n";
+    this->WriteDataArrayTag(outputFile, m_Points, offsets[&m_Points]);
+    outputFile << "      </Points>\n";
+    }
+
+  const char *sectionNames[] = { "Verts", "Lines", "Polys" };
+  for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+    {
+    if ( m_NumberOfSectionCells[section] )
+      {
+      outputFile << "      <" << sectionNames[section] << ">\n";
+      this->WriteDataArrayTag(outputFile, m_Connectivity[section], offsets[&m_Connectivity[section]]);
+      this->WriteDataArrayTag(outputFile, m_Offsets[section], offsets[&m_Offsets[section]]);
+      outputFile << "      </" << sectionNames[section] << ">\n";
+      }
+    }
+
+  outputFile << "    </Piece>\n";
+  outputFile << "  </PolyData>\n";
+  outputFile << "  <AppendedData encoding=\"raw\">\n   _";
+  for ( size_t ii = 0; ii < arrays.size(); ii++ )
+    {
+    if ( !arrays[ii]->Data.empty() )
+      {
+      outputFile.write(reinterpret_cast< const char * >( &arrays[ii]->Data[0] ), arrays[ii]->Data.size() );
+      }
+    }
+  outputFile << "\n  </AppendedData>\n";
+  outputFile << "</VTKFile>\n";
+
+  outputFile.close();
+}
+
+void VTKXMLPolyDataMeshIO::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Appended data position : " << m_AppendedDataPosition << std::endl;
+  os << indent << "Header size : " << m_HeaderSize << std::endl;
+  os << indent << "Compressed : " << ( m_Compressed ? "On" : "Off" ) << std::endl;
+  os << indent << "Number of verts : " << m_NumberOfSectionCells[VERTS] << std::endl;
+  os << indent << "Number of lines : " << m_NumberOfSectionCells[LINES] << std::endl;
+  os << indent << "Number of polys : " << m_NumberOfSectionCells[POLYS] << std::endl;
+}
+} // end namespace itk
@@ -0,0 +1,575 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkVTKXMLPolyDataMeshIO_h
+#define __itkVTKXMLPolyDataMeshIO_h
+
+#ifdef _MSC_VER
+#pragma warning ( disable : 4786 )
+#endif
+
+#include "itkByteSwapper.h"
+#include "itkMeshIOBase.h"
+#include "itkMultiThreader.h"
+
+#include <fstream>
+#include <map>
+#include <vector>
+
+namespace itk
+{
+/** \class VTKXMLPolyDataMeshIO
+ * \brief
+ * Reads and writes VTK XML PolyData (.vtp) files.
+ *
+ * The arrays are stored in the appended data section with the raw
+ * encoding, either uncompressed or split in zlib blocks
+ * (compressor="vtkZLibDataCompressor"). Both header types, UInt32 and
+ * UInt64, and both byte orders are read; files are written in the byte
+ * order of the system with UInt64 headers, compressed when UseCompression
+ * is on. The zlib blocks of an array are inflated, or deflated, by several
+ * threads.
+ *
+ * Only one Piece is supported, without triangle strips, and only the first
+ * array of PointData and of CellData is read. Verts, Lines and Polys are
+ * read as VERTEX_CELL, LINE_CELL and POLYGON_CELL. The connectivity of each
+ * section is decoded straight into the cells buffer, which takes the type
+ * of the connectivity array.
+ *
+ * \ingroup IOFilters
+ */
+class ITK_EXPORT VTKXMLPolyDataMeshIO:public MeshIOBase
+{
+public:
+  /** Standard class typedefs. */
+  typedef VTKXMLPolyDataMeshIO         Self;
+  typedef MeshIOBase                   Superclass;
+  typedef SmartPointer< const Self >   ConstPointer;
+  typedef SmartPointer< Self >         Pointer;
+  typedef Superclass::StreamOffsetType StreamOffsetType;
+  typedef Superclass::SizeValueType    SizeValueType;
+
+  typedef std::string                           StringType;
+  typedef std::map< StringType, StringType >    AttributesType;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(VTKXMLPolyDataMeshIO, MeshIOBase);
+
+  /*-------- This part of the interfaces deals with reading data. ----- */
+
+  /** Determine if the file can be read with this MeshIO implementation.
+  * \param FileNameToRead The name of the file to test for reading.
+  * \post Sets classes MeshIOBase::m_FileName variable to be FileNameToWrite
+  * \return Returns true if this MeshIO can read the file specified.
+  */
+  virtual bool CanReadFile(const char *FileNameToRead);
+
+  /** Set the spacing and dimension information for the set filename. */
+  virtual void ReadMeshInformation();
+
+  /** Reads the data from disk into the memory buffer provided. */
+  virtual void ReadPoints(void *buffer);
+
+  virtual void ReadCells(void *buffer);
+
+  virtual void ReadPointData(void *buffer);
+
+  virtual void ReadCellData(void *buffer);
+
+  /*-------- This part of the interfaces deals with writing data. ----- */
+
+  /** Determine if the file can be written with this MeshIO implementation.
+   * \param FileNameToWrite The name of the file to test for writing.
+   * \post Sets classes MeshIOBase::m_FileName variable to be FileNameToWrite
+   * \return Returns true if this MeshIO can write the file specified.
+   */
+  virtual bool CanWriteFile(const char *FileNameToWrite);
+
+  /** Set the spacing and dimension information for the set filename. */
+  virtual void WriteMeshInformation();
+
+  /** Encode the data from the memory buffer provided. The file itself is
+   * written by Write(), once the offsets of all the arrays are known. */
+  virtual void WritePoints(void *buffer);
+
+  virtual void WriteCells(void *buffer);
+
+  virtual void WritePointData(void *buffer);
+
+  virtual void WriteCellData(void *buffer);
+
+  virtual void Write();
+
+protected:
+  VTKXMLPolyDataMeshIO();
+  virtual ~VTKXMLPolyDataMeshIO(){}
+
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+  /** A DataArray of the file. When reading, Offset is the position of the
+   * array in the appended data; when writing, Data holds the encoded array,
+   * header included. */
+  struct DataArrayType
+    {
+    DataArrayType():
+      ComponentType(UNKNOWNCOMPONENTTYPE), NumberOfComponents(1), Offset(-1)
+    {}
+
+    bool IsPresent() const
+    {
+      return Offset >= 0;
+    }
+
+    StringType                   Name;
+    IOComponentType              ComponentType;
+    unsigned int                 NumberOfComponents;
+    StreamOffsetType             Offset;
+    std::vector< unsigned char > Data;
+    };
+
+  /** The three kinds of cells of a PolyData, in file order. */
+  enum { VERTS = 0, LINES, POLYS, NUMBER_OF_SECTIONS };
+
+  void OpenFile();
+
+  void CloseFile();
+
+  /** Parse the XML header, i.e. everything before the appended data. */
+  void ParseHeader(const StringType & header);
+
+  /** Handle one opening tag of the XML header. */
+  void ParseTag(const StringType & name, const AttributesType & attributes, const StringType & section);
+
+  /** Name of the VTK type of a component type, e.g. "Float32" for FLOAT, and
+   * the other way round. */
+  static const char * GetVTKTypeName(IOComponentType componentType);
+
+  static IOComponentType GetComponentTypeFromVTKTypeName(const StringType & name);
+
+  /** Read the number of bytes of an array from its header. */
+  SizeValueType ReadNumberOfBytes(const DataArrayType & array);
+
+  /** Read numberOfHeaderValues header integers at the current position. */
+  void ReadHeader(unsigned long long *values, SizeValueType numberOfHeaderValues);
+
+  /** Read the values of an array into a buffer of its own component type,
+   * inflating the zlib blocks and swapping the bytes as needed. */
+  void ReadArray(const DataArrayType & array, void *buffer, SizeValueType numberOfValues);
+
+  /** Read the values of an array into a buffer of type T, through a
+   * temporary buffer when the array is of another type. */
+  template< typename T >
+  void ReadArrayAs(const DataArrayType & array, T *buffer, SizeValueType numberOfValues)
+  {
+    if ( array.ComponentType == MapComponentType< T >::CType )
+      {
+      this->ReadArray(array, buffer, numberOfValues);
+      }
+    else
+      {
+      ReadArrayAsVisitor< T > visitor(this, array, buffer, numberOfValues);
+      this->VisitComponentType(array.ComponentType, visitor);
+      }
+  }
+
+  template< typename TOutput >
+  class ReadArrayAsVisitor
+  {
+public:
+    ReadArrayAsVisitor(Self *meshIO, const DataArrayType & array, TOutput *output, SizeValueType numberOfValues):
+      m_MeshIO(meshIO), m_Array(array), m_Output(output), m_NumberOfValues(numberOfValues)
+    {}
+
+    template< typename TInput >
+    void Visit()
+    {
+      MeshIOScratchBuffer< TInput > input(m_NumberOfValues);
+      m_MeshIO->ReadArray( m_Array, input.GetBuffer(), m_NumberOfValues );
+      ConvertBuffer(input.GetBuffer(), m_Output, m_NumberOfValues);
+    }
+
+private:
+    Self *                m_MeshIO;
+    const DataArrayType & m_Array;
+    TOutput *             m_Output;
+    SizeValueType         m_NumberOfValues;
+  };
+
+  /** Swap numberOfValues values of the given component type from the byte
+   * order of the file to the byte order of the system. */
+  void SwapFromFileByteOrder(IOComponentType componentType, void *buffer, SizeValueType numberOfValues) const;
+
+  class SwapVisitor
+  {
+public:
+    SwapVisitor(void *buffer, SizeValueType numberOfValues, bool bigEndian):
+      m_Buffer(buffer), m_NumberOfValues(numberOfValues), m_BigEndian(bigEndian)
+    {}
+
+    template< typename T >
+    void Visit()
+    {
+      if ( m_BigEndian )
+        {
+        ByteSwapper< T >::SwapRangeFromSystemToBigEndian(static_cast< T * >( m_Buffer ), m_NumberOfValues);
+        }
+      else
+        {
+        ByteSwapper< T >::SwapRangeFromSystemToLittleEndian(static_cast< T * >( m_Buffer ), m_NumberOfValues);
+        }
+    }
+
+private:
+    void *        m_Buffer;
+    SizeValueType m_NumberOfValues;
+    bool          m_BigEndian;
+  };
+
+  /** Read the cells of every section into the cells buffer. The
+   * connectivity of a section is read into the tail of its range of the
+   * buffer, then expanded in place to insert the cell type and the number
+   * of points of each cell. */
+  template< typename T >
+  void ReadCellsBuffer(T *buffer)
+  {
+    static const CellGeometryType cellTypes[NUMBER_OF_SECTIONS] = { VERTEX_CELL, LINE_CELL, POLYGON_CELL };
+
+    T *output = buffer;
+    for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+      {
+      const SizeValueType numberOfCells = m_NumberOfSectionCells[section];
+      if ( !numberOfCells )
+        {
+        continue;
+        }
+
+      const SizeValueType numberOfIndices = m_NumberOfSectionIndices[section];
+      MeshIOScratchBuffer< SizeValueType > offsets(numberOfCells);
+      this->ReadArrayAs(m_Offsets[section], offsets.GetBuffer(), numberOfCells);
+
+      // Before cell ii is written, the connectivity is still
+      // 2 * (numberOfCells - ii) values ahead of the output
+      const T *input = output + 2 * numberOfCells;
+      this->ReadArrayAs(m_Connectivity[section], output + 2 * numberOfCells, numberOfIndices);
+
+      SizeValueType inputIndex = 0;
+      SizeValueType outputIndex = 0;
+      for ( SizeValueType ii = 0; ii < numberOfCells; ii++ )
+        {
+        const SizeValueType end = offsets.GetBuffer()[ii];
+        if ( end < inputIndex || end > numberOfIndices )
+          {
+          itkExceptionMacro(<< "Invalid cell offsets in file " << this->m_FileName);
+          }
+
+        output[outputIndex++] = static_cast< T >( cellTypes[section] );
+        output[outputIndex++] = static_cast< T >( end - inputIndex );
+        while ( inputIndex < end )
+          {
+          output[outputIndex++] = input[inputIndex++];
+          }
+        }
+
+      // Connectivity left over after the last offset would otherwise be
+      // read as cells of the next section
+      if ( inputIndex != numberOfIndices )
+        {
+        itkExceptionMacro(<< "Invalid cell offsets in file " << this->m_FileName);
+        }
+
+      output +=numberOfIndices + 2 * numberOfCells;
+      }
+  }
+
+  class ReadCellsVisitor
+  {
+public:
+    ReadCellsVisitor(Self *meshIO, void *buffer):
+      m_MeshIO(meshIO), m_Buffer(buffer)
+    {}
+
+    template< typename T >
+    void Visit()
+    {
+      m_MeshIO->ReadCellsBuffer( static_cast< T * >( m_Buffer ) );
+    }
+
+private:
+    Self *m_MeshIO;
+    void *m_Buffer;
+  };
+
+  /** Encode numberOfValues values into array.Data: a header followed by the
+   * raw values, or by the zlib blocks when UseCompression is on. */
+  void EncodeArray(const void *buffer, SizeValueType numberOfBytes, DataArrayType & array);
+
+  /** Encode an array of values of the given component type. Long doubles
+   * have no VTK type and are stored as doubles. */
+  void EncodeArray(IOComponentType componentType, const void *buffer, SizeValueType numberOfValues,
+                   unsigned int numberOfComponents, const char *name, DataArrayType & array);
+
+  class EncodeLongDoubleVisitor
+  {
+public:
+    EncodeLongDoubleVisitor(const void *buffer, SizeValueType numberOfValues, double *output):
+      m_Buffer(buffer), m_NumberOfValues(numberOfValues), m_Output(output)
+    {}
+
+    template< typename T >
+    void Visit()
+    {
+      ConvertBuffer(static_cast< const T * >( m_Buffer ), m_Output, m_NumberOfValues);
+    }
+
+private:
+    const void *  m_Buffer;
+    SizeValueType m_NumberOfValues;
+    double *      m_Output;
+  };
+
+  /** Encode the points, padded to three coordinates as VTK expects. */
+  template< typename T >
+  void WritePointsBuffer(const T *buffer)
+  {
+    if ( this->m_PointDimension == 3 )
+      {
+      this->EncodeArray(this->m_PointComponentType, buffer, this->m_NumberOfPoints * 3, 3, "Points", m_Points);
+      return;
+      }
+
+    MeshIOScratchBuffer< T > points(this->m_NumberOfPoints * 3);
+    T *                      data = points.GetBuffer();
+    for ( SizeValueType ii = 0; ii < this->m_NumberOfPoints; ii++ )
+      {
+      for ( unsigned int jj = 0; jj < 3; jj++ )
+        {
+        data[ii * 3 + jj] = jj < this->m_PointDimension ? buffer[ii * this->m_PointDimension + jj] : T();
+        }
+      }
+    this->EncodeArray(this->m_PointComponentType, data, this->m_NumberOfPoints * 3, 3, "Points", m_Points);
+  }
+
+  /** Split the cells buffer in the connectivity and offsets of the Verts,
+   * Lines and Polys sections, stored as Int64. */
+  template< typename T >
+  void WriteCellsBuffer(const T *buffer)
+  {
+    // Count the cells and the point identifiers of each section
+    SizeValueType numberOfIndices[NUMBER_OF_SECTIONS] = { 0, 0, 0 };
+    SizeValueType index = 0;
+    for ( SizeValueType ii = 0; ii < this->m_NumberOfCells; ii++ )
+      {
+      const CellGeometryType cellType = static_cast< CellGeometryType >( static_cast< int >( buffer[index++] ) );
+      const unsigned int     numberOfPoints = static_cast< unsigned int >( buffer[index++] );
+      const int              section = GetSection(cellType);
+      if ( section < 0 )
+        {
+        itkExceptionMacro(<< "Cell type " << cellType << " can not be written in a VTK PolyData file");
+        }
+      m_NumberOfSectionCells[section]++;
+      numberOfIndices[section] += numberOfPoints;
+      index += numberOfPoints;
+      }
+
+    // VTK stores the cell data in section order, remember where each cell
+    // goes when the cells are not already in that order
+    m_CellDataOrder.clear();
+    SizeValueType first[NUMBER_OF_SECTIONS] = { 0, 0, 0 };
+    for ( unsigned int section = 1; section < NUMBER_OF_SECTIONS; section++ )
+      {
+      first[section] = first[section - 1] + m_NumberOfSectionCells[section - 1];
+      }
+
+    std::vector< long long > connectivity[NUMBER_OF_SECTIONS];
+    std::vector< long long > offsets[NUMBER_OF_SECTIONS];
+    for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+      {
+      connectivity[section].reserve(numberOfIndices[section]);
+      offsets[section].reserve(m_NumberOfSectionCells[section]);
+      }
+
+    bool ordered = true;
+    int  lastSection = 0;
+    index = 0;
+    for ( SizeValueType ii = 0; ii < this->m_NumberOfCells; ii++ )
+      {
+      const int          section = GetSection( static_cast< CellGeometryType >( static_cast< int >( buffer[index++] ) ) );
+      const unsigned int numberOfPoints = static_cast< unsigned int >( buffer[index++] );
+      for ( unsigned int jj = 0; jj < numberOfPoints; jj++ )
+        {
+        connectivity[section].push_back( static_cast< long long >( buffer[index++] ) );
+        }
+      offsets[section].push_back( static_cast< long long >( connectivity[section].size() ) );
+
+      ordered = ordered && section >= lastSection;
+      lastSection = section;
+      }
+
+    if ( !ordered )
+      {
+      m_CellDataOrder.resize(this->m_NumberOfCells);
+      index = 0;
+      for ( SizeValueType ii = 0; ii < this->m_NumberOfCells; ii++ )
+        {
+        const int section = GetSection( static_cast< CellGeometryType >( static_cast< int >( buffer[index++] ) ) );
+        index += static_cast< SizeValueType >( buffer[index] ) + 1;
+        m_CellDataOrder[ii] = first[section]++;
+        }
+      }
+
+    for ( unsigned int section = 0; section < NUMBER_OF_SECTIONS; section++ )
+      {
+      if ( m_NumberOfSectionCells[section] )
+        {
+        this->EncodeArray(LONGLONG, &connectivity[section][0], numberOfIndices[section], 1,
+                          "connectivity", m_Connectivity[section]);
+        this->EncodeArray(LONGLONG, &offsets[section][0], m_NumberOfSectionCells[section], 1,
+                          "offsets", m_Offsets[section]);
+        }
+      }
+  }
+
+  /** Encode the cell data in the order of the cells in the file. */
+  template< typename T >
+  void WriteCellDataBuffer(const T *buffer)
+  {
+    const SizeValueType numberOfValues = this->m_NumberOfCellPixels * this->m_NumberOfCellPixelComponents;
+    if ( m_CellDataOrder.size() != this->m_NumberOfCellPixels )
+      {
+      this->EncodeArray(this->m_CellPixelComponentType, buffer, numberOfValues,
+                        this->m_NumberOfCellPixelComponents, "CellData", m_CellData);
+      return;
+      }
+
+    const unsigned int       numberOfComponents = this->m_NumberOfCellPixelComponents;
+    MeshIOScratchBuffer< T > data(numberOfValues);
+    for ( SizeValueType ii = 0; ii < this->m_NumberOfCellPixels; ii++ )
+      {
+      for ( unsigned int jj = 0; jj < numberOfComponents; jj++ )
+        {
+        data.GetBuffer()[m_CellDataOrder[ii] * numberOfComponents + jj] = buffer[ii * numberOfComponents + jj];
+        }
+      }
+    this->EncodeArray(this->m_CellPixelComponentType, data.GetBuffer(), numberOfValues,
+                      numberOfComponents, "CellData", m_CellData);
+  }
+
+  template< typename TBufferUser >
+  class BufferVisitor
+  {
+public:
+    BufferVisitor(Self *meshIO, const void *buffer):
+      m_MeshIO(meshIO), m_Buffer(buffer)
+    {}
+
+    template< typename T >
+    void Visit()
+    {
+      TBufferUser::Call( m_MeshIO, static_cast< const T * >( m_Buffer ) );
+    }
+
+private:
+    Self *      m_MeshIO;
+    const void *m_Buffer;
+  };
+
+  struct WritePointsCall
+    {
+    template< typename T >
+    static void Call(Self *meshIO, const T *buffer)
+    {
+      meshIO->WritePointsBuffer(buffer);
+    }
+    };
+
+  struct WriteCellsCall
+    {
+    template< typename T >
+    static void Call(Self *meshIO, const T *buffer)
+    {
+      meshIO->WriteCellsBuffer(buffer);
+    }
+    };
+
+  struct WriteCellDataCall
+    {
+    template< typename T >
+    static void Call(Self *meshIO, const T *buffer)
+    {
+      meshIO->WriteCellDataBuffer(buffer);
+    }
+    };
+
+  /** Section of a cell type, or -1 when it has no PolyData counterpart. */
+  static int GetSection(CellGeometryType cellType);
+
+  /** Inflate or deflate zlib blocks with the threads of a MultiThreader. */
+  struct ZLibBlocksStruct
+    {
+    bool                                        Compress;
+    int                                         CompressionLevel;
+    std::vector< const unsigned char * >        Inputs;
+    std::vector< SizeValueType >                InputSizes;
+    std::vector< unsigned char * >              Outputs;
+    std::vector< SizeValueType >                OutputSizes;
+    std::vector< int >                          Status;
+    };
+
+  static ITK_THREAD_RETURN_TYPE ZLibBlocksThreaderCallback(void *arg);
+
+  void ProcessZLibBlocks(ZLibBlocksStruct & blocks);
+
+  /** Write a DataArray element of the XML header. */
+  void WriteDataArrayTag(std::ostream & os, const DataArrayType & array, StreamOffsetType offset) const;
+
+private:
+  VTKXMLPolyDataMeshIO(const Self &); // purposely not implemented
+  void operator=(const Self &);       // purposely not implemented
+
+  std::ifstream m_InputFile;
+
+  /** Position of the first byte of the appended data, after the '_' */
+  StreamOffsetType m_AppendedDataPosition;
+
+  /** Size of the integers of the array headers, 4 (UInt32) or 8 (UInt64) */
+  unsigned int m_HeaderSize;
+
+  /** Whether the arrays are split in zlib blocks */
+  bool m_Compressed;
+
+  /** Size of the uncompressed zlib blocks written */
+  SizeValueType m_BlockSize;
+
+  DataArrayType m_Points;
+  DataArrayType m_Connectivity[NUMBER_OF_SECTIONS];
+  DataArrayType m_Offsets[NUMBER_OF_SECTIONS];
+  DataArrayType m_PointData;
+  DataArrayType m_CellData;
+
+  SizeValueType m_NumberOfSectionCells[NUMBER_OF_SECTIONS];
+  SizeValueType m_NumberOfSectionIndices[NUMBER_OF_SECTIONS];
+
+  /** Position in the file of each cell of the mesh written, empty when the
+   * cells are already in the section order */
+  std::vector< SizeValueType > m_CellDataOrder;
+};
+} // end namespace itk
+
+#endif
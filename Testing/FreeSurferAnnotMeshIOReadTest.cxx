@@ -0,0 +1,94 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFreeSurferAnnotMeshIO.h"
+#include "itkGiftiMeshIO.h"
+
+#include <vector>
+
+#include "MeshFileTestHelper.h"
+
+// Read a FreeSurfer annotation, and compare its labels and its color table
+// with the ones of a GIFTI label file of the same surface.
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 4 )
+    {
+    std::cerr << "Usage: " << argv[0] << " input.annot labels.gii colortable" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::FreeSurferAnnotMeshIO::Pointer annotIO = itk::FreeSurferAnnotMeshIO::New();
+  itk::GiftiMeshIO::Pointer           giftiIO = itk::GiftiMeshIO::New();
+  std::vector< int >                  annotation;
+  std::vector< int >                  labels;
+
+  try
+    {
+    if ( !annotIO->CanReadFile(argv[1]) )
+      {
+      std::cerr << "Cannot read file " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+      }
+    annotIO->SetFileName(argv[1]);
+    annotIO->ReadMeshInformation();
+    annotation.resize( annotIO->GetNumberOfPointPixels() );
+    if ( !annotation.empty() )
+      {
+      annotIO->ReadPointData(&annotation[0]);
+      }
+
+    giftiIO->SetFileName(argv[2]);
+    giftiIO->ReadMeshInformation();
+    labels.resize( giftiIO->GetNumberOfPointPixels() );
+    if ( !labels.empty() )
+      {
+      giftiIO->ReadPointData(&labels[0]);
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Read file " << argv[1] << " or " << argv[2] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( annotation.size() != labels.size() )
+    {
+    std::cerr << "Wrong number of labels: " << annotation.size() << " != " << labels.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  for ( size_t ii = 0; ii < labels.size(); ++ii )
+    {
+    if ( annotation[ii] != labels[ii] )
+      {
+      std::cerr << "Label of point " << ii << " differs: " << annotation[ii] << " != " << labels[ii] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  if ( annotIO->GetColorTableFileName() != std::string(argv[3]) )
+    {
+    std::cerr << "Wrong color table file name " << annotIO->GetColorTableFileName() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return TestLabelTables( giftiIO->GetLabelColorTable().GetPointer(), giftiIO->GetLabelNameTable().GetPointer(),
+                          annotIO->GetLabelColorTable().GetPointer(), annotIO->GetLabelNameTable().GetPointer() );
+}
@@ -0,0 +1,108 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFreeSurferAnnotMeshIO.h"
+#include "itkGiftiMeshIO.h"
+
+#include <vector>
+
+#include "MeshFileTestHelper.h"
+
+// Write the labels and the label table of a GIFTI label file as a FreeSurfer
+// annotation, read the annotation back and compare it with the GIFTI file.
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 3 )
+    {
+    std::cerr << "Usage: " << argv[0] << " labels.gii output.annot" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::GiftiMeshIO::Pointer           giftiIO = itk::GiftiMeshIO::New();
+  itk::FreeSurferAnnotMeshIO::Pointer writeIO = itk::FreeSurferAnnotMeshIO::New();
+  itk::FreeSurferAnnotMeshIO::Pointer readIO = itk::FreeSurferAnnotMeshIO::New();
+  std::vector< int >                  labels;
+  std::vector< int >                  annotation;
+
+  try
+    {
+    giftiIO->SetFileName(argv[1]);
+    giftiIO->ReadMeshInformation();
+    if ( giftiIO->GetPointPixelComponentType() != itk::MeshIOBase::INT
+         || giftiIO->GetNumberOfPointPixelComponents() != 1 )
+      {
+      std::cerr << "File " << argv[1] << " does not hold scalar labels" << std::endl;
+      return EXIT_FAILURE;
+      }
+    labels.resize( giftiIO->GetNumberOfPointPixels() );
+    giftiIO->ReadPointData(&labels[0]);
+
+    writeIO->SetFileName(argv[2]);
+    writeIO->SetUpdatePointData(true);
+    writeIO->SetNumberOfPointPixels( labels.size() );
+    writeIO->SetNumberOfPointPixelComponents(1);
+    writeIO->SetPointPixelComponentType(itk::MeshIOBase::INT);
+    writeIO->SetLabelColorTable( giftiIO->GetLabelColorTable() );
+    writeIO->SetLabelNameTable( giftiIO->GetLabelNameTable() );
+    writeIO->SetColorTableFileName("aparc.annot.ctab");
+    writeIO->WriteMeshInformation();
+    writeIO->WritePointData(&labels[0]);
+
+    if ( !readIO->CanReadFile(argv[2]) )
+      {
+      std::cerr << "Cannot read file " << argv[2] << std::endl;
+      return EXIT_FAILURE;
+      }
+    readIO->SetFileName(argv[2]);
+    readIO->ReadMeshInformation();
+    if ( readIO->GetNumberOfPointPixels() != labels.size() )
+      {
+      std::cerr << "Wrong number of labels in " << argv[2] << std::endl;
+      return EXIT_FAILURE;
+      }
+    annotation.resize( labels.size() );
+    readIO->ReadPointData(&annotation[0]);
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Round trip of file " << argv[1] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The GIFTI keys are the annotation values of the colors, so the labels
+  // must come back unchanged.
+  for ( size_t ii = 0; ii < labels.size(); ++ii )
+    {
+    if ( annotation[ii] != labels[ii] )
+      {
+      std::cerr << "Label of point " << ii << " differs: " << annotation[ii] << " != " << labels[ii] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  if ( readIO->GetColorTableFileName() != std::string("aparc.annot.ctab") )
+    {
+    std::cerr << "Wrong color table file name " << readIO->GetColorTableFileName() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return TestLabelTables( giftiIO->GetLabelColorTable().GetPointer(), giftiIO->GetLabelNameTable().GetPointer(),
+                          readIO->GetLabelColorTable().GetPointer(), readIO->GetLabelNameTable().GetPointer() );
+}
@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFreeSurferBinaryMeshIO.h"
+#include "itkFreeSurferBundleMeshIO.h"
+#include "itkMesh.h"
+#include "itkVariableLengthVector.h"
+
+#include <vector>
+
+#include "MeshFileTestHelper.h"
+
+// Read a surface with its overlays in one mesh, and compare it with the
+// surface and every overlay read alone. When an overlay does not have one
+// value per vertex of the surface, reading the bundle must fail.
+
+typedef itk::VariableLengthVector< float >    BundlePixelType;
+typedef itk::Mesh< BundlePixelType, 3 >       BundleMeshType;
+typedef itk::MeshFileReader< BundleMeshType > BundleReaderType;
+
+typedef itk::Mesh< float, 3 >                 MeshType;
+typedef itk::MeshFileReader< MeshType >       ReaderType;
+
+static MeshType::Pointer
+ReadFreeSurferMesh(const char *fileName)
+{
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetMeshIO( itk::FreeSurferBinaryMeshIO::New() );
+  reader->SetFileName(fileName);
+  reader->Update();
+
+  return reader->GetOutput();
+}
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 3 )
+    {
+    std::cerr << "Usage: " << argv[0] << " surface overlay [overlay ...]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const unsigned int numberOfOverlays = static_cast< unsigned int >( argc - 2 );
+
+  MeshType::Pointer                surface;
+  std::vector< MeshType::Pointer > overlays(numberOfOverlays);
+  bool                             mismatched = false;
+  try
+    {
+    surface = ReadFreeSurferMesh(argv[1]);
+    for ( unsigned int jj = 0; jj < numberOfOverlays; ++jj )
+      {
+      overlays[jj] = ReadFreeSurferMesh(argv[jj + 2]);
+      if ( overlays[jj]->GetPointData() == 0
+           || overlays[jj]->GetPointData()->Size() != surface->GetNumberOfPoints() )
+        {
+        mismatched = true;
+        }
+      }
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Read of the surface or an overlay failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::FreeSurferBundleMeshIO::Pointer bundleIO = itk::FreeSurferBundleMeshIO::New();
+  for ( int ii = 2; ii < argc; ++ii )
+    {
+    bundleIO->AddOverlayFileName(argv[ii]);
+    }
+
+  BundleReaderType::Pointer bundleReader = BundleReaderType::New();
+  bundleReader->SetMeshIO(bundleIO);
+  bundleReader->SetFileName(argv[1]);
+
+  try
+    {
+    bundleReader->Update();
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    if ( mismatched )
+      {
+      std::cout << "Overlays with another number of vertices are rejected: " << err << std::endl;
+      return EXIT_SUCCESS;
+      }
+    std::cerr << "Read file " << argv[1] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( mismatched )
+    {
+    std::cerr << "Overlays with another number of vertices than " << argv[1] << " were read" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  BundleMeshType::Pointer bundle = bundleReader->GetOutput();
+  if ( TestPointsContainer< MeshType >( surface->GetPoints(), bundle->GetPoints() ) == EXIT_FAILURE
+       || surface->GetNumberOfCells() != bundle->GetNumberOfCells() )
+    {
+    std::cerr << "Geometry of the bundle differs from surface " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  BundleMeshType::PointDataContainerPointer pointData = bundle->GetPointData();
+  if ( pointData.IsNull() || pointData->Size() != bundle->GetNumberOfPoints() )
+    {
+    std::cerr << "Wrong number of point data pixels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for ( unsigned int jj = 0; jj < numberOfOverlays; ++jj )
+    {
+    MeshType::PointDataContainerPointer overlayData = overlays[jj]->GetPointData();
+    if ( overlayData.IsNull() || overlayData->Size() != pointData->Size() )
+      {
+      std::cerr << "Wrong number of values in overlay " << argv[jj + 2] << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    BundleMeshType::PointDataContainer::ConstIterator pointDataIt = pointData->Begin();
+    MeshType::PointDataContainer::ConstIterator       overlayDataIt = overlayData->Begin();
+    while ( pointDataIt != pointData->End() )
+      {
+      if ( pointDataIt.Value().GetSize() != numberOfOverlays )
+        {
+        std::cerr << "Wrong number of components at point " << pointDataIt.Index() << std::endl;
+        return EXIT_FAILURE;
+        }
+      if ( pointDataIt.Value()[jj] != overlayDataIt.Value() )
+        {
+        std::cerr << "Overlay " << argv[jj + 2] << " differs at point " << pointDataIt.Index() << ": "
+                  << pointDataIt.Value()[jj] << " != " << overlayDataIt.Value() << std::endl;
+        return EXIT_FAILURE;
+        }
+      ++pointDataIt;
+      ++overlayDataIt;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFreeSurferMGHMeshIO.h"
+#include "itkGiftiMeshIO.h"
+#include "itkMesh.h"
+#include "itkMeshFileReader.h"
+#include "itkVariableLengthVector.h"
+
+// Read the frames of a MGH file as point data, and compare them with the
+// functional data arrays of a GIFTI file read as frames. With a third
+// argument, the MGH file is corrupt and reading it must fail.
+
+typedef itk::VariableLengthVector< float >    FramesPixelType;
+typedef itk::Mesh< FramesPixelType, 3 >       FramesMeshType;
+typedef itk::MeshFileReader< FramesMeshType > FramesReaderType;
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 3 )
+    {
+    std::cerr << "Usage: " << argv[0] << " file.mgh|file.mgz reference.gii [corrupt]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  bool IsCorrupt = ( argc > 3 );
+
+  itk::FreeSurferMGHMeshIO::Pointer mghIO = itk::FreeSurferMGHMeshIO::New();
+  if ( !mghIO->CanReadFile(argv[1]) )
+    {
+    std::cerr << "Cannot read file " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  FramesReaderType::Pointer mghReader = FramesReaderType::New();
+  mghReader->SetMeshIO(mghIO);
+  mghReader->SetFileName(argv[1]);
+
+  itk::GiftiMeshIO::Pointer giftiIO = itk::GiftiMeshIO::New();
+  giftiIO->ReadPointDataFramesOn();
+
+  FramesReaderType::Pointer giftiReader = FramesReaderType::New();
+  giftiReader->SetMeshIO(giftiIO);
+  giftiReader->SetFileName(argv[2]);
+
+  if ( IsCorrupt )
+    {
+    try
+      {
+      mghReader->Update();
+      }
+    catch ( itk::ExceptionObject & err )
+      {
+      std::cout << "Corrupt file " << argv[1] << " is rejected: " << err << std::endl;
+      return EXIT_SUCCESS;
+      }
+    std::cerr << "Corrupt file " << argv[1] << " was read" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  try
+    {
+    mghReader->Update();
+    giftiReader->Update();
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Read file " << argv[1] << " or " << argv[2] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  FramesMeshType::PointDataContainerPointer frames = mghReader->GetOutput()->GetPointData();
+  FramesMeshType::PointDataContainerPointer reference = giftiReader->GetOutput()->GetPointData();
+  if ( frames.IsNull() || reference.IsNull() || frames->Size() != reference->Size() )
+    {
+    std::cerr << "Wrong number of point data pixels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  FramesMeshType::PointDataContainer::ConstIterator framesIt = frames->Begin();
+  FramesMeshType::PointDataContainer::ConstIterator referenceIt = reference->Begin();
+  while ( framesIt != frames->End() )
+    {
+    if ( framesIt.Value().GetSize() != referenceIt.Value().GetSize() )
+      {
+      std::cerr << "Wrong number of frames at point " << framesIt.Index() << ": " << framesIt.Value().GetSize()
+                << " != " << referenceIt.Value().GetSize() << std::endl;
+      return EXIT_FAILURE;
+      }
+    for ( unsigned int jj = 0; jj < framesIt.Value().GetSize(); ++jj )
+      {
+      if ( framesIt.Value()[jj] != referenceIt.Value()[jj] )
+        {
+        std::cerr << "Frame " << jj << " differs at point " << framesIt.Index() << ": "
+                  << framesIt.Value()[jj] << " != " << referenceIt.Value()[jj] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    ++framesIt;
+    ++referenceIt;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGiftiMeshIO.h"
+#include "itkMesh.h"
+#include "itkMeshFileReader.h"
+#include "itkVariableLengthVector.h"
+
+#include <vector>
+
+// Read all functional data arrays of a GIFTI file as the frames of one
+// point data pixel, and compare every frame with the data array read alone.
+
+typedef itk::VariableLengthVector< float >    FramesPixelType;
+typedef itk::Mesh< FramesPixelType, 3 >       FramesMeshType;
+typedef itk::MeshFileReader< FramesMeshType > FramesReaderType;
+
+typedef itk::Mesh< float, 3 >                 FrameMeshType;
+typedef itk::MeshFileReader< FrameMeshType >  FrameReaderType;
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " file.gii" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::GiftiMeshIO::Pointer framesIO = itk::GiftiMeshIO::New();
+  framesIO->ReadPointDataFramesOn();
+
+  FramesReaderType::Pointer framesReader = FramesReaderType::New();
+  framesReader->SetMeshIO(framesIO);
+  framesReader->SetFileName(argv[1]);
+
+  try
+    {
+    framesReader->Update();
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Read file " << argv[1] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const std::vector< int > frameDataArrays = framesIO->GetPointDataFrameDataArrays();
+  if ( frameDataArrays.size() < 2 )
+    {
+    std::cerr << "Expected several point data frames, found " << frameDataArrays.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  FramesMeshType::PointDataContainerPointer frames = framesReader->GetOutput()->GetPointData();
+  if ( frames.IsNull() || frames->Size() != framesReader->GetOutput()->GetNumberOfPoints() )
+    {
+    std::cerr << "Wrong number of point data frames pixels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for ( size_t jj = 0; jj < frameDataArrays.size(); ++jj )
+    {
+    itk::GiftiMeshIO::Pointer frameIO = itk::GiftiMeshIO::New();
+    std::vector< int >        selection(1, frameDataArrays[jj]);
+    frameIO->SetFunctionalDataArrays(selection);
+
+    FrameReaderType::Pointer frameReader = FrameReaderType::New();
+    frameReader->SetMeshIO(frameIO);
+    frameReader->SetFileName(argv[1]);
+
+    try
+      {
+      frameReader->Update();
+      }
+    catch ( itk::ExceptionObject & err )
+      {
+      std::cerr << "Read data array " << frameDataArrays[jj] << " of " << argv[1] << " failed " << std::endl;
+      std::cerr << err << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    FrameMeshType::PointDataContainerPointer frame = frameReader->GetOutput()->GetPointData();
+    if ( frame.IsNull() || frame->Size() != frames->Size() )
+      {
+      std::cerr << "Wrong number of pixels in data array " << frameDataArrays[jj] << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    FramesMeshType::PointDataContainer::ConstIterator framesIt = frames->Begin();
+    FrameMeshType::PointDataContainer::ConstIterator  frameIt = frame->Begin();
+    while ( framesIt != frames->End() )
+      {
+      if ( framesIt.Value().GetSize() != frameDataArrays.size() )
+        {
+        std::cerr << "Wrong number of frames at point " << framesIt.Index() << std::endl;
+        return EXIT_FAILURE;
+        }
+      if ( framesIt.Value()[jj] != frameIt.Value() )
+        {
+        std::cerr << "Frame " << jj << " differs at point " << framesIt.Index() << ": "
+                  << framesIt.Value()[jj] << " != " << frameIt.Value() << std::endl;
+        return EXIT_FAILURE;
+        }
+      ++framesIt;
+      ++frameIt;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
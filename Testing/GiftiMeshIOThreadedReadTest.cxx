@@ -0,0 +1,148 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGiftiMeshIO.h"
+#include "itkMesh.h"
+#include "itkMultiThreader.h"
+#include "itkVariableLengthVector.h"
+
+#include "MeshFileTestHelper.h"
+
+#include <vector>
+
+// Read GIFTI files from several threads at once, each thread with its own
+// reader, and compare every mesh with the one read before on one thread.
+
+typedef itk::VariableLengthVector< float > PixelType;
+typedef itk::Mesh< PixelType, 3 >          MeshType;
+typedef itk::MeshFileReader< MeshType >    MeshFileReaderType;
+
+struct ThreadedReadData
+{
+  std::vector< std::string >       FileNames;
+  std::vector< MeshType::Pointer > Meshes;
+  unsigned int                     NumberOfIterations;
+  std::vector< unsigned int >      NumberOfFailures;
+};
+
+static MeshType::Pointer
+ReadGiftiMesh(const std::string & fileName)
+{
+  MeshFileReaderType::Pointer reader = MeshFileReaderType::New();
+  reader->SetMeshIO( itk::GiftiMeshIO::New() );
+  reader->SetFileName( fileName.c_str() );
+  reader->Update();
+
+  return reader->GetOutput();
+}
+
+static int
+CompareMeshes(MeshType *mesh0, MeshType *mesh1)
+{
+  if ( TestPointsContainer< MeshType >( mesh0->GetPoints(), mesh1->GetPoints() ) == EXIT_FAILURE
+       || TestCellsContainer< MeshType >( mesh0->GetCells(), mesh1->GetCells() ) == EXIT_FAILURE
+       || TestPointDataContainer< MeshType >( mesh0->GetPointData(), mesh1->GetPointData() ) == EXIT_FAILURE
+       || TestCellDataContainer< MeshType >( mesh0->GetCellData(), mesh1->GetCellData() ) == EXIT_FAILURE )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+static ITK_THREAD_RETURN_TYPE
+ThreadedRead(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *threadInfo = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadedReadData *                    data = static_cast< ThreadedReadData * >( threadInfo->UserData );
+  const unsigned int                    threadId = static_cast< unsigned int >( threadInfo->ThreadID );
+  const size_t                          numberOfFiles = data->FileNames.size();
+
+  for ( unsigned int ii = 0; ii < data->NumberOfIterations; ++ii )
+    {
+    for ( size_t jj = 0; jj < numberOfFiles; ++jj )
+      {
+      // Start each thread on another file, so that different files are
+      // read at the same time as well as the same ones
+      const size_t index = ( jj + threadId + ii ) % numberOfFiles;
+      try
+        {
+        MeshType::Pointer mesh = ReadGiftiMesh(data->FileNames[index]);
+        if ( CompareMeshes(data->Meshes[index], mesh) == EXIT_FAILURE )
+          {
+          data->NumberOfFailures[threadId]++;
+          }
+        }
+      catch ( itk::ExceptionObject & )
+        {
+        data->NumberOfFailures[threadId]++;
+        }
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 4 )
+    {
+    std::cerr << "Usage: " << argv[0] << " numberOfThreads numberOfIterations file.gii [file.gii ...]" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int numberOfThreads = atoi(argv[1]);
+
+  ThreadedReadData data;
+  data.NumberOfIterations = atoi(argv[2]);
+
+  for ( int ii = 3; ii < argc; ++ii )
+    {
+    data.FileNames.push_back(argv[ii]);
+    try
+      {
+      data.Meshes.push_back( ReadGiftiMesh(argv[ii]) );
+      }
+    catch ( itk::ExceptionObject & err )
+      {
+      std::cerr << "Read file " << argv[ii] << " failed " << std::endl;
+      std::cerr << err << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  data.NumberOfFailures.resize(threader->GetNumberOfThreads(), 0);
+  threader->SetSingleMethod(ThreadedRead, &data);
+  threader->SingleMethodExecute();
+
+  unsigned int numberOfFailures = 0;
+  for ( size_t ii = 0; ii < data.NumberOfFailures.size(); ++ii )
+    {
+    numberOfFailures += data.NumberOfFailures[ii];
+    }
+
+  if ( numberOfFailures > 0 )
+    {
+    std::cerr << numberOfFailures << " threaded reads failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
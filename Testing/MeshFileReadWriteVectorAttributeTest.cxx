@@ -32,6 +32,7 @@ int main(int argc, char * argv[])
     }
 
   bool IsBinary = ( argc > 3 );
+  bool UseCompression = ( argc > 4 );
 
   const unsigned int dimension = 3;
   typedef itk::CovariantVector< float, dimension >     PixelType;
@@ -39,12 +40,12 @@ int main(int argc, char * argv[])
   typedef itk::Mesh< PixelType, dimension >            MeshType;
   typedef itk::QuadEdgeMesh< PixelType, dimension >    QEMeshType;
 
-  if( test< MeshType >( argv[1], argv[2], IsBinary ) )
+  if( test< MeshType >( argv[1], argv[2], IsBinary, UseCompression ) )
     {
     return EXIT_FAILURE;
     }
 
-  if( test< QEMeshType >( argv[1], argv[2], IsBinary ) )
+  if( test< QEMeshType >( argv[1], argv[2], IsBinary, UseCompression ) )
     {
     return EXIT_FAILURE;
     }
@@ -0,0 +1,107 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMesh.h"
+#include "itkMeshCellArena.h"
+#include "itkMetaDataObject.h"
+
+#include "MeshFileTestHelper.h"
+
+// Read a mesh with its cells in a cell arena and compare it with the mesh
+// read with the cells allocated one by one. The cells container is then
+// given to another mesh, and must stay valid once the reader and the mesh
+// it was read into are gone.
+
+typedef itk::Mesh< float, 3 >           MeshType;
+typedef itk::MeshFileReader< MeshType > MeshFileReaderType;
+
+static MeshType::Pointer
+ReadMesh(const char *fileName, bool useCellArena)
+{
+  MeshFileReaderType::Pointer reader = MeshFileReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetUseCellArena(useCellArena);
+  reader->Update();
+
+  return reader->GetOutput();
+}
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  MeshType::Pointer mesh;
+  MeshType::Pointer sharedCellsMesh = MeshType::New();
+  try
+    {
+    mesh = ReadMesh(argv[1], false);
+
+    MeshType::Pointer arenaMesh = ReadMesh(argv[1], true);
+    if ( arenaMesh->GetCellsAllocationMethod() != MeshType::CellsAllocatedAsStaticArray )
+      {
+      std::cerr << "The cells of a cell arena must not be deleted by the mesh" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    MeshType::CellsContainerPointer cells = arenaMesh->GetCells();
+    if ( cells.IsNull() || !cells->GetMetaDataDictionary().HasKey("MeshCellArena") )
+      {
+      std::cerr << "The cells container does not hold its cell arena" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    itk::MeshCellArena::Pointer arena;
+    if ( !itk::ExposeMetaData< itk::MeshCellArena::Pointer >(cells->GetMetaDataDictionary(), "MeshCellArena", arena)
+         || arena.IsNull() || arena->GetNumberOfCells() != cells->Size() )
+      {
+      std::cerr << "The cell arena does not hold the cells of the mesh" << std::endl;
+      return EXIT_FAILURE;
+      }
+    arena = 0;
+
+    if ( TestPointsContainer< MeshType >( mesh->GetPoints(), arenaMesh->GetPoints() ) == EXIT_FAILURE
+         || TestCellsContainer< MeshType >( mesh->GetCells(), arenaMesh->GetCells() ) == EXIT_FAILURE )
+      {
+      std::cerr << "The mesh read with a cell arena differs from " << argv[1] << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // Share the cells with another mesh, and release the first one
+    sharedCellsMesh->SetPoints( arenaMesh->GetPoints() );
+    sharedCellsMesh->SetCellsAllocationMethod(MeshType::CellsAllocatedAsStaticArray);
+    sharedCellsMesh->SetCells(cells);
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Read file " << argv[1] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( TestCellsContainer< MeshType >( mesh->GetCells(), sharedCellsMesh->GetCells() ) == EXIT_FAILURE )
+    {
+    std::cerr << "The cells shared with another mesh differ from " << argv[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
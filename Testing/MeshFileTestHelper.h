@@ -20,6 +20,8 @@
 #include "itkMeshFileWriter.h"
 #include <itksys/SystemTools.hxx>
 
+#include <cmath>
+
 template< class TMesh >
 int
 TestPointsContainer( typename TMesh::PointsContainerPointer points0,
@@ -169,6 +171,48 @@ TestPointDataContainer( typename TMesh::PointDataContainerPointer pointData0,
   return EXIT_SUCCESS;
 }
 
+// Compare the label color and name tables of a file with the ones of a
+// reference file. Colors are stored as bytes, alpha as a transparency byte.
+template< class TLabelColorContainer, class TLabelNameContainer >
+int
+TestLabelTables( const TLabelColorContainer *colors0, const TLabelNameContainer *names0,
+                 const TLabelColorContainer *colors1, const TLabelNameContainer *names1 )
+{
+  if ( !colors0 || !names0 || !colors1 || !names1
+       || colors1->Size() != colors0->Size() || names1->Size() != names0->Size() )
+    {
+    std::cerr << "Wrong number of entries in the color table" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const float tolerance = 0.5f / 255.0f + 1e-6f;
+  for ( typename TLabelColorContainer::ConstIterator it = colors0->Begin(); it != colors0->End(); ++it )
+    {
+    if ( !colors1->IndexExists( it.Index() ) || !names1->IndexExists( it.Index() ) )
+      {
+      std::cerr << "Label " << it.Index() << " is missing from the color table" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if ( names1->ElementAt( it.Index() ) != names0->ElementAt( it.Index() ) )
+      {
+      std::cerr << "Name of label " << it.Index() << " differs: " << names1->ElementAt( it.Index() )
+                << " != " << names0->ElementAt( it.Index() ) << std::endl;
+      return EXIT_FAILURE;
+      }
+    for ( unsigned int jj = 0; jj < 4; ++jj )
+      {
+      if ( std::fabs( colors1->ElementAt( it.Index() )[jj] - it.Value()[jj] ) > tolerance )
+        {
+        std::cerr << "Color of label " << it.Index() << " differs: " << colors1->ElementAt( it.Index() )
+                  << " != " << it.Value() << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
+
 template< class TMesh >
 int
 TestCellDataContainer( typename TMesh::CellDataContainerPointer cellData0,
@@ -215,7 +259,7 @@ TestCellDataContainer( typename TMesh::CellDataContainerPointer cellData0,
 
 template< class TMesh >
 int
-test(char *INfilename, char *OUTfilename, bool IsBinary)
+test(char *INfilename, char *OUTfilename, bool IsBinary, bool UseCompression = false)
 {
   typedef TMesh MeshType;
 
@@ -252,6 +296,10 @@ test(char *INfilename, char *OUTfilename, bool IsBinary)
     {
     writer->SetFileTypeAsBINARY();
     }
+  if ( UseCompression )
+    {
+    writer->UseCompressionOn();
+    }
 
   try
     {
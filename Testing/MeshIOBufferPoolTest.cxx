@@ -0,0 +1,87 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMesh.h"
+#include "itkMeshFileReader.h"
+#include "itkMeshIOBufferPool.h"
+
+// Read the same mesh twice with one reader: the second read must be served
+// from the buffers pooled by the first one. The buffers must be returned to
+// the heap once the reader is gone.
+
+typedef itk::Mesh< float, 3 >           MeshType;
+typedef itk::MeshFileReader< MeshType > MeshFileReaderType;
+
+int main(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " file" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::MeshIOBufferPool::Clear();
+
+  MeshFileReaderType::Pointer reader = MeshFileReaderType::New();
+  reader->SetFileName(argv[1]);
+
+  itk::MeshIOBufferPool::SizeValueType hits = 0;
+  itk::MeshIOBufferPool::SizeValueType grows = 0;
+  try
+    {
+    reader->Update();
+    hits = itk::MeshIOBufferPool::GetNumberOfHits();
+    grows = itk::MeshIOBufferPool::GetNumberOfGrows();
+    if ( grows == 0 )
+      {
+      std::cerr << "Reading " << argv[1] << " did not use the buffer pool" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    reader->Modified();
+    reader->Update();
+    }
+  catch ( itk::ExceptionObject & err )
+    {
+    std::cerr << "Read file " << argv[1] << " failed " << std::endl;
+    std::cerr << err << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if ( itk::MeshIOBufferPool::GetNumberOfHits() <= hits )
+    {
+    std::cerr << "The second read was not served from the pool: " << itk::MeshIOBufferPool::GetNumberOfHits()
+              << " hits after " << hits << std::endl;
+    return EXIT_FAILURE;
+    }
+  if ( itk::MeshIOBufferPool::GetNumberOfGrows() != grows )
+    {
+    std::cerr << "The second read allocated buffers: " << itk::MeshIOBufferPool::GetNumberOfGrows()
+              << " grows after " << grows << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  reader = 0;
+  if ( itk::MeshIOBufferPool::GetPooledBytes() != 0 )
+    {
+    std::cerr << itk::MeshIOBufferPool::GetPooledBytes() << " bytes are still pooled without a reader" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -257,9 +257,31 @@ int gifti_set_zlevel( int level )
     return gxml_set_zlevel(level);
 }
 
+/*! with nthreads > 0, base64 DataArrays are decoded after parsing, in
+    parallel, rather than from within the XML character callback */
+int gifti_get_decode_threads(void)       { return gxml_get_nthreads(); }
+int gifti_set_decode_threads(int nthreads){ return gxml_set_nthreads(nthreads); }
+
+/*! with nthreads > 1, streamed GZipBase64Binary DataArrays are compressed
+    by chunks in parallel, as one zlib stream */
+int gifti_get_encode_threads(void)       { return gxml_get_zthreads(); }
+int gifti_set_encode_threads(int nthreads){ return gxml_set_zthreads(nthreads); }
+
 int gifti_get_xml_buf_size(void)        { return gxml_get_buf_size(); }
 int gifti_set_xml_buf_size(int buf_size){ return gxml_set_buf_size(buf_size); }
 
+/*! fill ctx with the current user variables, to be modified and passed
+    to the reentrant (_ctx) functions */
+int gifti_init_context(gifti_context * ctx)
+{
+    if( !ctx ) return 1;
+
+    (void)gxml_init_context(ctx);
+    ctx->verb = G.verb;
+
+    return 0;
+}
+
 /*! reset user variables to their defaults(via set to -1) */
 int gifti_reset_user_vars(void)
 {
@@ -270,6 +292,8 @@ int gifti_reset_user_vars(void)
     gxml_set_b64_check(-1);
     gxml_set_update_ok(-1);
     gxml_set_zlevel(-1);
+    gxml_set_nthreads(-1);
+    gxml_set_zthreads(-1);
 
     return 0;
 }
@@ -332,15 +356,34 @@ int gifti_str2attr_gifti(gifti_image * gim, const char *attr, const char *val)
  *         NULL on error
 *//*-------------------------------------------------------------------*/
 gifti_image * gifti_read_image( const char * fname, int read_data )
+{
+    gifti_context ctx;
+
+    (void)gifti_init_context(&ctx);
+
+    return gifti_read_image_ctx(&ctx, fname, read_data);
+}
+
+/*----------------------------------------------------------------------
+ *! The reentrant form of gifti_read_image.
+ *
+ *  The user variables are taken from ctx (see gifti_init_context), and
+ *  all parsing state is local, so that images may be read concurrently
+ *  from several threads, given that no thread changes the global user
+ *  variables meanwhile.
+ *
+ *  return an allocated gifti_image struct on success,
+ *         NULL on error
+*//*-------------------------------------------------------------------*/
+gifti_image * gifti_read_image_ctx( const gifti_context * ctx,
+                                    const char * fname, int read_data )
 {
     if( !fname ) {
         fprintf(stderr,"** gifti_read_image: missing filename\n");
         return NULL;
     }
 
-    gxml_set_verb(G.verb);
-
-    return gxml_read_image(fname, read_data, NULL, 0);
+    return gxml_read_image(ctx, fname, read_data, NULL, 0);
 }
 
 /*----------------------------------------------------------------------
@@ -359,15 +402,25 @@ gifti_image * gifti_read_image( const char * fname, int read_data )
 *//*-------------------------------------------------------------------*/
 gifti_image * gifti_read_da_list( const char * fname, int read_data,
                                   const int * dalist, int len )
+{
+    gifti_context ctx;
+
+    (void)gifti_init_context(&ctx);
+
+    return gifti_read_da_list_ctx(&ctx, fname, read_data, dalist, len);
+}
+
+/*! the reentrant form of gifti_read_da_list, see gifti_read_image_ctx */
+gifti_image * gifti_read_da_list_ctx( const gifti_context * ctx,
+                                      const char * fname, int read_data,
+                                      const int * dalist, int len )
 {
     if( !fname ) {
         fprintf(stderr,"** gifti_read_da_list: missing filename\n");
         return NULL;
     }
 
-    gxml_set_verb(G.verb);
-
-    return gxml_read_image(fname, read_data, dalist, len);
+    return gxml_read_image(ctx, fname, read_data, dalist, len);
 }
 
 /*----------------------------------------------------------------------
@@ -379,6 +432,17 @@ gifti_image * gifti_read_da_list( const char * fname, int read_data,
  *         1 on error
 *//*-------------------------------------------------------------------*/
 int gifti_write_image(gifti_image *gim, const char *fname, int write_data)
+{
+    gifti_context ctx;
+
+    (void)gifti_init_context(&ctx);
+
+    return gifti_write_image_ctx(&ctx, gim, fname, write_data);
+}
+
+/*! the reentrant form of gifti_write_image, see gifti_read_image_ctx */
+int gifti_write_image_ctx(const gifti_context *ctx, gifti_image *gim,
+                          const char *fname, int write_data)
 {
     int errs = 0;
 
@@ -392,9 +456,60 @@ int gifti_write_image(gifti_image *gim, const char *fname, int write_data)
 
     if( errs ) return 1;
 
-    gxml_set_verb(G.verb);
+    return gxml_write_image(ctx, gim, fname, write_data);
+}
+
+/*----------------------------------------------------------------------
+ *! Stream a dataset, without storing its data in the gifti_image.
+ *
+ *  gifti_stream_open writes the meta data of gim to fname.  Each
+ *  DataArray of gim is then written in order, between
+ *  gifti_stream_begin_DA and gifti_stream_end_DA, with its nvals*nbyper
+ *  data bytes given to gifti_stream_write_DA_data in chunks of any size.
+ *  ExternalFileBinary data are left for the caller to write.
+ *  gifti_stream_close ends the dataset and frees the stream.
+ *
+ *  User variables should be set before gifti_stream_open.
+ *
+ *  gifti_stream_open returns the stream, or NULL on error
+ *  gifti_stream_close returns the number of errors met
+ *  the others return 0 on success, 1 on error
+*//*-------------------------------------------------------------------*/
+gifti_stream * gifti_stream_open(gifti_image *gim, const char *fname)
+{
+    gifti_context ctx;
+
+    (void)gifti_init_context(&ctx);
+
+    return gxml_stream_open(&ctx, gim, fname);
+}
 
-    return gxml_write_image(gim, fname, write_data);
+/*! the reentrant form of gifti_stream_open, see gifti_read_image_ctx */
+gifti_stream * gifti_stream_open_ctx(const gifti_context *ctx,
+                                     gifti_image *gim, const char *fname)
+{
+    return gxml_stream_open(ctx, gim, fname);
+}
+
+int gifti_stream_begin_DA(gifti_stream *gs, giiDataArray *da)
+{
+    return gxml_stream_begin_DA(gs, da);
+}
+
+int gifti_stream_write_DA_data(gifti_stream *gs, const void *data,
+                               long long nbytes)
+{
+    return gxml_stream_write_DA_data(gs, data, nbytes);
+}
+
+int gifti_stream_end_DA(gifti_stream *gs)
+{
+    return gxml_stream_end_DA(gs);
+}
+
+int gifti_stream_close(gifti_stream *gs)
+{
+    return gxml_stream_close(gs);
 }
 
 
@@ -135,6 +135,18 @@ typedef struct {
     int verb;
 } gifti_globals;
 
+/* user variables of one read or write, for the reentrant interface */
+typedef struct {
+    int verb;             /* verbose level                     */
+    int indent;           /* spaces per indent level           */
+    int buf_size;         /* XML parser buffer size            */
+    int b64_check;        /* GIFTI_B64_CHECK_* method          */
+    int update_ok;        /* library can update metadata       */
+    int zlevel;           /* compression level, -1..9          */
+    int nthreads;         /* threads decoding base64 data      */
+    int zthreads;         /* threads compressing streamed data */
+} gifti_context;
+
 typedef struct {
     int    type;          /* should match NIFTI_TYPE_* */
     int    nbyper;        /* bytes per value           */
@@ -143,6 +155,10 @@ typedef struct {
 } gifti_type_ele;
 
 
+/* streaming writer state, see gifti_xml.h */
+typedef struct gifti_stream_s gifti_stream;
+
+
 /* prototypes */
 
 /* main interface protos */
@@ -157,6 +173,26 @@ int    gifti_write_image        (gifti_image *gim, const char *fname,
 gifti_image * gifti_create_image(int numDA, int intent, int dtype, int ndim,
                                  const int * dims, int alloc_data);
 
+/* streaming write: the image meta data, then each DataArray in order */
+gifti_stream * gifti_stream_open (gifti_image *gim, const char *fname);
+int    gifti_stream_begin_DA     (gifti_stream *gs, giiDataArray *da);
+int    gifti_stream_write_DA_data(gifti_stream *gs, const void *data,
+                                  long long nbytes);
+int    gifti_stream_end_DA       (gifti_stream *gs);
+int    gifti_stream_close        (gifti_stream *gs);
+
+/* reentrant interface: the user variables come from ctx, not globals */
+int    gifti_init_context       (gifti_context *ctx);
+gifti_image * gifti_read_image_ctx  (const gifti_context *ctx,
+                                     const char *fname, int read_data);
+gifti_image * gifti_read_da_list_ctx(const gifti_context *ctx,
+                                     const char *fname, int read_data,
+                                     const int *dalist, int len);
+int    gifti_write_image_ctx    (const gifti_context *ctx, gifti_image *gim,
+                                 const char *fname, int write_data);
+gifti_stream * gifti_stream_open_ctx(const gifti_context *ctx,
+                                     gifti_image *gim, const char *fname);
+
 /* end main interface protos */
 
 int    gifti_get_b64_check      (void);
@@ -169,6 +205,10 @@ int    gifti_get_update_ok      (void);
 int    gifti_set_update_ok      (int level);
 int    gifti_get_zlevel         (void);
 int    gifti_set_zlevel         (int level);
+int    gifti_get_decode_threads (void);
+int    gifti_set_decode_threads (int nthreads);
+int    gifti_get_encode_threads (void);
+int    gifti_set_encode_threads (int nthreads);
 
 /* data copy routines */
 int     gifti_convert_to_float(gifti_image * gim);
@@ -3,8 +3,29 @@
 #include <string.h>
 #include "gifti_io.h"
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define GXML_HAVE_MMAP
+#endif
+
 #define GXML_MIN_BSIZE 2048
 #define GXML_DEF_BSIZE 32768
+#define GXML_MAP_SLICE (1<<24)  /* mapped bytes per XML_Parse call */
+#define GXML_MAX_DECODE_LEN (1<<30) /* max text per decode_b64 call */
+#define GXML_B64_ENC_BLOCK  8192    /* 3-byte sets per encoded write */
+#define GXML_STREAM_ZLEN    65536   /* compressed bytes per streamed write */
+#define GXML_ABUF_LEN       16384   /* bytes of ASCII output buffered */
+#define GXML_AVAL_LEN       40      /* room kept for one formatted value */
+#define GXML_ZCHUNK         131072  /* bytes per chunk compressed in parallel */
+#define GXML_ZDICT          32768   /* preceding bytes used as dictionary */
+#define GXML_ZCHUNK_BOUND   (GXML_ZCHUNK + (GXML_ZCHUNK>>3) + (GXML_ZCHUNK>>6) + 32)
 
 /* local prototypes */
 static int  append_to_cdata     (gxml_data *, const char *, int);
@@ -14,6 +35,8 @@ static int  append_to_data_b64  (gxml_data *, char*,long long,const char*, int);
 /* 
 static int  append_to_data_b64gz(gxml_data *, const char *, int);
 */
+static int  append_to_pending   (gxml_data *, const char *, int);
+static int  append_to_buffer    (gxml_pending *, const char *, long long);
 
 static int  add_label_rgba      (gxml_data *, giiLabelTable *, float *);
 static int  append_to_xform     (gxml_data *, const char *, int);
@@ -21,7 +44,17 @@ static int  apply_da_list_order (gxml_data *, const int *, int);
 static int  int_compare         (const void * v0, const void * v1);
 static int  copy_b64_data       (gxml_data *, const char *, char *, int, int*);
 static int  decode_ascii       (gxml_data*,char*,int,int,void*,long long*,int*);
+static long      gxml_strtol    (const char *, char **);
+static long long gxml_strtoll   (const char *, char **);
+static double    gxml_strtod    (const char *, char **);
 static int  decode_b64          (gxml_data*, char*, int, char *, long long *);
+static int  decode_pending      (gxml_data *);
+static void show_b64_errors     (gxml_data *, int, int);
+static int  swap_DA_data        (giiDataArray *);
+static int  uncompress_DA_data  (gxml_data *, giiDataArray *, int,
+                                 const char *, long long, int);
+static int  decode_pending_DA   (gxml_data *, gxml_pending *);
+static int  defer_data          (gxml_data *, giiDataArray *);
 static int  disp_gxml_data      (char *, gxml_data *, int);
 static int  ename2type          (const char *);
 static int  epush               (gxml_data *, int, const char *, const char **);
@@ -29,7 +62,9 @@ static int  epop                (gxml_data *, int, const char *);
 static int  free_xd_data        (gxml_data *);
 static int  get_label_attrs     (gxml_data *, const char **, int *, float *);
 static int  init_gxml_data      (gxml_data *, int, const int *, int);
+static const char * map_xml_file  (const char *, long long *);
 static int  partial_buf_size    (long long);
+static void unmap_xml_file      (const char *, long long);
 
 static int  push_gifti          (gxml_data *, const char **);
 static int  push_meta           (gxml_data *);
@@ -96,28 +131,53 @@ static void XMLCALL cb_start_doctype(void *, const char *, const char *,
 static void XMLCALL cb_end_doctype  (void *);
 static void XMLCALL cb_elem_dec     (void *, const char *, XML_Content *);
 static XML_Parser init_xml_parser   (void *);
+static void init_gxml_user_vars     (gxml_data *, const gifti_context *);
 
 /* writing functions */
+static int  gxml_fmt_decimal        (char *, int, unsigned long long, int);
+static int  gxml_fmt_uint           (char *, unsigned long long);
+static int  gxml_fmt_int            (char *, long long);
+static int  gxml_fmt_float          (char *, float);
+static int  gxml_fmt_double         (char *, double);
+static int  gxml_fmt_value          (char *, const unsigned char *, int);
 static int  gxml_write_gifti        (gxml_data *, FILE *);
+static int  gxml_write_gifti_head   (gxml_data *, FILE *);
+static int  gxml_write_gifti_tail   (gxml_data *, FILE *);
 static int  gxml_write_preamble     (FILE *);
 
 static int  ewrite_text_ele         (int, const char *, const char *,
                                      int, int, FILE *);
 static int  ewrite_coordsys         (gxml_data *, giiCoordSystem *, FILE *);
 static int  ewrite_data             (gxml_data *, giiDataArray *, FILE *);
-static int  ewrite_data_line        (void *, int, long long, long long,
-                                     int, FILE *);
+static int  ewrite_data_rows        (const void *, int, long long, long long,
+                                     long long, int, FILE *);
 static int  ewrite_double_line      (double *, int, int, FILE *);
 static int  ewrite_int_attr         (const char *, int, int, int, FILE *);
 static int  ewrite_long_long_attr   (const char *, long long, int, int, FILE *);
 static int  ewrite_str_attr         (const char*, const char*, int, int, FILE*);
 static int  ewrite_darray           (gxml_data *, giiDataArray *, FILE *);
+static int  ewrite_darray_head      (gxml_data *, giiDataArray *, FILE *);
+static int  ewrite_darray_tail      (gxml_data *, FILE *);
 static int  ewrite_ex_atrs          (gxml_data *, nvpairs *, int, int, FILE *);
 static int  ewrite_LT               (gxml_data*, giiLabelTable*, int, FILE*);
 static int  ewrite_meta             (gxml_data *, giiMetaData *, FILE *);
 
 static int  gxml_disp_b64_data      (const char *, const void *, int, FILE *);
 
+static int  stream_ascii_data       (gifti_stream *, const unsigned char *,
+                                     long long);
+static int  stream_b64_data         (gifti_stream *, const unsigned char *,
+                                     long long);
+static int  stream_gz_data          (gifti_stream *, const unsigned char *,
+                                     long long, int);
+static int  stream_pgz_begin        (gifti_stream *);
+static int  stream_pgz_data         (gifti_stream *, const unsigned char *,
+                                     long long);
+static int  stream_pgz_batch        (gifti_stream *, int);
+#if defined(HAVE_ZLIB) && defined(HAVE_PTHREAD)
+static int  deflate_zchunk          (gxml_zchunk *);
+#endif
+
 /* these should match GXML_ETYPE_* defines */
 static char * enames[GXML_MAX_ELEN] = {
     "Invalid", "GIFTI", "MetaData", "MD", "Name", "Value", "LabelTable",
@@ -135,6 +195,8 @@ static gxml_data GXD = {
     GIFTI_B64_CHECK_SKIPNCOUNT, /* b64_check, for b64 errors  */
     1,          /* assume it is okay to update metadata       */
     GZ_DEFAULT_COMPRESSION, /* zlevel, compress level, -1..9  */
+    0,          /* nthreads, 0 means decode while parsing     */
+    0,          /* zthreads, 0 means compress as one stream   */
 
     NULL,       /* da_list, list of DA indices to store       */
     0,          /* da_len, length of da_list                  */
@@ -153,11 +215,18 @@ static gxml_data GXD = {
     0,          /* xlen, length of current xform buffer       */
     0,          /* dlen, length of current Data buffer        */
     0,          /* doff, offset into current data buffer      */
+    0,          /* mod_prev, flag: can modify last value      */
     0,          /* zlen, length of compression buffer         */
     NULL,       /* cdata, CDATA char pointer                  */
     NULL,       /* xdata, xform buffer pointer                */
     NULL,       /* ddata, Data buffer pointer                 */
     NULL,       /* zdata, compression buffer pointer          */
+    0,          /* npending, number of deferred decodes       */
+    0,          /* apending, allocated deferred decodes       */
+    NULL,       /* pending, deferred DataArray decodes        */
+    NULL,       /* map, mapped input file                     */
+    0,          /* maplen, length of mapped file              */
+    NULL,       /* parser, XML parser of the input file       */
     NULL        /* gim, gifti_image *, for results            */
 };
 
@@ -228,19 +297,445 @@ static unsigned char b64_decode_table[256] = {
     128, 128, 128, 128, 128, 128, 128, 128    /* 248 - 255 */
 };
 
+/*--- Base64 block codec, vectorized when the CPU allows it ---
+ *
+ * The SSE4.1 and AVX2 kernels handle the bulk of the data, leaving any
+ * remainder (or any block with characters outside the base64 alphabet) to
+ * the scalar code, so the results match the table based code exactly.
+ * The kernel is chosen at run time, in b64_simd_level().
+ */
+#if ( defined(__clang__) || ( defined(__GNUC__) && \
+      ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) ) ) ) && \
+    ( defined(__x86_64__) || defined(__i386__) ) && !defined(GIFTI_NO_SIMD)
+#define GXML_B64_SIMD 1
+#include <immintrin.h>
+#endif
+
+#define GXML_B64_SCALAR 0
+#define GXML_B64_SSE41  1
+#define GXML_B64_AVX2   2
+
+static int g_b64_simd = -1;     /* kernel level, -1 until first use */
+
+static void init_b64_simd_level(void)
+{
+    int level = GXML_B64_SCALAR;
+#ifdef GXML_B64_SIMD
+    __builtin_cpu_init();
+    if     ( __builtin_cpu_supports("avx2") )   level = GXML_B64_AVX2;
+    else if( __builtin_cpu_supports("sse4.1") ) level = GXML_B64_SSE41;
+#endif
+    g_b64_simd = level;
+}
+
+/* the level is set once, even if several threads decode at first */
+static int b64_simd_level(void)
+{
+#ifdef HAVE_PTHREAD
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    (void)pthread_once(&once, init_b64_simd_level);
+#else
+    if( g_b64_simd < 0 ) init_b64_simd_level();
+#endif
+    return g_b64_simd;
+}
+
+#ifdef GXML_B64_SIMD
+/* bytes not in [A-Za-z0-9+/] have (lo & hi) set, with lo and hi looked up
+   by their low and high nibbles; roll maps the valid ones to 0..63 */
+#define GXML_B64_LUT_LO 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, \
+                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+#define GXML_B64_LUT_HI 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, \
+                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+#define GXML_B64_LUT_ROLL 0, 16, 19, 4, -65, -65, -71, -71, \
+                          0,  0,  0, 0,   0,   0,   0,   0
+#define GXML_B64_DEC_SHUF 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, \
+                          -1, -1, -1, -1
+#define GXML_B64_ENC_SHUF 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+#define GXML_B64_ENC_LUT  65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, \
+                          -19, -16, 0, 0
+
+/* return the mask of the bytes that b64_decode_table marks as invalid */
+__attribute__((target("sse4.1")))
+static int b64_bad_mask_sse41(__m128i str)
+{
+    const __m128i lut_lo = _mm_setr_epi8(GXML_B64_LUT_LO);
+    const __m128i lut_hi = _mm_setr_epi8(GXML_B64_LUT_HI);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, _mm_and_si128(str, nibble));
+    __m128i hi = _mm_shuffle_epi8(lut_hi,
+                          _mm_and_si128(_mm_srli_epi32(str, 4), nibble));
+    __m128i good = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+    /* '=' is valid in the table (as 0) */
+    good = _mm_or_si128(good, _mm_cmpeq_epi8(str, _mm_set1_epi8('=')));
+    return ~_mm_movemask_epi8(good) & 0xFFFF;
+}
+
+__attribute__((target("avx2")))
+static unsigned b64_bad_mask_avx2(__m256i str)
+{
+    const __m256i lut_lo = _mm256_setr_epi8(GXML_B64_LUT_LO, GXML_B64_LUT_LO);
+    const __m256i lut_hi = _mm256_setr_epi8(GXML_B64_LUT_HI, GXML_B64_LUT_HI);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(str, nibble));
+    __m256i hi = _mm256_shuffle_epi8(lut_hi,
+                          _mm256_and_si256(_mm256_srli_epi32(str, 4), nibble));
+    __m256i good = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi),
+                                     _mm256_setzero_si256());
+    good = _mm256_or_si256(good, _mm256_cmpeq_epi8(str,_mm256_set1_epi8('=')));
+    return ~(unsigned)_mm256_movemask_epi8(good);
+}
+
+/* count (or detect) bad chars in whole blocks, return bytes processed */
+__attribute__((target("sse4.1")))
+static long long b64_count_bad_sse41(const unsigned char * src, long long len,
+                                     int first_only, long long * nbad)
+{
+    long long c;
+    for( c = 0; c + 16 <= len; c += 16 ) {
+        int mask = b64_bad_mask_sse41(_mm_loadu_si128((const __m128i*)(src+c)));
+        if( mask ) {
+            *nbad += __builtin_popcount(mask);
+            if( first_only ) return c + 16;
+        }
+    }
+    return c;
+}
+
+__attribute__((target("avx2")))
+static long long b64_count_bad_avx2(const unsigned char * src, long long len,
+                                    int first_only, long long * nbad)
+{
+    long long c;
+    for( c = 0; c + 32 <= len; c += 32 ) {
+        unsigned mask = b64_bad_mask_avx2(
+                            _mm256_loadu_si256((const __m256i*)(src+c)));
+        if( mask ) {
+            *nbad += __builtin_popcount(mask);
+            if( first_only ) return c + 32;
+        }
+    }
+    return c;
+}
+
+/* copy whole blocks without bad chars, stopping at any other one
+   (dest may be src), return bytes processed and set *ndone to written */
+__attribute__((target("sse4.1")))
+static long long b64_copy_valid_sse41(const unsigned char * src, long long len,
+                                      unsigned char * dest, long long * ndone)
+{
+    long long c;
+    for( c = 0; c + 16 <= len; c += 16 ) {
+        __m128i str = _mm_loadu_si128((const __m128i*)(src+c));
+        if( b64_bad_mask_sse41(str) ) break;
+        _mm_storeu_si128((__m128i*)(dest + *ndone), str);
+        *ndone += 16;
+    }
+    return c;
+}
+
+__attribute__((target("avx2")))
+static long long b64_copy_valid_avx2(const unsigned char * src, long long len,
+                                     unsigned char * dest, long long * ndone)
+{
+    long long c;
+    for( c = 0; c + 32 <= len; c += 32 ) {
+        __m256i str = _mm256_loadu_si256((const __m256i*)(src+c));
+        if( b64_bad_mask_avx2(str) ) break;
+        _mm256_storeu_si256((__m256i*)(dest + *ndone), str);
+        *ndone += 32;
+    }
+    return c;
+}
+
+/* decode 4 quads (16 chars) at a time, while at least 16 output bytes can
+   be stored, stopping at any block that is not pure base64
+   return the number of quads decoded */
+__attribute__((target("sse4.1")))
+static long long b64_decode_sse41(const unsigned char * src, long long nquads,
+                                  unsigned char * dest)
+{
+    const __m128i lut_lo   = _mm_setr_epi8(GXML_B64_LUT_LO);
+    const __m128i lut_hi   = _mm_setr_epi8(GXML_B64_LUT_HI);
+    const __m128i lut_roll = _mm_setr_epi8(GXML_B64_LUT_ROLL);
+    const __m128i shuf     = _mm_setr_epi8(GXML_B64_DEC_SHUF);
+    const __m128i mask_2F  = _mm_set1_epi8(0x2F);
+    long long     q;
+
+    for( q = 0; nquads - q >= 6; q += 4 ) {
+        __m128i str = _mm_loadu_si128((const __m128i *)(src + 4*q));
+        __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2F);
+        __m128i lo_nibbles = _mm_and_si128(str, mask_2F);
+        __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+        __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        __m128i roll;
+
+        if( !_mm_testz_si128(lo, hi) ) break;
+
+        roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(
+                                _mm_cmpeq_epi8(str, mask_2F), hi_nibbles));
+        str = _mm_add_epi8(str, roll);
+
+        /* pack 4 6-bit values into 3 bytes */
+        str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+        str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+        str = _mm_shuffle_epi8(str, shuf);
+        _mm_storeu_si128((__m128i *)(dest + 3*q), str);
+    }
+    return q;
+}
+
+__attribute__((target("avx2")))
+static long long b64_decode_avx2(const unsigned char * src, long long nquads,
+                                 unsigned char * dest)
+{
+    const __m256i lut_lo   = _mm256_setr_epi8(GXML_B64_LUT_LO, GXML_B64_LUT_LO);
+    const __m256i lut_hi   = _mm256_setr_epi8(GXML_B64_LUT_HI, GXML_B64_LUT_HI);
+    const __m256i lut_roll = _mm256_setr_epi8(GXML_B64_LUT_ROLL,
+                                              GXML_B64_LUT_ROLL);
+    const __m256i shuf     = _mm256_setr_epi8(GXML_B64_DEC_SHUF,
+                                              GXML_B64_DEC_SHUF);
+    const __m256i mask_2F  = _mm256_set1_epi8(0x2F);
+    long long     q;
+
+    for( q = 0; nquads - q >= 11; q += 8 ) {
+        __m256i str = _mm256_loadu_si256((const __m256i *)(src + 4*q));
+        __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str,4),mask_2F);
+        __m256i lo_nibbles = _mm256_and_si256(str, mask_2F);
+        __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+        __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        __m256i roll;
+
+        if( !_mm256_testz_si256(lo, hi) ) break;
+
+        roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(
+                                   _mm256_cmpeq_epi8(str, mask_2F), hi_nibbles));
+        str = _mm256_add_epi8(str, roll);
+
+        str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+        str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+        str = _mm256_shuffle_epi8(str, shuf);
+        str = _mm256_permutevar8x32_epi32(str,
+                                  _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256((__m256i *)(dest + 3*q), str);
+    }
+    return q;
+}
+
+/* encode 3-byte blocks, while at least 16 (or 28) source bytes can be read,
+   return the number of blocks encoded */
+__attribute__((target("sse4.1")))
+static long long b64_encode_sse41(const unsigned char * src, long long nblocks,
+                                  unsigned char * dest)
+{
+    const __m128i shuf = _mm_setr_epi8(GXML_B64_ENC_SHUF);
+    const __m128i lut  = _mm_setr_epi8(GXML_B64_ENC_LUT);
+    long long     b;
+
+    for( b = 0; 3*(nblocks - b) >= 16; b += 4 ) {
+        __m128i in = _mm_loadu_si128((const __m128i *)(src + 3*b));
+        __m128i t0, t1, ind;
+
+        in = _mm_shuffle_epi8(in, shuf);
+        t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)),
+                             _mm_set1_epi32(0x04000040));
+        t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)),
+                             _mm_set1_epi32(0x01000010));
+        in = _mm_or_si128(t0, t1);      /* 6-bit values */
+
+        ind = _mm_subs_epu8(in, _mm_set1_epi8(51));
+        ind = _mm_sub_epi8(ind, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+        in  = _mm_add_epi8(in, _mm_shuffle_epi8(lut, ind));
+        _mm_storeu_si128((__m128i *)(dest + 4*b), in);
+    }
+    return b;
+}
+
+__attribute__((target("avx2")))
+static long long b64_encode_avx2(const unsigned char * src, long long nblocks,
+                                 unsigned char * dest)
+{
+    const __m256i shuf = _mm256_setr_epi8(GXML_B64_ENC_SHUF, GXML_B64_ENC_SHUF);
+    const __m256i lut  = _mm256_setr_epi8(GXML_B64_ENC_LUT, GXML_B64_ENC_LUT);
+    long long     b;
+
+    for( b = 0; 3*(nblocks - b) >= 28; b += 8 ) {
+        __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(
+                        _mm_loadu_si128((const __m128i *)(src + 3*b))),
+                        _mm_loadu_si128((const __m128i *)(src + 3*b + 12)), 1);
+        __m256i t0, t1, ind;
+
+        in = _mm256_shuffle_epi8(in, shuf);
+        t0 = _mm256_mulhi_epu16(_mm256_and_si256(in,
+                                    _mm256_set1_epi32(0x0FC0FC00)),
+                                _mm256_set1_epi32(0x04000040));
+        t1 = _mm256_mullo_epi16(_mm256_and_si256(in,
+                                    _mm256_set1_epi32(0x003F03F0)),
+                                _mm256_set1_epi32(0x01000010));
+        in = _mm256_or_si256(t0, t1);
+
+        ind = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+        ind = _mm256_sub_epi8(ind, _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+        in  = _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, ind));
+        _mm256_storeu_si256((__m256i *)(dest + 4*b), in);
+    }
+    return b;
+}
+#endif /* GXML_B64_SIMD */
+
+/* return the number of bad base64 chars in src, or 1 if any is found and
+   first_only is set */
+static long long b64_count_bad(const char * src, long long len, int first_only)
+{
+    const unsigned char * usrc = (const unsigned char *)src;
+    long long             c = 0, nbad = 0;
+
+#ifdef GXML_B64_SIMD
+    if( b64_simd_level() == GXML_B64_AVX2 )
+        c = b64_count_bad_avx2(usrc, len, first_only, &nbad);
+    else if( b64_simd_level() == GXML_B64_SSE41 )
+        c = b64_count_bad_sse41(usrc, len, first_only, &nbad);
+    if( first_only && nbad ) return 1;
+#endif
+
+    for( ; c < len; c++ )
+        if( b64_decode_table[usrc[c]] == (unsigned char)0x80 ) {
+            nbad++;
+            if( first_only ) break;
+        }
+
+    return nbad;
+}
+
+/* copy the good base64 chars of src to dest (which may be src), counting
+   the bad ones in *nbad (if set), and return the number of chars copied */
+static long long b64_copy_valid(const char * src, long long len, char * dest,
+                                long long * nbad)
+{
+    const unsigned char * usrc = (const unsigned char *)src;
+    unsigned char       * udest = (unsigned char *)dest;
+    long long             c = 0, ndone = 0, bad = 0;
+    int                   level = b64_simd_level();
+
+    while( c < len ) {
+#ifdef GXML_B64_SIMD
+        /* take whole clean blocks at once, then handle one block of chars */
+        int width = 0;
+        if( level == GXML_B64_AVX2 ) {
+            c += b64_copy_valid_avx2(usrc + c, len - c, udest, &ndone);
+            width = 32;
+        } else if( level == GXML_B64_SSE41 ) {
+            c += b64_copy_valid_sse41(usrc + c, len - c, udest, &ndone);
+            width = 16;
+        }
+        if( width ) {
+            long long end = c + width < len ? c + width : len;
+            for( ; c < end; c++ ) {
+                if( b64_decode_table[usrc[c]] == (unsigned char)0x80 ) bad++;
+                else udest[ndone++] = usrc[c];
+            }
+            continue;
+        }
+#endif
+        if( b64_decode_table[usrc[c]] == (unsigned char)0x80 ) bad++;
+        else udest[ndone++] = usrc[c];
+        c++;
+    }
+    (void)level;
+
+    if( nbad ) *nbad = bad;
+    return ndone;
+}
+
+#undef GII_B64_decode4
+#define GII_B64_decode4(w,x,y,z,a,b,c)                                  \
+     ( a = (b64_decode_table[w] << 2) | (b64_decode_table[x] >> 4) ,    \
+       b = (b64_decode_table[x] << 4) | (b64_decode_table[y] >> 2) ,    \
+       c = (b64_decode_table[y] << 6) | b64_decode_table[z]         )
+
+/* decode nquads 4-char quads of src into 3*nquads bytes of dest */
+static void b64_decode_quads(const char * src, long long nquads, char * dest)
+{
+    const unsigned char * din = (const unsigned char *)src;
+    unsigned char       * dout = (unsigned char *)dest;
+    long long             q = 0;
+
+    while( q < nquads ) {
+#ifdef GXML_B64_SIMD
+        /* vector blocks, then one quad at a time until past a bad block */
+        long long n = 0, end;
+        if( b64_simd_level() == GXML_B64_AVX2 ) {
+            n = b64_decode_avx2(din, nquads - q, dout);
+            end = 8;
+        } else if( b64_simd_level() == GXML_B64_SSE41 ) {
+            n = b64_decode_sse41(din, nquads - q, dout);
+            end = 4;
+        } else end = nquads - q;
+        q += n; din += 4*n; dout += 3*n;
+        end = q + end < nquads ? q + end : nquads;
+#else
+        long long end = nquads;
+#endif
+        for( ; q < end; q++, din += 4, dout += 3 )
+            GII_B64_decode4(din[0],din[1],din[2],din[3],dout[0],dout[1],dout[2]);
+    }
+}
+
+#undef GII_B64_encode3
+#define GII_B64_encode3(a,b,c,w,x,y,z)                       \
+     ( w = b64_encode_table[(a)>>2]                      ,   \
+       x = b64_encode_table[((a & 3) << 4) | (b >> 4)]   ,   \
+       y = b64_encode_table[((b & 0xF) << 2) | (c >> 6)] ,   \
+       z = b64_encode_table[c & 0x3F]                     )
+
+/* encode len bytes of src into 4*((len+2)/3) chars of dest, with padding */
+static long long b64_encode(const void * src, long long len, char * dest)
+{
+    const unsigned char * din = (const unsigned char *)src;
+    unsigned char       * dout = (unsigned char *)dest;
+    long long             b = 0, nblocks = len/3;
+    int                   rem = len % 3;
+
+#ifdef GXML_B64_SIMD
+    if( b64_simd_level() == GXML_B64_AVX2 )
+        b = b64_encode_avx2(din, nblocks, dout);
+    else if( b64_simd_level() == GXML_B64_SSE41 )
+        b = b64_encode_sse41(din, nblocks, dout);
+    din += 3*b; dout += 4*b;
+#endif
+
+    for( ; b < nblocks; b++, din += 3, dout += 4 )
+        GII_B64_encode3(din[0],din[1],din[2],dout[0],dout[1],dout[2],dout[3]);
+
+    /* finish off the last bytes */
+    if( rem == 1 ) {
+        GII_B64_encode3(din[0], 0, 0, dout[0], dout[1], dout[2], dout[3]);
+        dout[2] = dout[3] = '=';
+    } else if ( rem == 2 ) {
+        GII_B64_encode3(din[0], din[1], 0, dout[0], dout[1], dout[2], dout[3]);
+        dout[3] = '=';
+    }
+
+    return 4*(nblocks + (rem ? 1 : 0));
+}
+
 /* note: the buffer needs to be large enough to contain any contiguous
          piece of (CDATA?) text, o.w. it will require parsing in pieces */
-gifti_image * gxml_read_image(const char * fname, int read_data,
-                             const int * dalist, int dalen)
+gifti_image * gxml_read_image(const gifti_context * ctx, const char * fname,
+                              int read_data, const int * dalist, int dalen)
 {
-    gxml_data  * xd = &GXD;     /* point to global struct */
+    gxml_data    xdata;         /* parsing state, local for reentrancy */
+    gxml_data  * xd = &xdata;
     XML_Parser   parser;
     unsigned     blen;
-    FILE       * fp;
+    FILE       * fp = NULL;
     char       * buf = NULL;
+    const char * text;
+    long long    moff = 0;      /* offset of next mapped slice */
     int          bsize;    /* be sure it doesn't change at some point */
     int          done = 0, pcount = 1;
  
+    init_gxml_user_vars(xd, ctx);
     if( init_gxml_data(xd, 0, dalist, dalen) ) /* reset non-user variables */
         return NULL;
 
@@ -251,20 +746,27 @@ gifti_image * gxml_read_image(const char * fname, int read_data,
         return NULL;
     }
 
-    fp = fopen(fname, "r");
-    if( !fp ) {
-        fprintf(stderr,"** failed to open GIFTI XML file '%s'\n", fname);
-        return NULL;
-    }
-
-    /* create a new buffer */
+    /* parse straight from a mapping of the file, if possible, so that
+       Data text can be decoded where it lies, else read it in pieces */
     bsize = 0;
-    if( reset_xml_buf(xd, &buf, &bsize) ) { fclose(fp); return NULL; }
+    xd->map = map_xml_file(fname, &xd->maplen);
+    if( !xd->map ) {
+        fp = fopen(fname, "r");
+        if( !fp ) {
+            fprintf(stderr,"** failed to open GIFTI XML file '%s'\n", fname);
+            return NULL;
+        }
+
+        /* create a new buffer */
+        if( reset_xml_buf(xd, &buf, &bsize) ) { fclose(fp); return NULL; }
+    }
 
     if(xd->verb > 1) {
         fprintf(stderr,"-- reading gifti image '%s'\n", fname);
         if(xd->da_list) fprintf(stderr,"   (length %d DA list)\n", xd->da_len);
-        fprintf(stderr,"-- using %d byte XML buffer\n",bsize);
+        if(xd->map) fprintf(stderr,"-- using %lld byte file mapping\n",
+                            xd->maplen);
+        else        fprintf(stderr,"-- using %d byte XML buffer\n",bsize);
         if(xd->verb > 4) show_enames(stderr);
     }
 
@@ -272,24 +774,37 @@ gifti_image * gxml_read_image(const char * fname, int read_data,
     xd->gim = (gifti_image *)calloc(1,sizeof(gifti_image));
     if( !xd->gim ) {
         fprintf(stderr,"** failed to alloc initial gifti_image\n");
-        free(buf);
+        if( fp ) fclose(fp);
+        if( buf ) free(buf);
+        unmap_xml_file(xd->map, xd->maplen);
         return NULL;
     }
 
     /* create parser, init handlers */
     parser = init_xml_parser((void *)xd);
+    xd->parser = parser;
 
     while( !done )
     {
-        if( reset_xml_buf(xd, &buf, &bsize) )  /* fail out */
-            { gifti_free_image(xd->gim); xd->gim = NULL; break; }
+        if( xd->map ) {
+            /* expat copies what it is given, so go in large slices */
+            blen = xd->maplen - moff > GXML_MAP_SLICE ? GXML_MAP_SLICE :
+                                                   (unsigned)(xd->maplen - moff);
+            text = xd->map + moff;
+            moff += blen;
+            done = moff >= xd->maplen;
+        } else {
+            if( reset_xml_buf(xd, &buf, &bsize) )  /* fail out */
+                { gifti_free_image(xd->gim); xd->gim = NULL; break; }
 
-        blen = fread(buf, 1, bsize, fp);
-        done = blen < sizeof(buf);
+            blen = fread(buf, 1, bsize, fp);
+            done = blen < (unsigned)bsize;
+            text = buf;
+        }
 
         if(xd->verb > 3) fprintf(stderr,"-- XML_Parse # %d\n", pcount);
         pcount++;
-        if( XML_Parse(parser, buf, blen, done) == XML_STATUS_ERROR) {
+        if( XML_Parse(parser, text, blen, done) == XML_STATUS_ERROR) {
             fprintf(stderr,"** %s at line %u\n",
                     XML_ErrorString(XML_GetErrorCode(parser)),
                     (unsigned int)XML_GetCurrentLineNumber(parser));
@@ -307,9 +822,13 @@ gifti_image * gxml_read_image(const char * fname, int read_data,
         else fprintf(stderr,"** gifti image '%s', failure\n", fname);
     }
 
-    fclose(fp);
+    if( fp ) fclose(fp);
     if( buf ) free(buf);        /* parser buffer */
     XML_ParserFree(parser);
+    xd->parser = NULL;
+
+    /* decode any DataArrays whose text was only stored while parsing */
+    if( xd->gim && xd->npending > 0 ) (void)decode_pending(xd);
 
     if( dalist && xd->da_list )
         if( apply_da_list_order(xd, dalist, dalen) ) {
@@ -320,10 +839,53 @@ gifti_image * gxml_read_image(const char * fname, int read_data,
 
     free_xd_data(xd);  /* free data buffers */
 
+    /* pending text may have pointed into the mapping, so unmap it last */
+    unmap_xml_file(xd->map, xd->maplen);
+
     return xd->gim;
 }
 
 
+/* map a whole file for reading, returning NULL if it cannot be mapped */
+static const char * map_xml_file(const char * fname, long long * len)
+{
+#ifdef GXML_HAVE_MMAP
+    struct stat   st;
+    void        * addr = NULL;
+    int           fd;
+
+    *len = 0;
+    fd = open(fname, O_RDONLY);
+    if( fd < 0 ) return NULL;
+
+    /* an empty file cannot be mapped, and is left to fread() */
+    if( fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        (long long)(size_t)st.st_size == (long long)st.st_size ) {
+        addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if( addr == MAP_FAILED ) addr = NULL;
+        else                     *len = (long long)st.st_size;
+    }
+    close(fd);
+
+    return (const char *)addr;
+#else
+    (void)fname;
+    *len = 0;
+    return NULL;
+#endif
+}
+
+
+static void unmap_xml_file(const char * map, long long len)
+{
+#ifdef GXML_HAVE_MMAP
+    if( map ) munmap((void *)map, (size_t)len);
+#else
+    (void)map; (void)len;
+#endif
+}
+
+
 /* free da_list and buffers */
 static int free_xd_data(gxml_data * xd)
 {
@@ -333,6 +895,16 @@ static int free_xd_data(gxml_data * xd)
     if( xd->zdata) { free(xd->zdata); xd->zdata = NULL; } /* compress buff */
     if( xd->ddata ){ free(xd->ddata); xd->ddata = NULL; } /* Data buffer   */
 
+    if( xd->pending ){                                    /* deferred text */
+        int c;
+        for( c = 0; c < xd->npending; c++ )
+            if( xd->pending[c].text.nalloc ) free(xd->pending[c].text.buf);
+        free(xd->pending);
+        xd->pending = NULL;
+    }
+    xd->npending = 0;
+    xd->apending = 0;
+
     return 0;
 }
 
@@ -418,9 +990,11 @@ static int apply_da_list_order(gxml_data * xd, const int * orig, int len)
 
 
 /* return 0 on success */
-int gxml_write_image(gifti_image * gim, const char * fname, int write_data)
+int gxml_write_image(const gifti_context * ctx, gifti_image * gim,
+                     const char * fname, int write_data)
 {
-    gxml_data * xd = &GXD;     /* point to global struct */
+    gxml_data   xdata;         /* writing state, local for reentrancy */
+    gxml_data * xd = &xdata;
     FILE      * fp;
 
     if( !gim ) {
@@ -431,7 +1005,9 @@ int gxml_write_image(gifti_image * gim, const char * fname, int write_data)
         return 1;
     }
 
-    if(GXD.verb > 1) {
+    init_gxml_user_vars(xd, ctx);
+
+    if(xd->verb > 1) {
         fprintf(stderr,"++ writing gifti image (%s data) to '%s'",
                 write_data?"with":"no", fname);
         if( write_data )
@@ -477,6 +1053,618 @@ int gxml_write_image(gifti_image * gim, const char * fname, int write_data)
 }
 
 
+/*----------------------------------------------------------------------
+ * streaming write: the meta data of the image are written when opening
+ * the stream, then each DataArray is begun, given its data in chunks of
+ * any size and ended, in order.  The data are encoded as they arrive,
+ * so they need not be stored in the gifti_image.
+ *
+ * ExternalFileBinary data are only counted, the caller writes them.
+ *
+ * return a new stream on success, NULL on failure
+ *----------------------------------------------------------------------*/
+gifti_stream * gxml_stream_open(const gifti_context * ctx, gifti_image * gim,
+                                const char * fname)
+{
+    gifti_stream * gs;
+
+    if( !gim ) {
+        fprintf(stderr,"** GXML stream: no gifti_image\n");
+        return NULL;
+    } else if ( !fname ) {
+        fprintf(stderr,"** GXML stream: no filename\n");
+        return NULL;
+    }
+
+    gs = (gifti_stream *)calloc(1, sizeof(gifti_stream));
+    if( !gs ) {
+        fprintf(stderr,"** failed to alloc gifti_stream\n");
+        return NULL;
+    }
+
+    init_gxml_user_vars(&gs->xd, ctx);     /* set the user variables */
+    init_gxml_data(&gs->xd, 0, NULL, 0);   /* reset non-user variables */
+
+    if(gs->xd.verb > 1)
+        fprintf(stderr,"++ streaming gifti image (%d DA elements) to '%s'\n",
+                gim->numDA, fname);
+    gs->xd.gim = gim;
+
+#if defined(HAVE_ZLIB) && defined(HAVE_PTHREAD)
+    if( gs->xd.zthreads > 1 ) gs->zthreads = gs->xd.zthreads;
+#endif
+
+    /* note the library version */
+    if( gs->xd.update_ok )
+        gifti_add_to_meta(&gim->meta,"gifticlib-version",gifticlib_version(),1);
+
+    gs->fp = fopen(fname, "w");
+    if( !gs->fp ) {
+        fprintf(stderr,"** failed to open '%s' for gifti write\n", fname);
+        free(gs);
+        return NULL;
+    }
+
+    if( gxml_write_gifti_head(&gs->xd, gs->fp) ) gs->errs++;
+
+    return gs;
+}
+
+/* write the DataArray element up to its data, return 0 on success */
+int gxml_stream_begin_DA(gifti_stream * gs, giiDataArray * da)
+{
+    long long rows, cols, clen;
+    int       spaces;
+
+    if( !gs || !da ) return 1;
+
+    if( gs->da ) {
+        fprintf(stderr,"** GXML stream: DataArray already begun\n");
+        return 1;
+    }
+
+#ifndef HAVE_ZLIB  /* if the data is to be compressed, fail */
+    if( da->encoding == GIFTI_ENCODING_B64GZ ) {
+        fprintf(stderr,"** no ZLIB for compression...\n");
+        da->encoding = GIFTI_ENCODING_B64BIN;
+    }
+#endif
+
+    gs->da     = da;
+    gs->nbytes = 0;
+    gs->ncarry = 0;
+
+    ewrite_darray_head(&gs->xd, da, gs->fp);
+    spaces = gs->xd.indent * gs->xd.depth;
+
+    if( da->encoding == GIFTI_ENCODING_EXTBIN ) { /* then write as empty */
+        fprintf(gs->fp, "%*s<%s/>\n", spaces, "", enames[GXML_ETYPE_DATA]);
+        return 0;
+    }
+
+    fprintf(gs->fp, "%*s<%s>", spaces, "", enames[GXML_ETYPE_DATA]);
+
+    /* ASCII data are written by rows, base64 data by sets of 3 bytes */
+    if( da->encoding == GIFTI_ENCODING_ASCII ) {
+        fprintf(gs->fp, "\n");
+        gifti_DA_rows_cols(da, &rows, &cols);
+        gs->cols = cols;
+        clen = cols * da->nbyper;
+    } else
+        clen = 3;
+
+    if( clen > gs->carry_len ) {
+        gs->carry = (unsigned char *)realloc(gs->carry, clen);
+        if( !gs->carry ) {
+            fprintf(stderr,"** GXML stream: failed to alloc %lld bytes\n",clen);
+            gs->carry_len = 0;
+            gs->errs++;
+            return 1;
+        }
+        gs->carry_len = clen;
+    }
+
+#ifdef HAVE_ZLIB
+    if( da->encoding == GIFTI_ENCODING_B64GZ && gs->zthreads > 1 ) {
+        if( stream_pgz_begin(gs) ) {
+            gs->errs++;
+            return 1;
+        }
+        gs->zinit = 2;
+    } else if( da->encoding == GIFTI_ENCODING_B64GZ ) {
+        if( update_partial_buffer(&gs->xd.zdata, &gs->xd.zlen,
+                                  GXML_STREAM_ZLEN, 1) ) {
+            gs->errs++;
+            return 1;
+        }
+        memset(&gs->zs, 0, sizeof(gs->zs));
+        if( deflateInit(&gs->zs, gs->xd.zlevel) != Z_OK ) {
+            fprintf(stderr,"** zlib compression init failure\n");
+            gs->errs++;
+            return 1;
+        }
+        gs->zinit = 1;
+    }
+#endif
+
+    return 0;
+}
+
+/* encode and write nbytes of data of the current DataArray */
+int gxml_stream_write_DA_data(gifti_stream * gs, const void * data,
+                              long long nbytes)
+{
+    const unsigned char * dp = (const unsigned char *)data;
+    giiDataArray        * da;
+    int                   rv;
+
+    if( !gs || !gs->da ) {
+        fprintf(stderr,"** GXML stream: no DataArray begun\n");
+        return 1;
+    }
+
+    if( nbytes <= 0 ) return 0;
+    if( !data ) return 1;
+
+    da = gs->da;
+    if( gs->nbytes + nbytes > da->nvals * da->nbyper ) {
+        fprintf(stderr,"** GXML stream: %lld bytes past DataArray data\n",
+                gs->nbytes + nbytes - da->nvals * da->nbyper);
+        gs->errs++;
+        return 1;
+    }
+    gs->nbytes += nbytes;
+
+    switch( da->encoding ) {
+        case GIFTI_ENCODING_ASCII:  rv = stream_ascii_data(gs, dp, nbytes);
+                                    break;
+        case GIFTI_ENCODING_B64BIN: rv = stream_b64_data(gs, dp, nbytes);
+                                    break;
+        case GIFTI_ENCODING_B64GZ:
+            if( gs->zinit == 2 ) rv = stream_pgz_data(gs, dp, nbytes);
+            else                 rv = stream_gz_data(gs, dp, nbytes, 0);
+            break;
+        case GIFTI_ENCODING_EXTBIN: rv = 0;     /* written by the caller */
+                                    break;
+        default:
+            fprintf(stderr,"** unknown data encoding, %d\n", da->encoding);
+            rv = 1;
+            break;
+    }
+
+    if( rv ) gs->errs++;
+
+    return rv;
+}
+
+/* flush the data of the current DataArray and close its element */
+int gxml_stream_end_DA(gifti_stream * gs)
+{
+    giiDataArray * da;
+    char           obuf[4];
+    long long      olen;
+    int            spaces, errs = 0;
+
+    if( !gs || !gs->da ) {
+        fprintf(stderr,"** GXML stream: no DataArray begun\n");
+        return 1;
+    }
+
+    da = gs->da;
+    spaces = gs->xd.indent * gs->xd.depth;
+
+    if( gs->nbytes != da->nvals * da->nbyper ) {
+        fprintf(stderr,"** GXML stream: wrote %lld of %lld DataArray bytes\n",
+                gs->nbytes, da->nvals * da->nbyper);
+        errs++;
+    }
+
+    if( da->encoding == GIFTI_ENCODING_B64GZ ) {
+        if( gs->zinit == 2 ) {
+            unsigned char trailer[4];  /* adler32 of the data, big endian */
+            if( stream_pgz_batch(gs, 1) ) errs++;
+            trailer[0] = (gs->adler >> 24) & 0xff;
+            trailer[1] = (gs->adler >> 16) & 0xff;
+            trailer[2] = (gs->adler >>  8) & 0xff;
+            trailer[3] =  gs->adler        & 0xff;
+            if( stream_b64_data(gs, trailer, 4) ) errs++;
+            gs->zinit = 0;
+        } else if( gs->zinit ) {
+            if( stream_gz_data(gs, NULL, 0, 1) ) errs++;
+#ifdef HAVE_ZLIB
+            deflateEnd(&gs->zs);
+#endif
+            gs->zinit = 0;
+        }
+    }
+
+    if( da->encoding == GIFTI_ENCODING_B64BIN ||
+        da->encoding == GIFTI_ENCODING_B64GZ ) {
+        if( gs->ncarry > 0 ) {     /* the last, padded, set */
+            olen = b64_encode(gs->carry, gs->ncarry, obuf);
+            if( fwrite(obuf, 1, olen, gs->fp) != (size_t)olen ) errs++;
+        }
+    } else if( da->encoding == GIFTI_ENCODING_ASCII )
+        fprintf(gs->fp, "%*s", spaces, "");
+
+    gs->ncarry = 0;
+
+    if( da->encoding != GIFTI_ENCODING_EXTBIN )
+        fprintf(gs->fp, "</%s>\n", enames[GXML_ETYPE_DATA]);
+
+    ewrite_darray_tail(&gs->xd, gs->fp);
+    gs->da = NULL;
+
+    gs->errs += errs;
+
+    return errs;
+}
+
+/* close the GIFTI element and the file, and free the stream
+ * return the number of errors met while streaming */
+int gxml_stream_close(gifti_stream * gs)
+{
+    int errs;
+
+    if( !gs ) return 1;
+
+    if( gs->da ) {
+        fprintf(stderr,"** GXML stream: closing with DataArray not ended\n");
+        gxml_stream_end_DA(gs);
+        gs->errs++;
+    }
+
+    gxml_write_gifti_tail(&gs->xd, gs->fp);
+
+    if( ferror(gs->fp) ) gs->errs++;
+    if( fclose(gs->fp) ) gs->errs++;
+
+    if( gs->errs )
+        fprintf(stderr,"** GXML stream: %d errors writing gifti image\n",
+                gs->errs);
+
+    errs = gs->errs;
+    if( gs->xd.zdata ) free(gs->xd.zdata);
+    if( gs->carry )    free(gs->carry);
+    if( gs->zbatch )   free(gs->zbatch);
+    if( gs->zchunks ) {
+        int c;
+        for( c = 0; c < gs->zthreads; c++ )
+            if( gs->zchunks[c].out ) free(gs->zchunks[c].out);
+        free(gs->zchunks);
+    }
+    free(gs);
+
+    return errs;
+}
+
+/* write whole ASCII rows, carrying a partial row to the next call */
+static int stream_ascii_data(gifti_stream * gs, const unsigned char * data,
+                             long long len)
+{
+    giiDataArray * da = gs->da;
+    long long      rowlen = gs->cols * da->nbyper, clen;
+    int            spaces = gs->xd.indent * (gs->xd.depth + 1);
+
+    while( len > 0 ) {
+        /* whole rows can be formatted straight from the caller's data */
+        if( gs->ncarry == 0 && len >= rowlen ) {
+            clen = len / rowlen;
+            if( ewrite_data_rows(data, da->datatype, 0, clen, gs->cols,
+                                 spaces, gs->fp) )
+                return 1;
+            data += clen * rowlen;
+            len -= clen * rowlen;
+            continue;
+        }
+
+        clen = rowlen - gs->ncarry;
+        if( clen > len ) clen = len;
+
+        memcpy(gs->carry + gs->ncarry, data, clen);
+        gs->ncarry += clen;
+        data += clen;
+        len -= clen;
+
+        if( gs->ncarry == rowlen ) {
+            if( ewrite_data_rows(gs->carry, da->datatype, 0, 1, gs->cols,
+                                 spaces, gs->fp) )
+                return 1;
+            gs->ncarry = 0;
+        }
+    }
+
+    return 0;
+}
+
+/* base64 encode whole 3-byte sets, carrying the rest to the next call */
+static int stream_b64_data(gifti_stream * gs, const unsigned char * data,
+                           long long len)
+{
+    char      obuf[4*GXML_B64_ENC_BLOCK];
+    long long c, clen, olen, whole;
+
+    /* first complete a carried set */
+    if( gs->ncarry > 0 ) {
+        while( gs->ncarry < 3 && len > 0 ) {
+            gs->carry[gs->ncarry++] = *data++;
+            len--;
+        }
+        if( gs->ncarry < 3 ) return 0;
+
+        olen = b64_encode(gs->carry, 3, obuf);
+        if( fwrite(obuf, 1, olen, gs->fp) != (size_t)olen ) return 1;
+        gs->ncarry = 0;
+    }
+
+    whole = len - len % 3;
+    for( c = 0; c < whole; c += clen ) {
+        clen = whole - c < 3*GXML_B64_ENC_BLOCK ? whole - c
+                                                : 3*GXML_B64_ENC_BLOCK;
+        olen = b64_encode(data + c, clen, obuf);
+        if( fwrite(obuf, 1, olen, gs->fp) != (size_t)olen ) return 1;
+    }
+
+    if( len > whole ) {
+        memcpy(gs->carry, data + whole, len - whole);
+        gs->ncarry = len - whole;
+    }
+
+    return 0;
+}
+
+/* compress data into the base64 stream, finishing it if 'finish' is set */
+static int stream_gz_data(gifti_stream * gs, const unsigned char * data,
+                          long long len, int finish)
+{
+#ifdef HAVE_ZLIB
+    long long clen;
+    int       flush, rv;
+
+    do {
+        /* avail_in is only an unsigned int */
+        clen = len > GXML_MAX_DECODE_LEN ? GXML_MAX_DECODE_LEN : len;
+        gs->zs.next_in  = (Bytef *)data;
+        gs->zs.avail_in = (uInt)clen;
+        data += clen;
+        len -= clen;
+        flush = ( finish && len == 0 ) ? Z_FINISH : Z_NO_FLUSH;
+
+        do {
+            gs->zs.next_out  = (Bytef *)gs->xd.zdata;
+            gs->zs.avail_out = gs->xd.zlen;
+            rv = deflate(&gs->zs, flush);
+            if( rv == Z_STREAM_ERROR ) {
+                fprintf(stderr,"** zlib compression failure\n");
+                return 1;
+            }
+            if( stream_b64_data(gs, (unsigned char *)gs->xd.zdata,
+                                gs->xd.zlen - gs->zs.avail_out) )
+                return 1;
+        } while( gs->zs.avail_out == 0 );
+    } while( len > 0 );
+
+    return 0;
+#else
+    (void)gs; (void)data; (void)len; (void)finish;
+    fprintf(stderr,"** stream_gz_data: no ZLIB to compress with\n");
+    return 1;
+#endif
+}
+
+/*----------------------------------------------------------------------
+ * parallel compression of streamed data, as pigz does: the data are
+ * gathered in batches of one chunk per thread, and each chunk is
+ * compressed on its own as raw deflate data, with the 32 KB preceding it
+ * as dictionary.  All but the last chunk end with a sync flush, on a
+ * byte boundary, so that the compressed chunks concatenate into one
+ * deflate stream, wrapped in the zlib header and adler32 checksum that
+ * uncompress() expects.
+ *----------------------------------------------------------------------*/
+#if defined(HAVE_ZLIB) && defined(HAVE_PTHREAD)
+typedef struct {
+    gxml_zchunk     * chunks;
+    int               nchunks;
+    int               next;     /* next chunk to compress */
+    pthread_mutex_t   lock;
+} gxml_zchunk_pool;
+
+static void * deflate_zchunk_thread(void * arg)
+{
+    gxml_zchunk_pool * pool = (gxml_zchunk_pool *)arg;
+    int                ind;
+
+    for( ;; ) {
+        pthread_mutex_lock(&pool->lock);
+        ind = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if( ind >= pool->nchunks ) break;
+        (void)deflate_zchunk(pool->chunks + ind);
+    }
+
+    return NULL;
+}
+#endif
+
+/* allocate the batch buffers and write the zlib header */
+static int stream_pgz_begin(gifti_stream * gs)
+{
+#if defined(HAVE_ZLIB) && defined(HAVE_PTHREAD)
+    unsigned char head[2];
+    unsigned int  header;
+    int           c, flags, level = gs->xd.zlevel < 0 ? 6 : gs->xd.zlevel;
+
+    if( !gs->zbatch ) {
+        gs->zbatch = (unsigned char *)malloc(GXML_ZDICT +
+                                             gs->zthreads*(long long)GXML_ZCHUNK);
+        gs->zchunks = (gxml_zchunk *)calloc(gs->zthreads, sizeof(gxml_zchunk));
+        if( !gs->zbatch || !gs->zchunks ) {
+            fprintf(stderr,"** GXML stream: failed to alloc %d chunks\n",
+                    gs->zthreads);
+            return 1;
+        }
+        for( c = 0; c < gs->zthreads; c++ ) {
+            gs->zchunks[c].outalloc = GXML_ZCHUNK_BOUND;
+            gs->zchunks[c].out = (unsigned char *)malloc(GXML_ZCHUNK_BOUND);
+            if( !gs->zchunks[c].out ) {
+                fprintf(stderr,"** GXML stream: failed to alloc chunk\n");
+                return 1;
+            }
+        }
+    }
+
+    gs->zused = 0;
+    gs->zdict = 0;
+    gs->adler = adler32(0L, Z_NULL, 0);
+
+    /* the zlib header, as deflateInit writes it */
+    flags = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    header = (0x78 << 8) | (flags << 6);
+    header += 31 - header % 31;
+    head[0] = (header >> 8) & 0xff;
+    head[1] = header & 0xff;
+
+    return stream_b64_data(gs, head, 2);
+#else
+    (void)gs;
+    fprintf(stderr,"** stream_pgz_begin: no ZLIB or threads\n");
+    return 1;
+#endif
+}
+
+/* gather data into the batch, compressing each full batch */
+static int stream_pgz_data(gifti_stream * gs, const unsigned char * data,
+                           long long len)
+{
+    long long blen = gs->zthreads * (long long)GXML_ZCHUNK, clen;
+
+    while( len > 0 ) {
+        clen = blen - gs->zused;
+        if( clen > len ) clen = len;
+
+        memcpy(gs->zbatch + GXML_ZDICT + gs->zused, data, clen);
+        gs->zused += clen;
+        data += clen;
+        len -= clen;
+
+        if( gs->zused == blen && stream_pgz_batch(gs, 0) ) return 1;
+    }
+
+    return 0;
+}
+
+/* compress the chunks of the batch in parallel and write them in order,
+ * ending the deflate stream if 'finish' is set */
+static int stream_pgz_batch(gifti_stream * gs, int finish)
+{
+#if defined(HAVE_ZLIB) && defined(HAVE_PTHREAD)
+    unsigned char    * chunks = gs->zbatch + GXML_ZDICT;
+    gxml_zchunk_pool   pool;
+    pthread_t        * threads;
+    long long          keep;
+    int                c, nchunks, nstarted = 0, errs = 0;
+
+    nchunks = (int)((gs->zused + GXML_ZCHUNK - 1) / GXML_ZCHUNK);
+    if( nchunks == 0 ) {
+        if( !finish ) return 0;
+        nchunks = 1;            /* an empty last block ends the stream */
+    }
+
+    for( c = 0; c < nchunks; c++ ) {
+        gxml_zchunk * zc = gs->zchunks + c;
+        zc->in      = chunks + c * (long long)GXML_ZCHUNK;
+        zc->inlen   = gs->zused - c * (long long)GXML_ZCHUNK;
+        if( zc->inlen > GXML_ZCHUNK ) zc->inlen = GXML_ZCHUNK;
+        zc->dictlen = c ? GXML_ZDICT : gs->zdict;
+        zc->dict    = zc->in - zc->dictlen;
+        zc->last    = finish && c == nchunks-1;
+        zc->level   = gs->xd.zlevel;
+        zc->outlen  = 0;
+        zc->errors  = 0;
+    }
+
+    pool.chunks = gs->zchunks;
+    pool.nchunks = nchunks;
+    pool.next = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+
+    threads = (pthread_t *)malloc(nchunks*sizeof(pthread_t));
+    if( threads )
+        for( ; nstarted < nchunks-1; nstarted++ )
+            if( pthread_create(threads+nstarted, NULL,
+                               deflate_zchunk_thread, &pool) )
+                break;      /* go on with the threads we have */
+
+    /* checksum the data while the chunks are compressed */
+    gs->adler = adler32(gs->adler, chunks, (uInt)gs->zused);
+    (void)deflate_zchunk_thread(&pool);
+
+    for( c = 0; c < nstarted; c++ )
+        pthread_join(threads[c], NULL);
+
+    pthread_mutex_destroy(&pool.lock);
+    if( threads ) free(threads);
+
+    for( c = 0; c < nchunks; c++ ) {
+        gxml_zchunk * zc = gs->zchunks + c;
+        if( zc->errors ) {
+            fprintf(stderr,"** zlib compression failure\n");
+            errs++;
+        } else if( stream_b64_data(gs, zc->out, zc->outlen) )
+            errs++;
+    }
+
+    /* keep the last 32 KB as the dictionary of the next batch */
+    keep = gs->zdict + gs->zused;
+    if( keep > GXML_ZDICT ) keep = GXML_ZDICT;
+    memmove(gs->zbatch + GXML_ZDICT - keep, chunks + gs->zused - keep, keep);
+    gs->zdict = (int)keep;
+    gs->zused = 0;
+
+    return errs;
+#else
+    (void)gs; (void)finish;
+    fprintf(stderr,"** stream_pgz_batch: no ZLIB or threads\n");
+    return 1;
+#endif
+}
+
+#if defined(HAVE_ZLIB) && defined(HAVE_PTHREAD)
+/* compress one chunk as raw deflate data, return 0 on success */
+static int deflate_zchunk(gxml_zchunk * zc)
+{
+    z_stream zs;
+    int      rv;
+
+    memset(&zs, 0, sizeof(zs));
+    if( deflateInit2(&zs, zc->level, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK ) {
+        zc->errors++;
+        return 1;
+    }
+
+    if( zc->dictlen > 0 )
+        deflateSetDictionary(&zs, (Bytef *)zc->dict, zc->dictlen);
+
+    zs.next_in   = (Bytef *)zc->in;
+    zs.avail_in  = (uInt)zc->inlen;
+    zs.next_out  = (Bytef *)zc->out;
+    zs.avail_out = (uInt)zc->outalloc;
+
+    rv = deflate(&zs, zc->last ? Z_FINISH : Z_SYNC_FLUSH);
+    if( rv != (zc->last ? Z_STREAM_END : Z_OK) || zs.avail_in > 0 ||
+        zs.avail_out == 0 )
+        zc->errors++;
+
+    zc->outlen = zc->outalloc - zs.avail_out;
+    deflateEnd(&zs);
+
+    return zc->errors;
+}
+#endif
+
+
 /*---------- accessor functions for user-controllable variables ----------*/
 /*----------     (one can pass -1 to set the default value)     ----------*/
 
@@ -553,9 +1741,68 @@ int gxml_set_zlevel( int val )
     else return 1;      /* failure - no action */
     return 0;
 }
+
+/*! nthreads is the number of threads decoding base64 DataArrays once the
+    XML is parsed, with 0 meaning to decode them within the parser */
+int gxml_get_nthreads( void    ){ return GXD.nthreads; }
+int gxml_set_nthreads( int val )
+{
+    if      ( val == -1 ) GXD.nthreads = 0;
+    else if ( val >=  0 ) GXD.nthreads = val;
+    else return 1;      /* failure - no action */
+    return 0;
+}
+
+/*! zthreads is the number of threads compressing chunks of streamed
+    GZipBase64Binary DataArrays, with 0 or 1 meaning to use one stream */
+int gxml_get_zthreads( void    ){ return GXD.zthreads; }
+int gxml_set_zthreads( int val )
+{
+    if      ( val == -1 ) GXD.zthreads = 0;
+    else if ( val >=  0 ) GXD.zthreads = val;
+    else return 1;      /* failure - no action */
+    return 0;
+}
 /*----------------------- END accessor functions -----------------------*/
 
 
+/*! fill ctx with the current (global) user variables */
+int gxml_init_context( gifti_context * ctx )
+{
+    if( !ctx ) return 1;
+
+    ctx->verb      = GXD.verb;
+    ctx->indent    = GXD.indent;
+    ctx->buf_size  = GXD.buf_size;
+    ctx->b64_check = GXD.b64_check;
+    ctx->update_ok = GXD.update_ok;
+    ctx->zlevel    = GXD.zlevel;
+    ctx->nthreads  = GXD.nthreads;
+    ctx->zthreads  = GXD.zthreads;
+
+    return 0;
+}
+
+/* set the user variables of xd from ctx, or from GXD without one,
+ * applying the defaults to invalid values, as the gxml_set_* functions */
+static void init_gxml_user_vars(gxml_data * xd, const gifti_context * ctx)
+{
+    *xd = GXD;
+    if( !ctx ) return;
+
+    xd->verb      = ctx->verb >= 0 ? ctx->verb : 1;
+    xd->indent    = ctx->indent >= 0 ? ctx->indent : 3;
+    xd->buf_size  = ctx->buf_size > 0 ? ctx->buf_size : GXML_DEF_BSIZE;
+    xd->b64_check = ctx->b64_check > GIFTI_B64_CHECK_UNDEF &&
+                    ctx->b64_check <= GIFTI_B64_CHECK_MAX ?
+                    ctx->b64_check : GIFTI_B64_CHECK_SKIPNCOUNT;
+    xd->update_ok = ctx->update_ok >= 0 ? ctx->update_ok : 1;
+    xd->zlevel    = ctx->zlevel >= 0 && ctx->zlevel <= 9 ?
+                    ctx->zlevel : GZ_DEFAULT_COMPRESSION;
+    xd->nthreads  = ctx->nthreads > 0 ? ctx->nthreads : 0;
+    xd->zthreads  = ctx->zthreads > 0 ? ctx->zthreads : 0;
+}
+
 static int init_gxml_data(gxml_data *dp, int doall, const int *dalist, int len)
 {
     int errs = 0;
@@ -568,6 +1815,8 @@ static int init_gxml_data(gxml_data *dp, int doall, const int *dalist, int len)
         dp->b64_check = GIFTI_B64_CHECK_SKIPNCOUNT;
         dp->update_ok = 1;
         dp->zlevel    = GZ_DEFAULT_COMPRESSION;
+        dp->nthreads  = 0;
+        dp->zthreads  = 0;
     }
 
     if( dalist && len > 0 ) {
@@ -595,11 +1844,18 @@ static int init_gxml_data(gxml_data *dp, int doall, const int *dalist, int len)
     dp->xlen = 0;
     dp->dlen = 0;
     dp->doff = 0;
+    dp->mod_prev = 0;
     dp->zlen = 0;
     dp->cdata = NULL;
     dp->xdata = NULL;
     dp->ddata = NULL;
     dp->zdata = NULL;
+    dp->npending = 0;
+    dp->apending = 0;
+    dp->pending  = NULL;
+    dp->map      = NULL;
+    dp->maplen   = 0;
+    dp->parser   = NULL;
     dp->gim   = NULL;
 
 #ifndef HAVE_ZLIB  /* if we don't have this (and need it), print warnings */
@@ -1108,78 +2364,110 @@ static int pop_darray(gxml_data * xd)
 
     if( !da ) return 1;
 
-    /* check for and clear any b64 errors */
-    if( xd->b64_errors > 0 ) {
-        if( xd->b64_check == GIFTI_B64_CHECK_DETECT )
-            fprintf(stderr,"** bad base64 chars found in DataArray[%d]\n",
-                    xd->gim->numDA-1);
-        else if( xd->b64_check == GIFTI_B64_CHECK_COUNT ||
-                 xd->b64_check == GIFTI_B64_CHECK_SKIPNCOUNT )
-            fprintf(stderr,"** %d bad base64 chars found in DataArray[%d]\n",
-                    xd->b64_errors, xd->gim->numDA-1);
-        xd->b64_errors = 0;
+    /* a deferred DataArray is uncompressed and swapped by decode_pending */
+    if( xd->npending > 0 && xd->pending[xd->npending-1].da == da ) {
+        if( da->encoding == GIFTI_ENCODING_B64GZ ) xd->gim->compressed = 1;
+        return 0;
     }
 
-    if( da->encoding == GIFTI_ENCODING_B64GZ && da->data ) {
-#ifdef HAVE_ZLIB   /* for compiling, higher level test elsewhere */
-        long long olen;  /* to avoid warnings printing outlen */
-        uLongf    outlen = da->nvals*da->nbyper;
-        int       rv = 0;
-
-        /* unzip zdata to da->data */
-
-        if( xd->verb > 2 )
-            fprintf(stderr,"-- uncompressing %lld bytes into %lld\n",
-                           xd->dind, (long long)outlen);
-
-        rv = uncompress(da->data, &outlen, (Bytef*)xd->zdata, xd->dind);
-        olen = outlen;
-
-        if( rv != Z_OK ) {
-            fprintf(stderr,"** uncompress fails for DA[%d]\n",xd->gim->numDA-1);
-            if( rv == Z_MEM_ERROR )
-                fprintf(stderr,"   (zlib failure, not enough memory)\n");
-            else if ( rv == Z_BUF_ERROR )
-                fprintf(stderr,"   (zlib failure, output buffer too short)\n");
-            else if ( rv == Z_DATA_ERROR )
-                fprintf(stderr,"   (zlib failure, corrupted data)\n");
-            else if ( rv != Z_OK )
-                fprintf(stderr,"   (zlib failure, unknown error %d)\n", rv);
-        } else if ( xd->verb > 2 || (xd->verb > 1 && xd->gim->numDA == 1 ))
-            fprintf(stderr,"-- uncompressed buffer (%.2f%% of %lld bytes)\n",
-                    100.0*xd->dind/olen, olen);
-
-        if( olen != da->nvals*da->nbyper ) {
-            fprintf(stderr,"** uncompressed buf is %lld bytes, expected %lld\n",
-                    olen, da->nvals*da->nbyper);
-        }
-#endif
+    /* check for and clear any b64 errors */
+    show_b64_errors(xd, xd->b64_errors, xd->gim->numDA-1);
+    xd->b64_errors = 0;
 
+    if( da->encoding == GIFTI_ENCODING_B64GZ && da->data ) {
+        (void)uncompress_DA_data(xd, da, xd->gim->numDA-1, xd->zdata,
+                                 xd->dind, xd->verb > 2 ||
+                                 (xd->verb > 1 && xd->gim->numDA == 1));
         xd->gim->compressed = 1;   /* flag whether some data was compressed */
     }
 
-    /* possibly read data from an external file */
-    if( da->ext_fname && *da->ext_fname )
+    /* possibly read data from an external file (only when storing data) */
+    if( xd->dstore && da->ext_fname && *da->ext_fname )
         (void)gifti_read_extern_DA_data(da); /* nothing to do on failure */
 
     /* possibly perform byte-swapping on data */
     if( da->data && da->encoding != GIFTI_ENCODING_ASCII ) {
-        long long nvals;
-        int       swapsize;
+        int swapped = swap_DA_data(da);
+        if( swapped < 0 ) return 1;
+        if( swapped ) xd->gim->swapped = 1;       /* flag that it happened */
+    }
 
-        gifti_datatype_sizes(da->datatype, NULL, &swapsize);
-        if( swapsize <= 0 ) {
-            fprintf(stderr,"** bad swapsize %d for dtype %d\n",
-                    swapsize, da->datatype);
-            return 1;
-        }
+    return 0;
+}
 
-        nvals = da->nvals * da->nbyper / swapsize;
-        if( gifti_check_swap(da->data, da->endian, nvals, swapsize) )
-            xd->gim->swapped = 1;       /* flag that it happened */
+/* report the number of bad base64 characters found in DataArray[index] */
+static void show_b64_errors(gxml_data * xd, int nerrs, int index)
+{
+    if( nerrs <= 0 ) return;
+
+    if( xd->b64_check == GIFTI_B64_CHECK_DETECT )
+        fprintf(stderr,"** bad base64 chars found in DataArray[%d]\n", index);
+    else if( xd->b64_check == GIFTI_B64_CHECK_COUNT ||
+             xd->b64_check == GIFTI_B64_CHECK_SKIPNCOUNT )
+        fprintf(stderr,"** %d bad base64 chars found in DataArray[%d]\n",
+                nerrs, index);
+}
+
+/* uncompress zlen bytes of zdata into da->data, return 0 on success */
+static int uncompress_DA_data(gxml_data * xd, giiDataArray * da, int index,
+                              const char * zdata, long long zlen, int show)
+{
+#ifdef HAVE_ZLIB   /* for compiling, higher level test elsewhere */
+    long long olen;  /* to avoid warnings printing outlen */
+    uLongf    outlen = da->nvals*da->nbyper;
+    int       rv = 0;
+
+    /* unzip zdata to da->data */
+
+    if( xd->verb > 2 )
+        fprintf(stderr,"-- uncompressing %lld bytes into %lld\n",
+                       zlen, (long long)outlen);
+
+    rv = uncompress(da->data, &outlen, (const Bytef*)zdata, zlen);
+    olen = outlen;
+
+    if( rv != Z_OK ) {
+        fprintf(stderr,"** uncompress fails for DA[%d]\n",index);
+        if( rv == Z_MEM_ERROR )
+            fprintf(stderr,"   (zlib failure, not enough memory)\n");
+        else if ( rv == Z_BUF_ERROR )
+            fprintf(stderr,"   (zlib failure, output buffer too short)\n");
+        else if ( rv == Z_DATA_ERROR )
+            fprintf(stderr,"   (zlib failure, corrupted data)\n");
+        else if ( rv != Z_OK )
+            fprintf(stderr,"   (zlib failure, unknown error %d)\n", rv);
+    } else if ( show )
+        fprintf(stderr,"-- uncompressed buffer (%.2f%% of %lld bytes)\n",
+                100.0*zlen/olen, olen);
+
+    if( olen != da->nvals*da->nbyper ) {
+        fprintf(stderr,"** uncompressed buf is %lld bytes, expected %lld\n",
+                olen, da->nvals*da->nbyper);
+        return 1;
     }
 
-    return 0;
+    return rv != Z_OK;
+#else
+    return 1;
+#endif
+}
+
+/* byte-swap da->data if its endian differs from this machine's
+   return 1 if swapped, 0 if not, -1 on error */
+static int swap_DA_data(giiDataArray * da)
+{
+    long long nvals;
+    int       swapsize;
+
+    gifti_datatype_sizes(da->datatype, NULL, &swapsize);
+    if( swapsize <= 0 ) {
+        fprintf(stderr,"** bad swapsize %d for dtype %d\n",
+                swapsize, da->datatype);
+        return -1;
+    }
+
+    nvals = da->nvals * da->nbyper / swapsize;
+    return gifti_check_swap(da->data, da->endian, nvals, swapsize);
 }
 
 
@@ -1217,7 +2505,16 @@ static int push_data(gxml_data * xd)
     if( update_partial_buffer(&xd->ddata, &xd->dlen, da->nbyper*da->nvals, 0) )
         return 1;
 
-    if( da->encoding == GIFTI_ENCODING_B64GZ ) {
+    if( da->encoding == GIFTI_ENCODING_B64GZ && xd->nthreads > 0 ) {
+#ifndef HAVE_ZLIB
+        if( g_first_zlib_err_msg ) {
+            fprintf(stderr,"** no ZLIB: skipping all compressed data\n");
+            g_first_zlib_err_msg = 0;
+        }
+        xd->skip = xd->depth;
+        return 1;   /* return and skip this element */
+#endif
+    } else if( da->encoding == GIFTI_ENCODING_B64GZ ) {
 
 #ifndef HAVE_ZLIB  /* we don't know the encoding until push_darray */
         if( g_first_zlib_err_msg ) {
@@ -1252,6 +2549,42 @@ static int push_data(gxml_data * xd)
         fprintf(stderr,"++ PD: alloc %lld bytes for darray[%d]\n",
                 da->nvals*da->nbyper, xd->gim->numDA-1);
 
+    /* maybe only store the base64 text, to decode it after parsing
+       (from a mapped file, that text need not even be copied) */
+    if( (xd->nthreads > 0 || xd->map) &&
+        ( da->encoding == GIFTI_ENCODING_B64BIN ||
+          da->encoding == GIFTI_ENCODING_B64GZ ) )
+        return defer_data(xd, da);
+
+    return 0;
+}
+
+/* add a pending decode entry for da, the current DataArray */
+static int defer_data(gxml_data * xd, giiDataArray * da)
+{
+    gxml_pending * dp;
+
+    if( xd->npending >= xd->apending ) {
+        int nalloc = xd->apending ? 2*xd->apending : 16;
+        dp = (gxml_pending *)realloc(xd->pending, nalloc*sizeof(gxml_pending));
+        if( !dp ) {
+            fprintf(stderr,"** DD: failed to alloc %d pending entries\n",
+                    nalloc);
+            return 1;
+        }
+        xd->pending = dp;
+        xd->apending = nalloc;
+    }
+
+    dp = xd->pending + xd->npending;
+    memset(dp, 0, sizeof(gxml_pending));
+    dp->da = da;
+    dp->index = xd->eleDA-1;
+    xd->npending++;
+
+    if( xd->verb > 3 )
+        fprintf(stderr,"++ deferring decode of darray[%d]\n", dp->index);
+
     return 0;
 }
 
@@ -1346,6 +2679,10 @@ static int epop( gxml_data * xd, int etype, const char * ename )
             fprintf(stderr,"-- popping skip element '%s' at depth %d\n",
                     ename, xd->depth);
         xd->skip = 0;  /* clear skip level */
+    } else if( xd->skip ) {     /* inside a skip block, as in epush() */
+        if( xd->verb > 3 )
+            fprintf(stderr,"-- skip=%d, depth=%d, popping element '%s'\n",
+                    xd->skip, xd->depth, ename);
     } else {    /* may peform pop action for this element */
         switch( etype ) {
             default: /* do nothing special */
@@ -1354,7 +2691,16 @@ static int epop( gxml_data * xd, int etype, const char * ename )
                 if(xd->verb>3)fprintf(stderr,"-- data dind = %lld\n",xd->dind);
                 /* if we have not read data, but allocated for it, free */
                 da = xd->gim->darray[xd->gim->numDA-1];
-                if( da->data && xd->dind == 0 ) {
+                if( xd->npending > 0 && xd->pending[xd->npending-1].da == da ) {
+                    /* deferred: drop the entry if there was no text */
+                    if( xd->pending[xd->npending-1].text.nused == 0 ) {
+                        xd->npending--;
+                        if( xd->pending[xd->npending].text.nalloc )
+                            free(xd->pending[xd->npending].text.buf);
+                        free(da->data);
+                        da->data = NULL;
+                    }
+                } else if( da->data && xd->dind == 0 ) {
                     if( xd->verb > 3 ) fprintf(stderr,"   (freeing data)\n");
                     free(da->data);
                     da->data = NULL;
@@ -1591,6 +2937,9 @@ static int append_to_data(gxml_data * xd, const char * cdata, int len)
         return 1;
     } 
 
+    if( xd->npending > 0 && xd->pending[xd->npending-1].da == da )
+        return append_to_pending(xd, cdata, len);
+
     switch( da->encoding ){
         case GIFTI_ENCODING_ASCII:
             return append_to_data_ascii(xd, cdata, len);
@@ -1610,6 +2959,83 @@ static int append_to_data(gxml_data * xd, const char * cdata, int len)
 }
 
 
+/* store the base64 text of the current (deferred) DataArray
+ *
+ * When parsing a mapped file, text that expat passes on unchanged is only
+ * referenced where it lies in the mapping, as long as it is contiguous.
+ * Otherwise (entities, CDATA sections, CR-LF line ends) it is copied.
+ */
+static int append_to_pending(gxml_data * xd, const char * cdata, int len)
+{
+    gxml_pending * dp = xd->pending + xd->npending - 1;
+    gxml_buffer  * tb = &dp->text;
+    const char   * mtext;
+    long long      pos, mlen;
+
+    if( xd->map && !tb->nalloc ) {
+        pos = XML_GetCurrentByteIndex(xd->parser);
+        if( len > 0 && pos >= 0 && pos + len <= xd->maplen &&
+            XML_GetCurrentByteCount(xd->parser) == len &&
+            xd->map[pos] == cdata[0] && xd->map[pos+len-1] == cdata[len-1] &&
+            (tb->nused == 0 || tb->buf + tb->nused == xd->map + pos) ) {
+            if( tb->nused == 0 ) tb->buf = (char *)xd->map + pos;
+            tb->nused += len;
+            return 0;
+        }
+
+        /* copy any text referenced so far, and store the rest after it */
+        if( tb->nused > 0 ) {
+            if( xd->verb > 3 )
+                fprintf(stderr,"++ copying mapped text of darray[%d]\n",
+                        dp->index);
+            mtext = tb->buf;
+            mlen = tb->nused;
+            tb->buf = NULL;
+            tb->nused = 0;
+            if( append_to_buffer(dp, mtext, mlen) ) return 1;
+        }
+    }
+
+    if( xd->verb > 4 )
+        fprintf(stderr,"++ storing %d base64 bytes for darray[%d]\n",
+                len, dp->index);
+
+    return append_to_buffer(dp, cdata, len);
+}
+
+
+/* append text to the buffer of a pending DataArray, growing it as needed */
+static int append_to_buffer(gxml_pending * dp, const char * text,
+                            long long len)
+{
+    gxml_buffer * tb = &dp->text;
+    long long     nalloc;
+    char        * buf;
+
+    if( tb->nused + len > tb->nalloc ) {
+        /* start from the size of the unpacked data, expanded by base64 */
+        nalloc = tb->nalloc ? 2*tb->nalloc :
+                 (dp->da->nvals*dp->da->nbyper+2)/3*4 + GXML_MIN_BSIZE;
+        if( dp->da->encoding == GIFTI_ENCODING_B64GZ && !tb->nalloc )
+            nalloc /= 4;        /* expect some compression */
+        if( nalloc < tb->nused + len ) nalloc = tb->nused + len;
+
+        buf = (char *)realloc(tb->buf, nalloc);
+        if( !buf ) {
+            fprintf(stderr,"** A2P: failed to alloc %lld bytes of text\n",
+                    nalloc);
+            return 1;
+        }
+        tb->buf = buf;
+        tb->nalloc = nalloc;
+    }
+
+    memcpy(tb->buf + tb->nused, text, len);
+    tb->nused += len;
+
+    return 0;
+}
+
 /* decode the b64 data, inserting it into da->data
  *
  * use intermediate buffer (ddata), length dlen+1, reprocess length doff
@@ -1715,7 +3141,7 @@ static int append_to_data_b64(gxml_data * xd, char * dest, long long tot_bytes,
 static int copy_b64_data(gxml_data * xd, const char * src, char * dest,
                          int src_len, int * dest_len)
 {
-    const unsigned char * usrc = (const unsigned char *)src;
+    long long nbad = 0;
     int c, errs = 0, apply_len;
 
     if( xd->verb > 1 ) {  /* in verbose mode, perform automatic check */
@@ -1737,38 +3163,23 @@ static int copy_b64_data(gxml_data * xd, const char * src, char * dest,
             break;
 
         case GIFTI_B64_CHECK_DETECT:   /* check for existence of bad chars */
-            for(c = 0; c < src_len; c++)
-                if( b64_decode_table[usrc[c]] == (unsigned char)0x80 ) {
-                    errs++;
-                    break;
-                }
+            errs = (int)b64_count_bad(src, src_len, 1);
             memcpy(dest, src, src_len);
             apply_len = src_len;
             break;
 
         case GIFTI_B64_CHECK_COUNT:   /* count bad characters */
-            for(c = 0; c < src_len; c++)
-                if( b64_decode_table[usrc[c]] == (unsigned char)0x80 )
-                    errs++;
+            errs = (int)b64_count_bad(src, src_len, 0);
             memcpy(dest, src, src_len);
             apply_len = src_len;
             break;
 
         case GIFTI_B64_CHECK_SKIP: /* skip bad characters, but don't count */
-            apply_len = 0;
-            for(c = 0; c < src_len; c++){
-                if( b64_decode_table[usrc[c]] != (unsigned char)0x80 )
-                    dest[apply_len++] = src[c];
-            }
+            apply_len = (int)b64_copy_valid(src, src_len, dest, NULL);
             break;
         case GIFTI_B64_CHECK_SKIPNCOUNT:    /* skip and count bad characters */
-            apply_len = 0;
-            for(c = 0; c < src_len; c++){
-                if( b64_decode_table[usrc[c]] == (unsigned char)0x80 )
-                    errs++;
-                else 
-                    dest[apply_len++] = src[c];
-            }
+            apply_len = (int)b64_copy_valid(src, src_len, dest, &nbad);
+            errs = (int)nbad;
             break;
     }
 
@@ -1784,14 +3195,7 @@ static int copy_b64_data(gxml_data * xd, const char * src, char * dest,
 
 static int count_bad_b64_chars(const char * src, int len)
 {
-    const unsigned char * usrc = (const unsigned char *)src;
-    int c, bad = 0;
-
-    for(c = 0; c < len; c++)
-        if( b64_decode_table[usrc[c]] == (unsigned char)0x80 )
-            bad++;
-
-    return bad;
+    return (int)b64_count_bad(src, len, 0);
 }
 
 static int show_bad_b64_chars(const char * src, int len)
@@ -1814,7 +3218,6 @@ static int show_bad_b64_chars(const char * src, int len)
 /* this must go to the data of the latest darray struct */
 static int append_to_data_ascii(gxml_data * xd, const char * cdata, int len)
 {
-    static int     mod_prev = 0;
     giiDataArray * da = xd->gim->darray[xd->gim->numDA-1]; /* current DA */
 
     char      * dptr;
@@ -1860,7 +3263,7 @@ static int append_to_data_ascii(gxml_data * xd, const char * cdata, int len)
             fprintf(stderr,"-- %lld vals left at offset %lld, nbyper %d\n",
                     rem_vals, xd->dind, da->nbyper);
 
-        if( xd->dind == 0 ) mod_prev = 0;       /* nothing to modify at first */
+        if( xd->dind == 0 ) xd->mod_prev = 0;   /* nothing to modify at first */
         dptr = (char *)da->data + (xd->dind)*da->nbyper;
         xd->doff = decode_ascii(xd,
                         xd->ddata,              /* data source */
@@ -1868,7 +3271,7 @@ static int append_to_data_ascii(gxml_data * xd, const char * cdata, int len)
                         type,                   /* data type */
                         dptr,                   /* starting destination */
                         &rem_vals,              /* nvals to read */
-                        &mod_prev               /* can we mod previous val */
+                        &xd->mod_prev           /* can we mod previous val */
                         );
 
         /*--- check results --- */
@@ -1906,7 +3309,6 @@ static int append_to_data_ascii(gxml_data * xd, const char * cdata, int len)
 /* (process as 1-D array) */
 static int append_to_xform(gxml_data * xd, const char * cdata, int len)
 {
-    static int  mod_prev = 0;
     giiDataArray * da = xd->gim->darray[xd->gim->numDA-1]; /* current DA */
 
     double    * dptr;
@@ -1958,7 +3360,7 @@ static int append_to_xform(gxml_data * xd, const char * cdata, int len)
         rem_vals = 16 - xd->dind;
 
         /*--- process the ascii data ---*/
-        if( xd->dind == 0 ) mod_prev = 0;       /* nothing to modify at first */
+        if( xd->dind == 0 ) xd->mod_prev = 0;   /* nothing to modify at first */
         dptr = (double *)da->coordsys[CSind]->xform + (xd->dind); /* as array */
         xd->doff = decode_ascii(xd,
                         xd->xdata,              /* data source */
@@ -1966,7 +3368,7 @@ static int append_to_xform(gxml_data * xd, const char * cdata, int len)
                         type,                   /* data type */
                         dptr,                   /* starting destination */
                         &rem_vals,              /* nvals to read */
-                        &mod_prev               /* can we mod previous val */
+                        &xd->mod_prev           /* can we mod previous val */
                         );
 
         /*--- check results --- */
@@ -1998,13 +3400,7 @@ static int append_to_xform(gxml_data * xd, const char * cdata, int len)
     }
 
     return 0;
-}
-
-#undef GII_B64_decode4
-#define GII_B64_decode4(w,x,y,z,a,b,c)                                  \
-     ( a = (b64_decode_table[w] << 2) | (b64_decode_table[x] >> 4) ,    \
-       b = (b64_decode_table[x] << 4) | (b64_decode_table[y] >> 2) ,    \
-       c = (b64_decode_table[y] << 6) | b64_decode_table[z]         )
+}
 
 /*  given: source pointer, length, dest loc and nbytes to set,
           (cdata is null-terminated)
@@ -2035,13 +3431,14 @@ static int decode_b64(gxml_data * xd, char * cdata, int cdlen,
         return 0;
     }
 
-    for( ind = 0; ind < blocks && *needed >= 3; ind++, *needed -= 3 ){
-        GII_B64_decode4(din[0],din[1],din[2],din[3], dout[0],dout[1],dout[2]);
-
-        din  += 4;
-        dout += 3;
-    }
-    assigned = 3*ind;
+    /* decode the whole blocks that fit */
+    ind = blocks;
+    if( ind > *needed/3 ) ind = (int)(*needed/3);
+    b64_decode_quads(cdata, ind, dptr);
+    din      += 4*ind;
+    dout     += 3*ind;
+    *needed  -= 3*ind;
+    assigned  = 3*ind;
 
     /* the first blocks-1 sets should just work */
     if( ind < blocks-1 || (ind < blocks && *needed == 0) ){
@@ -2068,6 +3465,304 @@ static int decode_b64(gxml_data * xd, char * cdata, int cdlen,
 }
 
 
+/* decode the stored base64 text of one DataArray into da->data:
+ *      - drop or count bad characters, according to b64_check
+ *      - decode, in pieces that fit decode_b64
+ *      - uncompress, if the encoding is GZipBase64Binary
+ *      - byte-swap
+ *
+ * This is run from the decoding threads, so it only modifies dp and the
+ * data of its DataArray.
+ */
+static int decode_pending_DA(gxml_data * xd, gxml_pending * dp)
+{
+    giiDataArray  * da = dp->da;
+    unsigned char * text = (unsigned char *)dp->text.buf;
+    char          * dest, * zdata = NULL;
+    long long       nbytes, needed, tlen, c;
+    int             len, swapped;
+
+    /* remove bad characters in place, as copy_b64_data would */
+    tlen = dp->text.nused;
+    if( xd->b64_check == GIFTI_B64_CHECK_DETECT )
+        dp->b64_errors = (int)b64_count_bad((char *)text, tlen, 1);
+    else if( xd->b64_check == GIFTI_B64_CHECK_COUNT )
+        dp->b64_errors = (int)b64_count_bad((char *)text, tlen, 0);
+    else if( xd->b64_check == GIFTI_B64_CHECK_SKIP ||
+             xd->b64_check == GIFTI_B64_CHECK_SKIPNCOUNT ) {
+        /* text in the mapped file is read-only, so copy it if need be */
+        c = 0;
+        if( dp->text.nalloc || b64_count_bad((char *)text, tlen, 1) ) {
+            if( !dp->text.nalloc ) {
+                char * buf = (char *)malloc(tlen);
+                if( !buf ) {
+                    fprintf(stderr,"** DPDA: failed to alloc %lld bytes for "
+                            "text of DA[%d]\n", tlen, dp->index);
+                    dp->errors++;
+                    return 1;
+                }
+                memcpy(buf, text, tlen);
+                dp->text.buf = buf;
+                dp->text.nalloc = tlen;
+                text = (unsigned char *)buf;
+            }
+            tlen = b64_copy_valid((char *)text, tlen, (char *)text, &c);
+        }
+        if( xd->b64_check == GIFTI_B64_CHECK_SKIPNCOUNT )
+            dp->b64_errors = (int)c;
+    }
+
+    /* compressed data is first decoded into its own buffer */
+    if( da->encoding == GIFTI_ENCODING_B64GZ ) {
+        nbytes = tlen/4*3;
+        zdata = (char *)malloc(nbytes+3);
+        if( !zdata ) {
+            fprintf(stderr,"** DPDA: failed to alloc %lld bytes for DA[%d]\n",
+                    nbytes, dp->index);
+            dp->errors++;
+            return 1;
+        }
+        dest = zdata;
+    } else {
+        nbytes = da->nvals*da->nbyper;
+        dest = (char *)da->data;
+    }
+
+    /* decode_b64 takes int lengths, so go in pieces of whole quads */
+    needed = nbytes;
+    for( c = 0; c < tlen && needed > 0; c += len ) {
+        len = tlen - c > GXML_MAX_DECODE_LEN ? GXML_MAX_DECODE_LEN :
+                                               (int)(tlen - c);
+        if( decode_b64(xd, (char *)text + c, len, dest + (nbytes - needed),
+                       &needed) < 0 ) {
+            dp->errors++;
+            break;
+        }
+    }
+
+    if( zdata ) {
+        if( uncompress_DA_data(xd, da, dp->index, zdata, nbytes - needed,
+                               xd->verb > 2) )
+            dp->errors++;
+        free(zdata);
+    }
+
+    swapped = swap_DA_data(da);
+    if( swapped < 0 ) dp->errors++;
+    else              dp->swapped = swapped;
+
+    return dp->errors;
+}
+
+#ifdef HAVE_PTHREAD
+typedef struct {
+    gxml_data       * xd;
+    int               next;     /* next pending entry to decode */
+    pthread_mutex_t   lock;
+} gxml_decode_pool;
+
+/* decode pending entries until there are none left */
+static void * decode_pending_thread(void * arg)
+{
+    gxml_decode_pool * pool = (gxml_decode_pool *)arg;
+    int                ind;
+
+    for( ;; ) {
+        pthread_mutex_lock(&pool->lock);
+        ind = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if( ind >= pool->xd->npending ) break;
+        (void)decode_pending_DA(pool->xd, pool->xd->pending + ind);
+    }
+
+    return NULL;
+}
+#endif
+
+/* decode all deferred DataArrays, using up to nthreads threads
+ * (the calling thread being one of them), then report any errors
+ * in DataArray order and release the stored text
+ *
+ * return the number of DataArrays with errors
+ */
+static int decode_pending(gxml_data * xd)
+{
+    int c, nthreads = xd->nthreads, errs = 0;
+
+    if( nthreads > xd->npending ) nthreads = xd->npending;
+    if( nthreads < 1 ) nthreads = 1;    /* deferred only for the mapping */
+
+    if( xd->verb > 1 )
+        fprintf(stderr,"-- decoding %d DataArrays with %d thread(s)\n",
+                xd->npending, nthreads);
+
+#ifdef HAVE_PTHREAD
+    if( nthreads > 1 ) {
+        gxml_decode_pool   pool;
+        pthread_t        * threads;
+        int                nstarted = 0;
+
+        threads = (pthread_t *)malloc((nthreads-1)*sizeof(pthread_t));
+        pool.xd = xd;
+        pool.next = 0;
+        pthread_mutex_init(&pool.lock, NULL);
+
+        if( threads )
+            for( ; nstarted < nthreads-1; nstarted++ )
+                if( pthread_create(threads+nstarted, NULL,
+                                   decode_pending_thread, &pool) )
+                    break;      /* go on with the threads we have */
+
+        (void)decode_pending_thread(&pool);
+
+        for( c = 0; c < nstarted; c++ )
+            pthread_join(threads[c], NULL);
+
+        pthread_mutex_destroy(&pool.lock);
+        if( threads ) free(threads);
+    } else
+#endif
+    for( c = 0; c < xd->npending; c++ )
+        (void)decode_pending_DA(xd, xd->pending + c);
+
+    for( c = 0; c < xd->npending; c++ ) {
+        gxml_pending * dp = xd->pending + c;
+
+        show_b64_errors(xd, dp->b64_errors, dp->index);
+        if( dp->swapped ) xd->gim->swapped = 1;
+        if( dp->errors ) errs++;
+
+        if( dp->text.nalloc ) free(dp->text.buf);
+        memset(&dp->text, 0, sizeof(dp->text));
+    }
+
+    return errs;
+}
+
+/*----------------------------------------------------------------------
+ * ASCII number parsing, as strtol and strtod do
+ *
+ * The usual short numbers are converted directly: integers of up to
+ * 9 (or 18) digits, and decimals of up to 19 significant digits whose
+ * mantissa and power of ten are exact doubles, where one multiplication
+ * or division is correctly rounded.  Anything else (long numbers, big
+ * exponents, inf, nan, hex) is left to the C library.
+ *----------------------------------------------------------------------*/
+#define GXML_IS_SPACE(c) ((c)==' '||(c)=='\n'||(c)=='\t'||(c)=='\r'|| \
+                          (c)=='\f'||(c)=='\v')
+#define GXML_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+#if defined(__i386__) && !defined(__SSE2_MATH__)
+#define GXML_SLOW_STRTOD        /* x87 math would round twice */
+#endif
+
+static const double gxml_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static long gxml_strtol(const char * str, char ** end)
+{
+    const char * p = str, * digits;
+    long         val = 0;
+    int          neg = 0;
+
+    while( GXML_IS_SPACE(*p) ) p++;
+    if     ( *p == '-' ) { neg = 1; p++; }
+    else if( *p == '+' ) p++;
+
+    for( digits = p; GXML_IS_DIGIT(*p); p++ ) {
+        if( p - digits >= 9 ) return strtol(str, end, 10); /* may overflow */
+        val = val * 10 + (*p - '0');
+    }
+
+    if( p == digits ) { *end = (char *)str; return 0; }
+
+    *end = (char *)p;
+    return neg ? -val : val;
+}
+
+static long long gxml_strtoll(const char * str, char ** end)
+{
+    const char * p = str, * digits;
+    long long    val = 0;
+    int          neg = 0;
+
+    while( GXML_IS_SPACE(*p) ) p++;
+    if     ( *p == '-' ) { neg = 1; p++; }
+    else if( *p == '+' ) p++;
+
+    for( digits = p; GXML_IS_DIGIT(*p); p++ ) {
+        if( p - digits >= 18 ) {                        /* may overflow */
+#if defined(_WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
+            return strtol(str, end, 10); /* There is no strtoll in MS VC++ */
+#else
+            return strtoll(str, end, 10);
+#endif
+        }
+        val = val * 10 + (*p - '0');
+    }
+
+    if( p == digits ) { *end = (char *)str; return 0; }
+
+    *end = (char *)p;
+    return neg ? -val : val;
+}
+
+static double gxml_strtod(const char * str, char ** end)
+{
+#ifdef GXML_SLOW_STRTOD
+    return strtod(str, end);
+#else
+    const char         * p = str, * e;
+    unsigned long long   mant = 0;
+    double               val;
+    int                  neg = 0, ndig = 0, nsig = 0, exp10 = 0, eval = 0;
+
+    while( GXML_IS_SPACE(*p) ) p++;
+    if     ( *p == '-' ) { neg = 1; p++; }
+    else if( *p == '+' ) p++;
+
+    /* mantissa digits, with the decimal point moving the exponent */
+    for( ; GXML_IS_DIGIT(*p); p++, ndig++ )
+        if( mant || *p != '0' ) {
+            if( ++nsig > 19 ) return strtod(str, end);
+            mant = mant * 10 + (*p - '0');
+        }
+    if( *p == '.' )
+        for( p++; GXML_IS_DIGIT(*p); p++, ndig++, exp10-- )
+            if( mant || *p != '0' ) {
+                if( ++nsig > 19 ) return strtod(str, end);
+                mant = mant * 10 + (*p - '0');
+            }
+
+    /* no digits (inf, nan or nothing) or hex */
+    if( ndig == 0 || *p == 'x' || *p == 'X' ) return strtod(str, end);
+
+    /* an exponent counts only with digits */
+    if( *p == 'e' || *p == 'E' ) {
+        e = p + 1;
+        if( *e == '-' || *e == '+' ) e++;
+        if( GXML_IS_DIGIT(*e) ) {
+            for( ; GXML_IS_DIGIT(*e); e++ )
+                if( eval < 100000 ) eval = eval * 10 + (*e - '0');
+            exp10 += p[1] == '-' ? -eval : eval;
+            p = e;
+        }
+    }
+
+    if( mant == 0 ) val = 0.0;
+    else if( mant > (1ULL << 53) || exp10 < -22 || exp10 > 22 )
+        return strtod(str, end);
+    else if( exp10 < 0 ) val = (double)mant / gxml_pow10[-exp10];
+    else                 val = (double)mant * gxml_pow10[exp10];
+
+    *end = (char *)p;
+    return neg ? -val : val;
+#endif
+}
+
 /* given: source pointer, remaining length, nvals desired, dest loc and type
           (cdata is null-terminated)
    modify: nvals left for output, mod_prev for next call
@@ -2107,7 +3802,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             prev = p1;
             /* vals could be < 0, but we must care for promotion to size_t */
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                lval = strtol(p1, &p2, 10);   /* try to read next value */
+                lval = gxml_strtol(p1, &p2);  /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2123,7 +3818,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             p1 = cdata;
             prev = p1;
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                lval = strtol(p1, &p2, 10);   /* try to read next value */
+                lval = gxml_strtol(p1, &p2);  /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2139,7 +3834,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             p1 = cdata;
             prev = p1;
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                lval = strtol(p1, &p2, 10);   /* try to read next value */
+                lval = gxml_strtol(p1, &p2);  /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2155,7 +3850,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             p1 = cdata;
             prev = p1;
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                dval = strtod(p1, &p2); /* try to read next value */
+                dval = gxml_strtod(p1, &p2); /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2171,7 +3866,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             p1 = cdata;
             prev = p1;
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                dval = strtod(p1, &p2); /* try to read next value */
+                dval = gxml_strtod(p1, &p2); /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2188,7 +3883,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             prev = p1;
             /* vals could be < 0, but we must care for promotion to size_t */
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                lval = strtol(p1, &p2, 10);   /* try to read next value */
+                lval = gxml_strtol(p1, &p2);  /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2204,7 +3899,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             p1 = cdata;
             prev = p1;
             while( (vals < 0 || vals < *nvals) && p1 ) {
-                lval = strtol(p1, &p2, 10);   /* try to read next value */
+                lval = gxml_strtol(p1, &p2);  /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2221,11 +3916,7 @@ static int decode_ascii(gxml_data * xd, char * cdata, int cdlen, int type,
             p1 = cdata;
             prev = p1;
             while( (vals < 0 || vals < *nvals) && p1 ) {
-#if defined(_WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
-	            llval = strtol(p1, &p2, 10);   /* There is no strtoll defined in MS VC++ */
-#else
-	            llval = strtoll(p1, &p2, 10);   /* try to read next value */
-#endif
+                llval = gxml_strtoll(p1, &p2); /* try to read next value */
                 if( p1 == p2 ) break;   /* nothing read, terminate loop */
                 prev = p1;              /* store old success ptr */
                 p1 = p2;                /* move to next posn */
@@ -2380,7 +4071,8 @@ static XML_Parser init_xml_parser( void * user_data )
     XML_SetEndDoctypeDeclHandler(parser, cb_end_doctype);
     XML_SetElementDeclHandler(parser, cb_elem_dec);
 
-    if( GXD.verb > 3 ) fprintf(stderr,"-- parser initialized\n");
+    if( ((gxml_data *)user_data)->verb > 3 )
+        fprintf(stderr,"-- parser initialized\n");
 
     return parser;
 }
@@ -2474,9 +4166,9 @@ static int stack_is_valid(gxml_data * xd)
     }
 
     /* possibly print a message if the stack looks bad */
-    if( bad_parent && GXD.verb )
+    if( bad_parent && xd->verb )
         fprintf(stderr,"** %s: bad parent '%s'\n",enames[etype],enames[parent]);
-    if( (!valid || bad_parent) && GXD.verb > 1 ) show_stack("** invalid ", xd);
+    if( (!valid || bad_parent) && xd->verb > 1 ) show_stack("** invalid ", xd);
 
     return valid;
 }
@@ -2561,7 +4253,7 @@ static int update_partial_buffer(char ** buf, int * blen, long long bytes,
 
     /* just make sure we have a text buffer to work with */
     if( *buf || *blen != bsize ) {
-        if( GXD.verb > 2 )
+        if( gifti_get_verb() > 2 )
             fprintf(stderr,"++ UPB, alloc %d bytes (from %lld, %d) for buff\n",
                     bsize, bytes, full);
         *buf = (char *)realloc(*buf, bsize * sizeof(char));
@@ -2578,9 +4270,7 @@ static int update_partial_buffer(char ** buf, int * blen, long long bytes,
 static int gxml_write_gifti(gxml_data * xd, FILE * fp)
 {
     gifti_image * gim = xd->gim;
-
-    int c, offset;
-    int first = 1;  /* first attr to print? */
+    int           c;
 
     if( !gim || !fp ) return 1;
 
@@ -2588,6 +4278,29 @@ static int gxml_write_gifti(gxml_data * xd, FILE * fp)
         fprintf(stderr,"++ gifti image, numDA = %d, size = %lld MB\n",
                 gim->numDA, gifti_gim_DA_size(gim,1));
 
+    gxml_write_gifti_head(xd, fp);
+
+    /* write the giiDataArray */
+    if(!gim->darray) {
+        if( xd->verb > 0 ) fprintf(stderr,"** gifti_image, missing darray\n");
+    } else {
+        for( c = 0; c < gim->numDA; c++ )
+            ewrite_darray(xd, gim->darray[c], fp);
+    }
+
+    return gxml_write_gifti_tail(xd, fp);
+}
+
+/* write everything of the GIFTI element up to its DataArray elements */
+static int gxml_write_gifti_head(gxml_data * xd, FILE * fp)
+{
+    gifti_image * gim = xd->gim;
+
+    int offset;
+    int first = 1;  /* first attr to print? */
+
+    if( !gim || !fp ) return 1;
+
     gxml_write_preamble(fp);
     fprintf(fp,"<%s",enames[GXML_ETYPE_GIFTI]);
     if(gim->version){ fprintf(fp," Version=\"%s\"", gim->version); first = 0; }
@@ -2603,14 +4316,11 @@ static int gxml_write_gifti(gxml_data * xd, FILE * fp)
     ewrite_meta(xd, &gim->meta, fp);
     ewrite_LT(xd, &gim->labeltable, 1, fp);
 
-    /* write the giiDataArray */
-    if(!gim->darray) {
-        if( xd->verb > 0 ) fprintf(stderr,"** gifti_image, missing darray\n");
-    } else {
-        for( c = 0; c < gim->numDA; c++ )
-            ewrite_darray(xd, gim->darray[c], fp);
-    }
-    
+    return 0;
+}
+
+static int gxml_write_gifti_tail(gxml_data * xd, FILE * fp)
+{
     xd->depth--;
     fprintf(fp,"</%s>\n",enames[GXML_ETYPE_GIFTI]);
 
@@ -2618,6 +4328,17 @@ static int gxml_write_gifti(gxml_data * xd, FILE * fp)
 }
 
 static int ewrite_darray(gxml_data * xd, giiDataArray * da, FILE * fp)
+{
+    if( !da ) return 0;
+
+    ewrite_darray_head(xd, da, fp);
+    ewrite_data(xd, da, fp);
+
+    return ewrite_darray_tail(xd, fp);
+}
+
+/* write everything of a DataArray element up to its Data element */
+static int ewrite_darray_head(gxml_data * xd, giiDataArray * da, FILE * fp)
 {
     int  spaces = xd->indent * xd->depth;
     int  offset, c;
@@ -2658,8 +4379,16 @@ static int ewrite_darray(gxml_data * xd, giiDataArray * da, FILE * fp)
     ewrite_meta(xd, &da->meta, fp);
     for( c = 0; c < da->numCS; c++ )
         ewrite_coordsys(xd, da->coordsys[c], fp);
-    ewrite_data(xd, da, fp);
+
+    return 0;
+}
+
+static int ewrite_darray_tail(gxml_data * xd, FILE * fp)
+{
+    int spaces;
+
     xd->depth--;
+    spaces = xd->indent * xd->depth;
 
     fprintf(fp, "%*s</DataArray>\n", spaces, "");
 
@@ -2670,7 +4399,7 @@ static int ewrite_darray(gxml_data * xd, giiDataArray * da, FILE * fp)
 /* this depends on ind_ord, how to write out lines */
 static int ewrite_data(gxml_data * xd, giiDataArray * da, FILE * fp)
 {
-    long long c, rows, cols;
+    long long rows, cols;
     int       spaces = xd->indent * xd->depth;
     int       errs = 0;
 
@@ -2695,9 +4424,9 @@ static int ewrite_data(gxml_data * xd, giiDataArray * da, FILE * fp)
         if( da->encoding == GIFTI_ENCODING_ASCII ) {
             fprintf(fp, "\n");
             gifti_DA_rows_cols(da, &rows, &cols);  /* product will be nvals */
-            for(c = 0; c < rows; c++ )
-                ewrite_data_line(da->data,da->datatype,c,cols,
-                                 spaces+xd->indent,fp);
+            if( ewrite_data_rows(da->data, da->datatype, 0, rows, cols,
+                                 spaces+xd->indent, fp) )
+                errs++;
             fprintf(fp, "%*s", spaces, "");
         } else if( da->encoding == GIFTI_ENCODING_B64BIN ) {
             gxml_disp_b64_data(NULL, da->data, da->nvals*da->nbyper, fp);
@@ -2741,19 +4470,14 @@ static int ewrite_data(gxml_data * xd, giiDataArray * da, FILE * fp)
     return errs;
 }
 
-#undef GII_B64_encode3
-#define GII_B64_encode3(a,b,c,w,x,y,z)                       \
-     ( w = b64_encode_table[(a)>>2]                      ,   \
-       x = b64_encode_table[((a & 3) << 4) | (b >> 4)]   ,   \
-       y = b64_encode_table[((b & 0xF) << 2) | (c >> 6)] ,   \
-       z = b64_encode_table[c & 0x3F]                     )
 static int gxml_disp_b64_data(const char *mesg, const void *data, int len,
                               FILE *fp)
 {
     const unsigned char * dp = (const unsigned char *)data;
-    unsigned char         w, x, y, z;
+    char                  obuf[4*GXML_B64_ENC_BLOCK];
     FILE                * stream;
-    int                   c, rem = len % 3;
+    long long             olen;
+    int                   c, clen;
 
     stream = fp ? fp : stdout;
 
@@ -2761,22 +4485,13 @@ static int gxml_disp_b64_data(const char *mesg, const void *data, int len,
 
     if( mesg ) fputs(mesg, stream);
 
-    /* first get all of the 3-byte blocks */
-    for( c = 0; c < len/3; c++, dp += 3 ) {
-        GII_B64_encode3(dp[0], dp[1], dp[2], w, x, y, z);
-        fprintf(stream, "%c%c%c%c", w, x, y, z);
+    /* encode and write in blocks of whole 3-byte sets */
+    for( c = 0; c < len; c += clen ) {
+        clen = len - c < 3*GXML_B64_ENC_BLOCK ? len - c : 3*GXML_B64_ENC_BLOCK;
+        olen = b64_encode(dp + c, clen, obuf);
+        if( fwrite(obuf, 1, olen, stream) != (size_t)olen ) return 1;
     }
 
-    /* finish off the last bytes */
-    if( rem == 1 ) {
-        GII_B64_encode3(dp[0], 0, 0, w, x, y, z);
-        fprintf(stream, "%c%c==", w, x);
-    } else if ( rem == 2 ) {
-        GII_B64_encode3(dp[0], dp[1], 0, w, x, y, z);
-        fprintf(stream, "%c%c%c=", w, x, y);
-    }
-    /* else we're done */
-
     return 0;
 }
 
@@ -2807,97 +4522,366 @@ static int ewrite_coordsys(gxml_data * xd, giiCoordSystem * cs, FILE * fp)
 }
 
 
-/* write one 'row' ('cols' values) of data in text */
-static int ewrite_data_line(void * data, int type, long long row,
-                            long long cols, int space, FILE * fp)
+/*----------------------------------------------------------------------
+ * ASCII number formatting
+ *
+ * Floats are written with the fewest digits that read back to the same
+ * float, found with the Ryu algorithm (Ulf Adams, PLDI 2018), and doubles
+ * with the fewest of 15, 16 or 17 significant digits that read back.
+ *----------------------------------------------------------------------*/
+#define GXML_POW5_INV_BITCOUNT 59
+#define GXML_POW5_BITCOUNT     61
+
+/* floor(2^(len(5^i)-1+59) / 5^i) + 1 */
+static const unsigned long long gxml_pow5_inv_split[31] = {
+    0x0800000000000001ULL, 0x0666666666666667ULL, 0x051eb851eb851eb9ULL,
+    0x04189374bc6a7efaULL, 0x068db8bac710cb2aULL, 0x053e2d6238da3c22ULL,
+    0x0431bde82d7b634eULL, 0x06b5fca6af2bd216ULL, 0x055e63b88c230e78ULL,
+    0x044b82fa09b5a52dULL, 0x06df37f675ef6eaeULL, 0x057f5ff85e592558ULL,
+    0x0465e6604b7a8447ULL, 0x0709709a125da071ULL, 0x05a126e1a84ae6c1ULL,
+    0x0480ebe7b9d58567ULL, 0x0734aca5f6226f0bULL, 0x05c3bd5191b525a3ULL,
+    0x049c97747490eae9ULL, 0x0760f253edb4ab0eULL, 0x05e72843249088d8ULL,
+    0x04b8ed0283a6d3e0ULL, 0x078e480405d7b966ULL, 0x060b6cd004ac9452ULL,
+    0x04d5f0a66a23a9dbULL, 0x07bcb43d769f762bULL, 0x063090312bb2c4efULL,
+    0x04f3a68dbc8f03f3ULL, 0x07ec3daf94180651ULL, 0x065697bfa9acd1daULL,
+    0x051212ffbaf0a7e2ULL
+};
+
+/* 5^i, as its top 61 bits */
+static const unsigned long long gxml_pow5_split[47] = {
+    0x1000000000000000ULL, 0x1400000000000000ULL, 0x1900000000000000ULL,
+    0x1f40000000000000ULL, 0x1388000000000000ULL, 0x186a000000000000ULL,
+    0x1e84800000000000ULL, 0x1312d00000000000ULL, 0x17d7840000000000ULL,
+    0x1dcd650000000000ULL, 0x12a05f2000000000ULL, 0x174876e800000000ULL,
+    0x1d1a94a200000000ULL, 0x12309ce540000000ULL, 0x16bcc41e90000000ULL,
+    0x1c6bf52634000000ULL, 0x11c37937e0800000ULL, 0x16345785d8a00000ULL,
+    0x1bc16d674ec80000ULL, 0x1158e460913d0000ULL, 0x15af1d78b58c4000ULL,
+    0x1b1ae4d6e2ef5000ULL, 0x10f0cf064dd59200ULL, 0x152d02c7e14af680ULL,
+    0x1a784379d99db420ULL, 0x108b2a2c28029094ULL, 0x14adf4b7320334b9ULL,
+    0x19d971e4fe8401e7ULL, 0x1027e72f1f128130ULL, 0x1431e0fae6d7217cULL,
+    0x193e5939a08ce9dbULL, 0x1f8def8808b02452ULL, 0x13b8b5b5056e16b3ULL,
+    0x18a6e32246c99c60ULL, 0x1ed09bead87c0378ULL, 0x13426172c74d822bULL,
+    0x1812f9cf7920e2b6ULL, 0x1e17b84357691b64ULL, 0x12ced32a16a1b11eULL,
+    0x178287f49c4a1d66ULL, 0x1d6329f1c35ca4bfULL, 0x125dfa371a19e6f7ULL,
+    0x16f578c4e0a060b5ULL, 0x1cb2d6f618c878e3ULL, 0x11efc659cf7d4b8dULL,
+    0x166bb7f0435c9e71ULL, 0x1c06a5ec5433c60dULL
+};
+
+/* number of bits of 5^e, for e > 0 */
+static int gxml_pow5bits(int e)
 {
-    int c;
-    if( !data || row < 0 || cols <= 0 || !fp ) return 1;
+    return (int)(((unsigned)e * 1217359) >> 19) + 1;
+}
 
-    fprintf(fp, "%*s", space, "");
-    switch( type ) {
-        default : 
-            fprintf(stderr,"** write_data_line, unknown type %d\n",type);
-            return -1;
-        case NIFTI_TYPE_UINT8: {
-            unsigned char * ptr = (unsigned char *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%u ", ptr[c]);
-            break;
-        }
-        case NIFTI_TYPE_INT16: {
-            short * ptr = (short *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%d ", ptr[c]);
-            break;
-        }
-        case NIFTI_TYPE_INT32: {
-            int * ptr = (int *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%d ", ptr[c]);
-            break;
-        }
-        case NIFTI_TYPE_FLOAT32: {
-            float * ptr = (float *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%f ", ptr[c]);
-            break;
-        }
-        case NIFTI_TYPE_COMPLEX64: {
-            float * ptr = (float *)data + row * cols;
-            for(c = 0; c < 2*cols; c+=2)fprintf(fp, "%f %f   ",ptr[c],ptr[c+1]);
-            break;
-        }
-        case NIFTI_TYPE_FLOAT64: {
-            double * ptr = (double *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%f ", ptr[c]);
-            break;
+static int gxml_pow5_factor(unsigned int val)
+{
+    int count = 0;
+    while( val % 5 == 0 ) { val /= 5; count++; }
+    return count;
+}
+
+/* (m * factor) >> shift, for shift > 32 */
+static unsigned int gxml_mul_shift(unsigned int m, unsigned long long factor,
+                                   int shift)
+{
+    unsigned long long lo = (unsigned long long)m * (unsigned int)factor;
+    unsigned long long hi = (unsigned long long)m * (unsigned int)(factor>>32);
+    return (unsigned int)(((lo >> 32) + hi) >> (shift - 32));
+}
+
+/* write digits * 10^exp10 as printf's %g would, but with all digits */
+static int gxml_fmt_decimal(char * out, int neg, unsigned long long digits,
+                            int exp10)
+{
+    char  tmp[24];
+    char *op = out;
+    int   ndig = 0, point, c;
+
+    do { tmp[ndig++] = '0' + (char)(digits % 10); digits /= 10; }
+    while( digits );
+
+    if( neg ) *op++ = '-';
+    point = ndig + exp10;       /* digits before the decimal point */
+
+    if( point > 0 && point <= 9 ) {             /* ddd.ddd or ddd000 */
+        for( c = 0; c < ndig; c++ ) {
+            if( c == point ) *op++ = '.';
+            *op++ = tmp[ndig-1-c];
         }
-        case NIFTI_TYPE_RGB24: {
-            unsigned char * ptr = (unsigned char *)data + row * cols;
-            for( c = 0; c < 3*cols; c+=3 )
-                fprintf(fp, "%u %u %u   ", ptr[c], ptr[c+1], ptr[c+2]);
-            break;
+        for( ; c < point; c++ ) *op++ = '0';
+    } else if( point <= 0 && point > -5 ) {     /* 0.000ddd */
+        *op++ = '0';
+        *op++ = '.';
+        for( c = point; c < 0; c++ ) *op++ = '0';
+        for( c = 0; c < ndig; c++ ) *op++ = tmp[ndig-1-c];
+    } else {                                    /* d.ddde+XX */
+        *op++ = tmp[ndig-1];
+        if( ndig > 1 ) {
+            *op++ = '.';
+            for( c = 1; c < ndig; c++ ) *op++ = tmp[ndig-1-c];
         }
-        case NIFTI_TYPE_INT8: {
-            char * ptr = (char *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%d ", ptr[c]);
-            break;
+        exp10 = point - 1;
+        *op++ = 'e';
+        *op++ = exp10 < 0 ? '-' : '+';
+        if( exp10 < 0 ) exp10 = -exp10;
+        if( exp10 >= 100 ) { *op++ = '0' + exp10 / 100; exp10 %= 100; }
+        *op++ = '0' + exp10 / 10;
+        *op++ = '0' + exp10 % 10;
+    }
+
+    return (int)(op - out);
+}
+
+static int gxml_fmt_uint(char * out, unsigned long long val)
+{
+    char tmp[24];
+    int  len = 0, c;
+
+    do { tmp[len++] = '0' + (char)(val % 10); val /= 10; } while( val );
+    for( c = 0; c < len; c++ ) out[c] = tmp[len-1-c];
+
+    return len;
+}
+
+static int gxml_fmt_int(char * out, long long val)
+{
+    if( val >= 0 ) return gxml_fmt_uint(out, (unsigned long long)val);
+    *out = '-';
+    return 1 + gxml_fmt_uint(out+1, 0ULL - (unsigned long long)val);
+}
+
+static int gxml_fmt_float(char * out, float fval)
+{
+    unsigned int  bits, mant, m2, mv, mp, mm, vr, vp, vm, q, output;
+    int           expo, e2, e10, k, i, j, l, mmshift, removed = 0;
+    int           even, vm_zeros = 0, vr_zeros = 0, last = 0;
+
+    memcpy(&bits, &fval, sizeof(bits));
+    mant = bits & 0x7fffff;
+    expo = (bits >> 23) & 0xff;
+
+    if( expo == 0xff ) {
+        if( mant ) { memcpy(out, "nan", 3); return 3; }
+        if( bits >> 31 ) { memcpy(out, "-inf", 4); return 4; }
+        memcpy(out, "inf", 3); return 3;
+    }
+    if( expo == 0 && mant == 0 ) {
+        if( bits >> 31 ) { memcpy(out, "-0", 2); return 2; }
+        *out = '0'; return 1;
+    }
+
+    /* the value is m2 * 2^e2, with 2 more bits for the bounds */
+    if( expo == 0 ) { e2 = 1 - 127 - 23 - 2;    m2 = mant; }
+    else            { e2 = expo - 127 - 23 - 2; m2 = (1u << 23) | mant; }
+    even = (m2 & 1) == 0;
+
+    mv = 4 * m2;
+    mp = 4 * m2 + 2;
+    mmshift = mant != 0 || expo <= 1;
+    mm = 4 * m2 - 1 - mmshift;
+
+    /* the bounds and value in base 10, vm < vr < vp */
+    if( e2 >= 0 ) {
+        q = ((unsigned)e2 * 78913) >> 18;       /* log10(2^e2) */
+        e10 = (int)q;
+        k = GXML_POW5_INV_BITCOUNT + gxml_pow5bits((int)q) - 1;
+        i = -e2 + (int)q + k;
+        vr = gxml_mul_shift(mv, gxml_pow5_inv_split[q], i);
+        vp = gxml_mul_shift(mp, gxml_pow5_inv_split[q], i);
+        vm = gxml_mul_shift(mm, gxml_pow5_inv_split[q], i);
+        if( q != 0 && (vp - 1) / 10 <= vm / 10 ) {
+            l = GXML_POW5_INV_BITCOUNT + gxml_pow5bits((int)q - 1) - 1;
+            last = (int)(gxml_mul_shift(mv, gxml_pow5_inv_split[q-1],
+                                        -e2 + (int)q - 1 + l) % 10);
         }
-        case NIFTI_TYPE_UINT16: {
-            unsigned short * ptr = (unsigned short *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%u ", ptr[c]);
-            break;
+        if( q <= 9 ) {
+            if     ( mv % 5 == 0 ) vr_zeros = gxml_pow5_factor(mv) >= (int)q;
+            else if( even )        vm_zeros = gxml_pow5_factor(mm) >= (int)q;
+            else                   vp -= gxml_pow5_factor(mp) >= (int)q;
         }
-        case NIFTI_TYPE_UINT32: {
-            unsigned int * ptr = (unsigned int *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%u ", ptr[c]);
-            break;
+    } else {
+        q = ((unsigned)(-e2) * 732923) >> 20;   /* log10(5^-e2) */
+        e10 = (int)q + e2;
+        i = -e2 - (int)q;
+        k = gxml_pow5bits(i) - GXML_POW5_BITCOUNT;
+        j = (int)q - k;
+        vr = gxml_mul_shift(mv, gxml_pow5_split[i], j);
+        vp = gxml_mul_shift(mp, gxml_pow5_split[i], j);
+        vm = gxml_mul_shift(mm, gxml_pow5_split[i], j);
+        if( q != 0 && (vp - 1) / 10 <= vm / 10 ) {
+            j = (int)q - 1 - (gxml_pow5bits(i + 1) - GXML_POW5_BITCOUNT);
+            last = (int)(gxml_mul_shift(mv, gxml_pow5_split[i+1], j) % 10);
         }
-        case NIFTI_TYPE_INT64: {
-            long long * ptr = (long long *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%lld ", ptr[c]);
-            break;
+        if( q <= 1 ) {
+            vr_zeros = 1;
+            if( even ) vm_zeros = mmshift == 1;
+            else       vp--;
+        } else if( q < 31 )
+            vr_zeros = (mv & ((1u << (q - 1)) - 1)) == 0;
+    }
+
+    /* drop digits while the bounds still differ */
+    if( vm_zeros || vr_zeros ) {
+        while( vp / 10 > vm / 10 ) {
+            vm_zeros &= vm % 10 == 0;
+            vr_zeros &= last == 0;
+            last = (int)(vr % 10);
+            vr /= 10; vp /= 10; vm /= 10;
+            removed++;
         }
-        case NIFTI_TYPE_UINT64: {
-            unsigned long long * ptr = (unsigned long long *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%llu ", ptr[c]);
-            break;
+        if( vm_zeros )
+            while( vm % 10 == 0 ) {
+                vr_zeros &= last == 0;
+                last = (int)(vr % 10);
+                vr /= 10; vp /= 10; vm /= 10;
+                removed++;
+            }
+        if( vr_zeros && last == 5 && vr % 2 == 0 ) last = 4; /* to even */
+        output = vr + ((vr == vm && (!even || !vm_zeros)) || last >= 5);
+    } else {
+        while( vp / 10 > vm / 10 ) {
+            last = (int)(vr % 10);
+            vr /= 10; vp /= 10; vm /= 10;
+            removed++;
         }
-        case NIFTI_TYPE_FLOAT128: {
-            long double * ptr = (long double *)data + row * cols;
-            for( c = 0; c < cols; c++ ) fprintf(fp, "%Lf ", ptr[c]);
-            break;
+        output = vr + (vr == vm || last >= 5);
+    }
+
+    return gxml_fmt_decimal(out, bits >> 31, output, e10 + removed);
+}
+
+static int gxml_fmt_double(char * out, double dval)
+{
+    int prec, len = 0;
+
+    if( dval != dval )      { memcpy(out, "nan", 3); return 3; }
+    if( dval - dval != 0.0 ) {                          /* infinite */
+        if( dval < 0 ) { memcpy(out, "-inf", 4); return 4; }
+        memcpy(out, "inf", 3); return 3;
+    }
+
+    for( prec = 15; prec <= 17; prec++ ) {
+        len = sprintf(out, "%.*g", prec, dval);
+        if( prec == 17 || strtod(out, NULL) == dval ) break;
+    }
+
+    return len;
+}
+
+/* format one value of the given scalar type, return the length */
+static int gxml_fmt_value(char * out, const unsigned char * src, int ctype)
+{
+    switch( ctype ) {
+        case NIFTI_TYPE_UINT8:  return gxml_fmt_uint(out, *src);
+        case NIFTI_TYPE_INT8:   return gxml_fmt_int(out, *(const signed char *)src);
+        case NIFTI_TYPE_INT16:  { short v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_int(out, v); }
+        case NIFTI_TYPE_UINT16: { unsigned short v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_uint(out, v); }
+        case NIFTI_TYPE_INT32:  { int v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_int(out, v); }
+        case NIFTI_TYPE_UINT32: { unsigned int v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_uint(out, v); }
+        case NIFTI_TYPE_INT64:  { long long v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_int(out, v); }
+        case NIFTI_TYPE_UINT64: { unsigned long long v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_uint(out, v); }
+        case NIFTI_TYPE_FLOAT32:{ float v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_float(out, v); }
+        case NIFTI_TYPE_FLOAT64:{ double v;
+                                  memcpy(&v, src, sizeof(v));
+                                  return gxml_fmt_double(out, v); }
+    }
+
+    return 0;
+}
+
+
+/* write 'nrows' rows of 'cols' values in text, starting at 'row'
+
+   Values are formatted into a local buffer, which is written out whenever
+   it is nearly full, rather than making one fprintf() call per value.
+*/
+static int ewrite_data_rows(const void * data, int type, long long row,
+                            long long nrows, long long cols, int space,
+                            FILE * fp)
+{
+    char                  buf[GXML_ABUF_LEN];
+    const unsigned char * ptr;
+    long long             r, c;
+    int                   ctype, ncomp, csize, k, pad, blen = 0;
+
+    if( !data || row < 0 || nrows < 0 || cols <= 0 || !fp ) return 1;
+
+    /* split each value into 'ncomp' components of type 'ctype' */
+    switch( type ) {
+        default :
+            fprintf(stderr,"** write_data_rows, unknown type %d\n",type);
+            return -1;
+        case NIFTI_TYPE_UINT8:      case NIFTI_TYPE_INT8:
+        case NIFTI_TYPE_INT16:      case NIFTI_TYPE_UINT16:
+        case NIFTI_TYPE_INT32:      case NIFTI_TYPE_UINT32:
+        case NIFTI_TYPE_INT64:      case NIFTI_TYPE_UINT64:
+        case NIFTI_TYPE_FLOAT32:    case NIFTI_TYPE_FLOAT64:
+        case NIFTI_TYPE_FLOAT128:
+            ctype = type;                ncomp = 1; break;
+        case NIFTI_TYPE_RGB24:
+            ctype = NIFTI_TYPE_UINT8;    ncomp = 3; break;
+        case NIFTI_TYPE_COMPLEX64:
+            ctype = NIFTI_TYPE_FLOAT32;  ncomp = 2; break;
+        case NIFTI_TYPE_COMPLEX128:
+            ctype = NIFTI_TYPE_FLOAT64;  ncomp = 2; break;
+        case NIFTI_TYPE_COMPLEX256:
+            ctype = NIFTI_TYPE_FLOAT128; ncomp = 2; break;
+    }
+    if( ctype == NIFTI_TYPE_FLOAT128 ) csize = (int)sizeof(long double);
+    else                               gifti_datatype_sizes(ctype, &csize, NULL);
+    pad = (ncomp > 1) ? 2 : 0;    /* extra spaces after each tuple */
+
+    ptr = (const unsigned char *)data + row * cols * ncomp * csize;
+    for( r = 0; r < nrows; r++ ) {
+        if( blen + space > GXML_ABUF_LEN - GXML_AVAL_LEN ) {
+            if( fwrite(buf, 1, blen, fp) != (size_t)blen ) return 1;
+            blen = 0;
         }
-        case NIFTI_TYPE_COMPLEX128: {
-            double * ptr = (double *)data + row * cols;
-            for(c = 0; c < 2*cols; c+=2)fprintf(fp, "%f %f   ",ptr[c],ptr[c+1]);
-            break;
+        if( space > GXML_ABUF_LEN - GXML_AVAL_LEN ) {
+            fprintf(fp, "%*s", space, "");
+        } else {
+            memset(buf + blen, ' ', space);
+            blen += space;
         }
-        case NIFTI_TYPE_COMPLEX256: {
-            long double * ptr = (long double *)data + row * cols;
-            for(c = 0; c<2*cols; c+=2)fprintf(fp, "%Lf %Lf   ",ptr[c],ptr[c+1]);
-            break;
+
+        for( c = 0; c < cols; c++ ) {
+            for( k = 0; k < ncomp; k++, ptr += csize ) {
+                if( blen > GXML_ABUF_LEN - GXML_AVAL_LEN ) {
+                    if( fwrite(buf, 1, blen, fp) != (size_t)blen ) return 1;
+                    blen = 0;
+                }
+                if( ctype == NIFTI_TYPE_FLOAT128 ) {  /* rare, use stdio */
+                    long double v;
+                    memcpy(&v, ptr, sizeof(v));
+                    if( fwrite(buf, 1, blen, fp) != (size_t)blen ) return 1;
+                    blen = 0;
+                    fprintf(fp, "%Lf ", v);
+                } else {
+                    blen += gxml_fmt_value(buf + blen, ptr, ctype);
+                    buf[blen++] = ' ';
+                }
+            }
+            for( k = 0; k < pad; k++ ) buf[blen++] = ' ';
         }
+
+        buf[blen++] = '\n';
     }
 
-    fputc('\n', fp);
+    if( blen > 0 && fwrite(buf, 1, blen, fp) != (size_t)blen ) return 1;
 
     return 0;
 }
@@ -2905,15 +4889,10 @@ static int ewrite_data_line(void * data, int type, long long row,
 
 static int ewrite_double_line(double * data, int nvals, int space, FILE * fp)
 {
-    int c;
     if( !data || nvals <= 0 || !fp ) return 1;
 
-    fprintf(fp, "%*s", space, "");
-    for( c = 0; c < nvals; c++ )        /* duplicate trailing space for diff */
-        fprintf(fp, "%f ", data[c]);
-    fputc('\n', fp);
-
-    return 0;
+    /* duplicate trailing space for diff */
+    return ewrite_data_rows(data, NIFTI_TYPE_FLOAT64, 0, 1, nvals, space, fp);
 }
 
 
@@ -3086,9 +5065,11 @@ static int disp_gxml_data(char * mesg, gxml_data * dp, int show_all )
                 "   buf_size    : %d\n"
                 "   b64_check   : %d\n"
                 "   zlevel      : %d\n"
+                "   nthreads    : %d\n"
+                "   zthreads    : %d\n"
                 "   da_len      : %d\n"
            , dp->verb, dp->dstore, dp->indent, dp->buf_size, dp->b64_check,
-             dp->zlevel, dp->da_len);
+             dp->zlevel, dp->nthreads, dp->zthreads, dp->da_len);
 
     if( show_all )
         fprintf(stderr,
@@ -3108,12 +5089,13 @@ static int disp_gxml_data(char * mesg, gxml_data * dp, int show_all )
                 "   xdata       : %p\n"
                 "   ddata       : %p\n"
                 "   zdata       : %p\n"
+                "   npending    : %d\n"
                 "   gim         : %p\n"
            , (void *)dp->da_list, dp->da_ind, dp->eleDA, dp->expDA,
              dp->b64_errors, dp->errors, dp->skip, dp->depth, dp->dind,
              dp->clen, dp->doff, dp->zlen,
              (void *)dp->cdata, (void *)dp->xdata, (void *)dp->ddata,
-             (void *)dp->zdata, (void *)dp->gim);
+             (void *)dp->zdata, dp->npending, (void *)dp->gim);
 
     return 0;
 }
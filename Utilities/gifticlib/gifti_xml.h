@@ -63,9 +63,19 @@
 typedef struct {
     long long   nalloc;                 /* allocation length    */
     long long   nused;                  /* number of bytes used */
-    char      * buf;                    /* buffer               */
+    char      * buf;                    /* buffer (in the mapped
+                                           file if nalloc is 0) */
 } gxml_buffer;
 
+typedef struct {
+    giiDataArray * da;              /* DataArray to decode into     */
+    int            index;           /* DataArray index in the file  */
+    int            b64_errors;      /* bad chars, found on decoding */
+    int            errors;          /* decoding errors              */
+    int            swapped;         /* flag: data was byte-swapped  */
+    gxml_buffer    text;            /* encoded character data       */
+} gxml_pending;
+
 typedef struct {
     int            verb;            /* verbose level                */
     int            dstore;          /* flag: store data             */
@@ -74,6 +84,8 @@ typedef struct {
     int            b64_check;       /* 0=no, 1=check, 2=count, 3=skip */
     int            update_ok;       /* library can update metadata  */
     int            zlevel;          /* compression level -1..9      */
+    int            nthreads;        /* threads for deferred decoding */
+    int            zthreads;        /* threads for chunked compression */
 
     int          * da_list;         /* DA index list to store       */
     int            da_len;          /* DA index list length         */
@@ -92,22 +104,71 @@ typedef struct {
     int            xlen;            /* length of xform buffer       */
     int            dlen;            /* length of Data buffer        */
     int            doff;            /* offset into data buffer      */
+    int            mod_prev;        /* flag: can modify last value  */
     int            zlen;            /* length of compression buffer */
     char        ** cdata;           /* pointer to current CDATA     */
     char         * xdata;           /* xform buffer                 */
     char         * ddata;           /* I/O buffer xml->ddata->data  */
     char         * zdata;           /* zlib compression buffer      */
+    int            npending;        /* number of deferred decodes   */
+    int            apending;        /* allocated deferred decodes   */
+    gxml_pending * pending;         /* deferred DataArray decodes   */
+    const char   * map;             /* mapped input file, if any    */
+    long long      maplen;          /* length of mapped file        */
+    XML_Parser     parser;          /* parser of the input file     */
     gifti_image  * gim;             /* pointer to returning image   */
 } gxml_data;
 
-/* protos */
+typedef struct {
+    const unsigned char * in;       /* data to compress             */
+    long long      inlen;           /* length of data               */
+    const unsigned char * dict;     /* preceding data, as dictionary */
+    int            dictlen;         /* length of dictionary         */
+    int            last;            /* flag: last chunk of the data */
+    int            level;           /* compression level            */
+    unsigned char* out;             /* raw deflate output           */
+    long long      outalloc;        /* allocated output length      */
+    long long      outlen;          /* output length                */
+    int            errors;          /* compression errors           */
+} gxml_zchunk;
+
+struct gifti_stream_s {
+    gxml_data      xd;              /* writing state, user vars of GXD */
+    FILE         * fp;              /* GIFTI file being written     */
+    giiDataArray * da;              /* DataArray being written      */
+    long long      nbytes;          /* data bytes of da written     */
+    long long      cols;            /* values per ASCII row         */
+    long long      ncarry;          /* bytes carried to next write  */
+    long long      carry_len;       /* allocated carry length       */
+    unsigned char* carry;           /* partial row or 3-byte set    */
+    int            zinit;           /* flag: zs is initialized      */
+    z_stream       zs;              /* GZipBase64Binary compressor  */
+    int            zthreads;        /* threads for chunks, if > 1   */
+    unsigned char* zbatch;          /* dictionary, then chunk data  */
+    long long      zused;           /* chunk data bytes in zbatch   */
+    int            zdict;           /* dictionary bytes in zbatch   */
+    uLong          adler;           /* adler32 checksum of the data */
+    gxml_zchunk  * zchunks;         /* one per thread               */
+    int            errs;            /* errors met while streaming   */
+};
 
-/* main interface */
-gifti_image * gxml_read_image (const char * fname, int read_data,
-                               const int * dalist, int len);
-int           gxml_write_image(gifti_image * gim, const char * fname,
-                               int write_data);
+/* protos */
 
+/* main interface, with NULL ctx meaning the global user variables */
+gifti_image * gxml_read_image (const gifti_context * ctx, const char * fname,
+                               int read_data, const int * dalist, int len);
+int           gxml_write_image(const gifti_context * ctx, gifti_image * gim,
+                               const char * fname, int write_data);
+
+gifti_stream* gxml_stream_open         (const gifti_context * ctx,
+                                        gifti_image * gim, const char * fname);
+int           gxml_stream_begin_DA     (gifti_stream * gs, giiDataArray * da);
+int           gxml_stream_write_DA_data(gifti_stream * gs, const void * data,
+                                        long long nbytes);
+int           gxml_stream_end_DA       (gifti_stream * gs);
+int           gxml_stream_close        (gifti_stream * gs);
+
+int   gxml_init_context    ( gifti_context * ctx );
 int   gxml_set_verb        ( int val );
 int   gxml_get_verb        ( void    );
 int   gxml_set_dstore      ( int val );
@@ -122,6 +183,10 @@ int   gxml_set_update_ok   ( int val );
 int   gxml_get_update_ok   ( void    );
 int   gxml_set_zlevel      ( int val );
 int   gxml_get_zlevel      ( void    );
+int   gxml_set_nthreads    ( int val );
+int   gxml_get_nthreads    ( void    );
+int   gxml_set_zthreads    ( int val );
+int   gxml_get_zthreads    ( void    );
 
 
 #endif /* GIFTI_XML_H */